@@ -0,0 +1,76 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File BenchCommon.h
+* Description: timing and percentile helpers shared by the benchmarks
+*/
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+inline uint64_t BenchNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the user + system cpu time of the calling thread
+inline uint64_t BenchThreadCpuUs()
+{
+    rusage usage = {};
+    (void)getrusage(RUSAGE_THREAD, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// the value at ratio 0~1 of the samples, the samples are sorted
+inline uint64_t BenchPercentile(std::vector<uint64_t>& samples, double ratio)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t index = std::min(samples.size() - 1, (size_t)(ratio * samples.size()));
+    return samples[index];
+}
+
+// print one row of p50/p99/p99.9/max in microseconds of the nanosecond samples
+inline void BenchPrintLatency(const std::string& name, std::vector<uint64_t>& samplesNs)
+{
+    const double nsPerUs = 1000.0;
+    std::sort(samplesNs.begin(), samplesNs.end());
+    printf("%-28s n %7zu  p50 %9.1f us  p99 %9.1f us  p99.9 %9.1f us  max %9.1f us\n",
+           name.c_str(), samplesNs.size(), BenchPercentile(samplesNs, 0.5) / nsPerUs,
+           BenchPercentile(samplesNs, 0.99) / nsPerUs, BenchPercentile(samplesNs, 0.999) / nsPerUs,
+           samplesNs.empty() ? 0 : samplesNs.back() / nsPerUs);
+}
+
+// the integer argument at index, or the default value
+inline uint64_t BenchArg(int argc, char* argv[], int index, uint64_t defaultValue)
+{
+    return (argc > index) ? strtoull(argv[index], nullptr, 0) : defaultValue;
+}
+
+#endif
@@ -0,0 +1,310 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File asyncInferBench.cpp
+* Description: throughput and latency of the inference thread executing the
+* model synchronously against N async slots, with a preprocess thread feeding
+* it, and the share of the host work done while the device executes a batch.
+* Run it on the Host_ACL target, HOSTACL_INFER_LATENCY_US is the device time
+*/
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "AclLiteResource.h"
+#include "AclLiteModel.h"
+#include "ThreadSafeQueue.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint64_t kDefaultBatchNum = 300;
+    const uint64_t kDefaultPreUs = 6000;  // preprocess of one batch
+    const uint64_t kDefaultHostUs = 3000;  // the inference thread besides execute: gather, input, scatter
+    const uint64_t kDefaultDeviceUs = 10000;
+    const uint32_t kQueueSize = 3;  // kMsgQueueSize
+    const uint32_t kWaitMs = 100;
+    const vector<uint32_t> kSlotNums = {0, 1, 2, 3};  // 0: synchronous execution
+    const uint32_t kInputRingExtra = 2;  // the batches in preprocess and being gathered
+
+    struct Interval {
+        uint64_t beginNs;
+        uint64_t endNs;
+    };
+
+    struct BenchBatch {
+        uint64_t index = 0;
+        uint64_t preStartNs = 0;
+        void* input = nullptr;
+    };
+    using BatchQueue = ThreadSafeQueue<shared_ptr<BenchBatch>>;
+
+    struct CaseResult {
+        vector<Interval> preIntervals;
+        vector<Interval> hostIntervals;
+        vector<Interval> deviceIntervals;  // launch or execute call to the end of wait
+        vector<uint64_t> latencyNs;  // preprocess start to the inference result
+    };
+
+    void BusyWait(uint64_t us)
+    {
+        uint64_t endNs = BenchNowNs() + us * 1000;
+        while (BenchNowNs() < endNs) {
+        }
+    }
+
+    // the host cost, busy on the cpu when the two threads have their own cpus, otherwise
+    // a sleep stands for it, so the overlap and not the cpu number of this machine is measured
+    void HostCost(uint64_t us, bool busy)
+    {
+        if (busy) {
+            BusyWait(us);
+        } else {
+            usleep(us);
+        }
+    }
+
+    // the time of the intervals covered by the union of the covers
+    uint64_t OverlapNs(const vector<Interval>& intervals, vector<Interval> covers)
+    {
+        sort(covers.begin(), covers.end(), [](const Interval& a, const Interval& b) {
+            return a.beginNs < b.beginNs;
+        });
+        vector<Interval> merged;
+        for (const Interval& cover : covers) {
+            if (!merged.empty() && (cover.beginNs <= merged.back().endNs)) {
+                merged.back().endNs = max(merged.back().endNs, cover.endNs);
+            } else {
+                merged.push_back(cover);
+            }
+        }
+        uint64_t overlapNs = 0;
+        for (const Interval& interval : intervals) {
+            for (const Interval& cover : merged) {
+                uint64_t beginNs = max(interval.beginNs, cover.beginNs);
+                uint64_t endNs = min(interval.endNs, cover.endNs);
+                overlapNs += (endNs > beginNs) ? (endNs - beginNs) : 0;
+            }
+        }
+        return overlapNs;
+    }
+
+    uint64_t TotalNs(const vector<Interval>& intervals)
+    {
+        uint64_t totalNs = 0;
+        for (const Interval& interval : intervals) {
+            totalNs += interval.endNs - interval.beginNs;
+        }
+        return totalNs;
+    }
+
+    void PreprocessRun(BatchQueue& queue, vector<void*>& inputs, uint64_t batchNum, uint64_t preUs,
+                       bool busy, CaseResult& result)
+    {
+        for (uint64_t i = 0; i < batchNum; i++) {
+            shared_ptr<BenchBatch> batch = make_shared<BenchBatch>();
+            batch->index = i;
+            batch->preStartNs = BenchNowNs();
+            batch->input = inputs[i % inputs.size()];
+            HostCost(preUs, busy);
+            result.preIntervals.push_back({batch->preStartNs, BenchNowNs()});
+            while (!queue.WaitPush(batch, kWaitMs)) {
+            }
+        }
+    }
+
+    class InferRunner {
+    public:
+        InferRunner(AclLiteModel& model, size_t inputSize, uint32_t slotNum, uint64_t hostUs, bool busy,
+                    CaseResult& result)
+            : model_(model), inputSize_(inputSize), slotNum_(slotNum), hostUs_(hostUs), busy_(busy),
+              result_(result) {}
+
+        // the same order as DetectInferenceThread: launch while a slot is free, finish the
+        // oldest slot when every slot is in flight or no batch is waiting
+        AclLiteError Run(BatchQueue& queue, uint64_t batchNum)
+        {
+            uint64_t receivedNum = 0;
+            while ((receivedNum < batchNum) || !inFlight_.empty()) {
+                shared_ptr<BenchBatch> batch = nullptr;
+                if (receivedNum < batchNum) {
+                    batch = inFlight_.empty() ? queue.WaitPop(kWaitMs) : queue.Pop();
+                }
+                if (batch == nullptr) {
+                    if (!inFlight_.empty() && (FinishOldest() != ACLLITE_OK)) {
+                        return ACLLITE_ERROR;
+                    }
+                    continue;
+                }
+                receivedNum++;
+                uint64_t hostStartNs = BenchNowNs();
+                HostCost(hostUs_, busy_);
+                result_.hostIntervals.push_back({hostStartNs, BenchNowNs()});
+                AclLiteError ret = (slotNum_ == 0) ? Execute(batch) : Launch(batch);
+                if (ret != ACLLITE_OK) {
+                    return ret;
+                }
+            }
+            return ACLLITE_OK;
+        }
+
+    private:
+        struct InFlight {
+            uint32_t slot;
+            uint64_t launchNs;
+            shared_ptr<BenchBatch> batch;
+        };
+
+        // the input dataset is created and destroyed for every batch as ModelExecute does
+        AclLiteError Execute(shared_ptr<BenchBatch> batch)
+        {
+            uint64_t startNs = BenchNowNs();
+            vector<InferenceOutput> outputs;
+            AclLiteError ret = model_.CreateInput(batch->input, inputSize_);
+            if (ret == ACLLITE_OK) {
+                ret = model_.ExecuteV2(outputs);
+            }
+            model_.DestroyInput();
+            uint64_t endNs = BenchNowNs();
+            result_.deviceIntervals.push_back({startNs, endNs});
+            result_.latencyNs.push_back(endNs - batch->preStartNs);
+            return ret;
+        }
+
+        AclLiteError Launch(shared_ptr<BenchBatch> batch)
+        {
+            if ((inFlight_.size() == slotNum_) && (FinishOldest() != ACLLITE_OK)) {
+                return ACLLITE_ERROR;
+            }
+            uint32_t slot = nextSlot_;
+            nextSlot_ = (nextSlot_ + 1) % slotNum_;
+            vector<DataInfo> inputData = {{batch->input, (uint32_t)inputSize_}};
+            uint64_t launchNs = BenchNowNs();
+            AclLiteError ret = model_.ExecuteAsync(slot, inputData);
+            if (ret != ACLLITE_OK) {
+                return ret;
+            }
+            inFlight_.push_back({slot, launchNs, batch});
+            return ACLLITE_OK;
+        }
+
+        AclLiteError FinishOldest()
+        {
+            InFlight oldest = inFlight_.front();
+            inFlight_.pop_front();
+            vector<InferenceOutput> outputs;
+            AclLiteError ret = model_.WaitAsync(oldest.slot, outputs);
+            uint64_t endNs = BenchNowNs();
+            result_.deviceIntervals.push_back({oldest.launchNs, endNs});
+            result_.latencyNs.push_back(endNs - oldest.batch->preStartNs);
+            return ret;
+        }
+
+    private:
+        AclLiteModel& model_;
+        size_t inputSize_;
+        uint32_t slotNum_;
+        uint64_t hostUs_;
+        bool busy_;
+        CaseResult& result_;
+        deque<InFlight> inFlight_;
+        uint32_t nextSlot_ = 0;
+    };
+
+    int RunCase(uint32_t slotNum, uint64_t batchNum, uint64_t preUs, uint64_t hostUs, bool busy,
+                aclrtContext context)
+    {
+        AclLiteModel model("bench.om");
+        if ((model.Init() != ACLLITE_OK) || ((slotNum > 0) && (model.InitAsync(slotNum) != ACLLITE_OK))) {
+            ACLLITE_LOG_ERROR("Init model with %u async slots failed", slotNum);
+            return 1;
+        }
+        size_t inputSize = model.GetModelInputSize(0);
+        vector<void*> inputs(kQueueSize + slotNum + kInputRingExtra, nullptr);
+        for (void*& input : inputs) {
+            if (aclrtMalloc(&input, inputSize, ACL_MEM_MALLOC_NORMAL_ONLY) != ACL_SUCCESS) {
+                ACLLITE_LOG_ERROR("Malloc model input of %zu bytes failed", inputSize);
+                return 1;
+            }
+        }
+        BatchQueue queue(kQueueSize);
+        CaseResult result;
+        uint64_t startNs = BenchNowNs();
+        thread preprocess([&]() {
+            (void)aclrtSetCurrentContext(context);
+            PreprocessRun(queue, inputs, batchNum, preUs, busy, result);
+        });
+        InferRunner runner(model, inputSize, slotNum, hostUs, busy, result);
+        AclLiteError ret = runner.Run(queue, batchNum);
+        preprocess.join();
+        uint64_t totalNs = BenchNowNs() - startNs;
+        for (void* input : inputs) {
+            (void)aclrtFree(input);
+        }
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Inference with %u async slots failed, error %d", slotNum, ret);
+            return 1;
+        }
+
+        const double nsPerSec = 1e9;
+        const double percent = 100.0;
+        string name = (slotNum == 0) ? "sync" : ("async " + to_string(slotNum) + " slots");
+        BenchPrintLatency(name + " latency", result.latencyNs);
+        printf("%-28s %.1f batches/s, preprocess %.0f%% and inference host work %.0f%% "
+               "done while the device executes\n", name.c_str(), batchNum * nsPerSec / totalNs,
+               OverlapNs(result.preIntervals, result.deviceIntervals) * percent / TotalNs(result.preIntervals),
+               OverlapNs(result.hostIntervals, result.deviceIntervals) * percent / TotalNs(result.hostIntervals));
+        return 0;
+    }
+}
+
+// usage: async_infer_bench [batch num] [preprocess us] [inference host us] [device us]
+int main(int argc, char* argv[])
+{
+    uint64_t batchNum = BenchArg(argc, argv, 1, kDefaultBatchNum);
+    uint64_t preUs = BenchArg(argc, argv, 2, kDefaultPreUs);
+    uint64_t hostUs = BenchArg(argc, argv, 3, kDefaultHostUs);
+    uint64_t deviceUs = BenchArg(argc, argv, 4, kDefaultDeviceUs);
+    if (batchNum == 0) {
+        printf("usage: %s [batch num] [preprocess us] [inference host us] [device us]\n", argv[0]);
+        return 1;
+    }
+    // the stand-in runtime of the Host_ACL target sleeps this long in every execution
+    (void)setenv("HOSTACL_INFER_LATENCY_US", to_string(deviceUs).c_str(), 1);
+    (void)setenv("HOSTACL_INFER_IMAGE_LATENCY_US", "0", 1);
+
+    AclLiteResource aclDev;
+    if (aclDev.Init() != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Init acl resource failed");
+        return 1;
+    }
+    long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+    bool busy = (cpuNum > 2);
+    printf("%lu batches, preprocess %lu us, inference host work %lu us, device %lu us per batch, "
+           "%s (%ld cpus)\n", batchNum, preUs, hostUs, deviceUs,
+           busy ? "busy on the cpu" : "sleep for the host work", cpuNum);
+    for (uint32_t slotNum : kSlotNums) {
+        if (RunCase(slotNum, batchNum, preUs, hostUs, busy, aclDev.GetContext()) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
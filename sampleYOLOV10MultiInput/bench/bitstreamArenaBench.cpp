@@ -0,0 +1,180 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File bitstreamArenaBench.cpp
+* Description: packets per second the demux thread hands to vdec, the packets
+* written to the bitstream arena against a dvpp pool buffer or a dvpp malloc per
+* packet, with a synthetic GOP and the packets released in order as vdec returns them
+*/
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include "acl/acl.h"
+#include "acl/ops/acl_dvpp.h"
+#include "AclLiteUtils.h"
+#include "AclLiteMemPool.h"
+#include "BitstreamArena.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint64_t kDefaultPacketNum = 20000;
+    const uint64_t kDefaultInFlightNum = 8;  // the packets vdec holds before the callback
+    const uint32_t kGopSize = 25;
+    const uint32_t kIFrameSize = 150 * 1024;
+    const uint32_t kPFrameSize = 15 * 1024;
+    const uint64_t kDefaultArenaMb = 8;  // kBitstreamArenaSize of VideoCapture
+    const uint32_t kArenaWaitMs = 1000;
+    const uint32_t kSeed = 12345;
+
+    enum BenchMode {
+        MODE_ARENA = 0,
+        MODE_POOL,
+        MODE_MALLOC,
+    };
+
+    // an I frame every kGopSize packets, the P frames vary by +-50%
+    vector<uint32_t> CreatePacketSizes(uint64_t packetNum)
+    {
+        vector<uint32_t> sizes;
+        srand(kSeed);
+        for (uint64_t i = 0; i < packetNum; i++) {
+            if (i % kGopSize == 0) {
+                sizes.push_back(kIFrameSize);
+            } else {
+                sizes.push_back(kPFrameSize / 2 + rand() % kPFrameSize);
+            }
+        }
+        return sizes;
+    }
+
+    void* WritePacket(BenchMode mode, BitstreamArena& arena, const uint8_t* data,
+                      uint32_t size, aclrtRunMode runMode)
+    {
+        if (mode == MODE_ARENA) {
+            void* buffer = nullptr;
+            return (arena.Write(data, size, buffer, kArenaWaitMs) == ACLLITE_OK) ? buffer : nullptr;
+        }
+        if (mode == MODE_POOL) {
+            return CopyDataToDevice(data, size, runMode, MEMORY_DVPP);
+        }
+        // the copy of every packet before the arena and the pool
+        void* buffer = nullptr;
+        if (acldvppMalloc(&buffer, size) != ACL_SUCCESS) {
+            return nullptr;
+        }
+        aclrtMemcpyKind kind = (runMode == ACL_HOST) ? ACL_MEMCPY_HOST_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_DEVICE;
+        if (aclrtMemcpy(buffer, size, data, size, kind) != ACL_SUCCESS) {
+            (void)acldvppFree(buffer);
+            return nullptr;
+        }
+        return buffer;
+    }
+
+    void ReleasePacket(BenchMode mode, BitstreamArena& arena, void* buffer)
+    {
+        if (mode == MODE_ARENA) {
+            (void)arena.Release(buffer);
+        } else if (mode == MODE_POOL) {
+            AclLiteMemPool::GetDvppPool().Free(buffer);
+        } else {
+            (void)acldvppFree(buffer);
+        }
+    }
+
+    int RunCase(const string& name, BenchMode mode, const vector<uint32_t>& sizes,
+                uint32_t inFlightNum, uint32_t arenaSize, aclrtRunMode runMode)
+    {
+        BitstreamArena arena(arenaSize, runMode);
+        if ((mode == MODE_ARENA) && (arena.Init() != ACLLITE_OK)) {
+            ACLLITE_LOG_ERROR("Init bitstream arena failed");
+            return 1;
+        }
+        // the demuxed packet is in host memory, as the bsf output of ffmpeg
+        vector<uint8_t> packet(kIFrameSize * 2, 0x5a);
+        deque<void*> inFlight;
+        vector<uint64_t> writeNs;
+        uint64_t totalBytes = 0;
+        uint64_t cpuStartUs = BenchThreadCpuUs();
+        uint64_t startNs = BenchNowNs();
+        for (uint32_t size : sizes) {
+            uint64_t writeStartNs = BenchNowNs();
+            void* buffer = WritePacket(mode, arena, packet.data(), size, runMode);
+            writeNs.push_back(BenchNowNs() - writeStartNs);
+            if (buffer == nullptr) {
+                ACLLITE_LOG_ERROR("Write packet of %u bytes failed", size);
+                return 1;
+            }
+            totalBytes += size;
+            inFlight.push_back(buffer);
+            if (inFlight.size() > inFlightNum) {
+                ReleasePacket(mode, arena, inFlight.front());
+                inFlight.pop_front();
+            }
+        }
+        while (!inFlight.empty()) {
+            ReleasePacket(mode, arena, inFlight.front());
+            inFlight.pop_front();
+        }
+        uint64_t totalNs = BenchNowNs() - startNs;
+        uint64_t cpuUs = BenchThreadCpuUs() - cpuStartUs;
+
+        const double nsPerSec = 1e9;
+        const double bytesPerMb = 1024.0 * 1024.0;
+        BenchPrintLatency(name + " write", writeNs);
+        printf("%-28s %lu packets, %.0f packets/s, %.1f MB/s, cpu %.2f us/packet\n", name.c_str(),
+               sizes.size(), sizes.size() * nsPerSec / totalNs, totalBytes * nsPerSec / totalNs / bytesPerMb,
+               (double)cpuUs / sizes.size());
+        return 0;
+    }
+}
+
+// usage: bitstream_arena_bench [packet num] [packets in vdec] [arena MB]
+int main(int argc, char* argv[])
+{
+    uint64_t packetNum = BenchArg(argc, argv, 1, kDefaultPacketNum);
+    uint32_t inFlightNum = BenchArg(argc, argv, 2, kDefaultInFlightNum);
+    uint64_t arenaMb = BenchArg(argc, argv, 3, kDefaultArenaMb);
+    const uint32_t bytesPerMb = 1024 * 1024;
+    if ((packetNum == 0) || (inFlightNum == 0) || (arenaMb == 0) || (arenaMb > UINT32_MAX / bytesPerMb)) {
+        printf("usage: %s [packet num] [packets in vdec] [arena MB]\n", argv[0]);
+        return 1;
+    }
+    if (aclInit(nullptr) != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Acl init failed");
+        return 1;
+    }
+    aclrtRunMode runMode;
+    if ((aclrtSetDevice(0) != ACL_SUCCESS) || (aclrtGetRunMode(&runMode) != ACL_SUCCESS)) {
+        ACLLITE_LOG_ERROR("Set device failed");
+        return 1;
+    }
+    printf("%lu packets, an I frame of %u bytes every %u packets, %u packets in vdec, arena %lu MB, run mode %s\n",
+           packetNum, kIFrameSize, kGopSize, inFlightNum, arenaMb, (runMode == ACL_HOST) ? "host" : "device");
+    uint32_t arenaSize = arenaMb * bytesPerMb;
+    vector<uint32_t> sizes = CreatePacketSizes(packetNum);
+    int ret = RunCase("malloc per packet", MODE_MALLOC, sizes, inFlightNum, arenaSize, runMode);
+    ret = (ret == 0) ? RunCase("dvpp pool", MODE_POOL, sizes, inFlightNum, arenaSize, runMode) : ret;
+    ret = (ret == 0) ? RunCase("bitstream arena", MODE_ARENA, sizes, inFlightNum, arenaSize, runMode) : ret;
+    AclLiteMemPool::GetDvppPool().Release();
+    (void)aclrtResetDevice(0);
+    (void)aclFinalize();
+    return ret;
+}
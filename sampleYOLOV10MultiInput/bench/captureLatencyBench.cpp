@@ -0,0 +1,149 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File captureLatencyBench.cpp
+* Description: age of the frame read by a slow reader in the queue and latest
+* capture modes, a live source producing at its frame rate, and the frames a
+* file in latest mode delivers with and without pacing to its frame rate
+*/
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "AclLiteVideoCapBase.h"
+#include "ThreadSafeQueue.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kWaitMs = 100;
+    const uint32_t kQueueSize = 256;  // kDecodeFrameQueueSize of VideoCapture
+    const uint32_t kReadSlow = 5;  // demux is held while more frames are queued
+    const uint64_t kDefaultFrameNum = 250;
+    const uint64_t kDefaultFps = 25;
+    const uint64_t kDefaultReadMs = 60;
+    const uint64_t kFileDecodeUs = 1000;  // demux and decode of one file frame
+
+    struct BenchFrame {
+        uint64_t sourceNs = 0;  // the time the frame is due at the source
+    };
+    using FrameQueue = ThreadSafeQueue<shared_ptr<BenchFrame>>;
+
+    enum SourceType {
+        SOURCE_LIVE = 0,  // the camera produces at its rate, a held demux delays the frames
+        SOURCE_FILE,  // unpaced, demux runs as fast as decode
+        SOURCE_FILE_PACED  // FramePacer holds demux to the frame rate
+    };
+
+    struct CaseResult {
+        vector<uint64_t> ageNs;  // source time to read
+        uint64_t overwrittenNum = 0;
+        uint64_t totalNs = 0;
+    };
+
+    void ProduceRun(FrameQueue& queue, bool latest, SourceType source, uint64_t frameNum,
+                    uint64_t fps, atomic<bool>& produceEnd, CaseResult& result)
+    {
+        const uint64_t intervalNs = 1000000000 / fps;
+        FramePacer pacer;
+        pacer.Init((int)fps);
+        uint64_t startNs = BenchNowNs();
+        for (uint64_t i = 0; i < frameNum; i++) {
+            shared_ptr<BenchFrame> frame = make_shared<BenchFrame>();
+            if (source == SOURCE_LIVE) {
+                frame->sourceNs = startNs + i * intervalNs;
+                uint64_t nowNs = BenchNowNs();
+                if (frame->sourceNs > nowNs) {
+                    usleep((frame->sourceNs - nowNs) / 1000);
+                }
+            } else {
+                usleep(kFileDecodeUs);
+                if (source == SOURCE_FILE_PACED) {
+                    pacer.Wait();
+                }
+                frame->sourceNs = BenchNowNs();
+            }
+            if (latest) {
+                if (queue.ForcePush(frame) != nullptr) {
+                    result.overwrittenNum++;
+                }
+                continue;
+            }
+            // the same hold as SleeptoNextFrameTime in queue mode
+            while (!queue.WaitSizeBelow(kReadSlow + 1, kWaitMs)) {
+            }
+            (void)queue.Push(frame);
+        }
+        produceEnd.store(true);
+    }
+
+    // the reader takes readMs per frame like a loaded pipeline
+    void ReadRun(FrameQueue& queue, uint64_t readMs, atomic<bool>& produceEnd, CaseResult& result)
+    {
+        while (true) {
+            shared_ptr<BenchFrame> frame = queue.WaitPop(kWaitMs);
+            if (frame == nullptr) {
+                if (produceEnd.load() && queue.Empty()) {
+                    break;
+                }
+                continue;
+            }
+            result.ageNs.push_back(BenchNowNs() - frame->sourceNs);
+            usleep(readMs * 1000);
+        }
+    }
+
+    void RunCase(const string& name, bool latest, SourceType source, uint64_t frameNum,
+                 uint64_t fps, uint64_t readMs)
+    {
+        FrameQueue queue(latest ? 1 : kQueueSize);
+        atomic<bool> produceEnd(false);
+        CaseResult result;
+        uint64_t startNs = BenchNowNs();
+        thread producer(ProduceRun, ref(queue), latest, source, frameNum, fps, ref(produceEnd), ref(result));
+        thread reader(ReadRun, ref(queue), readMs, ref(produceEnd), ref(result));
+        producer.join();
+        reader.join();
+        result.totalNs = BenchNowNs() - startNs;
+
+        const double nsPerSec = 1e9;
+        BenchPrintLatency(name + " age", result.ageNs);
+        printf("%-28s read %lu of %lu frames, overwritten %lu, %.2f s (source %.2f s)\n",
+               name.c_str(), result.ageNs.size(), frameNum, result.overwrittenNum,
+               result.totalNs / nsPerSec, (double)frameNum / fps);
+    }
+}
+
+// usage: capture_latency_bench [frame num] [source fps] [read ms per frame]
+int main(int argc, char* argv[])
+{
+    uint64_t frameNum = BenchArg(argc, argv, 1, kDefaultFrameNum);
+    uint64_t fps = BenchArg(argc, argv, 2, kDefaultFps);
+    uint64_t readMs = BenchArg(argc, argv, 3, kDefaultReadMs);
+    if ((frameNum == 0) || (fps == 0)) {
+        printf("usage: %s [frame num] [source fps] [read ms per frame]\n", argv[0]);
+        return 1;
+    }
+    printf("%lu frames at %lu fps, the reader takes %lu ms per frame\n", frameNum, fps, readMs);
+    RunCase("live queue", false, SOURCE_LIVE, frameNum, fps, readMs);
+    RunCase("live latest", true, SOURCE_LIVE, frameNum, fps, readMs);
+    RunCase("file latest unpaced", true, SOURCE_FILE, frameNum, fps, readMs);
+    RunCase("file latest paced", true, SOURCE_FILE_PACED, frameNum, fps, readMs);
+    return 0;
+}
@@ -0,0 +1,214 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File h264EncodeBench.cpp
+* Description: cost of the output thread per frame and the encode rate of the
+* h264file output (dvpp venc or libx264) against the old opencv mp4v video output
+*/
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "opencv2/opencv.hpp"
+#include "opencv2/imgproc/types_c.h"
+#include "AclLiteResource.h"
+#include "AclLiteUtils.h"
+#include "AclLiteVideoProc.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint64_t kDefaultFrameNum = 300;
+    const uint64_t kDefaultWidth = 1280;
+    const uint64_t kDefaultHeight = 720;
+    const uint32_t kFrameRingNum = 8;  // distinct synthetic frames fed in turn
+    const uint32_t kOldOutputWidth = 640;  // kOutputWidth of the old video output
+    const uint32_t kOldOutputHeight = 320;
+    const double kOldOutputFps = 25;
+
+    // a moving gradient, so the encoder does not see a static picture
+    void FillNv12(uint8_t* data, uint32_t width, uint32_t height, uint32_t index)
+    {
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                data[y * width + x] = (uint8_t)(x + y + index * 8);
+            }
+        }
+        uint8_t* uv = data + width * height;
+        for (uint32_t y = 0; y < height / 2; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uv[y * width + x] = (uint8_t)(128 + ((x >> 4) + index) % 32);
+            }
+        }
+    }
+
+    // the frames are in dvpp memory as decoded by vdec, or in host memory
+    bool CreateFrames(vector<ImageData>& frames, uint32_t width, uint32_t height,
+                      bool isDvpp, aclrtRunMode runMode)
+    {
+        uint32_t size = YUV420SP_SIZE(width, height);
+        vector<uint8_t> host(size);
+        for (uint32_t i = 0; i < kFrameRingNum; i++) {
+            ImageData frame;
+            frame.format = PIXEL_FORMAT_YUV_SEMIPLANAR_420;
+            frame.width = width;
+            frame.height = height;
+            frame.alignWidth = width;
+            frame.alignHeight = height;
+            frame.size = size;
+            FillNv12(host.data(), width, height, i);
+            if (isDvpp) {
+                void* buffer = nullptr;
+                if (acldvppMalloc(&buffer, size) != ACL_SUCCESS) {
+                    return false;
+                }
+                aclrtMemcpyKind kind = (runMode == ACL_HOST) ?
+                                       ACL_MEMCPY_HOST_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_DEVICE;
+                if (aclrtMemcpy(buffer, size, host.data(), size, kind) != ACL_SUCCESS) {
+                    (void)acldvppFree(buffer);
+                    return false;
+                }
+                frame.data = SHARED_PTR_DVPP_BUF(buffer);
+                frame.memType = MEMORY_DVPP;
+            } else {
+                uint8_t* buffer = new uint8_t[size];
+                memcpy(buffer, host.data(), size);
+                frame.data = SHARED_PTR_U8_BUF(buffer);
+                frame.memType = MEMORY_NORMAL;
+            }
+            frames.push_back(frame);
+        }
+        return true;
+    }
+
+    uint64_t FileSize(const string& path)
+    {
+        struct stat fileStat;
+        return (stat(path.c_str(), &fileStat) == 0) ? fileStat.st_size : 0;
+    }
+
+    // the total time includes the encoder open and close, the encode queue is drained by close
+    void PrintResult(const string& name, vector<uint64_t>& callNs, uint64_t cpuUs,
+                     uint64_t totalNs, const string& outFile)
+    {
+        const double nsPerSec = 1e9;
+        const double usPerMs = 1000.0;
+        uint64_t frameNum = callNs.size();
+        BenchPrintLatency(name + " call", callNs);
+        printf("%-28s %lu frames in %.2f s, %.1f fps, caller cpu %.3f ms/frame, file %lu bytes\n",
+               name.c_str(), frameNum, totalNs / nsPerSec, frameNum * nsPerSec / totalNs,
+               (frameNum > 0) ? cpuUs / usPerMs / frameNum : 0, FileSize(outFile));
+    }
+
+    // the h264file output: the NV12 frame is handed to the encoder
+    int RunH264(const string& mode, uint64_t frameNum, uint32_t width, uint32_t height,
+                AclLiteResource& aclDev)
+    {
+        vector<ImageData> frames;
+        bool isDvpp = (mode == "dvpp");
+        if (!CreateFrames(frames, width, height, isDvpp, aclDev.GetRunMode())) {
+            ACLLITE_LOG_ERROR("Create %s frames failed", mode.c_str());
+            return 1;
+        }
+        VencConfig vencConfig;
+        vencConfig.maxWidth = width;
+        vencConfig.maxHeight = height;
+        vencConfig.outFile = "bench_" + mode + ".h264";
+        vencConfig.runMode = aclDev.GetRunMode();
+        vencConfig.context = aclDev.GetContext();
+        vencConfig.swEncode = !isDvpp;
+
+        uint64_t startNs = BenchNowNs();
+        AclLiteVideoProc writer(vencConfig, vencConfig.context);
+        if (!writer.IsOpened()) {
+            ACLLITE_LOG_ERROR("Open %s encoder failed", mode.c_str());
+            return 1;
+        }
+        vector<uint64_t> callNs;
+        uint64_t cpuStartUs = BenchThreadCpuUs();
+        for (uint64_t i = 0; i < frameNum; i++) {
+            uint64_t callStartNs = BenchNowNs();
+            if (writer.Read(frames[i % frames.size()]) != ACLLITE_OK) {
+                ACLLITE_LOG_ERROR("Encode frame %lu failed", i);
+                return 1;
+            }
+            callNs.push_back(BenchNowNs() - callStartNs);
+        }
+        uint64_t cpuUs = BenchThreadCpuUs() - cpuStartUs;
+        // the queued frames are encoded before close returns
+        (void)writer.Close();
+        PrintResult(mode, callNs, cpuUs, BenchNowNs() - startNs, vencConfig.outFile);
+        return 0;
+    }
+
+    // the old video output: NV12 to BGR, resize to 640x320 and write mp4v by opencv
+    int RunOpencv(uint64_t frameNum, uint32_t width, uint32_t height)
+    {
+        vector<cv::Mat> frames;
+        for (uint32_t i = 0; i < kFrameRingNum; i++) {
+            cv::Mat nv12(height * 3 / 2, width, CV_8UC1);
+            FillNv12(nv12.data, width, height, i);
+            frames.push_back(nv12);
+        }
+        string outFile = "bench_opencv.mp4";
+        uint64_t startNs = BenchNowNs();
+        cv::VideoWriter writer;
+        if (!writer.open(outFile, cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+                         kOldOutputFps, cv::Size(kOldOutputWidth, kOldOutputHeight))) {
+            ACLLITE_LOG_ERROR("Open opencv video writer failed");
+            return 1;
+        }
+        vector<uint64_t> callNs;
+        uint64_t cpuStartUs = BenchThreadCpuUs();
+        cv::Mat bgr;
+        for (uint64_t i = 0; i < frameNum; i++) {
+            uint64_t callStartNs = BenchNowNs();
+            cv::cvtColor(frames[i % frames.size()], bgr, CV_YUV2BGR_NV12);
+            cv::resize(bgr, bgr, cv::Size(kOldOutputWidth, kOldOutputHeight), 0, 0, cv::INTER_LINEAR);
+            writer << bgr;
+            callNs.push_back(BenchNowNs() - callStartNs);
+        }
+        uint64_t cpuUs = BenchThreadCpuUs() - cpuStartUs;
+        writer.release();
+        PrintResult("opencv", callNs, cpuUs, BenchNowNs() - startNs, outFile);
+        return 0;
+    }
+}
+
+// usage: h264_encode_bench [dvpp|sw|opencv] [frame num] [width] [height]
+int main(int argc, char* argv[])
+{
+    string mode = (argc > 1) ? argv[1] : "sw";
+    uint64_t frameNum = BenchArg(argc, argv, 2, kDefaultFrameNum);
+    uint32_t width = ALIGN_UP16(BenchArg(argc, argv, 3, kDefaultWidth));
+    uint32_t height = ALIGN_UP2(BenchArg(argc, argv, 4, kDefaultHeight));
+    if (mode == "opencv") {
+        return RunOpencv(frameNum, width, height);
+    }
+    if ((mode != "dvpp") && (mode != "sw")) {
+        printf("usage: %s [dvpp|sw|opencv] [frame num] [width] [height]\n", argv[0]);
+        return 1;
+    }
+
+    AclLiteResource aclDev;
+    if (aclDev.Init() != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Init acl resource failed");
+        return 1;
+    }
+    return RunH264(mode, frameNum, width, height, aclDev);
+}
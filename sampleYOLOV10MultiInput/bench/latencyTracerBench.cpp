@@ -0,0 +1,98 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File latencyTracerBench.cpp
+* Description: cost per frame of the latency trace, the stamps of all the stages
+* and the record of the output stage, with the tracer disabled and enabled
+*/
+#include <string>
+#include <thread>
+#include <vector>
+#include "LatencyTracer.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint64_t kDefaultFrameNum = 1000000;
+    const uint64_t kDefaultThreadNum = 4;
+    const uint32_t kStageNum = 7;  // STAGE_NUM of Params.h
+    const vector<string> kStageNames = {
+        "decode", "pre_enqueue", "pre_done", "infer_enqueue", "infer_done", "post_done", "output"
+    };
+
+    struct BenchMsg {
+        bool isLastFrame = false;
+        uint64_t stageTimeUs[kStageNum] = {0};
+    };
+
+    // the same check as StampFrameStage of Params.h
+    inline void Stamp(BenchMsg& msg, uint32_t stage)
+    {
+        if (LatencyTracer::IsEnabled() && !msg.isLastFrame) {
+            msg.stageTimeUs[stage] = LatencyTracer::NowUs();
+        }
+    }
+
+    // one frame through all the stages as the pipeline threads stamp it, then the output record
+    void RunFrames(uint32_t channelId, uint64_t frameNum)
+    {
+        for (uint64_t i = 0; i < frameNum; i++) {
+            BenchMsg msg;
+            for (uint32_t stage = 0; stage < kStageNum; stage++) {
+                Stamp(msg, stage);
+            }
+            if (LatencyTracer::IsEnabled() && (msg.stageTimeUs[kStageNum - 1] != 0)) {
+                LatencyTracer::GetInstance().Record(channelId, (int)i, msg.stageTimeUs);
+            }
+        }
+    }
+
+    // every thread is the output thread of one channel, they share the tracer lock
+    void RunCase(const string& name, uint64_t frameNum, uint32_t threadNum)
+    {
+        uint64_t frameNumPerThread = frameNum / threadNum;
+        vector<thread> threads;
+        uint64_t startNs = BenchNowNs();
+        for (uint32_t i = 0; i < threadNum; i++) {
+            threads.emplace_back(RunFrames, i, frameNumPerThread);
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        uint64_t totalNs = BenchNowNs() - startNs;
+        uint64_t totalFrameNum = frameNumPerThread * threadNum;
+        printf("%-28s threads %2u  %9lu frames  %8.1f ns/frame  %6.2f Mframes/s\n",
+               name.c_str(), threadNum, totalFrameNum, (double)totalNs / totalFrameNum,
+               totalFrameNum * 1000.0 / totalNs);
+    }
+}
+
+// usage: latency_tracer_bench [frame num] [thread num]
+int main(int argc, char* argv[])
+{
+    uint64_t frameNum = BenchArg(argc, argv, 1, kDefaultFrameNum);
+    uint32_t threadNum = BenchArg(argc, argv, 2, kDefaultThreadNum);
+    threadNum = (threadNum == 0) ? 1 : threadNum;
+
+    RunCase("disabled", frameNum, 1);
+    RunCase("disabled", frameNum, threadNum);
+    // without a trace file only the histograms are updated
+    LatencyTracer::GetInstance().Enable(kStageNames, "", 0);
+    RunCase("enabled", frameNum, 1);
+    RunCase("enabled", frameNum, threadNum);
+    return 0;
+}
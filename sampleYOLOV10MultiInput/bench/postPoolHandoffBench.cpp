@@ -0,0 +1,302 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File postPoolHandoffBench.cpp
+* Description: throughput and latency of the channels when the postprocess cost
+* of one channel is high, static per channel postprocess threads against the
+* shared pool, then the latency of the pool when the output of one channel is
+* slow, the workers waiting for the full output queue as before, or handing the
+* results to the MsgBacklog
+*/
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "MsgBacklog.h"
+#include "ThreadSafeQueue.h"
+#include "WorkStealingPool.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kWaitMs = 100;  // kSendTimeoutMs of the old handoff
+    const uint32_t kSinkQueueSize = 16;
+    const size_t kMaxOutputBacklog = 32;  // the same as DetectPostprocessPool
+    const uint64_t kDefaultMsgNum = 100;  // per channel
+    const uint64_t kDefaultChannelNum = 8;
+    const uint64_t kDefaultWorkerNum = 4;
+    const uint64_t kDefaultSlowSinkMs = 60;
+    const uint64_t kDefaultHeavyPostMs = 60;  // more than the frame interval, one thread can not keep up
+    const uint32_t kPostQueueSize = 3;  // kMsgQueueSize of the postprocess threads
+    const uint64_t kFrameIntervalUs = 40000;  // 25 fps per channel
+    const uint64_t kPostprocessUs = 1000;  // cpu time of one postprocess task
+    const uint32_t kSlowChannel = 0;
+
+    struct BenchMsg {
+        uint32_t channelId = 0;
+        uint64_t submitNs = 0;
+    };
+    using SinkQueue = ThreadSafeQueue<shared_ptr<BenchMsg>>;
+
+    struct ChannelResult {
+        vector<uint64_t> latencyNs;  // submit to output
+        uint64_t finishNs = 0;
+    };
+
+    void BusyWait(uint64_t us)
+    {
+        uint64_t endNs = BenchNowNs() + us * 1000;
+        while (BenchNowNs() < endNs) {
+        }
+    }
+
+    // the output thread of one channel, the slow one is an encoder or rtsp behind,
+    // the stolen tasks finish out of order so the messages are counted
+    void SinkRun(SinkQueue& queue, uint64_t msgNum, uint64_t delayMs, ChannelResult& result)
+    {
+        while (result.latencyNs.size() < msgNum) {
+            shared_ptr<BenchMsg> msg = queue.WaitPop(kWaitMs);
+            if (msg == nullptr) {
+                continue;
+            }
+            result.latencyNs.push_back(BenchNowNs() - msg->submitNs);
+            if (delayMs > 0) {
+                usleep(delayMs * 1000);
+            }
+        }
+        result.finishNs = BenchNowNs();
+    }
+
+    // the inference thread of one channel submits its frames at the frame rate
+    void ProduceRun(WorkStealingPool& pool, MsgBacklog* backlog, vector<unique_ptr<SinkQueue>>& sinks,
+                    uint32_t channelId, uint64_t msgNum)
+    {
+        for (uint64_t i = 0; i < msgNum; i++) {
+            shared_ptr<BenchMsg> msg = make_shared<BenchMsg>();
+            msg->channelId = channelId;
+            if (backlog != nullptr) {
+                while (!backlog->WaitBelow(channelId, kMaxOutputBacklog, kWaitMs)) {
+                }
+            }
+            msg->submitNs = BenchNowNs();
+            (void)pool.Submit([backlog, &sinks, msg](uint32_t) {
+                BusyWait(kPostprocessUs);
+                if (backlog != nullptr) {
+                    (void)backlog->Send(msg->channelId, msg->channelId, 0, msg);
+                    return;
+                }
+                while (!sinks[msg->channelId]->WaitPush(msg, kWaitMs)) {
+                }
+            }, channelId);
+            usleep(kFrameIntervalUs);
+        }
+    }
+
+    // the postprocess cost, busy on the cpu when every worker has a cpu, otherwise a sleep
+    // stands for it, so the scheduling and not the cpu number of this machine is measured
+    void PostprocessCost(uint64_t us, bool busy)
+    {
+        if (busy) {
+            BusyWait(us);
+        } else {
+            usleep(us);
+        }
+    }
+
+    struct SkewResult {
+        mutex lock;
+        vector<uint64_t> latencyNs;  // source time of the frame to the end of postprocess
+        uint64_t finishNs = 0;
+    };
+
+    void RecordSkew(SkewResult& result, uint64_t sourceNs)
+    {
+        uint64_t nowNs = BenchNowNs();
+        lock_guard<mutex> guard(result.lock);
+        result.latencyNs.push_back(nowNs - sourceNs);
+        result.finishNs = max(result.finishNs, nowNs);
+    }
+
+    using PostQueue = ThreadSafeQueue<shared_ptr<BenchMsg>>;
+
+    // the postprocess thread of one channel, the messages are assigned by msgNum % postNum
+    void StaticPostRun(PostQueue& queue, uint64_t msgNum, uint64_t costUs, bool busy, SkewResult& result)
+    {
+        for (uint64_t i = 0; i < msgNum;) {
+            shared_ptr<BenchMsg> msg = queue.WaitPop(kWaitMs);
+            if (msg == nullptr) {
+                continue;
+            }
+            PostprocessCost(costUs, busy);
+            RecordSkew(result, msg->submitNs);
+            i++;
+        }
+    }
+
+    // the frames of one channel at the frame rate, the sender waits for a full queue
+    // of the static thread, the pool takes every task
+    void SkewProduceRun(WorkStealingPool* pool, PostQueue* queue, uint32_t channelId, uint64_t msgNum,
+                        uint64_t costUs, bool busy, SkewResult& result)
+    {
+        uint64_t startNs = BenchNowNs();
+        for (uint64_t i = 0; i < msgNum; i++) {
+            shared_ptr<BenchMsg> msg = make_shared<BenchMsg>();
+            msg->channelId = channelId;
+            msg->submitNs = startNs + i * kFrameIntervalUs * 1000;
+            uint64_t nowNs = BenchNowNs();
+            if (msg->submitNs > nowNs) {
+                usleep((msg->submitNs - nowNs) / 1000);
+            }
+            if (pool == nullptr) {
+                while (!queue->WaitPush(msg, kWaitMs)) {
+                }
+                continue;
+            }
+            (void)pool->Submit([msg, costUs, busy, &result](uint32_t) {
+                PostprocessCost(costUs, busy);
+                RecordSkew(result, msg->submitNs);
+            }, channelId);
+        }
+    }
+
+    void RunSkewCase(const string& name, bool usePool, uint64_t msgNum, uint32_t channelNum,
+                     uint32_t workerNum, uint64_t heavyPostMs, bool busy)
+    {
+        vector<unique_ptr<SkewResult>> results;
+        vector<unique_ptr<PostQueue>> queues;
+        for (uint32_t i = 0; i < channelNum; i++) {
+            results.push_back(unique_ptr<SkewResult>(new SkewResult()));
+            queues.push_back(unique_ptr<PostQueue>(new PostQueue(kPostQueueSize)));
+        }
+        WorkStealingPool pool;
+        if (usePool) {
+            (void)pool.Start(workerNum, "bench_post");
+        }
+        vector<thread> threads;
+        uint64_t startNs = BenchNowNs();
+        for (uint32_t i = 0; i < channelNum; i++) {
+            uint64_t costUs = (i == kSlowChannel) ? heavyPostMs * 1000 : kPostprocessUs;
+            if (!usePool) {
+                threads.emplace_back(StaticPostRun, ref(*queues[i]), msgNum, costUs, busy, ref(*results[i]));
+            }
+            threads.emplace_back(SkewProduceRun, usePool ? &pool : nullptr, queues[i].get(), i, msgNum,
+                                 costUs, busy, ref(*results[i]));
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        pool.Stop();
+
+        vector<uint64_t> lightLatencyNs;
+        uint64_t lightFinishNs = 0;
+        for (uint32_t i = 0; i < channelNum; i++) {
+            if (i == kSlowChannel) {
+                continue;
+            }
+            lightLatencyNs.insert(lightLatencyNs.end(), results[i]->latencyNs.begin(), results[i]->latencyNs.end());
+            lightFinishNs = max(lightFinishNs, results[i]->finishNs - startNs);
+        }
+        const double nsPerSec = 1e9;
+        uint64_t heavyFinishNs = results[kSlowChannel]->finishNs - startNs;
+        uint64_t totalFinishNs = max(lightFinishNs, heavyFinishNs);
+        BenchPrintLatency(name + " light channels", lightLatencyNs);
+        BenchPrintLatency(name + " heavy channel", results[kSlowChannel]->latencyNs);
+        printf("%-28s total %.1f frames/s, heavy channel %.1f frames/s, light channel %.1f frames/s\n",
+               name.c_str(), msgNum * channelNum * nsPerSec / totalFinishNs, msgNum * nsPerSec / heavyFinishNs,
+               msgNum * nsPerSec / lightFinishNs);
+    }
+
+    void RunCase(const string& name, bool useBacklog, uint64_t msgNum, uint32_t channelNum,
+                 uint32_t workerNum, uint64_t slowSinkMs)
+    {
+        vector<unique_ptr<SinkQueue>> sinks;
+        for (uint32_t i = 0; i < channelNum; i++) {
+            sinks.push_back(unique_ptr<SinkQueue>(new SinkQueue(kSinkQueueSize)));
+        }
+        MsgBacklog backlog([&sinks](int dest, int msgId, shared_ptr<void> data) {
+            return sinks[dest]->Push(static_pointer_cast<BenchMsg>(data)) ? ACLLITE_OK : ACLLITE_ERROR_ENQUEUE;
+        });
+        if (useBacklog) {
+            (void)backlog.Start("bench_backlog");
+        }
+        WorkStealingPool pool;
+        (void)pool.Start(workerNum, "bench_post");
+
+        vector<ChannelResult> results(channelNum);
+        vector<thread> threads;
+        uint64_t startNs = BenchNowNs();
+        for (uint32_t i = 0; i < channelNum; i++) {
+            uint64_t delayMs = (i == kSlowChannel) ? slowSinkMs : 0;
+            threads.emplace_back(SinkRun, ref(*sinks[i]), msgNum, delayMs, ref(results[i]));
+        }
+        for (uint32_t i = 0; i < channelNum; i++) {
+            MsgBacklog* handoff = useBacklog ? &backlog : nullptr;
+            threads.emplace_back(ProduceRun, ref(pool), handoff, ref(sinks), i, msgNum);
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        pool.Stop();
+        backlog.Stop();
+
+        vector<uint64_t> fastLatencyNs;
+        uint64_t fastFinishNs = 0;
+        for (uint32_t i = 0; i < channelNum; i++) {
+            if (i == kSlowChannel) {
+                continue;
+            }
+            fastLatencyNs.insert(fastLatencyNs.end(), results[i].latencyNs.begin(), results[i].latencyNs.end());
+            fastFinishNs = max(fastFinishNs, results[i].finishNs - startNs);
+        }
+        const double nsPerSec = 1e9;
+        BenchPrintLatency(name + " fast channels", fastLatencyNs);
+        BenchPrintLatency(name + " slow channel", results[kSlowChannel].latencyNs);
+        printf("%-28s fast channels finish %.2f s, slow channel finish %.2f s\n", name.c_str(),
+               fastFinishNs / nsPerSec, (results[kSlowChannel].finishNs - startNs) / nsPerSec);
+    }
+}
+
+// usage: post_pool_handoff_bench [msg num per channel] [channel num] [worker num] [slow output ms]
+//        [heavy postprocess ms]
+int main(int argc, char* argv[])
+{
+    uint64_t msgNum = BenchArg(argc, argv, 1, kDefaultMsgNum);
+    uint32_t channelNum = BenchArg(argc, argv, 2, kDefaultChannelNum);
+    uint32_t workerNum = BenchArg(argc, argv, 3, kDefaultWorkerNum);
+    uint64_t slowSinkMs = BenchArg(argc, argv, 4, kDefaultSlowSinkMs);
+    uint64_t heavyPostMs = BenchArg(argc, argv, 5, kDefaultHeavyPostMs);
+    if ((msgNum == 0) || (channelNum < 2)) {
+        printf("usage: %s [msg num per channel] [channel num >= 2] [worker num] [slow output ms] "
+               "[heavy postprocess ms]\n", argv[0]);
+        return 1;
+    }
+    long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+    bool busy = (cpuNum > (long)channelNum);
+    printf("%u channels x %lu frames at 25 fps, postprocess of channel %u takes %lu ms, the others %lu us, "
+           "%s (%ld cpus)\n", channelNum, msgNum, kSlowChannel, heavyPostMs, kPostprocessUs,
+           busy ? "busy on the cpu" : "sleep for the cost", cpuNum);
+    RunSkewCase("static post threads", false, msgNum, channelNum, workerNum, heavyPostMs, busy);
+    RunSkewCase("pool", true, msgNum, channelNum, workerNum, heavyPostMs, busy);
+
+    printf("%u channels x %lu frames at 25 fps, %u workers, output of channel %u takes %lu ms per frame\n",
+           channelNum, msgNum, workerNum, kSlowChannel, slowSinkMs);
+    RunCase("blocking send", false, msgNum, channelNum, workerNum, slowSinkMs);
+    RunCase("backlog", true, msgNum, channelNum, workerNum, slowSinkMs);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File queueLatencyBench.cpp
+* Description: enqueue to process latency of a pipeline of threads, polling the
+* queue with a 10ms sleep as AclLiteThreadMgr did before, or waiting on it
+*/
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include "ThreadSafeQueue.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kQueueSize = 64;
+    const uint32_t kPollSleepUs = 10000;  // the usleep of the old thread loop
+    const uint32_t kIdleTimeoutMs = 100;  // DEFAULT_IDLE_TIMEOUT_MS of AclLiteThread
+    const uint64_t kDefaultMsgNum = 250;
+    const uint64_t kDefaultIntervalUs = 20000;
+    const uint64_t kDefaultHopNum = 5;  // dataInput -> pre -> infer -> post -> dataOutput
+
+    struct BenchMsg {
+        uint64_t sendNs = 0;  // sent by the source
+        uint64_t enqueueNs = 0;  // pushed to the current hop
+        bool isLast = false;
+    };
+
+    struct HopResult {
+        vector<uint64_t> latencyNs;
+        uint64_t cpuUs = 0;
+        uint64_t emptyWakeups = 0;  // the loop ran without a message
+    };
+
+    BenchMsg* TakeMsg(ThreadSafeQueue<BenchMsg*>& queue, bool isPolling, HopResult& result)
+    {
+        while (true) {
+            BenchMsg* msg = nullptr;
+            if (isPolling) {
+                msg = queue.Pop();
+                if (msg == nullptr) {
+                    usleep(kPollSleepUs);
+                }
+            } else {
+                msg = queue.WaitPop(kIdleTimeoutMs);
+            }
+            if (msg != nullptr) {
+                return msg;
+            }
+            result.emptyWakeups++;
+        }
+    }
+
+    void HopRun(vector<unique_ptr<ThreadSafeQueue<BenchMsg*>>>& queues, uint32_t hop,
+                bool isPolling, HopResult& result, vector<uint64_t>& endToEndNs)
+    {
+        bool isTail = (hop + 1 == queues.size());
+        while (true) {
+            BenchMsg* msg = TakeMsg(*queues[hop], isPolling, result);
+            uint64_t now = BenchNowNs();
+            if (msg->isLast) {
+                if (!isTail) {
+                    (void)queues[hop + 1]->WaitPush(msg, kIdleTimeoutMs);
+                }
+                break;
+            }
+            result.latencyNs.push_back(now - msg->enqueueNs);
+            if (isTail) {
+                endToEndNs.push_back(now - msg->sendNs);
+                continue;
+            }
+            msg->enqueueNs = BenchNowNs();
+            while (!queues[hop + 1]->WaitPush(msg, kIdleTimeoutMs)) {
+            }
+        }
+        result.cpuUs = BenchThreadCpuUs();
+    }
+
+    void RunMode(bool isPolling, uint64_t msgNum, uint64_t intervalUs, uint32_t hopNum)
+    {
+        vector<unique_ptr<ThreadSafeQueue<BenchMsg*>>> queues;
+        for (uint32_t i = 0; i < hopNum; i++) {
+            queues.emplace_back(new ThreadSafeQueue<BenchMsg*>(kQueueSize));
+        }
+        vector<BenchMsg> msgs(msgNum + 1);
+        msgs[msgNum].isLast = true;
+        vector<HopResult> results(hopNum);
+        vector<uint64_t> endToEndNs;
+        vector<thread> hops;
+        for (uint32_t i = 0; i < hopNum; i++) {
+            hops.emplace_back(HopRun, ref(queues), i, isPolling, ref(results[i]), ref(endToEndNs));
+        }
+
+        uint64_t startNs = BenchNowNs();
+        auto next = chrono::steady_clock::now();
+        for (uint64_t i = 0; i <= msgNum; i++) {
+            this_thread::sleep_until(next);
+            next += chrono::microseconds(intervalUs);
+            msgs[i].sendNs = BenchNowNs();
+            msgs[i].enqueueNs = msgs[i].sendNs;
+            while (!queues[0]->WaitPush(&msgs[i], kIdleTimeoutMs)) {
+            }
+        }
+        for (auto& hop : hops) {
+            hop.join();
+        }
+        double seconds = (BenchNowNs() - startNs) / 1e9;
+
+        printf("== %s: %lu messages every %lu us through %u hops\n",
+               isPolling ? "poll, Pop + usleep(10ms)" : "wait, WaitPop", msgNum, intervalUs, hopNum);
+        uint64_t cpuUs = 0;
+        uint64_t wakeups = 0;
+        for (uint32_t i = 0; i < hopNum; i++) {
+            BenchPrintLatency("hop " + to_string(i), results[i].latencyNs);
+            cpuUs += results[i].cpuUs;
+            wakeups += results[i].emptyWakeups;
+        }
+        BenchPrintLatency("end to end", endToEndNs);
+        printf("hop threads: %.1f empty wakeups/s, cpu %.3f ms/s\n\n",
+               wakeups / seconds, cpuUs / 1000.0 / seconds);
+    }
+}
+
+// usage: queue_latency_bench [message number] [send interval us] [hop number]
+int main(int argc, char* argv[])
+{
+    uint64_t msgNum = BenchArg(argc, argv, 1, kDefaultMsgNum);
+    uint64_t intervalUs = BenchArg(argc, argv, 2, kDefaultIntervalUs);
+    uint32_t hopNum = max((uint64_t)1, BenchArg(argc, argv, 3, kDefaultHopNum));
+    RunMode(true, msgNum, intervalUs, hopNum);
+    RunMode(false, msgNum, intervalUs, hopNum);
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File queueThroughputBench.cpp
+* Description: throughput and latency of the thread message queues with 1, 4
+* and 16 channels, as point to point edges and as the shared inference inbox
+*/
+#include <memory>
+#include <thread>
+#include "MsgQueue.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kWaitMs = 100;
+    const uint64_t kDefaultMsgNum = 400000;  // all channels together
+    const uint64_t kDefaultQueueSize = 64;
+    const uint32_t kChannelNums[] = {1, 4, 16};
+
+    struct BenchMsg {
+        uint64_t enqueueNs = 0;
+        bool isLast = false;
+    };
+
+    void ProduceRun(MsgQueue<BenchMsg*>& queue, vector<BenchMsg>& msgs)
+    {
+        for (auto& msg : msgs) {
+            msg.enqueueNs = BenchNowNs();
+            while (!queue.WaitPush(&msg, kWaitMs)) {
+            }
+        }
+    }
+
+    // pop until the last message of every producer arrives
+    void ConsumeRun(MsgQueue<BenchMsg*>& queue, uint32_t producerNum, vector<uint64_t>& latencyNs)
+    {
+        uint32_t finishedNum = 0;
+        while (finishedNum < producerNum) {
+            BenchMsg* msg = queue.WaitPop(kWaitMs);
+            if (msg == nullptr) {
+                continue;
+            }
+            latencyNs.push_back(BenchNowNs() - msg->enqueueNs);
+            finishedNum += msg->isLast ? 1 : 0;
+        }
+    }
+
+    /**
+     * isFanIn false: every channel is a producer and consumer pair with its own queue
+     * isFanIn true: the producers of all channels send to one consumer
+     */
+    void RunCase(AclLiteQueueType type, bool isFanIn, uint32_t channelNum, uint64_t msgNum, uint32_t queueSize)
+    {
+        uint32_t queueNum = isFanIn ? 1 : channelNum;
+        vector<unique_ptr<MsgQueue<BenchMsg*>>> queues;
+        for (uint32_t i = 0; i < queueNum; i++) {
+            queues.emplace_back(CreateMsgQueue<BenchMsg*>(type, queueSize));
+        }
+        uint64_t channelMsgNum = max((uint64_t)1, msgNum / channelNum);
+        vector<vector<BenchMsg>> msgs(channelNum, vector<BenchMsg>(channelMsgNum));
+        for (auto& channelMsgs : msgs) {
+            channelMsgs.back().isLast = true;
+        }
+        vector<vector<uint64_t>> latencyNs(queueNum);
+        for (auto& samples : latencyNs) {
+            samples.reserve(isFanIn ? channelMsgNum * channelNum : channelMsgNum);
+        }
+
+        uint64_t startNs = BenchNowNs();
+        vector<thread> threads;
+        for (uint32_t i = 0; i < queueNum; i++) {
+            threads.emplace_back(ConsumeRun, ref(*queues[i]), isFanIn ? channelNum : 1, ref(latencyNs[i]));
+        }
+        for (uint32_t i = 0; i < channelNum; i++) {
+            threads.emplace_back(ProduceRun, ref(*queues[isFanIn ? 0 : i]), ref(msgs[i]));
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        double seconds = (BenchNowNs() - startNs) / 1e9;
+
+        vector<uint64_t> allNs;
+        for (auto& samples : latencyNs) {
+            allNs.insert(allNs.end(), samples.begin(), samples.end());
+        }
+        const char* typeName = (type == QUEUE_TYPE_SPSC) ? "spsc" : ((type == QUEUE_TYPE_MPSC) ? "mpsc" : "mutex");
+        printf("%-5s %-7s %2u ch  %8.3f Mmsg/s  ", typeName, isFanIn ? "fan-in" : "p2p", channelNum,
+               allNs.size() / seconds / 1e6);
+        BenchPrintLatency("", allNs);
+    }
+}
+
+// usage: queue_throughput_bench [message number of all channels] [queue size]
+int main(int argc, char* argv[])
+{
+    uint64_t msgNum = BenchArg(argc, argv, 1, kDefaultMsgNum);
+    uint32_t queueSize = BenchArg(argc, argv, 2, kDefaultQueueSize);
+    printf("%lu messages, queue size %u, %u cpus\n", msgNum, queueSize, thread::hardware_concurrency());
+    for (uint32_t channelNum : kChannelNums) {
+        RunCase(QUEUE_TYPE_MUTEX, false, channelNum, msgNum, queueSize);
+        RunCase(QUEUE_TYPE_SPSC, false, channelNum, msgNum, queueSize);
+        RunCase(QUEUE_TYPE_MUTEX, true, channelNum, msgNum, queueSize);
+        RunCase(QUEUE_TYPE_MPSC, true, channelNum, msgNum, queueSize);
+    }
+    return 0;
+}
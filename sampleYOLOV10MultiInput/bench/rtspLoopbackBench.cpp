@@ -0,0 +1,307 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File rtspLoopbackBench.cpp
+* Description: the rtsp output pushing to a loopback server, the encode cost
+* per frame of each codec and preset on an unlimited link, then the frame rate
+* kept by the push thread with a fixed and an adaptive bitrate when the server
+* reads the stream at a limited rate
+*/
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "pictortsp.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint64_t kDefaultFrameNum = 450;
+    const uint64_t kDefaultWidth = 1280;
+    const uint64_t kDefaultHeight = 720;
+    const uint64_t kDefaultLinkKbps = 1000;  // of the congested cases, 0: not limited
+    const vector<string> kCodecs = {"h264", "h265"};
+    const vector<string> kPresets = {"ultrafast", "superfast", "veryfast", "faster", "medium"};
+    const uint32_t kBitRate = 2000000;
+    const uint32_t kFrameRate = 15;
+    const uint32_t kFrameRingNum = 8;
+    const size_t kReadChunkSize = 4096;
+    const uint32_t kBitsPerByte = 8;
+
+    // the rtsp server side of the loopback: OPTIONS, ANNOUNCE, SETUP and RECORD are
+    // answered with 200 OK, then the interleaved rtp data is read at the link rate
+    class LoopbackServer {
+    public:
+        bool Start(uint64_t linkKbps)
+        {
+            linkKbps_ = linkKbps;
+            listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+            if (listenFd_ < 0) {
+                return false;
+            }
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            socklen_t addrLen = sizeof(addr);
+            if ((bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0) || (listen(listenFd_, 1) != 0) ||
+                (getsockname(listenFd_, (sockaddr*)&addr, &addrLen) != 0)) {
+                close(listenFd_);
+                return false;
+            }
+            port_ = ntohs(addr.sin_port);
+            thread_ = thread(&LoopbackServer::Run, this);
+            return true;
+        }
+
+        void Stop()
+        {
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+            close(listenFd_);
+        }
+
+        uint16_t GetPort() const
+        {
+            return port_;
+        }
+
+        uint64_t GetRecvBytes() const
+        {
+            return recvBytes_.load();
+        }
+
+    private:
+        // one request: the header up to the empty line and the body of Content-Length
+        bool ReadRequest(int fd, string& method, string& cseq)
+        {
+            while (pending_.find("\r\n\r\n") == string::npos) {
+                char buf[kReadChunkSize];
+                ssize_t len = recv(fd, buf, sizeof(buf), 0);
+                if (len <= 0) {
+                    return false;
+                }
+                pending_.append(buf, len);
+            }
+            size_t headerEnd = pending_.find("\r\n\r\n") + strlen("\r\n\r\n");
+            string header = pending_.substr(0, headerEnd);
+            size_t bodyLen = 0;
+            size_t pos = header.find("Content-Length:");
+            if (pos != string::npos) {
+                bodyLen = stoul(header.substr(pos + strlen("Content-Length:")));
+            }
+            while (pending_.size() < headerEnd + bodyLen) {
+                char buf[kReadChunkSize];
+                ssize_t len = recv(fd, buf, sizeof(buf), 0);
+                if (len <= 0) {
+                    return false;
+                }
+                pending_.append(buf, len);
+            }
+            pending_.erase(0, headerEnd + bodyLen);
+            method = header.substr(0, header.find(' '));
+            pos = header.find("CSeq:");
+            cseq = (pos == string::npos) ? "0" :
+                   header.substr(pos + strlen("CSeq:"), header.find("\r\n", pos) - pos - strlen("CSeq:"));
+            return true;
+        }
+
+        void Reply(int fd, const string& method, const string& cseq)
+        {
+            string reply = "RTSP/1.0 200 OK\r\nCSeq:" + cseq + "\r\n";
+            if (method == "SETUP") {
+                reply += "Transport: RTP/AVP/TCP;unicast;interleaved=0-1\r\nSession: 1\r\n";
+            } else if (method == "RECORD") {
+                reply += "Session: 1\r\n";
+            }
+            reply += "\r\n";
+            (void)send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+        }
+
+        void Run()
+        {
+            int fd = accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            string method;
+            string cseq;
+            while ((method != "RECORD") && ReadRequest(fd, method, cseq)) {
+                Reply(fd, method, cseq);
+            }
+            recvBytes_ += pending_.size();
+            // the link rate is kept by sleeping after each chunk
+            uint64_t startNs = BenchNowNs();
+            char buf[kReadChunkSize];
+            ssize_t len;
+            while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                recvBytes_ += len;
+                if (linkKbps_ == 0) {
+                    continue;
+                }
+                uint64_t dueNs = recvBytes_.load() * kBitsPerByte * 1000000 / linkKbps_;
+                uint64_t elapsedNs = BenchNowNs() - startNs;
+                if (dueNs > elapsedNs) {
+                    usleep((dueNs - elapsedNs) / 1000);
+                }
+            }
+            close(fd);
+        }
+
+    private:
+        int listenFd_ = -1;
+        uint16_t port_ = 0;
+        uint64_t linkKbps_ = 0;
+        string pending_;
+        atomic<uint64_t> recvBytes_{0};
+        thread thread_;
+    };
+
+    // a moving gradient, so the encoder does not see a static picture
+    void FillNv12(uint8_t* data, uint32_t width, uint32_t height, uint32_t index)
+    {
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                data[y * width + x] = (uint8_t)(x + y + index * 8);
+            }
+        }
+        uint8_t* uv = data + width * height;
+        for (uint32_t y = 0; y < height / 2; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uv[y * width + x] = (uint8_t)(128 + ((x >> 4) + index) % 32);
+            }
+        }
+    }
+
+    struct CaseConfig {
+        string codec = "h264";
+        string preset = "superfast";
+        bool adaptive = false;
+        bool paced = true;  // feed at the frame rate, otherwise as fast as the encoder takes
+        uint64_t linkKbps = 0;
+    };
+
+    // a call blocked by the full packet queue delays the following frames, on an
+    // unlimited link the call time is the encode time of the frame
+    int RunCase(const string& name, const CaseConfig& caseConfig, uint64_t frameNum,
+                uint32_t width, uint32_t height, const vector<shared_ptr<uint8_t>>& frames)
+    {
+        LoopbackServer server;
+        if (!server.Start(caseConfig.linkKbps)) {
+            ACLLITE_LOG_ERROR("Start loopback rtsp server failed");
+            return 1;
+        }
+        RtspEncodeConfig config;
+        config.codec = caseConfig.codec;
+        config.preset = caseConfig.preset;
+        config.bitRate = kBitRate;
+        config.frameRate = kFrameRate;
+        config.nv12Input = true;
+        config.adaptiveBitRate = caseConfig.adaptive;
+        string url = "rtsp://127.0.0.1:" + to_string(server.GetPort()) + "/bench";
+        vector<uint64_t> callNs;
+        uint64_t startNs = BenchNowNs();
+        {
+            PicToRtsp rtsp;
+            if (rtsp.AvInit(width, height, url, config) != ACLLITE_OK) {
+                ACLLITE_LOG_ERROR("Open rtsp output %s failed", url.c_str());
+                server.Stop();
+                return 1;
+            }
+            const uint64_t frameIntervalNs = 1000000000 / kFrameRate;
+            uint64_t dueNs = BenchNowNs();
+            for (uint64_t i = 0; i < frameNum; i++) {
+                uint64_t nowNs = BenchNowNs();
+                if (caseConfig.paced && (dueNs > nowNs)) {
+                    usleep((dueNs - nowNs) / 1000);
+                }
+                uint64_t callStartNs = BenchNowNs();
+                if (rtsp.Nv12DataToRtsp(frames[i % frames.size()], width, height, width, height, i) != ACLLITE_OK) {
+                    ACLLITE_LOG_ERROR("Push frame %lu failed", i);
+                    break;
+                }
+                callNs.push_back(BenchNowNs() - callStartNs);
+                dueNs += frameIntervalNs;
+            }
+            (void)rtsp.FlushEncoder();
+        }
+        uint64_t totalNs = BenchNowNs() - startNs;
+        server.Stop();
+
+        const double nsPerSec = 1e9;
+        const double nsPerMs = 1e6;
+        uint64_t sumNs = 0;
+        for (uint64_t ns : callNs) {
+            sumNs += ns;
+        }
+        double avgMs = callNs.empty() ? 0 : sumNs / nsPerMs / callNs.size();
+        BenchPrintLatency(name + " call", callNs);
+        printf("%-28s %lu frames in %.2f s, %.1f fps, encode %.2f ms/frame, received %.0f kbit/s\n",
+               name.c_str(), callNs.size(), totalNs / nsPerSec, callNs.size() * nsPerSec / totalNs,
+               avgMs, server.GetRecvBytes() * kBitsPerByte * nsPerSec / totalNs / 1000);
+        return 0;
+    }
+}
+
+// usage: rtsp_loopback_bench [frame num] [width] [height] [link kbit/s]
+int main(int argc, char* argv[])
+{
+    uint64_t frameNum = BenchArg(argc, argv, 1, kDefaultFrameNum);
+    uint32_t width = BenchArg(argc, argv, 2, kDefaultWidth) & ~1u;
+    uint32_t height = BenchArg(argc, argv, 3, kDefaultHeight) & ~1u;
+    uint64_t linkKbps = BenchArg(argc, argv, 4, kDefaultLinkKbps);
+    if ((frameNum == 0) || (width == 0) || (height == 0)) {
+        printf("usage: %s [frame num] [width] [height] [link kbit/s]\n", argv[0]);
+        return 1;
+    }
+    vector<shared_ptr<uint8_t>> frames;
+    for (uint32_t i = 0; i < kFrameRingNum; i++) {
+        uint8_t* buffer = new uint8_t[YUV420SP_SIZE(width, height)];
+        FillNv12(buffer, width, height, i);
+        frames.push_back(SHARED_PTR_U8_BUF(buffer));
+    }
+    printf("%ux%u, bitrate %u, %u fps\n", width, height, kBitRate, kFrameRate);
+    // the encode cost of each codec and preset, the frames are fed as fast as encoded
+    for (const string& codec : kCodecs) {
+        for (const string& preset : kPresets) {
+            CaseConfig config;
+            config.codec = codec;
+            config.preset = preset;
+            config.paced = false;
+            if (RunCase(codec + " " + preset, config, frameNum, width, height, frames) != 0) {
+                return 1;
+            }
+        }
+    }
+    // the congested link, the frames are fed at the frame rate
+    printf("link %lu kbit/s\n", linkKbps);
+    CaseConfig config;
+    config.linkKbps = linkKbps;
+    if (RunCase("fixed bitrate", config, frameNum, width, height, frames) != 0) {
+        return 1;
+    }
+    config.adaptive = true;
+    return RunCase("adaptive", config, frameNum, width, height, frames);
+}
@@ -0,0 +1,135 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+
+* File yolov10DecoderBench.cpp
+* Description: decode time of one image by the yolov10 decoder with the confidence
+* filter in scalar, 4 boxes (sse or neon) and 8 boxes (avx) at once, the boxes of
+* every width are checked against the scalar ones
+*/
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "yolov10Decoder.h"
+#include "BenchCommon.h"
+
+using namespace std;
+
+namespace {
+    const uint64_t kDefaultBoxNum = 8400;  // the boxes of a 640x640 yolo head, yolov10 keeps 300
+    const uint64_t kDefaultPassPercent = 5;  // the boxes above the threshold
+    const uint64_t kDefaultIterNum = 20000;
+    const uint32_t kBoxAttrNum = 6;
+    const uint32_t kClassNum = 80;
+    const uint32_t kBadClassInterval = 97;  // a NaN or out of range class every so many boxes
+    const uint32_t kModelSize = 640;
+    const uint32_t kSeed = 12345;
+    const uint32_t kPercent = 100;
+    const vector<uint32_t> kSimdWidths = {1, 4, 8};
+
+    vector<float> CreateOutput(uint32_t boxNum, uint32_t passPercent, float threshold)
+    {
+        vector<float> output(boxNum * kBoxAttrNum);
+        srand(kSeed);
+        for (uint32_t i = 0; i < boxNum; i++) {
+            float* box = output.data() + i * kBoxAttrNum;
+            float x = rand() % kModelSize;
+            float y = rand() % kModelSize;
+            box[0] = x;
+            box[1] = y;
+            box[2] = x + rand() % 100;
+            box[3] = y + rand() % 100;
+            bool pass = (uint32_t)(rand() % kPercent) < passPercent;
+            float ratio = (float)rand() / RAND_MAX;
+            box[4] = pass ? (threshold + (1 - threshold) * ratio) : (threshold * ratio * 0.99f);
+            box[5] = rand() % kClassNum;
+            if (i % kBadClassInterval == 1) {
+                box[5] = (i % 2 == 0) ? NAN : 1e10f;
+            }
+        }
+        return output;
+    }
+
+    bool SameBoxes(const vector<DetectBox>& boxes1, const vector<DetectBox>& boxes2)
+    {
+        if (boxes1.size() != boxes2.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < boxes1.size(); i++) {
+            if ((boxes1[i].left != boxes2[i].left) || (boxes1[i].bottom != boxes2[i].bottom) ||
+                (boxes1[i].score != boxes2[i].score) || (boxes1[i].classIndex != boxes2[i].classIndex)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// usage: yolov10_decoder_bench [box num] [percent above threshold] [iteration num]
+int main(int argc, char* argv[])
+{
+    uint32_t boxNum = BenchArg(argc, argv, 1, kDefaultBoxNum);
+    uint32_t passPercent = BenchArg(argc, argv, 2, kDefaultPassPercent);
+    uint64_t iterNum = BenchArg(argc, argv, 3, kDefaultIterNum);
+    if ((boxNum == 0) || (passPercent > kPercent) || (iterNum == 0)) {
+        printf("usage: %s [box num] [percent above threshold] [iteration num]\n", argv[0]);
+        return 1;
+    }
+    YoloV10DecoderConfig config;
+    config.maxDets = boxNum;
+    vector<float> output = CreateOutput(boxNum, passPercent, config.confThreshold);
+    ModelOutputInfo outputInfo;
+    outputInfo.name = "output0";
+    outputInfo.format = ACL_FORMAT_ND;
+    outputInfo.dataType = ACL_FLOAT;
+    outputInfo.dims.dimCount = 3;
+    outputInfo.dims.dims[0] = 1;
+    outputInfo.dims.dims[1] = boxNum;
+    outputInfo.dims.dims[2] = kBoxAttrNum;
+    LetterboxInfo letterbox;
+    letterbox.scaleX = 0.5f;
+    letterbox.scaleY = 0.5f;
+    letterbox.padTop = 80;
+
+    printf("%u boxes, %u%% above the threshold, %lu iterations\n", boxNum, passPercent, iterNum);
+    vector<DetectBox> scalarBoxes;
+    for (uint32_t width : kSimdWidths) {
+        config.simdWidth = width;
+        YoloV10Decoder decoder(config);
+        if (decoder.Init(outputInfo) != ACLLITE_OK) {
+            return 1;
+        }
+        if (decoder.GetSimdWidth() != width) {
+            printf("simd width %u is not supported by the cpu\n", width);
+            continue;
+        }
+        vector<DetectBox> boxes;
+        vector<uint64_t> decodeNs;
+        for (uint64_t i = 0; i < iterNum; i++) {
+            uint64_t startNs = BenchNowNs();
+            decoder.Decode(output.data(), letterbox, boxes);
+            decodeNs.push_back(BenchNowNs() - startNs);
+        }
+        if (width == kSimdWidths[0]) {
+            scalarBoxes = boxes;
+        }
+        string name = "simd width " + to_string(width);
+        BenchPrintLatency(name, decodeNs);
+        printf("%-28s %zu boxes, %s\n", name.c_str(), boxes.size(),
+               SameBoxes(boxes, scalarBoxes) ? "same as scalar" : "DIFFERENT from scalar");
+    }
+    return 0;
+}
@@ -48,12 +48,29 @@ public:
      * @return Result of create thread
      */
     int CreateAclLiteThread(AclLiteThread* thInst, const std::string& instName,
-                            aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize);
+                            aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize,
+                            AclLiteQueueType msgQueueType = QUEUE_TYPE_MUTEX);
     int Start(std::vector<AclLiteThreadParam>& threadParamTbl);
     void Wait();
     void Wait(AclLiteMsgProcess msgProcess, void* param);
     int GetAclLiteThreadIdByName(const std::string& threadName);
     AclLiteError SendMessage(int dest, int msgId, std::shared_ptr<void> data);
+    /**
+     * @brief Send message to thread, handle the full destination queue by policy
+     * @param [in] dest: destination thread instance id
+     * @param [in] msgId: message id
+     * @param [in] data: message data
+     * @param [in] timeoutMs: max wait time when the policy is QUEUE_POLICY_BLOCK
+     * @param [in] policy: the action when the destination queue is full
+     * @param [out] droppedMsg: the oldest message dropped by QUEUE_POLICY_DROP_OLDEST,
+     *         nullptr if no message is dropped; it is not returned when droppedMsg is nullptr
+     * @return ACLLITE_OK: message enqueued, or the oldest message is dropped;
+     *         ACLLITE_ERROR_ENQUEUE: queue is still full after timeout, or
+     *         the message is dropped by QUEUE_POLICY_DROP_NEWEST
+     */
+    AclLiteError SendMessageBlocking(int dest, int msgId, std::shared_ptr<void> data,
+                                     uint32_t timeoutMs, AclLiteQueuePolicy policy = QUEUE_POLICY_BLOCK,
+                                     std::shared_ptr<AclLiteMessage>* droppedMsg = nullptr);
     void WaitEnd()
     {
         waitEnd_ = true;
@@ -63,7 +80,8 @@ public:
 private:
     AclLiteError Init();
     int CreateAclLiteThreadMgr(AclLiteThread* thInst, const std::string& instName,
-                               aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize);
+                               aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize,
+                               AclLiteQueueType msgQueueType);
     bool CheckThreadAbnormal();
     bool CheckThreadNameUnique(const std::string& threadName);
     void ReleaseThreads();
@@ -77,5 +95,8 @@ private:
 AclLiteApp& CreateAclLiteAppInstance();
 AclLiteApp& GetAclLiteAppInstance();
 AclLiteError SendMessage(int dest, int msgId, std::shared_ptr<void> data);
+AclLiteError SendMessageBlocking(int dest, int msgId, std::shared_ptr<void> data,
+                                 uint32_t timeoutMs, AclLiteQueuePolicy policy = QUEUE_POLICY_BLOCK,
+                                 std::shared_ptr<AclLiteMessage>* droppedMsg = nullptr);
 int GetAclLiteThreadIdByName(const std::string& threadName);
 #endif
\ No newline at end of file
@@ -40,6 +40,7 @@ const int ACLLITE_ERROR_WRITE_FILE = 13;
 const int ACLLITE_ERROR_THREAD_ABNORMAL = 14;
 const int ACLLITE_ERROR_START_THREAD = 15;
 const int ACLLITE_ERROR_ADD_THREAD = 16;
+const int ACLLITE_ERROR_POOL_STOPPED = 17;
 
 // malloc or new memory failed
 const int ACLLITE_ERROR_MALLOC = 101;
@@ -175,6 +176,10 @@ const int ACLLITE_ERROR_DECODE_FINISH = 630;
 
 const int ACLLITE_ERROR_H26X_FRAME = 631;
 
+const int ACLLITE_ERROR_FRAME_POOL_TIMEOUT = 632;
+
+const int ACLLITE_ERROR_BITSTREAM_ARENA_FULL = 633;
+
 const int ACLLITE_ERROR_VENC_STATUS = 701;
 
 const int ACLLITE_ERROR_VENC_QUEUE_FULL = 702;
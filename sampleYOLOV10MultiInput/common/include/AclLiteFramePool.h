@@ -0,0 +1,132 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteFramePool.h
+* Description: process wide pool of decoded frame buffers
+*/
+#ifndef ACLLITE_FRAME_POOL_H
+#define ACLLITE_FRAME_POOL_H
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "acl/acl.h"
+#include "AclLiteError.h"
+
+struct FramePoolStats {
+    uint64_t allocNum = 0;    // frames got from the pool
+    uint64_t mallocNum = 0;   // frames malloced because there was no free frame
+    uint64_t waitNum = 0;     // allocs waited for a frame at the high water mark
+    uint64_t waitTimeUs = 0;  // total wait time of the allocs
+    uint32_t inUseNum = 0;    // frames not returned yet
+};
+
+/**
+ * Pool of the dvpp buffers of decoded frames, shared by all vdec channels.
+ * The frames are kept by (context, alignWidth, alignHeight). The number of
+ * frames of one resolution is limited by the high water mark, when all of
+ * them are in use Alloc waits until a frame is returned, so decoding slows
+ * down to the speed of the pipeline instead of mallocing more memory.
+ */
+class AclLiteFramePool {
+public:
+    /**
+    * @brief get the process wide frame pool
+    */
+    static AclLiteFramePool& GetInstance();
+
+    /**
+    * @brief set the high water mark
+    * @param [in]: maxFrameNum: the max frame number of one resolution, 0: no limit
+    */
+    void SetMaxFrameNum(uint32_t maxFrameNum);
+
+    /**
+    * @brief get a NV12 frame buffer in the current context
+    * @param [in]: channelId: the vdec channel using the frame, for statistics
+    * @param [in]: alignWidth: the width stride of the frame
+    * @param [in]: alignHeight: the height stride of the frame
+    * @param [out]: buffer: the frame buffer
+    * @param [in]: timeoutMs: the max wait time at the high water mark
+    * @return ACLLITE_OK: success; ACLLITE_ERROR_FRAME_POOL_TIMEOUT: no frame
+    * is returned before timeout; others: malloc failed
+    */
+    AclLiteError Alloc(int channelId, uint32_t alignWidth, uint32_t alignHeight,
+                       void*& buffer, uint32_t timeoutMs);
+
+    /**
+    * @brief return the frame to the pool
+    * @param [in]: ptr: the frame buffer got by Alloc
+    */
+    void Free(void* ptr);
+
+    /**
+    * @brief free all free frames, the frames returned later are freed directly.
+    * It must be called before the contexts are destroyed
+    */
+    void Release();
+
+    /**
+    * @brief get the statistics of one channel
+    * @param [in]: channelId: the vdec channel
+    * @param [out]: stats: the statistics
+    */
+    void GetChannelStats(int channelId, FramePoolStats& stats);
+
+private:
+    AclLiteFramePool();
+    ~AclLiteFramePool();
+    AclLiteFramePool(const AclLiteFramePool&) = delete;
+    AclLiteFramePool& operator=(const AclLiteFramePool&) = delete;
+
+    struct FrameKey {
+        aclrtContext context;
+        uint32_t alignWidth;
+        uint32_t alignHeight;
+        bool operator<(const FrameKey& other) const
+        {
+            if (context != other.context) {
+                return context < other.context;
+            }
+            if (alignWidth != other.alignWidth) {
+                return alignWidth < other.alignWidth;
+            }
+            return alignHeight < other.alignHeight;
+        }
+    };
+    struct FrameList {
+        std::vector<void*> freeFrames;
+        uint32_t frameNum = 0;  // the free and in use frames
+    };
+    struct FrameOwner {
+        FrameKey key;
+        int channelId;
+    };
+
+private:
+    uint32_t maxFrameNum_;
+    bool isReleased_;
+    std::mutex mutex_;
+    std::condition_variable frameReturned_;
+    std::map<FrameKey, FrameList> frameLists_;
+    std::unordered_map<void*, FrameOwner> inUseFrames_;
+    std::map<int, FramePoolStats> channelStats_;
+};
+
+#endif
@@ -148,6 +148,20 @@ public:
     */
     AclLiteError Border(ImageData& dest, ImageData& src,
                         uint32_t width, uint32_t height);
+    /**
+    * @brief Resize the image keeping the aspect ratio and paste it to the
+    * center of a (width, height) image in one vpc call, the rest is padded gray.
+    * The output is written to the caller's buffer, such as a slot of a model batch.
+    * @param [in]: dest: output address, dvpp memory of YUV420SP_SIZE(width, height) bytes
+    * @param [in]: src: original image
+    * @param [in]: width: output image width, 16 aligned
+    * @param [in]: height: output image height, even
+    * @param [out]: info: the scale and offset of the resized image in the output
+    * @return AclLiteError ACLLITE_OK: read success
+    * others: letterbox failed
+    */
+    AclLiteError Letterbox(void* dest, ImageData& src, uint32_t width, uint32_t height,
+                           LetterboxInfo& info);
     void DestroyResource();
 
 protected:
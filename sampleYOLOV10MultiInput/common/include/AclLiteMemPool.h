@@ -0,0 +1,110 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMemPool.h
+* Description: pool of device and dvpp buffers
+*/
+#ifndef ACLLITE_MEM_POOL_H
+#define ACLLITE_MEM_POOL_H
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "acl/acl.h"
+#include "AclLiteType.h"
+
+/**
+ * Pool of device or dvpp buffers. The sizes are rounded up to size classes,
+ * 8 per power of 2, and the freed buffers are kept by (context, size class),
+ * so the buffers malloced for every frame or inference are reused instead of
+ * malloced again, also when their sizes vary a little as the jpeg pictures.
+ * The cached bytes are limited, the least recently freed buffers are freed
+ * to keep a new one. The buffers not malloced by the pool are freed directly.
+ */
+class AclLiteMemPool {
+public:
+    /**
+    * @brief get the pool of aclrtMalloc buffers
+    */
+    static AclLiteMemPool& GetDevicePool();
+    /**
+    * @brief get the pool of acldvppMalloc buffers
+    */
+    static AclLiteMemPool& GetDvppPool();
+
+    /**
+    * @brief malloc a buffer in the current context
+    * @param [in]: size: buffer size
+    * @return buffer address; nullptr: malloc failed
+    */
+    void* Alloc(size_t size);
+    /**
+    * @brief return the buffer to the pool
+    * @param [in]: ptr: buffer address, it is freed directly
+    * if it is not malloced by the pool
+    */
+    void Free(void* ptr);
+    /**
+    * @brief free all cached buffers, the buffers freed later are freed directly.
+    * It must be called before the contexts are destroyed
+    */
+    void Release();
+    /**
+    * @brief get the pool statistics
+    * @param [out]: hitNum: the number of Alloc reusing a cached buffer
+    * @param [out]: missNum: the number of Alloc mallocing a new buffer
+    */
+    void GetStats(uint64_t& hitNum, uint64_t& missNum);
+    /**
+    * @brief get the size class of a size, the size malloced for it
+    * @param [in]: size: requested size
+    * @return the size rounded up to its class
+    */
+    static size_t GetClassSize(size_t size);
+
+private:
+    AclLiteMemPool(MemoryType memType);
+    ~AclLiteMemPool();
+    AclLiteMemPool(const AclLiteMemPool&) = delete;
+    AclLiteMemPool& operator=(const AclLiteMemPool&) = delete;
+    void* RawAlloc(size_t size);
+    void RawFree(void* ptr);
+    void FreeInContext(const std::vector<std::pair<aclrtContext, void*>>& bufs);
+
+private:
+    typedef std::pair<aclrtContext, size_t> BufKey;
+    struct BufInfo {
+        BufKey key;
+        bool isCached;
+        std::list<void*>::iterator lruIt;  // the position in cachedLru_ when it is cached
+    };
+    MemoryType memType_;
+    bool isReleased_;
+    uint64_t hitNum_;
+    uint64_t missNum_;
+    uint64_t evictNum_;
+    size_t cachedBytes_;
+    std::mutex mutex_;
+    std::map<BufKey, std::vector<void*>> freeBufs_;  // cached buffers
+    std::list<void*> cachedLru_;  // cached buffers, the least recently freed first
+    std::unordered_map<void*, BufInfo> allocatedBufs_;  // all buffers malloced by the pool
+};
+
+#endif
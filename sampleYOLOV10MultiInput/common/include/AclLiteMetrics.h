@@ -0,0 +1,185 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMetrics.h
+* Description: process wide counters and gauges exported in Prometheus text format
+*/
+#ifndef ACLLITE_METRICS_H
+#define ACLLITE_METRICS_H
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "AclLiteError.h"
+
+class MetricCounter {
+public:
+    MetricCounter() : value_(0) {}
+    void Add(uint64_t value = 1)
+    {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+    // for a counter copied from a source counting by itself, such as /proc
+    void Set(uint64_t value)
+    {
+        value_.store(value, std::memory_order_relaxed);
+    }
+    uint64_t Get() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_;
+};
+
+class MetricGauge {
+public:
+    MetricGauge() : value_(0) {}
+    void Set(int64_t value)
+    {
+        value_.store(value, std::memory_order_relaxed);
+    }
+    void Add(int64_t value)
+    {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+    int64_t Get() const
+    {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> value_;
+};
+
+/**
+ * AclLiteMetrics
+ * The components get their counters and gauges once at init, the registration
+ * takes a lock, the updates are relaxed atomics. The metrics are never freed,
+ * so they outlive the threads updating them. A metric is identified by its
+ * name and labels, such as GetCounter("frames_total", help, Label("channel", "0")).
+ * The metrics can be served on a localhost http port for Prometheus and written
+ * to a file periodically, both in the Prometheus text format. The values that
+ * are cheap to read but costly to track, such as a queue size, are set by the
+ * collectors which run on every export.
+ */
+class AclLiteMetrics {
+public:
+    using Collector = std::function<void()>;
+
+    /**
+    * @brief get the process wide metrics registry
+    */
+    static AclLiteMetrics& GetInstance();
+
+    /**
+    * @brief get or create a counter
+    * @param [in]: name: the metric name
+    * @param [in]: help: the description of the metric
+    * @param [in]: labels: the labels made by Label, empty: no label
+    * @return the counter, valid until the process exits
+    */
+    MetricCounter* GetCounter(const std::string& name, const std::string& help,
+                              const std::string& labels = "");
+
+    /**
+    * @brief get or create a gauge
+    * @param [in]: name: the metric name
+    * @param [in]: help: the description of the metric
+    * @param [in]: labels: the labels made by Label, empty: no label
+    * @return the gauge, valid until the process exits
+    */
+    MetricGauge* GetGauge(const std::string& name, const std::string& help,
+                          const std::string& labels = "");
+
+    /**
+    * @brief add a collector called before every export, it may get and set metrics
+    * @param [in]: collector: the function setting the metrics
+    * @return the collector id used to remove the collector
+    */
+    uint32_t AddCollector(const Collector& collector);
+
+    /**
+    * @brief remove a collector, it is not running when the function returns
+    * @param [in]: id: the collector id returned by AddCollector
+    */
+    void RemoveCollector(uint32_t id);
+
+    /**
+    * @brief make one label, join several labels with ","
+    * @param [in]: key: the label name
+    * @param [in]: value: the label value, escaped here
+    */
+    static std::string Label(const std::string& key, const std::string& value);
+
+    /**
+    * @brief get all metrics in the Prometheus text format
+    */
+    std::string Export();
+
+    /**
+    * @brief start the export thread
+    * @param [in]: port: the localhost http port, 0: no http server
+    * @param [in]: file: the file rewritten every intervalMs, empty: no file
+    * @param [in]: intervalMs: the interval of writing the file
+    * @return ACLLITE_OK: success; others: the port can not be listened
+    */
+    AclLiteError StartExport(uint16_t port, const std::string& file, uint32_t intervalMs);
+
+    /**
+    * @brief stop the export thread, the file is written once more
+    */
+    void StopExport();
+
+private:
+    AclLiteMetrics();
+    ~AclLiteMetrics();
+    AclLiteMetrics(const AclLiteMetrics&) = delete;
+    AclLiteMetrics& operator=(const AclLiteMetrics&) = delete;
+
+    struct MetricFamily {
+        std::string help;
+        bool isCounter;
+        std::map<std::string, std::unique_ptr<MetricCounter>> counters;  // by labels
+        std::map<std::string, std::unique_ptr<MetricGauge>> gauges;  // by labels
+    };
+
+    MetricFamily* GetFamily(const std::string& name, const std::string& help, bool isCounter);
+    AclLiteError Listen(uint16_t port);
+    void ExportRun();
+    void ServeRequest();
+    void WriteFile();
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, MetricFamily> families_;
+    std::mutex collectorMutex_;  // taken before mutex_
+    std::map<uint32_t, Collector> collectors_;
+    uint32_t nextCollectorId_;
+    std::thread exportThread_;
+    std::atomic<bool> isExporting_;
+    int listenFd_;
+    std::string file_;
+    uint32_t intervalMs_;
+};
+
+#endif
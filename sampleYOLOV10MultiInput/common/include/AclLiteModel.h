@@ -20,6 +20,7 @@
 #define ACLLITE_MODEL_H
 #pragma once
 #include <iostream>
+#include <vector>
 #include "AclLiteUtils.h"
 #include "acl/acl.h"
 
@@ -87,6 +88,38 @@ public:
 
     AclLiteError ExecuteV2(std::vector<InferenceOutput>& inferOutputs);
 
+    /**
+    * @brief Create the resources of asynchronous execution: one stream and
+    * slotNum slots, every slot has prebuilt input/output datasets and an event.
+    * The slots let the host prepare the next inference while the device
+    * is executing the previous one.
+    * @param [in]: slotNum: the max number of inferences in flight
+    * @return AclLiteError ACLLITE_OK: Created successfully
+    * Other: Failed to create
+    */
+    AclLiteError InitAsync(uint32_t slotNum);
+    /**
+    * @brief Launch the inference of one slot on the stream without waiting
+    * @param [in]: slot: the slot index, the slot must not be in flight
+    * @param [in]: inputData: model input data, it must stay valid until
+    * WaitAsync of the slot returns
+    * @return AclLiteError ACLLITE_OK: Launched successfully
+    * Other: Failed to launch
+    */
+    AclLiteError ExecuteAsync(uint32_t slot, std::vector<DataInfo>& inputData);
+    /**
+    * @brief Wait the inference of one slot to finish and get its results
+    * @param [in]: slot: the slot index launched by ExecuteAsync
+    * @param [in]: inferOutputs: model inference results in device memory
+    * @return AclLiteError ACLLITE_OK: Inference successfully
+    * Other: Inference failed
+    */
+    AclLiteError WaitAsync(uint32_t slot, std::vector<InferenceOutput>& inferOutputs);
+    uint32_t GetAsyncSlotNum()
+    {
+        return asyncSlots_.size();
+    }
+
     /**
     * @brief Get the model input data size
     * @param [in]: index: index. The mark is the first input of the model.
@@ -100,18 +133,28 @@ public:
     void DestroyInput();
 
 private:
+    struct AsyncSlot {
+        aclmdlDataset* input = nullptr;
+        aclmdlDataset* output = nullptr;
+        aclrtEvent event = nullptr;
+        bool inFlight = false;
+    };
+
     int SetDynamicBatchSize(uint64_t batchSize);
     AclLiteError LoadModelFromFile(const std::string& modelPath);
     AclLiteError LoadModelFromMem();
     AclLiteError SetDesc();
     AclLiteError CreateOutput();
+    AclLiteError CreateOutput(aclmdlDataset*& output);
     AclLiteError AddDatasetBuffer(aclmdlDataset* dataset,
                                   void* buffer, uint32_t bufferSize);
-    AclLiteError GetOutputItem(InferenceOutput& out,
+    AclLiteError GetOutputItem(aclmdlDataset* output, InferenceOutput& out,
                                uint32_t idx, bool isDevice);
     void Unload();
     void DestroyDesc();
     void DestroyOutput();
+    void DestroyOutput(aclmdlDataset*& output);
+    void DestroyAsync();
     
 private:
     bool loadFlag_;    // model load flag
@@ -129,5 +172,7 @@ private:
     aclmdlDataset *input_;    // input dataset
     aclmdlDataset *output_;    // output dataset
     std::string modelPath_;    // model path
+    aclrtStream stream_;    // stream of asynchronous execution
+    std::vector<AsyncSlot> asyncSlots_;
 };
 #endif
\ No newline at end of file
@@ -23,11 +23,21 @@
 #include <memory>
 #include <thread>
 #include <unistd.h>
-#include "ThreadSafeQueue.h"
+#include "MsgQueue.h"
 #include "acl/acl.h"
 #include "AclLiteError.h"
+#include "AclLiteThreadSched.h"
 
 #define INVALID_INSTANCE_ID (-1)
+#define DEFAULT_IDLE_TIMEOUT_MS 100
+
+// The action of sender when the destination message queue is full
+enum AclLiteQueuePolicy {
+    QUEUE_POLICY_BLOCK = 0,       // wait until the queue is not full
+    QUEUE_POLICY_DROP_OLDEST = 1, // drop the oldest message in the queue
+    QUEUE_POLICY_DROP_NEWEST = 2, // drop the message to be sent
+};
+
 class AclLiteThread {
 public:
     AclLiteThread();
@@ -37,6 +47,16 @@ public:
         return ACLLITE_OK;
     };
     virtual int Process(int msgId, std::shared_ptr<void> msgData) = 0;
+    // The max time in milliseconds to wait for message before Idle() is called
+    virtual uint32_t IdleTimeoutMs()
+    {
+        return DEFAULT_IDLE_TIMEOUT_MS;
+    }
+    // Called when no message arrives in IdleTimeoutMs()
+    virtual int Idle()
+    {
+        return ACLLITE_OK;
+    }
     int SelfInstanceId()
     {
         return instanceId_;
@@ -71,5 +91,7 @@ struct AclLiteThreadParam {
     aclrtRunMode runMode = ACL_HOST;
     int threadInstId = INVALID_INSTANCE_ID;
     uint32_t queueSize = 256;
+    AclLiteQueueType queueType = QUEUE_TYPE_MUTEX;
+    ThreadSchedConfig sched;  // the thread is named threadInstName
 };
 #endif
\ No newline at end of file
@@ -19,12 +19,14 @@
 #ifndef ACLLITE_THREADMGR_H
 #define ACLLITE_THREADMGR_H
 #pragma once
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <unistd.h>
 #include "AclLiteUtils.h"
-#include "ThreadSafeQueue.h"
+#include "AclLiteMetrics.h"
+#include "MsgQueue.h"
 #include "AclLiteThread.h"
 
 enum AclLiteThreadStatus {
@@ -38,7 +40,8 @@ enum AclLiteThreadStatus {
 class AclLiteThreadMgr {
 public:
     AclLiteThreadMgr(AclLiteThread* userThreadInstance,
-                     const std::string& threadName, const uint32_t msgQueueSize);
+                     const std::string& threadName, const uint32_t msgQueueSize,
+                     AclLiteQueueType msgQueueType = QUEUE_TYPE_MUTEX);
     ~AclLiteThreadMgr();
     // Thread function
     static void ThreadEntry(void* data);
@@ -52,10 +55,23 @@ public:
     }
     // Send AclLiteMessage data to the queue
     AclLiteError PushMsgToQueue(std::shared_ptr<AclLiteMessage>& pMessage);
+    // Send AclLiteMessage data to the queue, block until the queue is not full or timeout
+    AclLiteError WaitPushMsgToQueue(std::shared_ptr<AclLiteMessage>& pMessage, uint32_t timeoutMs);
+    // Send AclLiteMessage data to the queue, drop the oldest message if the queue is full,
+    // the dropped message is returned by droppedMsg when it is not nullptr
+    AclLiteError ForcePushMsgToQueue(std::shared_ptr<AclLiteMessage>& pMessage,
+                                     std::shared_ptr<AclLiteMessage>* droppedMsg = nullptr);
+    // Record one message dropped by the queue policy
+    void RecordDroppedMsg();
     // Get AclLiteMessage data from the queue
     std::shared_ptr<AclLiteMessage> PopMsgFromQueue()
     {
-        return this->msgQueue_.Pop();
+        return this->msgQueue_->Pop();
+    }
+    // Get AclLiteMessage data from the queue, block until data arrive or timeout
+    std::shared_ptr<AclLiteMessage> WaitPopMsgFromQueue(uint32_t timeoutMs)
+    {
+        return this->msgQueue_->WaitPop(timeoutMs);
     }
     void CreateThread();
     void SetStatus(AclLiteThreadStatus status)
@@ -67,12 +83,26 @@ public:
         return status_;
     }
     AclLiteError WaitThreadInitEnd();
+    // Set the affinity and scheduling policy applied when the thread starts
+    void SetSchedConfig(const ThreadSchedConfig& sched)
+    {
+        sched_ = sched;
+    }
  
 public:
+    std::atomic<uint64_t> droppedMsgNum_;
     bool isExit_;
     AclLiteThreadStatus status_;
     AclLiteThread* userInstance_;
     std::string name_;
-    ThreadSafeQueue<std::shared_ptr<AclLiteMessage>> msgQueue_;
+    std::unique_ptr<MsgQueue<std::shared_ptr<AclLiteMessage>>> msgQueue_;
+    ThreadSchedConfig sched_;
+    // the metrics labeled by the thread name
+    MetricGauge* queueDepth_;
+    MetricCounter* processedMsgNum_;
+    MetricCounter* processTimeUs_;
+    MetricCounter* droppedMsgMetric_;
+    MetricCounter* enqueueTimeoutNum_;
+    uint32_t queueDepthCollector_;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteThreadSched.h
+* Description: name, cpu affinity and scheduling policy of the threads
+*/
+#ifndef ACLLITE_THREAD_SCHED_H
+#define ACLLITE_THREAD_SCHED_H
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "AclLiteError.h"
+
+struct ThreadSchedConfig {
+    std::vector<int> cpuAffinity;  // the cpus the thread may run on, empty: all cpus
+    int nice = 0;  // the nice value of SCHED_OTHER, -20~19
+    int fifoPriority = 0;  // 1~99: SCHED_FIFO with the priority, 0: SCHED_OTHER
+};
+
+/**
+* @brief set the name of the calling thread shown in top, ps and /proc,
+* it is cut to 15 characters
+* @param [in]: name: the thread name
+*/
+void SetThreadName(const std::string& name);
+
+/**
+* @brief apply the affinity and scheduling policy to the calling thread, the
+* threads created by it later inherit them
+* @param [in]: name: the thread name for log
+* @param [in]: config: the affinity and scheduling policy
+* @return ACLLITE_OK: success; others: some of them can not be applied, the
+* thread keeps running with the default ones
+*/
+AclLiteError ApplyThreadSched(const std::string& name, const ThreadSchedConfig& config);
+
+/**
+* @brief run the function with the calling thread allowed on all cpus of the
+* process, the threads created in it, such as the codec threads of ffmpeg and
+* libx264, are not pinned to the cpus of the calling thread
+* @param [in]: func: the function, such as opening a codec
+* @return the return value of func
+*/
+AclLiteError RunOnAllCpus(const std::function<AclLiteError()>& func);
+
+/**
+* @brief print the user and system cpu time of every thread of the process,
+* read from /proc/self/task
+*/
+void ReportThreadCpuTime();
+
+/**
+* @brief export the user and system cpu time of every thread of the process as
+* acllite_thread_cpu_microseconds_total, read from /proc/self/task on export
+*/
+void AddThreadCpuTimeMetrics();
+
+#endif
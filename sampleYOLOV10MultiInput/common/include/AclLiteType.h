@@ -34,6 +34,14 @@ enum MemoryType {
     MEMORY_INVALID_TYPE
 };
 
+// The geometry of an image resized keeping the aspect ratio and padded to the model input
+struct LetterboxInfo {
+    float scaleX = 1.0f;  // resized width / original width
+    float scaleY = 1.0f;  // resized height / original height
+    uint32_t padLeft = 0;  // x of the resized image in the model input
+    uint32_t padTop = 0;  // y of the resized image in the model input
+};
+
 enum CopyDirection {
     TO_DEVICE = 0,
     TO_HOST,
@@ -62,6 +70,7 @@ struct VencConfig {
     acldvppStreamFormat enType = H264_MAIN_LEVEL;
     aclrtContext context = nullptr;
     aclrtRunMode runMode = ACL_HOST;
+    bool swEncode = false; // encode with libx264 on cpu instead of dvpp venc
 };
 
 struct ImageData {
@@ -72,6 +81,7 @@ struct ImageData {
     uint32_t alignHeight = 0;
     uint32_t size = 0;
     std::shared_ptr<uint8_t> data = nullptr;
+    MemoryType memType = MEMORY_NORMAL; // MEMORY_DVPP: data can be used by dvpp without copy
 };
 
 struct FrameData {
@@ -32,6 +32,8 @@
 #include "acl/ops/acl_dvpp.h"
 #include "AclLiteError.h"
 #include "AclLiteType.h"
+#include "AclLiteMemPool.h"
+#include "AclLiteFramePool.h"
 
 /**
  * @brief calculate RGB 24bits image size
@@ -66,17 +68,27 @@
 
 /**
  * @brief generate shared pointer of dvpp memory
- * @param [in]: buf: memory pointer, malloc by acldvppMalloc
- * @return shared pointer of input buffer
+ * @param [in]: buf: memory pointer, malloc by acldvppMalloc or the dvpp pool
+ * @return shared pointer of input buffer, the buffer is returned to the dvpp pool
  */
-#define SHARED_PTR_DVPP_BUF(buf) (shared_ptr<uint8_t>((uint8_t *)(buf), [](uint8_t* p) { acldvppFree(p); }))
+#define SHARED_PTR_DVPP_BUF(buf) (shared_ptr<uint8_t>((uint8_t *)(buf), \
+    [](uint8_t* p) { AclLiteMemPool::GetDvppPool().Free(p); }))
+
+/**
+ * @brief generate shared pointer of decoded frame
+ * @param [in]: buf: memory pointer, got from the frame pool
+ * @return shared pointer of input buffer, the buffer is returned to the frame pool
+ */
+#define SHARED_PTR_FRAME_BUF(buf) (shared_ptr<uint8_t>((uint8_t *)(buf), \
+    [](uint8_t* p) { AclLiteFramePool::GetInstance().Free(p); }))
 
 /**
  * @brief generate shared pointer of device memory
- * @param [in]: buf: memory pointer, malloc by acldvppMalloc
- * @return shared pointer of input buffer
+ * @param [in]: buf: memory pointer, malloc by aclrtMalloc or the device pool
+ * @return shared pointer of input buffer, the buffer is returned to the device pool
  */
-#define SHARED_PTR_DEV_BUF(buf) (shared_ptr<uint8_t>((uint8_t *)(buf), [](uint8_t* p) { aclrtFree(p); }))
+#define SHARED_PTR_DEV_BUF(buf) (shared_ptr<uint8_t>((uint8_t *)(buf), \
+    [](uint8_t* p) { AclLiteMemPool::GetDevicePool().Free(p); }))
 
 /**
  * @brief generate shared pointer of memory
@@ -20,19 +20,65 @@
 #define ACLLITE_VIDEO_CAP_BASE_H
 #pragma once
 
+#include <chrono>
+#include <thread>
 #include "AclLiteError.h"
 #include "AclLiteType.h"
 
 #define RTSP_TRANS_UDP ((uint32_t)0)
 #define RTSP_TRANS_TCP ((uint32_t)1)
 
+#define CAPTURE_MODE_QUEUE ((uint32_t)0)
+#define CAPTURE_MODE_LATEST ((uint32_t)1)
+
 enum StreamProperty {
     FRAME_WIDTH = 1,
     FRAME_HEIGHT = 2,
     VIDEO_FPS = 3,
     OUTPUT_IMAGE_FORMAT = 4,
     RTSP_TRANSPORT = 5,
-    STREAM_FORMAT = 6
+    STREAM_FORMAT = 6,
+    CAPTURE_MODE = 7,
+    SKIP_NON_REF_FRAME = 8,
+    DECODE_THREAD_NUM = 9
+};
+
+/**
+ * FramePacer: holds the demux of a video file to the frame rate of the file,
+ * used by the latest capture mode which does not wait for the reader
+ */
+class FramePacer {
+public:
+    /**
+     * @brief set the frame rate, the first Wait returns at once
+     * @param [in] fps: the frame rate of the file, no wait when it is not positive
+     */
+    void Init(int fps)
+    {
+        interval_ = (fps > 0) ? std::chrono::microseconds(1000000 / fps) : std::chrono::microseconds(0);
+        started_ = false;
+    }
+
+    /**
+     * @brief sleep until the due time of the next frame, the schedule restarts when
+     *        the caller is more than one frame late, so a stall is not caught up in a burst
+     */
+    void Wait()
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (!started_ || (now > nextFrameTime_ + interval_)) {
+            started_ = true;
+            nextFrameTime_ = now + interval_;
+            return;
+        }
+        std::this_thread::sleep_until(nextFrameTime_);
+        nextFrameTime_ += interval_;
+    }
+
+private:
+    std::chrono::microseconds interval_{0};
+    std::chrono::steady_clock::time_point nextFrameTime_;
+    bool started_ = false;
 };
 
 class AclLiteVideoCapBase {
@@ -30,7 +30,7 @@ public:
     AclLiteVideoProc(uint32_t cameraId, uint32_t width = 1280,
                       uint32_t height = 720, uint32_t fps = 15);
     AclLiteVideoProc(const std::string& videoPath, int32_t deviceId = 0,
-                      aclrtContext context = nullptr);
+                      aclrtContext context = nullptr, bool swDecode = false);
     AclLiteVideoProc(VencConfig& vencConfig,
                      aclrtContext context = nullptr);
     ~AclLiteVideoProc();
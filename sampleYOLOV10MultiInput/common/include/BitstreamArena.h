@@ -0,0 +1,100 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File BitstreamArena.h
+* Description: dvpp buffer ring for the h26x packets sent to vdec
+*/
+#ifndef BITSTREAM_ARENA_H
+#define BITSTREAM_ARENA_H
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include "acl/acl.h"
+#include "AclLiteError.h"
+
+/**
+ * BitstreamArena
+ * One dvpp buffer malloced at init, the demuxed packets are written to it one
+ * after another and wrap at the end, so no dvpp memory is malloced or freed per
+ * packet. A packet is released when vdec returns its input stream desc; vdec
+ * may return them out of order, the space is reused after all older packets
+ * are released. When the arena is full Write waits, so demuxing slows down to
+ * the speed of vdec. In the device run mode the cpu writes the arena directly,
+ * in the host run mode a packet is one host to device copy.
+ */
+class BitstreamArena {
+public:
+    BitstreamArena(uint32_t capacity, aclrtRunMode runMode);
+    ~BitstreamArena();
+
+    /**
+     * @brief malloc the arena in the current context
+     * @return ACLLITE_OK: success; others: malloc failed
+     */
+    AclLiteError Init();
+
+    /**
+     * @brief copy a packet to the arena
+     * @param [in] data: the packet on host
+     * @param [in] size: the packet size
+     * @param [out] buffer: the packet in the arena
+     * @param [in] timeoutMs: the max wait time when the arena is full
+     * @return ACLLITE_OK: success; ACLLITE_ERROR_BITSTREAM_ARENA_FULL: the arena
+     * is still full after timeout; others: the packet can not be written
+     */
+    AclLiteError Write(const void* data, uint32_t size, void*& buffer, uint32_t timeoutMs);
+
+    /**
+     * @brief release a packet written by Write
+     * @param [in] buffer: the packet in the arena
+     * @return true: released; false: the buffer is not in the arena
+     */
+    bool Release(void* buffer);
+
+    uint32_t GetCapacity()
+    {
+        return capacity_;
+    }
+
+    /**
+     * @brief get the statistics
+     * @param [out] writeNum: the packets written
+     * @param [out] waitNum: the writes waited for the arena is full
+     */
+    void GetStats(uint64_t& writeNum, uint64_t& waitNum);
+
+private:
+    struct Packet {
+        uint32_t offset;
+        uint32_t size;
+        bool released;
+    };
+    bool Reserve(uint32_t size, uint32_t& offset);
+
+private:
+    uint32_t capacity_;
+    aclrtRunMode runMode_;
+    uint8_t* base_;
+    std::mutex mutex_;
+    std::condition_variable released_;
+    std::deque<Packet> packets_;  // the packets in the arena, the oldest first
+    uint64_t writeNum_;
+    uint64_t waitNum_;
+};
+
+#endif
@@ -70,11 +70,15 @@ public:
     AclLiteError ProcessCropPaste(ImageData& cropedImage, ImageData& srcImage);
     AclLiteError ProportionProcess(ImageData& resizedImage, ImageData& srcImage);
     AclLiteError ProportionCenterProcess(ImageData& resizedImage, ImageData& srcImage);
+    AclLiteError LetterboxProcess(void* dest, ImageData& srcImage, LetterboxInfo& info);
 
 private:
     AclLiteError InitCropAndPasteResource(ImageData& inputImage);
     AclLiteError InitCropAndPasteInputDesc(ImageData& inputImage);
     AclLiteError InitCropAndPasteOutputDesc();
+    AclLiteError InitLetterboxOutputDesc(void* dest);
+    AclLiteError FillLetterboxPad(uint8_t* dest, uint32_t pasteLeft, uint32_t pasteTop,
+                                  uint32_t pasteWidth, uint32_t pasteHeight);
 
     void DestroyCropAndPasteResource();
 
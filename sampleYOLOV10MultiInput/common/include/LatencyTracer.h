@@ -0,0 +1,131 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File LatencyTracer.h
+* Description: per channel latency of the pipeline stages
+*/
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AclLiteError.h"
+
+/**
+ * LatencyTracer
+ * Every message carries one monotonic timestamp per pipeline stage, stamped by
+ * the thread holding the message, and the last stage records them here. The
+ * latency of a stage is the time from the previous stamp to its stamp, so the
+ * queue waits are counted in the stage after the queue. The latencies are kept
+ * in log-linear histograms per channel for p50/p95/p99, and the stamps of the
+ * first frames can be dumped as a Chrome trace_event json for chrome://tracing
+ * or Perfetto, one row per frame with its stages.
+ * When it is disabled the stages only check one relaxed atomic flag.
+ */
+class LatencyTracer {
+public:
+    /**
+    * @brief get the process wide tracer
+    */
+    static LatencyTracer& GetInstance();
+
+    static bool IsEnabled()
+    {
+        return isEnabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+    * @brief get the monotonic time in microseconds
+    */
+    static uint64_t NowUs();
+
+    /**
+    * @brief start tracing, it must be called before the pipeline starts
+    * @param [in]: stageNames: the names of the stamps in order
+    * @param [in]: traceFile: the Chrome trace json path, empty: no trace file
+    * @param [in]: maxTraceFrames: the max frame number kept for the trace file
+    */
+    void Enable(const std::vector<std::string>& stageNames, const std::string& traceFile,
+                uint32_t maxTraceFrames);
+
+    /**
+    * @brief record the stamps of one frame, the stamps of 0 are skipped
+    * @param [in]: channelId: the channel of the frame
+    * @param [in]: frameId: the frame number in the channel
+    * @param [in]: stageTimeUs: one stamp per stage name
+    */
+    void Record(uint32_t channelId, int frameId, const uint64_t* stageTimeUs);
+
+    /**
+    * @brief print the latency percentiles of every channel and write the trace file
+    */
+    void Report();
+
+private:
+    LatencyTracer();
+    ~LatencyTracer() = default;
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    class LatencyHistogram {
+    public:
+        LatencyHistogram();
+        void Add(uint64_t us);
+        uint64_t Percentile(double percent) const;
+        uint64_t GetCount() const
+        {
+            return count_;
+        }
+        uint64_t GetMax() const
+        {
+            return maxUs_;
+        }
+
+    private:
+        std::vector<uint64_t> buckets_;
+        uint64_t count_;
+        uint64_t maxUs_;
+    };
+    struct ChannelLatency {
+        std::vector<LatencyHistogram> stages;
+        LatencyHistogram endToEnd;
+    };
+    struct TraceFrame {
+        uint32_t channelId;
+        int frameId;
+        std::vector<uint64_t> stageTimeUs;
+    };
+
+    void PrintHistogram(uint32_t channelId, const std::string& name, const LatencyHistogram& histogram);
+    AclLiteError WriteTraceFile();
+
+private:
+    static std::atomic<bool> isEnabled_;
+    std::mutex mutex_;
+    std::vector<std::string> stageNames_;
+    std::string traceFile_;
+    uint32_t maxTraceFrames_;
+    uint64_t droppedTraceNum_;
+    bool isReported_;
+    std::map<uint32_t, ChannelLatency> channels_;
+    std::vector<TraceFrame> traceFrames_;
+};
+
+#endif
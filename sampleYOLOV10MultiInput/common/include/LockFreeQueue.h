@@ -0,0 +1,334 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File LockFreeQueue.h
+* Description: bounded lock free ring queue for pipeline message passing
+*/
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <utility>
+
+#define CACHE_LINE_SIZE 64
+
+/**
+ * EventCount lets a thread sleep until a lock free queue changes, the
+ * notifier only takes the mutex when there is a waiter.
+ * Waiter: key = PrepareWait(); recheck the condition; Wait(key, ...) or CancelWait()
+ */
+class EventCount {
+public:
+    EventCount() : waiters_(0), epoch_(0) {}
+
+    uint64_t PrepareWait()
+    {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_seq_cst);
+    }
+
+    void CancelWait()
+    {
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /**
+     * @brief wait until notified after PrepareWait
+     * @return true: notified; false: timeout
+     */
+    bool Wait(uint64_t key, const std::chrono::steady_clock::time_point& deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool notified = cv_.wait_until(lock, deadline,
+            [this, key] { return epoch_.load(std::memory_order_relaxed) != key; });
+        waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        return notified;
+    }
+
+    void Notify()
+    {
+        // pairs with the seq_cst increase in PrepareWait
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            epoch_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // every notification is for one message or one free slot, waking all the
+        // producers blocked on a full mpsc queue only lets one of them push
+        cv_.notify_one();
+    }
+
+private:
+    std::atomic<uint32_t> waiters_;
+    std::atomic<uint64_t> epoch_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+/**
+ * Bounded ring queue. Every slot carries a sequence number, so a slot value
+ * is only accessed by the thread which owns the slot:
+ * - seq == pos: the slot is free for the producer of position pos
+ * - seq == pos + 1: the slot holds the data of position pos
+ * The consumer side always claims slots by CAS, so the producer can drop the
+ * oldest data (ForcePush) while the consumer is popping.
+ * multiProducer false: single producer, the producer index is not contended
+ * multiProducer true: any number of producers claim slots by CAS
+ * The interface is the same as ThreadSafeQueue, T must be nullable like shared_ptr.
+ */
+template<typename T, bool multiProducer>
+class RingQueue {
+public:
+    /**
+     * @brief RingQueue constructor
+     * @param [in] capacity: the queue capacity
+     */
+    RingQueue(uint32_t capacity)
+        : capacity_((capacity >= kMinQueueCapacity && capacity <= kMaxQueueCapacity) ?
+                    capacity : kDefaultQueueCapacity),
+          slots_(nullptr), head_(0), tail_(0)
+    {
+        void* buf = nullptr;
+        if (posix_memalign(&buf, CACHE_LINE_SIZE, sizeof(Slot) * capacity_) != 0) {
+            throw std::bad_alloc();
+        }
+        slots_ = static_cast<Slot*>(buf);
+        for (uint32_t i = 0; i < capacity_; i++) {
+            new (&slots_[i]) Slot();
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    /**
+     * @brief RingQueue destructor
+     */
+    ~RingQueue()
+    {
+        for (uint32_t i = 0; i < capacity_; i++) {
+            slots_[i].~Slot();
+        }
+        free(slots_);
+    }
+
+    /**
+     * @brief push data to queue
+     * @param [in] input_value: the value will push to the queue
+     * @return true: success to push data; false: the queue is full
+     */
+    bool Push(T input_value)
+    {
+        if (!Enqueue(input_value)) {
+            return false;
+        }
+        notEmpty_.Notify();
+        return true;
+    }
+
+    /**
+     * @brief push data to queue, wait until the queue is not full
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] timeoutMs: the max wait time in milliseconds
+     * @return true: success to push data; false: the queue is still full after timeout
+     */
+    bool WaitPush(T input_value, uint32_t timeoutMs)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (!Enqueue(input_value)) {
+            uint64_t key = notFull_.PrepareWait();
+            if (Enqueue(input_value)) {
+                notFull_.CancelWait();
+                break;
+            }
+            if (!notFull_.Wait(key, deadline)) {
+                if (!Enqueue(input_value)) {
+                    return false;
+                }
+                break;
+            }
+        }
+        notEmpty_.Notify();
+        return true;
+    }
+
+    /**
+     * @brief push data to queue, drop the oldest data when the queue is full
+     * @param [in] input_value: the value will push to the queue
+     * @return the dropped data; nullptr: no data is dropped
+     */
+    T ForcePush(T input_value)
+    {
+        T dropped = nullptr;
+        while (!Enqueue(input_value)) {
+            T oldest = Dequeue();
+            if (oldest != nullptr) {
+                dropped = oldest;
+            }
+        }
+        notEmpty_.Notify();
+        return dropped;
+    }
+
+    /**
+     * @brief pop data from queue
+     * @return the data poped from queue; nullptr: the queue is empty
+     */
+    T Pop()
+    {
+        T value = Dequeue();
+        if (value != nullptr) {
+            notFull_.Notify();
+        }
+        return value;
+    }
+
+    /**
+     * @brief pop data from queue, wait until the queue is not empty
+     * @param [in] timeoutMs: the max wait time in milliseconds
+     * @return the data poped from queue; nullptr: the queue is still empty after timeout
+     */
+    T WaitPop(uint32_t timeoutMs)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        T value = Dequeue();
+        while (value == nullptr) {
+            uint64_t key = notEmpty_.PrepareWait();
+            value = Dequeue();
+            if (value != nullptr) {
+                notEmpty_.CancelWait();
+                break;
+            }
+            if (!notEmpty_.Wait(key, deadline)) {
+                value = Dequeue();
+                if (value == nullptr) {
+                    return nullptr;
+                }
+                break;
+            }
+            value = Dequeue();
+        }
+        notFull_.Notify();
+        return value;
+    }
+
+    /**
+     * @brief check the queue is empty
+     * @return true: the queue is empty; false: the queue is not empty
+     */
+    bool Empty()
+    {
+        return Size() == 0;
+    }
+
+    /**
+     * @brief get the queue size, it is a snapshot when other threads are running
+     * @return the queue size
+     */
+    uint32_t Size()
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        return (tail > head) ? (uint32_t)(tail - head) : 0;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<uint64_t> seq;
+        T value;
+    };
+
+    bool Enqueue(T& input_value)
+    {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos % capacity_];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)pos;
+            if (diff < 0) {
+                return false;
+            }
+            if (diff > 0) {
+                pos = tail_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (!multiProducer) {
+                tail_.store(pos + 1, std::memory_order_relaxed);
+            } else if (!tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                continue;
+            }
+            slot.value = std::move(input_value);
+            slot.seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+    }
+
+    T Dequeue()
+    {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots_[pos % capacity_];
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)(pos + 1);
+            if (diff < 0) {
+                return nullptr;
+            }
+            if (diff > 0) {
+                pos = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (!head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                continue;
+            }
+            T value = std::move(slot.value);
+            slot.value = nullptr;
+            slot.seq.store(pos + capacity_, std::memory_order_release);
+            return value;
+        }
+    }
+
+private:
+    const uint32_t kMinQueueCapacity = 1; // the minimum queue capacity
+    const uint32_t kMaxQueueCapacity = 10000; // the maximum queue capacity
+    const uint32_t kDefaultQueueCapacity = 10; // default queue capacity
+    const uint32_t capacity_;
+    Slot* slots_;
+    // the padding keeps consumer and producer positions in separate cache lines
+    char pad0_[CACHE_LINE_SIZE];
+    std::atomic<uint64_t> head_; // consumer position
+    char pad1_[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail_; // producer position
+    char pad2_[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+    EventCount notEmpty_;
+    EventCount notFull_;
+};
+
+template<typename T>
+using SpscRingQueue = RingQueue<T, false>;
+
+template<typename T>
+using MpscRingQueue = RingQueue<T, true>;
+
+#endif
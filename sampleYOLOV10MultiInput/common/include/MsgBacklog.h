@@ -0,0 +1,116 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File MsgBacklog.h
+* Description: non-blocking message sending with a backlog per key
+*/
+#ifndef MSG_BACKLOG_H
+#define MSG_BACKLOG_H
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "AclLiteError.h"
+
+/**
+ * MsgBacklog
+ * Sends the messages of many keys (channels) from shared threads without blocking
+ * them on a full destination queue. A message is sent at once if the queue has
+ * room and no earlier message of its key is waiting, otherwise it waits in the
+ * backlog of its key, and a flush thread retries the backlogs until the
+ * destinations take them. The messages of one key are sent in order, a slow
+ * destination only delays its own key.
+ */
+class MsgBacklog {
+public:
+    /**
+     * @brief send without waiting
+     * @return ACLLITE_OK: sent; ACLLITE_ERROR_ENQUEUE: the destination queue is full;
+     *         others: the message can not be sent
+     */
+    using SendFunc = std::function<AclLiteError(int dest, int msgId, std::shared_ptr<void> data)>;
+
+    /**
+     * @brief send by SendMessage of AclLiteApp
+     */
+    MsgBacklog();
+    MsgBacklog(SendFunc sendFunc);
+    ~MsgBacklog();
+
+    /**
+     * @brief create the flush thread
+     * @param [in] name: the name of the flush thread
+     * @return ACLLITE_OK: success; ACLLITE_ERROR_INITED_ALREADY: started already
+     */
+    AclLiteError Start(const std::string& name = "backlog");
+
+    /**
+     * @brief send the message now, or queue it behind the waiting messages of the key
+     * @param [in] key: the messages of the same key keep their order
+     * @param [in] dest: destination thread instance id
+     * @param [in] msgId: message id
+     * @param [in] data: message data
+     * @return ACLLITE_OK: sent or queued; ACLLITE_ERROR_POOL_STOPPED: not started;
+     *         others: the error of the send
+     */
+    AclLiteError Send(uint32_t key, int dest, int msgId, std::shared_ptr<void> data);
+
+    /**
+     * @brief wait until the messages waiting for the key are less than maxNum
+     * @param [in] key: the key
+     * @param [in] maxNum: the max waiting messages
+     * @param [in] timeoutMs: max wait time
+     * @return true: below maxNum; false: timeout
+     */
+    bool WaitBelow(uint32_t key, size_t maxNum, uint32_t timeoutMs);
+
+    /**
+     * @brief send the waiting messages and join the flush thread
+     */
+    void Stop();
+
+private:
+    struct WaitingMsg {
+        int dest;
+        int msgId;
+        std::shared_ptr<void> data;
+    };
+
+    void FlushRun();
+    void FlushKey(std::deque<WaitingMsg>& backlog);
+
+private:
+    SendFunc sendFunc_;
+    std::string name_;
+    std::mutex mutex_;
+    std::condition_variable msgAdded_;
+    std::condition_variable msgSent_;
+    std::map<uint32_t, std::deque<WaitingMsg>> backlogs_;
+    size_t waitingNum_;  // messages in all backlogs
+    uint64_t backloggedNum_;  // messages which were not sent at once
+    size_t maxWaitingNum_;
+    std::thread flushThread_;
+    bool isRunning_;
+    bool isStopping_;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File MsgQueue.h
+* Description: message queue interface of AclLite thread
+*/
+#ifndef MSG_QUEUE_H
+#define MSG_QUEUE_H
+#pragma once
+#include <cstdint>
+#include "ThreadSafeQueue.h"
+#include "LockFreeQueue.h"
+
+// The implementation of thread message queue
+enum AclLiteQueueType {
+    QUEUE_TYPE_MUTEX = 0, // mutex and std::queue, any number of producers
+    QUEUE_TYPE_SPSC = 1,  // lock free ring, only one thread sends to the queue
+    QUEUE_TYPE_MPSC = 2,  // lock free ring, any number of producers
+};
+
+template<typename T>
+class MsgQueue {
+public:
+    virtual ~MsgQueue() {};
+    virtual bool Push(T value) = 0;
+    virtual bool WaitPush(T value, uint32_t timeoutMs) = 0;
+    virtual T ForcePush(T value) = 0;
+    virtual T Pop() = 0;
+    virtual T WaitPop(uint32_t timeoutMs) = 0;
+    virtual bool Empty() = 0;
+    virtual uint32_t Size() = 0;
+};
+
+template<typename T, typename Queue>
+class MsgQueueImpl : public MsgQueue<T> {
+public:
+    MsgQueueImpl(uint32_t capacity) : queue_(capacity) {}
+    ~MsgQueueImpl() {}
+    bool Push(T value)
+    {
+        return queue_.Push(value);
+    }
+    bool WaitPush(T value, uint32_t timeoutMs)
+    {
+        return queue_.WaitPush(value, timeoutMs);
+    }
+    T ForcePush(T value)
+    {
+        return queue_.ForcePush(value);
+    }
+    T Pop()
+    {
+        return queue_.Pop();
+    }
+    T WaitPop(uint32_t timeoutMs)
+    {
+        return queue_.WaitPop(timeoutMs);
+    }
+    bool Empty()
+    {
+        return queue_.Empty();
+    }
+    uint32_t Size()
+    {
+        return queue_.Size();
+    }
+
+private:
+    Queue queue_;
+};
+
+template<typename T>
+MsgQueue<T>* CreateMsgQueue(AclLiteQueueType type, uint32_t capacity)
+{
+    switch (type) {
+        case QUEUE_TYPE_SPSC:
+            return new MsgQueueImpl<T, SpscRingQueue<T>>(capacity);
+        case QUEUE_TYPE_MPSC:
+            return new MsgQueueImpl<T, MpscRingQueue<T>>(capacity);
+        default:
+            return new MsgQueueImpl<T, ThreadSafeQueue<T>>(capacity);
+    }
+}
+
+#endif
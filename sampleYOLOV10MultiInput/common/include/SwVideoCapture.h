@@ -0,0 +1,122 @@
+/**
+ * ============================================================================
+ *
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   1 Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *   2 Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *   3 Neither the names of the copyright holders nor the names of the
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ============================================================================
+ */
+
+#ifndef SW_VIDEO_CAPTURE_H
+#define SW_VIDEO_CAPTURE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ThreadSafeQueue.h"
+#include "VideoCapture.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+/**
+ * SwVideoCapture
+ * The software backend of the video capture, it has the same interface as
+ * VideoCapture (dvpp vdec). The stream is demuxed by FFmpegDecoder and decoded
+ * by libavcodec with frame threading, so the channel does not take a vdec
+ * channel. The output is NV12 in the same layout as vdec: the width stride is
+ * ALIGN_UP16(width), the height stride is ALIGN_UP2(height), and the buffer is
+ * got from AclLiteFramePool, so the rest of the pipeline does not know which
+ * backend decoded the frame.
+ */
+class SwVideoCapture : public AclLiteVideoCapBase {
+public:
+    /**
+     * @brief SwVideoCapture constructor
+     */
+    SwVideoCapture(const std::string& videoName, int32_t deviceId = 0, aclrtContext context = nullptr);
+
+    /**
+     * @brief SwVideoCapture destructor
+     */
+    ~SwVideoCapture();
+    bool IsOpened();
+    AclLiteError Set(StreamProperty key, uint32_t value);
+    uint32_t Get(StreamProperty key);
+    AclLiteError Read(ImageData& image);
+    AclLiteError Close();
+    AclLiteError Open();
+    void DestroyResource();
+
+private:
+    AclLiteError InitResource();
+    AclLiteError InitCodec();
+    static void DecodeThreadEntry(SwVideoCapture* thisPtr);
+    static AclLiteError PacketCallback(void* decoder, void* frameData, int frameSize);
+    AclLiteError DecodePacket(AVPacket* packet);
+    AclLiteError OutputFrame(AVFrame* frame);
+    AclLiteError ConvertToNv12(AVFrame* frame, uint8_t* dest, uint32_t alignWidth, uint32_t alignHeight);
+    AclLiteError FrameEnQueue(std::shared_ptr<ImageData> image);
+    void PushEndOfStream();
+    ThreadSafeQueue<std::shared_ptr<ImageData>>& OutputQueue();
+
+private:
+    bool isReleased_;
+    std::atomic<bool> isStop_;
+    std::atomic<int> status_;
+    int32_t deviceId_;
+    aclrtContext context_;
+    aclrtRunMode runMode_;
+    int statsId_; // the frame pool statistics id, it does not overlap the vdec channels
+    std::string streamName_;
+    uint32_t captureMode_;
+    bool skipNonRefFrame_;
+    bool isRtsp_;
+    FramePacer framePacer_; // the demux of a file in latest mode
+    int threadNum_;
+    FFmpegDecoder* ffmpegDecoder_;
+    const AVCodec* codec_;
+    AVCodecContext* codecCtx_;
+    AVPacket* pkt_;
+    AVFrame* frame_;
+    SwsContext* swsCtx_;
+    std::vector<uint8_t> hostFrame_; // the NV12 frame converted on host before copy to device
+    uint64_t decodedFrameNum_;
+    uint64_t overwrittenFrameNum_;
+    MetricCounter* decodedFrameMetric_;
+    MetricCounter* overwrittenFrameMetric_;
+    ThreadSafeQueue<std::shared_ptr<ImageData>> frameImageQueue_;
+    ThreadSafeQueue<std::shared_ptr<ImageData>> latestFrame_; // single slot mailbox of latest mode
+    std::thread decodeThread_;
+};
+
+#endif
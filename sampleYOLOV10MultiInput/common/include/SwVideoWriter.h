@@ -0,0 +1,96 @@
+/**
+ * ============================================================================
+ *
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   1 Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *   2 Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *   3 Neither the names of the copyright holders nor the names of the
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ============================================================================
+ */
+
+#ifndef SW_VIDEO_WRITER_H
+#define SW_VIDEO_WRITER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include "ThreadSafeQueue.h"
+#include "AclLiteVideoProc.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * SwVideoWriter
+ * The software backend of the video writer, it has the same interface as
+ * VideoWriter (dvpp venc). The NV12 images are encoded by libx264 on a
+ * separate thread and the h264 raw stream is written to VencConfig::outFile,
+ * so the output also works on a host without dvpp.
+ * The image data must be accessible by cpu: host memory, or dvpp memory when
+ * the app runs on the device.
+ */
+class SwVideoWriter : public AclLiteVideoCapBase {
+public:
+    /**
+     * @brief SwVideoWriter constructor
+     */
+    SwVideoWriter(VencConfig& vencConfig, aclrtContext context = nullptr);
+
+    /**
+     * @brief SwVideoWriter destructor
+     */
+    ~SwVideoWriter();
+    bool IsOpened();
+    uint32_t Get(StreamProperty key);
+    AclLiteError Read(ImageData& image);
+    AclLiteError Close();
+    AclLiteError Open();
+    void DestroyResource();
+
+private:
+    AclLiteError InitEncoder();
+    static void EncodeThreadEntry(SwVideoWriter* thisPtr);
+    AclLiteError EncodeImage(std::shared_ptr<ImageData> image);
+    AclLiteError WritePackets();
+
+private:
+    bool isReleased_;
+    std::atomic<int> status_;
+    aclrtContext context_;
+    VencConfig vencInfo_;
+    AVCodecContext* codecCtx_;
+    AVPacket* pkt_;
+    FILE* outFp_;
+    int64_t pts_;
+    ThreadSafeQueue<std::shared_ptr<ImageData>> frameImageQueue_;
+    std::thread encodeThread_;
+};
+
+#endif
@@ -34,6 +34,8 @@
 #ifndef THREAD_SAFE_QUEUE_H
 #define THREAD_SAFE_QUEUE_H
 
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <queue>
 
@@ -80,12 +82,51 @@ public:
         // check current size is less than capacity
         if (queue_.size() < queueCapacity) {
             queue_.push(input_value);
+            notEmpty_.notify_one();
             return true;
         }
 
         return false;
     }
 
+    /**
+     * @brief push data to queue, wait until the queue is not full
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] timeoutMs: the max wait time in milliseconds
+     * @return true: success to push data; false: the queue is still full after timeout
+     */
+    bool WaitPush(T input_value, uint32_t timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!notFull_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                               [this] { return queue_.size() < queueCapacity; })) {
+            return false;
+        }
+
+        queue_.push(input_value);
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief push data to queue, drop the oldest data when the queue is full
+     * @param [in] input_value: the value will push to the queue
+     * @return the dropped data; nullptr: no data is dropped
+     */
+    T ForcePush(T input_value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        T dropped = nullptr;
+        if (queue_.size() >= queueCapacity) {
+            dropped = queue_.front();
+            queue_.pop();
+        }
+
+        queue_.push(input_value);
+        notEmpty_.notify_one();
+        return dropped;
+    }
+
     /**
      * @brief pop data from queue
      * @return true: success to pop data; false: fail to pop data
@@ -99,9 +140,42 @@ public:
 
         T tmp_ptr = queue_.front();
         queue_.pop();
+        notFull_.notify_all();
         return tmp_ptr;
     }
 
+    /**
+     * @brief pop data from queue, wait until the queue is not empty
+     * @param [in] timeoutMs: the max wait time in milliseconds
+     * @return the data poped from queue; nullptr: the queue is still empty after timeout
+     */
+    T WaitPop(uint32_t timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!notEmpty_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                [this] { return !queue_.empty(); })) {
+            return nullptr;
+        }
+
+        T tmp_ptr = queue_.front();
+        queue_.pop();
+        notFull_.notify_all();
+        return tmp_ptr;
+    }
+
+    /**
+     * @brief wait until the queue size is less than the given size
+     * @param [in] size: the size to wait for
+     * @param [in] timeoutMs: the max wait time in milliseconds
+     * @return true: the queue size is less than size; false: timeout
+     */
+    bool WaitSizeBelow(uint32_t size, uint32_t timeoutMs)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return notFull_.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                                 [this, size] { return queue_.size() < size; });
+    }
+
     /**
      * @brief check the queue is empty
      * @return true: the queue is empty; false: the queue is not empty
@@ -132,6 +206,8 @@ private:
     std::queue<T> queue_; // the queue
     uint32_t queueCapacity; // queue capacity
     mutable std::mutex mutex_; // the mutex value
+    std::condition_variable notEmpty_; // notified when data is pushed
+    std::condition_variable notFull_; // notified when data is poped, waiters may wait for different sizes
     const uint32_t kMinQueueCapacity = 1; // the minimum queue capacity
     const uint32_t kMaxQueueCapacity = 10000; // the maximum queue capacity
     const uint32_t kDefaultQueueCapacity = 10; // default queue capacity
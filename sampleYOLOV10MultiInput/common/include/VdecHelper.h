@@ -33,6 +33,13 @@ public:
     {
         return isExit_;
     }
+    /**
+     * @brief stop waiting for a free frame, the decoder is closing
+     */
+    void Stop()
+    {
+        isStopped_ = true;
+    }
     aclrtContext GetContext()
     {
         return context_ ;
@@ -42,6 +49,7 @@ private:
     AclLiteError CreateVdecChannelDesc();
     AclLiteError CreateInputStreamDesc(std::shared_ptr<FrameData> frame);
     AclLiteError CreateOutputPicDesc(size_t size);
+    void DestroyUnsentDesc();
     void UnsubscribReportThread();
 
 private:
@@ -76,6 +84,7 @@ private:
     pthread_t subscribeThreadId_;
     bool isExit_;
     bool isReleased_;
+    bool isStopped_;
 };
 
 #endif
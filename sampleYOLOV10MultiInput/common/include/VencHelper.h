@@ -10,14 +10,26 @@
 #ifndef VENC_HELPER_H
 #define VENC_HELPER_H
 #pragma once
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <iostream>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include "acl/acl.h"
 #include "acl/ops/acl_dvpp.h"
 #include "AclLiteUtils.h"
 #include "ThreadSafeQueue.h"
 
+// One input frame of the venc, it is reused after the frame is encoded
+struct VencInputSlot {
+    acldvppPicDesc* picDesc = nullptr;
+    void* buffer = nullptr; // dvpp buffer owned by the slot
+    uint32_t bufferSize = 0;
+    std::shared_ptr<uint8_t> image = nullptr; // the dvpp image encoded without copy
+};
+
 class DvppVenc {
 public:
     DvppVenc(VencConfig &vencConfig);
@@ -27,10 +39,31 @@ public:
     AclLiteError Process(ImageData &image);
     void Finish();
 
+    /**
+     * @brief get the number of frames sent to venc and not encoded yet
+     * @return the in-flight frame number
+     */
+    uint32_t GetInFlightNum()
+    {
+        return inFlightNum_;
+    }
+
+    /**
+     * @brief get the number of frames encoded from the dvpp image without copy
+     * @return the zero copy frame number
+     */
+    uint64_t GetZeroCopyFrameNum()
+    {
+        return zeroCopyFrameNum_;
+    }
+
 private:
     AclLiteError InitResource();
     AclLiteError CreateVencChannel();
-    AclLiteError CreateInputPicDesc(ImageData& image);
+    AclLiteError CreateInputSlots();
+    AclLiteError CreateInputPicDesc(ImageData& image, VencInputSlot* slot);
+    void ReleaseInputSlot(acldvppPicDesc* picDesc);
+    void DestroyInputSlots();
     AclLiteError CreateFrameConfig();
     AclLiteError SetFrameConfig(uint8_t eos, uint8_t forceIFrame);
     AclLiteError SaveVencFile(void* vencData, uint32_t size);
@@ -45,9 +78,21 @@ private:
     pthread_t threadId_;
     aclvencChannelDesc *vencChannelDesc_;
     aclvencFrameConfig *vencFrameConfig_;
-    acldvppPicDesc *inputPicDesc_;
     aclrtStream vencStream_;
 
+    // the input slots are recycled in Callback, the free number limits the in-flight frames
+    std::vector<VencInputSlot> inputSlots_;
+    ThreadSafeQueue<VencInputSlot*> freeSlots_;
+    std::atomic<uint32_t> inFlightNum_;
+    // signalled by Callback when an in-flight frame is released
+    std::mutex inFlightMutex_;
+    std::condition_variable inFlightCond_;
+    uint32_t maxInFlightNum_;
+    uint64_t sendFrameNum_;
+    uint64_t zeroCopyFrameNum_;
+
+    // the callbacks write the file, Finish closes it
+    std::mutex fileMutex_;
     FILE *outFp_;
     bool isFinished_;
 };
@@ -62,7 +107,9 @@ public:
 
     void SetStatus(VencStatus status)
     {
+        std::lock_guard<std::mutex> lock(statusMutex_);
         status_ = status;
+        statusCond_.notify_all();
     }
     void DestroyResource();
     VencStatus GetStatus()
@@ -73,11 +120,15 @@ public:
 private:
     static void AsyncVencThreadEntry(void* arg);
     std::shared_ptr<ImageData> GetEncodeImage();
+    void WaitStatusLeave(VencStatus status);
 
 private:
     VencConfig vencInfo_;
     VencStatus status_;
-    DvppVenc* vencProc_;
+    std::mutex statusMutex_;
+    std::condition_variable statusCond_;
+    // the dvpp images are expected to be encoded without copy
+    std::atomic<uint64_t> dvppImageNum_;
     ThreadSafeQueue<std::shared_ptr<ImageData>> frameImageQueue_;
 };
 
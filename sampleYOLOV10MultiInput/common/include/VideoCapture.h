@@ -44,8 +44,12 @@
 #include <memory>
 #include <vector>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "ThreadSafeQueue.h"
+#include "AclLiteMetrics.h"
 #include "VdecHelper.h"
+#include "BitstreamArena.h"
 #include "AclLiteVideoProc.h"
 
 extern "C" {
@@ -200,26 +204,20 @@ public:
     bool IsOpened();
     AclLiteError Open();
 
-    void SetEnd()
-    {
-        isFrameDecodeEnd_ = true;
-    }
+    void SetEnd();
 
     bool GetEnd()
     {
         return isFrameDecodeEnd_;
     }
 
-    void SetStatus(DecodeStatus status)
-    {
-        status_ = status;
-    }
+    void SetStatus(DecodeStatus status);
     DecodeStatus GetStatus()
     {
         return status_;
     }
     
-    AclLiteError Set(StreamProperty key, int value);
+    AclLiteError Set(StreamProperty key, uint32_t value);
     uint32_t Get(StreamProperty key);
 
     void SleeptoNextFrameTime();
@@ -243,8 +241,16 @@ private:
     void StartFrameDecoder();
     int GetVdecType();
     AclLiteError FrameImageEnQueue(std::shared_ptr<ImageData> frameData);
-    std::shared_ptr<ImageData> FrameImageOutQueue(bool noWait = false);
+    std::shared_ptr<ImageData> FrameImageOutQueue();
+    ThreadSafeQueue<std::shared_ptr<ImageData>>& OutputQueue();
+    void PushEndOfStream();
+    void CheckDvppFinished();
+    void WaitDecodeEnd();
     AclLiteError SetRtspTransType(uint32_t transCode);
+    AclLiteError SetCaptureMode(uint32_t mode);
+    bool IsNonRefFrame(const uint8_t* data, int size);
+    void* WritePacket(void* frameData, int frameSize);
+    void ReleasePacket(void* buffer);
 
 private:
     bool isStop_;
@@ -262,11 +268,25 @@ private:
     uint32_t finFrameCnt_;
     int64_t lastDecodeTime_;
     int64_t fpsInterval_;
+    FramePacer framePacer_; // the demux of a file in latest mode
     std::string streamName_;
     std::thread decodeThread_;
     FFmpegDecoder* ffmpegDecoder_;
     VdecHelper* dvppVdec_;
+    BitstreamArena* bitstreamArena_;
+    uint64_t poolPacketNum_; // the packets copied to the dvpp pool instead of the arena
     ThreadSafeQueue<std::shared_ptr<ImageData>> frameImageQueue_;
+    ThreadSafeQueue<std::shared_ptr<ImageData>> latestFrame_; // single slot mailbox of latest mode
+    uint32_t captureMode_;
+    bool skipNonRefFrame_;
+    uint64_t skippedFrameNum_;
+    uint64_t overwrittenFrameNum_;
+    MetricCounter* decodedFrameMetric_;
+    MetricCounter* skippedFrameMetric_;
+    MetricCounter* overwrittenFrameMetric_;
+    MetricCounter* lostFrameMetric_;
+    std::mutex statusMutex_;
+    std::condition_variable statusCond_; // notified when status_ or isFrameDecodeEnd_ changes
     int videoChannelMax_;
 };
 
@@ -0,0 +1,121 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File WorkStealingPool.h
+* Description: thread pool with one task deque per worker
+*/
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AclLiteError.h"
+#include "AclLiteThreadSched.h"
+
+struct WorkStealingStats {
+    uint64_t executedNum = 0;  // tasks run by the worker
+    uint64_t stolenNum = 0;    // tasks the worker took from the other workers
+    uint64_t stealNum = 0;     // successful steals of the worker
+};
+
+/**
+ * WorkStealingPool
+ * Every worker owns a deque. A task is pushed to the worker chosen by its hint,
+ * so the tasks with the same hint stay on one worker while it keeps up. The
+ * owner runs its tasks from the front in submit order; a worker with an empty
+ * deque steals the newer half from the back of another worker's deque, so a
+ * burst on one hint is spread over the idle workers. The idle workers sleep
+ * until a task is submitted.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @param [in] workerId: the worker running the task
+     */
+    using Task = std::function<void(uint32_t workerId)>;
+
+    WorkStealingPool();
+    ~WorkStealingPool();
+
+    /**
+     * @brief create the workers
+     * @param [in] workerNum: the worker number, 0: the number of cpu cores
+     * @param [in] name: the workers are named name + worker id
+     * @param [in] sched: the affinity and scheduling policy of the workers
+     * @return ACLLITE_OK: success; ACLLITE_ERROR_INITED_ALREADY: started already
+     */
+    AclLiteError Start(uint32_t workerNum, const std::string& name = "worker",
+                       const ThreadSchedConfig& sched = ThreadSchedConfig());
+
+    /**
+     * @brief push a task to the deque of worker hint % workerNum
+     * @param [in] task: the task
+     * @param [in] hint: the tasks with the same hint prefer the same worker
+     * @return ACLLITE_OK: success; ACLLITE_ERROR_POOL_STOPPED: the pool is not running
+     */
+    AclLiteError Submit(Task task, uint32_t hint);
+
+    /**
+     * @brief run the tasks left in the deques and join the workers
+     */
+    void Stop();
+
+    uint32_t GetWorkerNum() const
+    {
+        return workers_.size();
+    }
+
+    /**
+     * @brief get the statistics of one worker
+     * @param [in] workerId: the worker
+     * @param [out] stats: the statistics
+     */
+    void GetWorkerStats(uint32_t workerId, WorkStealingStats& stats) const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+        std::atomic<uint64_t> executedNum{0};
+        std::atomic<uint64_t> stolenNum{0};
+        std::atomic<uint64_t> stealNum{0};
+    };
+
+    void WorkerRun(uint32_t workerId);
+    bool PopLocal(uint32_t workerId, Task& task);
+    bool Steal(uint32_t workerId, Task& task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::string name_;
+    ThreadSchedConfig sched_;
+    std::atomic<bool> isRunning_;
+    std::atomic<uint64_t> pendingNum_;  // tasks in all deques
+    std::mutex idleMutex_;
+    std::condition_variable taskAdded_;
+    bool isStopping_;
+};
+
+#endif
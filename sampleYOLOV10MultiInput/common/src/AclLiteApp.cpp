@@ -14,6 +14,7 @@
 using namespace std;
 namespace {
 const uint32_t kWaitInterval = 10000;
+const uint32_t kWaitMsgTimeoutMs = 10;
 const uint32_t kThreadExitRetry = 3;
 }
 
@@ -37,9 +38,10 @@ AclLiteError AclLiteApp::Init()
 }
 
 int AclLiteApp::CreateAclLiteThread(AclLiteThread* thInst, const string& instName,
-                                    aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize)
+                                    aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize,
+                                    AclLiteQueueType msgQueueType)
 {
-    int instId = CreateAclLiteThreadMgr(thInst, instName, context, runMode, msgQueueSize);
+    int instId = CreateAclLiteThreadMgr(thInst, instName, context, runMode, msgQueueSize, msgQueueType);
     if (instId == INVALID_INSTANCE_ID) {
         ACLLITE_LOG_ERROR("Add thread instance %s failed", instName.c_str());
         return INVALID_INSTANCE_ID;
@@ -56,7 +58,8 @@ int AclLiteApp::CreateAclLiteThread(AclLiteThread* thInst, const string& instNam
 }
 
 int AclLiteApp::CreateAclLiteThreadMgr(AclLiteThread* thInst, const string& instName,
-                                       aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize)
+                                       aclrtContext context, aclrtRunMode runMode, const uint32_t msgQueueSize,
+                                       AclLiteQueueType msgQueueType)
 {
     if (!CheckThreadNameUnique(instName)) {
         ACLLITE_LOG_ERROR("The thread instance name is not unique");
@@ -70,7 +73,7 @@ int AclLiteApp::CreateAclLiteThreadMgr(AclLiteThread* thInst, const string& inst
         return INVALID_INSTANCE_ID;
     }
 
-    AclLiteThreadMgr* thMgr = new AclLiteThreadMgr(thInst, instName, msgQueueSize);
+    AclLiteThreadMgr* thMgr = new AclLiteThreadMgr(thInst, instName, msgQueueSize, msgQueueType);
     threadList_.push_back(thMgr);
 
     return instId;
@@ -98,12 +101,14 @@ int AclLiteApp::Start(vector<AclLiteThreadParam>& threadParamTbl)
                                             threadParamTbl[i].threadInstName,
                                             threadParamTbl[i].context,
                                             threadParamTbl[i].runMode,
-                                            threadParamTbl[i].queueSize);
+                                            threadParamTbl[i].queueSize,
+                                            threadParamTbl[i].queueType);
         if (instId == INVALID_INSTANCE_ID) {
             ACLLITE_LOG_ERROR("Create thread instance failed");
             return ACLLITE_ERROR;
         }
         threadParamTbl[i].threadInstId = instId;
+        threadList_[instId]->SetSchedConfig(threadParamTbl[i].sched);
     }
     // Note:The instance id must generate first, then create thread,
     // for the user thread get other thread instance id in Init function
@@ -154,6 +159,39 @@ AclLiteError AclLiteApp::SendMessage(int dest, int msgId, shared_ptr<void> data)
     return threadList_[dest]->PushMsgToQueue(pMessage);
 }
 
+AclLiteError AclLiteApp::SendMessageBlocking(int dest, int msgId, shared_ptr<void> data,
+                                             uint32_t timeoutMs, AclLiteQueuePolicy policy,
+                                             shared_ptr<AclLiteMessage>* droppedMsg)
+{
+    if ((dest < 0) || ((uint32_t)dest >= threadList_.size())) {
+        ACLLITE_LOG_ERROR("Send message to %d failed for thread not exist", dest);
+        return ACLLITE_ERROR_DEST_INVALID;
+    }
+
+    shared_ptr<AclLiteMessage> pMessage = make_shared<AclLiteMessage>();
+    pMessage->dest = dest;
+    pMessage->msgId = msgId;
+    pMessage->data = data;
+
+    AclLiteError ret;
+    switch (policy) {
+        case QUEUE_POLICY_DROP_OLDEST:
+            ret = threadList_[dest]->ForcePushMsgToQueue(pMessage, droppedMsg);
+            break;
+        case QUEUE_POLICY_DROP_NEWEST:
+            ret = threadList_[dest]->PushMsgToQueue(pMessage);
+            if (ret == ACLLITE_ERROR_ENQUEUE) {
+                threadList_[dest]->RecordDroppedMsg();
+            }
+            break;
+        default:
+            ret = threadList_[dest]->WaitPushMsgToQueue(pMessage, timeoutMs);
+            break;
+    }
+
+    return ret;
+}
+
 void AclLiteApp::Wait()
 {
     while (true) {
@@ -186,9 +224,8 @@ void AclLiteApp::Wait(AclLiteMsgProcess msgProcess, void* param)
     while (true) {
         if (waitEnd_) break;
 
-        shared_ptr<AclLiteMessage> msg = mainMgr->PopMsgFromQueue();
+        shared_ptr<AclLiteMessage> msg = mainMgr->WaitPopMsgFromQueue(kWaitMsgTimeoutMs);
         if (msg == nullptr) {
-            usleep(kWaitInterval);
             continue;
         }
         int ret = msgProcess(msg->msgId, msg->data, param);
@@ -256,6 +293,14 @@ AclLiteError SendMessage(int dest, int msgId, shared_ptr<void> data)
     return app.SendMessage(dest, msgId, data);
 }
 
+AclLiteError SendMessageBlocking(int dest, int msgId, shared_ptr<void> data,
+                                 uint32_t timeoutMs, AclLiteQueuePolicy policy,
+                                 shared_ptr<AclLiteMessage>* droppedMsg)
+{
+    AclLiteApp& app = AclLiteApp::GetInstance();
+    return app.SendMessageBlocking(dest, msgId, data, timeoutMs, policy, droppedMsg);
+}
+
 int GetAclLiteThreadIdByName(const string& threadName)
 {
     AclLiteApp& app = AclLiteApp::GetInstance();
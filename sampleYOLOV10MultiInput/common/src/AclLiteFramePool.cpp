@@ -0,0 +1,180 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteFramePool.cpp
+* Description: process wide pool of decoded frame buffers
+*/
+#include <chrono>
+#include "AclLiteFramePool.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace {
+    // 1080p NV12 frames of the high water mark take about 400MB
+    const uint32_t kDefaultMaxFrameNum = 128;
+    const uint64_t kStatsLogInterval = 3000;
+}
+
+AclLiteFramePool& AclLiteFramePool::GetInstance()
+{
+    static AclLiteFramePool framePool;
+    return framePool;
+}
+
+AclLiteFramePool::AclLiteFramePool()
+    :maxFrameNum_(kDefaultMaxFrameNum), isReleased_(false)
+{
+}
+
+AclLiteFramePool::~AclLiteFramePool()
+{
+    // the acl resource may be finalized already, leave the buffers to the process exit
+    frameLists_.clear();
+    inUseFrames_.clear();
+}
+
+void AclLiteFramePool::SetMaxFrameNum(uint32_t maxFrameNum)
+{
+    lock_guard<mutex> lock(mutex_);
+    maxFrameNum_ = maxFrameNum;
+    frameReturned_.notify_all();
+}
+
+AclLiteError AclLiteFramePool::Alloc(int channelId, uint32_t alignWidth, uint32_t alignHeight,
+                                     void*& buffer, uint32_t timeoutMs)
+{
+    FrameKey key;
+    key.context = nullptr;
+    (void)aclrtGetCurrentContext(&key.context);
+    key.alignWidth = alignWidth;
+    key.alignHeight = alignHeight;
+    buffer = nullptr;
+
+    unique_lock<mutex> lock(mutex_);
+    FrameList& frameList = frameLists_[key];
+    FramePoolStats& stats = channelStats_[channelId];
+    auto canAlloc = [this, &frameList] {
+        return !frameList.freeFrames.empty() || (maxFrameNum_ == 0) ||
+               (frameList.frameNum < maxFrameNum_) || isReleased_;
+    };
+    if (!canAlloc()) {
+        // all frames of the resolution are in the pipeline
+        stats.waitNum++;
+        auto start = chrono::steady_clock::now();
+        bool ready = frameReturned_.wait_for(lock, chrono::milliseconds(timeoutMs), canAlloc);
+        stats.waitTimeUs += chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - start).count();
+        if (!ready) {
+            return ACLLITE_ERROR_FRAME_POOL_TIMEOUT;
+        }
+    }
+
+    if (!frameList.freeFrames.empty()) {
+        buffer = frameList.freeFrames.back();
+        frameList.freeFrames.pop_back();
+    } else {
+        // reserve the frame before malloc, so the other channels see the limit
+        frameList.frameNum++;
+        lock.unlock();
+        uint32_t size = YUV420SP_SIZE(alignWidth, alignHeight);
+        aclError aclRet = acldvppMalloc(&buffer, size);
+        lock.lock();
+        if ((aclRet != ACL_SUCCESS) || (buffer == nullptr)) {
+            ACLLITE_LOG_ERROR("Malloc frame %ux%u failed, size: %u, errorno:%d",
+                              alignWidth, alignHeight, size, aclRet);
+            frameList.frameNum--;
+            buffer = nullptr;
+            frameReturned_.notify_all();
+            return ACLLITE_ERROR_MALLOC_DVPP;
+        }
+        stats.mallocNum++;
+    }
+    FrameOwner owner;
+    owner.key = key;
+    owner.channelId = channelId;
+    inUseFrames_[buffer] = owner;
+    stats.allocNum++;
+    stats.inUseNum++;
+    if (stats.allocNum % kStatsLogInterval == 0) {
+        ACLLITE_LOG_INFO("Frame pool channel %d: alloc %lu, malloc %lu, wait %lu times %lu us, in use %u",
+                         channelId, stats.allocNum, stats.mallocNum, stats.waitNum,
+                         stats.waitTimeUs, stats.inUseNum);
+    }
+    return ACLLITE_OK;
+}
+
+void AclLiteFramePool::Free(void* ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = inUseFrames_.find(ptr);
+        if (it == inUseFrames_.end()) {
+            ACLLITE_LOG_ERROR("The frame %p is not in use, it is not returned", ptr);
+            return;
+        }
+        FrameOwner owner = it->second;
+        inUseFrames_.erase(it);
+        channelStats_[owner.channelId].inUseNum--;
+        FrameList& frameList = frameLists_[owner.key];
+        if (!isReleased_) {
+            frameList.freeFrames.push_back(ptr);
+            frameReturned_.notify_all();
+            return;
+        }
+        frameList.frameNum--;
+    }
+    (void)acldvppFree(ptr);
+}
+
+void AclLiteFramePool::Release()
+{
+    lock_guard<mutex> lock(mutex_);
+    aclrtContext curContext = nullptr;
+    (void)aclrtGetCurrentContext(&curContext);
+    for (auto it = frameLists_.begin(); it != frameLists_.end(); ++it) {
+        if (it->second.freeFrames.empty()) {
+            continue;
+        }
+        // the frame must be freed in the context malloced it
+        (void)aclrtSetCurrentContext(it->first.context);
+        for (size_t i = 0; i < it->second.freeFrames.size(); i++) {
+            (void)acldvppFree(it->second.freeFrames[i]);
+        }
+        it->second.frameNum -= it->second.freeFrames.size();
+        it->second.freeFrames.clear();
+    }
+    if (curContext != nullptr) {
+        (void)aclrtSetCurrentContext(curContext);
+    }
+    for (auto it = channelStats_.begin(); it != channelStats_.end(); ++it) {
+        ACLLITE_LOG_INFO("Frame pool channel %d released: alloc %lu, malloc %lu, wait %lu times %lu us",
+                         it->first, it->second.allocNum, it->second.mallocNum,
+                         it->second.waitNum, it->second.waitTimeUs);
+    }
+    // the frames still in use are freed directly when they are returned
+    isReleased_ = true;
+    frameReturned_.notify_all();
+}
+
+void AclLiteFramePool::GetChannelStats(int channelId, FramePoolStats& stats)
+{
+    lock_guard<mutex> lock(mutex_);
+    auto it = channelStats_.find(channelId);
+    stats = (it != channelStats_.end()) ? it->second : FramePoolStats();
+}
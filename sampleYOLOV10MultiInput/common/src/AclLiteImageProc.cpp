@@ -173,6 +173,14 @@ AclLiteError AclLiteImageProc::JpegE(ImageData& dest, ImageData& src)
     return jpegE.Process(dest, src);
 }
 
+AclLiteError AclLiteImageProc::Letterbox(void* dest, ImageData& src, uint32_t width, uint32_t height,
+                                         LetterboxInfo& info)
+{
+    CropAndPasteHelper crop(stream_, dvppChannelDesc_, width, height,
+                            0, 0, width, height);
+    return crop.LetterboxProcess(dest, src, info);
+}
+
 AclLiteError AclLiteImageProc::Border(ImageData& dest, ImageData& src,
                                       uint32_t width, uint32_t height)
 {
@@ -0,0 +1,230 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMemPool.cpp
+* Description: pool of device and dvpp buffers
+*/
+#include <algorithm>
+#include "AclLiteMemPool.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace {
+    // the max number of cached buffers of one size class, the buffers exceeding it are freed
+    const size_t kMaxFreeBufNum = 64;
+    // the max bytes of the cached buffers of one pool
+    const size_t kMaxCachedBytes = 256 * 1024 * 1024;
+    // the smallest size class, and 2^3 size classes per power of 2, at most 12.5% is wasted
+    const size_t kMinClassSize = 4096;
+    const uint32_t kClassBits = 3;
+    const uint64_t kStatsLogInterval = 1000;
+}
+
+AclLiteMemPool& AclLiteMemPool::GetDevicePool()
+{
+    static AclLiteMemPool devicePool(MEMORY_DEVICE);
+    return devicePool;
+}
+
+AclLiteMemPool& AclLiteMemPool::GetDvppPool()
+{
+    static AclLiteMemPool dvppPool(MEMORY_DVPP);
+    return dvppPool;
+}
+
+AclLiteMemPool::AclLiteMemPool(MemoryType memType)
+    :memType_(memType), isReleased_(false), hitNum_(0), missNum_(0), evictNum_(0), cachedBytes_(0)
+{
+}
+
+AclLiteMemPool::~AclLiteMemPool()
+{
+    // the acl resource may be finalized already, leave the buffers to the process exit
+    freeBufs_.clear();
+    cachedLru_.clear();
+    allocatedBufs_.clear();
+}
+
+size_t AclLiteMemPool::GetClassSize(size_t size)
+{
+    if (size <= kMinClassSize) {
+        return kMinClassSize;
+    }
+    uint32_t msb = 63 - __builtin_clzll(size);
+    size_t step = (size_t)1 << (msb - kClassBits);
+    return (size + step - 1) & ~(step - 1);
+}
+
+void* AclLiteMemPool::RawAlloc(size_t size)
+{
+    void* buffer = nullptr;
+    aclError aclRet = (memType_ == MEMORY_DVPP) ?
+        acldvppMalloc(&buffer, size) : aclrtMalloc(&buffer, size, ACL_MEM_MALLOC_HUGE_FIRST);
+    if ((aclRet != ACL_SUCCESS) || (buffer == nullptr)) {
+        ACLLITE_LOG_ERROR("Malloc memory failed, type: %d, size: %zu, errorno:%d",
+                          memType_, size, aclRet);
+        return nullptr;
+    }
+    return buffer;
+}
+
+void AclLiteMemPool::RawFree(void* ptr)
+{
+    if (memType_ == MEMORY_DVPP) {
+        (void)acldvppFree(ptr);
+    } else {
+        (void)aclrtFree(ptr);
+    }
+}
+
+void AclLiteMemPool::FreeInContext(const vector<pair<aclrtContext, void*>>& bufs)
+{
+    if (bufs.empty()) {
+        return;
+    }
+    aclrtContext curContext = nullptr;
+    (void)aclrtGetCurrentContext(&curContext);
+    for (size_t i = 0; i < bufs.size(); i++) {
+        // the buffer must be freed in the context malloced it
+        if (bufs[i].first != curContext) {
+            (void)aclrtSetCurrentContext(bufs[i].first);
+        }
+        RawFree(bufs[i].second);
+        if (bufs[i].first != curContext) {
+            (void)aclrtSetCurrentContext(curContext);
+        }
+    }
+}
+
+void* AclLiteMemPool::Alloc(size_t size)
+{
+    aclrtContext context = nullptr;
+    (void)aclrtGetCurrentContext(&context);
+    size_t classSize = GetClassSize(size);
+    BufKey key(context, classSize);
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = freeBufs_.find(key);
+        if ((it != freeBufs_.end()) && !it->second.empty()) {
+            void* buffer = it->second.back();
+            it->second.pop_back();
+            BufInfo& info = allocatedBufs_[buffer];
+            cachedLru_.erase(info.lruIt);
+            info.isCached = false;
+            cachedBytes_ -= classSize;
+            hitNum_++;
+            return buffer;
+        }
+        missNum_++;
+        if (missNum_ % kStatsLogInterval == 0) {
+            ACLLITE_LOG_WARNING("Memory pool type %d missed %lu times, hit %lu times, evicted %lu buffers",
+                                memType_, missNum_, hitNum_, evictNum_);
+        }
+    }
+
+    void* buffer = RawAlloc(classSize);
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    lock_guard<mutex> lock(mutex_);
+    if (!isReleased_) {
+        BufInfo info;
+        info.key = key;
+        info.isCached = false;
+        info.lruIt = cachedLru_.end();
+        allocatedBufs_[buffer] = info;
+    }
+    return buffer;
+}
+
+void AclLiteMemPool::Free(void* ptr)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+    vector<pair<aclrtContext, void*>> evictedBufs;
+    bool isCached = false;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = allocatedBufs_.find(ptr);
+        if (it != allocatedBufs_.end()) {
+            size_t classSize = it->second.key.second;
+            vector<void*>& bufs = freeBufs_[it->second.key];
+            if ((bufs.size() < kMaxFreeBufNum) && (classSize <= kMaxCachedBytes)) {
+                // free the least recently freed buffers to keep this one
+                while (cachedBytes_ + classSize > kMaxCachedBytes) {
+                    void* oldest = cachedLru_.front();
+                    cachedLru_.pop_front();
+                    auto oldIt = allocatedBufs_.find(oldest);
+                    vector<void*>& oldBufs = freeBufs_[oldIt->second.key];
+                    oldBufs.erase(find(oldBufs.begin(), oldBufs.end(), oldest));
+                    cachedBytes_ -= oldIt->second.key.second;
+                    evictedBufs.emplace_back(oldIt->second.key.first, oldest);
+                    allocatedBufs_.erase(oldIt);
+                    evictNum_++;
+                }
+                bufs.push_back(ptr);
+                it->second.isCached = true;
+                it->second.lruIt = cachedLru_.insert(cachedLru_.end(), ptr);
+                cachedBytes_ += classSize;
+                isCached = true;
+            } else {
+                allocatedBufs_.erase(it);
+            }
+        }
+    }
+    FreeInContext(evictedBufs);
+    if (!isCached) {
+        RawFree(ptr);
+    }
+}
+
+void AclLiteMemPool::Release()
+{
+    lock_guard<mutex> lock(mutex_);
+    aclrtContext curContext = nullptr;
+    (void)aclrtGetCurrentContext(&curContext);
+    for (auto it = freeBufs_.begin(); it != freeBufs_.end(); ++it) {
+        if (it->second.empty()) {
+            continue;
+        }
+        // the buffer must be freed in the context malloced it
+        (void)aclrtSetCurrentContext(it->first.first);
+        for (size_t i = 0; i < it->second.size(); i++) {
+            allocatedBufs_.erase(it->second[i]);
+            RawFree(it->second[i]);
+        }
+    }
+    if (curContext != nullptr) {
+        (void)aclrtSetCurrentContext(curContext);
+    }
+    ACLLITE_LOG_INFO("Memory pool type %d released, hit %lu times, miss %lu times, "
+                     "evicted %lu buffers, %zu bytes cached",
+                     memType_, hitNum_, missNum_, evictNum_, cachedBytes_);
+    freeBufs_.clear();
+    cachedLru_.clear();
+    cachedBytes_ = 0;
+    // the buffers still in use are freed directly when they are returned
+    allocatedBufs_.clear();
+    isReleased_ = true;
+}
+
+void AclLiteMemPool::GetStats(uint64_t& hitNum, uint64_t& missNum)
+{
+    lock_guard<mutex> lock(mutex_);
+    hitNum = hitNum_;
+    missNum = missNum_;
+}
@@ -0,0 +1,276 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMetrics.cpp
+* Description: process wide counters and gauges exported in Prometheus text format
+*/
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "AclLiteMetrics.h"
+#include "AclLiteUtils.h"
+#include "AclLiteThreadSched.h"
+
+using namespace std;
+
+namespace {
+    const int kPollIntervalMs = 100;
+    const int kListenBacklog = 8;
+    const uint32_t kRequestBufferSize = 4096;
+}
+
+AclLiteMetrics& AclLiteMetrics::GetInstance()
+{
+    static AclLiteMetrics metrics;
+    return metrics;
+}
+
+AclLiteMetrics::AclLiteMetrics()
+    :nextCollectorId_(0), isExporting_(false), listenFd_(-1), intervalMs_(0)
+{
+}
+
+AclLiteMetrics::~AclLiteMetrics()
+{
+    StopExport();
+}
+
+string AclLiteMetrics::Label(const string& key, const string& value)
+{
+    string label = key + "=\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            label += '\\';
+            label += c;
+        } else if (c == '\n') {
+            label += "\\n";
+        } else {
+            label += c;
+        }
+    }
+    return label + "\"";
+}
+
+AclLiteMetrics::MetricFamily* AclLiteMetrics::GetFamily(const string& name, const string& help, bool isCounter)
+{
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+        MetricFamily& family = families_[name];
+        family.help = help;
+        family.isCounter = isCounter;
+        return &family;
+    }
+    if (it->second.isCounter != isCounter) {
+        ACLLITE_LOG_WARNING("Metric %s is registered as %s already", name.c_str(),
+                            it->second.isCounter ? "counter" : "gauge");
+    }
+    return &it->second;
+}
+
+MetricCounter* AclLiteMetrics::GetCounter(const string& name, const string& help, const string& labels)
+{
+    unique_lock<mutex> lock(mutex_);
+    MetricFamily* family = GetFamily(name, help, true);
+    unique_ptr<MetricCounter>& counter = family->counters[labels];
+    if (counter == nullptr) {
+        counter.reset(new MetricCounter);
+    }
+    return counter.get();
+}
+
+MetricGauge* AclLiteMetrics::GetGauge(const string& name, const string& help, const string& labels)
+{
+    unique_lock<mutex> lock(mutex_);
+    MetricFamily* family = GetFamily(name, help, false);
+    unique_ptr<MetricGauge>& gauge = family->gauges[labels];
+    if (gauge == nullptr) {
+        gauge.reset(new MetricGauge);
+    }
+    return gauge.get();
+}
+
+uint32_t AclLiteMetrics::AddCollector(const Collector& collector)
+{
+    unique_lock<mutex> lock(collectorMutex_);
+    uint32_t id = nextCollectorId_++;
+    collectors_[id] = collector;
+    return id;
+}
+
+void AclLiteMetrics::RemoveCollector(uint32_t id)
+{
+    unique_lock<mutex> lock(collectorMutex_);
+    collectors_.erase(id);
+}
+
+string AclLiteMetrics::Export()
+{
+    stringstream text;
+    // the collectors may register metrics, which takes mutex_
+    unique_lock<mutex> collectorLock(collectorMutex_);
+    for (auto& collector : collectors_) {
+        collector.second();
+    }
+    unique_lock<mutex> lock(mutex_);
+    for (auto& family : families_) {
+        const string& name = family.first;
+        text << "# HELP " << name << " " << family.second.help << "\n";
+        text << "# TYPE " << name << " " << (family.second.isCounter ? "counter" : "gauge") << "\n";
+        for (auto& counter : family.second.counters) {
+            text << name;
+            if (!counter.first.empty()) {
+                text << "{" << counter.first << "}";
+            }
+            text << " " << counter.second->Get() << "\n";
+        }
+        for (auto& gauge : family.second.gauges) {
+            text << name;
+            if (!gauge.first.empty()) {
+                text << "{" << gauge.first << "}";
+            }
+            text << " " << gauge.second->Get() << "\n";
+        }
+    }
+    return text.str();
+}
+
+AclLiteError AclLiteMetrics::Listen(uint16_t port)
+{
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        ACLLITE_LOG_ERROR("Create metrics socket failed");
+        return ACLLITE_ERROR;
+    }
+    int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    // only served on localhost, the metrics are not exposed to the network
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0) ||
+        (listen(listenFd_, kListenBacklog) != 0)) {
+        ACLLITE_LOG_ERROR("Listen metrics port %u failed", port);
+        close(listenFd_);
+        listenFd_ = -1;
+        return ACLLITE_ERROR;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError AclLiteMetrics::StartExport(uint16_t port, const string& file, uint32_t intervalMs)
+{
+    if (isExporting_ || ((port == 0) && file.empty())) {
+        return ACLLITE_OK;
+    }
+    if ((port != 0) && (Listen(port) != ACLLITE_OK)) {
+        return ACLLITE_ERROR;
+    }
+    file_ = file;
+    intervalMs_ = (intervalMs == 0) ? 1 : intervalMs;
+    isExporting_ = true;
+    exportThread_ = thread(&AclLiteMetrics::ExportRun, this);
+    ACLLITE_LOG_INFO("Metrics are exported on http://127.0.0.1:%u/metrics, file %s every %u ms",
+                     port, file.empty() ? "none" : file.c_str(), intervalMs_);
+    return ACLLITE_OK;
+}
+
+void AclLiteMetrics::StopExport()
+{
+    if (!isExporting_) {
+        return;
+    }
+    isExporting_ = false;
+    exportThread_.join();
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+    }
+    WriteFile();
+}
+
+void AclLiteMetrics::ExportRun()
+{
+    SetThreadName("metrics");
+    auto nextWrite = chrono::steady_clock::now();
+    while (isExporting_) {
+        auto now = chrono::steady_clock::now();
+        if (!file_.empty() && (now >= nextWrite)) {
+            WriteFile();
+            nextWrite = now + chrono::milliseconds(intervalMs_);
+        }
+        if (listenFd_ < 0) {
+            this_thread::sleep_for(chrono::milliseconds(kPollIntervalMs));
+            continue;
+        }
+        pollfd pfd = { listenFd_, POLLIN, 0 };
+        if (poll(&pfd, 1, kPollIntervalMs) > 0) {
+            ServeRequest();
+        }
+    }
+}
+
+void AclLiteMetrics::ServeRequest()
+{
+    int fd = accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) {
+        return;
+    }
+    // every request path gets the metrics, the request is not parsed
+    char request[kRequestBufferSize];
+    pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, kPollIntervalMs) > 0) {
+        (void)recv(fd, request, sizeof(request), 0);
+    }
+    string body = Export();
+    string response = "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t ret = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (ret <= 0) {
+            break;
+        }
+        sent += ret;
+    }
+    close(fd);
+}
+
+void AclLiteMetrics::WriteFile()
+{
+    if (file_.empty()) {
+        return;
+    }
+    // the readers never see a partly written file
+    string tmpFile = file_ + ".tmp";
+    ofstream out(tmpFile);
+    if (!out.is_open()) {
+        ACLLITE_LOG_ERROR("Open metrics file %s failed", tmpFile.c_str());
+        return;
+    }
+    out << Export();
+    out.close();
+    if (rename(tmpFile.c_str(), file_.c_str()) != 0) {
+        ACLLITE_LOG_ERROR("Rename metrics file to %s failed", file_.c_str());
+    }
+}
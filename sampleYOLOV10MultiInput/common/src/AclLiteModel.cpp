@@ -25,7 +25,7 @@ AclLiteModel::AclLiteModel():loadFlag_(false), isReleased_(false),
     modelId_(0), outputsNum_(0), modelMemSize_(0),
     modelWorkSize_(0), modelWeightSize_(0), modelMemPtr_(nullptr),
     modelWorkPtr_(nullptr), modelWeightPtr_(nullptr), modelDesc_(nullptr),
-    input_(nullptr), output_(nullptr), modelPath_("")
+    input_(nullptr), output_(nullptr), modelPath_(""), stream_(nullptr)
 {
 }
 
@@ -33,7 +33,7 @@ AclLiteModel::AclLiteModel(const string& modelPath):loadFlag_(false), isReleased
     modelId_(0), outputsNum_(0), modelMemSize_(0),
     modelWorkSize_(0), modelWeightSize_(0), modelMemPtr_(nullptr),
     modelWorkPtr_(nullptr), modelWeightPtr_(nullptr), modelDesc_(nullptr),
-    input_(nullptr), output_(nullptr), modelPath_(modelPath)
+    input_(nullptr), output_(nullptr), modelPath_(modelPath), stream_(nullptr)
 {
 }
 
@@ -41,7 +41,7 @@ AclLiteModel::AclLiteModel(void *modelAddr, size_t modelSize): loadFlag_(false),
     modelId_(0), outputsNum_(0), modelMemSize_(modelSize),
     modelWorkSize_(0), modelWeightSize_(0), modelMemPtr_(modelAddr),
     modelWorkPtr_(nullptr), modelWeightPtr_(nullptr), modelDesc_(nullptr),
-    input_(nullptr), output_(nullptr), modelPath_("")
+    input_(nullptr), output_(nullptr), modelPath_(""), stream_(nullptr)
 {
 }
 
@@ -55,6 +55,7 @@ void AclLiteModel::DestroyResource()
     if (isReleased_) {
         return;
     }
+    DestroyAsync();
     Unload();
     DestroyDesc();
     DestroyInput();
@@ -268,6 +269,11 @@ AclLiteError AclLiteModel::CreateInput(vector<DataInfo>& inputData)
 }
 
 AclLiteError AclLiteModel::CreateOutput()
+{
+    return CreateOutput(output_);
+}
+
+AclLiteError AclLiteModel::CreateOutput(aclmdlDataset*& output)
 {
     if (modelDesc_ == nullptr) {
         ACLLITE_LOG_ERROR("Create output failed for no model(%s) description",
@@ -275,8 +281,8 @@ AclLiteError AclLiteModel::CreateOutput()
         return ACLLITE_ERROR_NO_MODEL_DESC;
     }
 
-    output_ = aclmdlCreateDataset();
-    if (output_ == nullptr) {
+    output = aclmdlCreateDataset();
+    if (output == nullptr) {
         ACLLITE_LOG_ERROR("Create output failed for create dataset error");
         return ACLLITE_ERROR_CREATE_DATASET;
     }
@@ -285,20 +291,18 @@ AclLiteError AclLiteModel::CreateOutput()
     for (size_t i = 0; i < outputsNum_; ++i) {
         size_t bufSize = aclmdlGetOutputSizeByIndex(modelDesc_, i);
 
-        void *outputBuffer = nullptr;
-        aclError ret = aclrtMalloc(&outputBuffer, bufSize,
-                                   ACL_MEM_MALLOC_NORMAL_ONLY);
-        if (ret != ACL_SUCCESS) {
+        void *outputBuffer = AclLiteMemPool::GetDevicePool().Alloc(bufSize);
+        if (outputBuffer == nullptr) {
             ACLLITE_LOG_ERROR("Create output failed for malloc "
                               "device failed, size %d", (int)bufSize);
             return ACLLITE_ERROR_MALLOC_DEVICE;
         }
 
-        AclLiteError atlRet = AddDatasetBuffer(output_, outputBuffer, bufSize);
+        AclLiteError atlRet = AddDatasetBuffer(output, outputBuffer, bufSize);
         if (atlRet != ACLLITE_OK) {
             ACLLITE_LOG_ERROR("Create output failed for "
                               "add dataset buffer error %d", atlRet);
-            aclrtFree(outputBuffer);
+            AclLiteMemPool::GetDevicePool().Free(outputBuffer);
             return ACLLITE_ERROR_ADD_DATASET_BUFFER;
         }
     }
@@ -381,7 +385,7 @@ AclLiteError AclLiteModel::ExecuteV2(vector<InferenceOutput>& inferOutputs)
 
     for (uint32_t i = 0; i < outputsNum_; i++) {
         InferenceOutput out;
-        AclLiteError ret = GetOutputItem(out, i, true);
+        AclLiteError ret = GetOutputItem(output_, out, i, true);
         if (ret != ACLLITE_OK) {
             ACLLITE_LOG_ERROR("Get the %dth interference output failed, "
                               "error: %d", i, ret);
@@ -403,7 +407,7 @@ AclLiteError AclLiteModel::Execute(vector<InferenceOutput>& inferOutputs)
 
     for (uint32_t i = 0; i < outputsNum_; i++) {
         InferenceOutput out;
-        AclLiteError ret = GetOutputItem(out, i, false);
+        AclLiteError ret = GetOutputItem(output_, out, i, false);
         if (ret != ACLLITE_OK) {
             ACLLITE_LOG_ERROR("Get the %dth interference output failed, "
                               "error: %d", i, ret);
@@ -415,9 +419,10 @@ AclLiteError AclLiteModel::Execute(vector<InferenceOutput>& inferOutputs)
     return ACLLITE_OK;
 }
 
-AclLiteError AclLiteModel::GetOutputItem(InferenceOutput& out, uint32_t idx, bool isDevice)
+AclLiteError AclLiteModel::GetOutputItem(aclmdlDataset* output, InferenceOutput& out,
+                                         uint32_t idx, bool isDevice)
 {
-    aclDataBuffer* dataBuffer = aclmdlGetDatasetBuffer(output_, idx);
+    aclDataBuffer* dataBuffer = aclmdlGetDatasetBuffer(output, idx);
     if (dataBuffer == nullptr) {
         ACLLITE_LOG_ERROR("Get the %dth dataset buffer from model "
                           "inference output failed", idx);
@@ -442,15 +447,14 @@ AclLiteError AclLiteModel::GetOutputItem(InferenceOutput& out, uint32_t idx, boo
         out.data = SHARED_PTR_DEV_BUF(dataBufferDev);
         out.size = bufferSize;
 
-        void *outputBuffer = nullptr;
-        aclError ret = aclrtMalloc(&outputBuffer, bufferSize,
-                                   ACL_MEM_MALLOC_NORMAL_ONLY);
-        if (ret != ACL_SUCCESS) {
+        // the output buffer is handed out, take a pooled buffer for the next inference
+        void *outputBuffer = AclLiteMemPool::GetDevicePool().Alloc(bufferSize);
+        if (outputBuffer == nullptr) {
             ACLLITE_LOG_ERROR("Create output failed for malloc "
                               "device failed, size %d", (int)bufferSize);
             return ACLLITE_ERROR_MALLOC_DEVICE;
         }
-        ret = aclUpdateDataBuffer(dataBuffer, outputBuffer, bufferSize);
+        aclError ret = aclUpdateDataBuffer(dataBuffer, outputBuffer, bufferSize);
         if (ret != ACL_SUCCESS) {
             ACLLITE_LOG_ERROR("Update DataBuffer %d data for model output failed"
                               , idx);
@@ -471,6 +475,157 @@ AclLiteError AclLiteModel::GetOutputItem(InferenceOutput& out, uint32_t idx, boo
     return ACLLITE_OK;
 }
 
+AclLiteError AclLiteModel::InitAsync(uint32_t slotNum)
+{
+    if (!loadFlag_ || (modelDesc_ == nullptr)) {
+        ACLLITE_LOG_ERROR("Init async execution failed for model(%s) is not loaded",
+                          modelPath_.c_str());
+        return ACLLITE_ERROR_NO_MODEL_DESC;
+    }
+    if (stream_ != nullptr) {
+        ACLLITE_LOG_ERROR("Async execution of model(%s) is inited already",
+                          modelPath_.c_str());
+        return ACLLITE_ERROR_INITED_ALREADY;
+    }
+    if (slotNum == 0) {
+        ACLLITE_LOG_ERROR("Init async execution failed for slot number is 0");
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+
+    aclError aclRet = aclrtCreateStream(&stream_);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Create stream failed, error %d", aclRet);
+        stream_ = nullptr;
+        return ACLLITE_ERROR_CREATE_STREAM;
+    }
+
+    size_t inputNum = aclmdlGetNumInputs(modelDesc_);
+    asyncSlots_.resize(slotNum);
+    for (uint32_t i = 0; i < slotNum; i++) {
+        AsyncSlot& slot = asyncSlots_[i];
+        // the input buffers are set by ExecuteAsync, only the dataset is prebuilt
+        slot.input = aclmdlCreateDataset();
+        if (slot.input == nullptr) {
+            ACLLITE_LOG_ERROR("Create async input dataset failed");
+            return ACLLITE_ERROR_CREATE_DATASET;
+        }
+        for (size_t j = 0; j < inputNum; j++) {
+            AclLiteError ret = AddDatasetBuffer(slot.input, nullptr, 0);
+            if (ret != ACLLITE_OK) {
+                ACLLITE_LOG_ERROR("Create async input failed for "
+                                  "add dataset buffer error %d", ret);
+                return ret;
+            }
+        }
+        AclLiteError ret = CreateOutput(slot.output);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Create async output failed, error %d", ret);
+            return ret;
+        }
+        aclRet = aclrtCreateEvent(&slot.event);
+        if (aclRet != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("Create event failed, error %d", aclRet);
+            slot.event = nullptr;
+            return ACLLITE_ERROR_CREATE_STREAM;
+        }
+    }
+
+    ACLLITE_LOG_INFO("Init model %s async execution with %u slots success",
+                     modelPath_.c_str(), slotNum);
+    return ACLLITE_OK;
+}
+
+AclLiteError AclLiteModel::ExecuteAsync(uint32_t slot, vector<DataInfo>& inputData)
+{
+    if ((slot >= asyncSlots_.size()) || asyncSlots_[slot].inFlight) {
+        ACLLITE_LOG_ERROR("Async slot %u is invalid or in flight", slot);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    AsyncSlot& asyncSlot = asyncSlots_[slot];
+    if (inputData.size() != aclmdlGetDatasetNumBuffers(asyncSlot.input)) {
+        ACLLITE_LOG_ERROR("Execute async failed for wrong input nums %zu", inputData.size());
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    for (uint32_t i = 0; i < inputData.size(); i++) {
+        aclDataBuffer* dataBuffer = aclmdlGetDatasetBuffer(asyncSlot.input, i);
+        aclError ret = aclUpdateDataBuffer(dataBuffer, inputData[i].data, inputData[i].size);
+        if (ret != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("Update DataBuffer %u data for model input failed", i);
+            return ACLLITE_ERROR_ADD_DATASET_BUFFER;
+        }
+    }
+
+    aclError ret = aclmdlExecuteAsync(modelId_, asyncSlot.input, asyncSlot.output, stream_);
+    if (ret != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Execute model(%s) async error:%d", modelPath_.c_str(), ret);
+        return ACLLITE_ERROR_EXECUTE_MODEL;
+    }
+    ret = aclrtRecordEvent(asyncSlot.event, stream_);
+    if (ret != ACL_SUCCESS) {
+        // the event can not tell the end of this slot, wait the whole stream
+        ACLLITE_LOG_ERROR("Record event of slot %u failed, error:%d", slot, ret);
+        (void)aclrtSynchronizeStream(stream_);
+        return ACLLITE_ERROR_EXECUTE_MODEL;
+    }
+    asyncSlot.inFlight = true;
+    return ACLLITE_OK;
+}
+
+AclLiteError AclLiteModel::WaitAsync(uint32_t slot, vector<InferenceOutput>& inferOutputs)
+{
+    if ((slot >= asyncSlots_.size()) || !asyncSlots_[slot].inFlight) {
+        ACLLITE_LOG_ERROR("Async slot %u is invalid or not in flight", slot);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    AsyncSlot& asyncSlot = asyncSlots_[slot];
+    aclError aclRet = aclrtSynchronizeEvent(asyncSlot.event);
+    asyncSlot.inFlight = false;
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Wait model(%s) async execution error:%d", modelPath_.c_str(), aclRet);
+        return ACLLITE_ERROR_SYNC_STREAM;
+    }
+
+    for (uint32_t i = 0; i < outputsNum_; i++) {
+        InferenceOutput out;
+        AclLiteError ret = GetOutputItem(asyncSlot.output, out, i, true);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Get the %dth interference output failed, "
+                              "error: %d", i, ret);
+            return ret;
+        }
+        inferOutputs.push_back(out);
+    }
+    return ACLLITE_OK;
+}
+
+void AclLiteModel::DestroyAsync()
+{
+    if (stream_ != nullptr) {
+        (void)aclrtSynchronizeStream(stream_);
+    }
+    for (size_t i = 0; i < asyncSlots_.size(); i++) {
+        AsyncSlot& slot = asyncSlots_[i];
+        if (slot.input != nullptr) {
+            // the input buffers belong to the caller
+            for (size_t j = 0; j < aclmdlGetDatasetNumBuffers(slot.input); ++j) {
+                (void)aclDestroyDataBuffer(aclmdlGetDatasetBuffer(slot.input, j));
+            }
+            (void)aclmdlDestroyDataset(slot.input);
+            slot.input = nullptr;
+        }
+        DestroyOutput(slot.output);
+        if (slot.event != nullptr) {
+            (void)aclrtDestroyEvent(slot.event);
+            slot.event = nullptr;
+        }
+    }
+    asyncSlots_.clear();
+    if (stream_ != nullptr) {
+        (void)aclrtDestroyStream(stream_);
+        stream_ = nullptr;
+    }
+}
+
 void AclLiteModel::DestroyInput()
 {
     if (input_ == nullptr) {
@@ -510,20 +665,25 @@ AclLiteError AclLiteModel::GetModelOutputInfo(vector<ModelOutputInfo>& modelOutp
 
 void AclLiteModel::DestroyOutput()
 {
-    if (output_ == nullptr) {
+    DestroyOutput(output_);
+}
+
+void AclLiteModel::DestroyOutput(aclmdlDataset*& output)
+{
+    if (output == nullptr) {
         return;
     }
 
-    for (size_t i = 0; i < aclmdlGetDatasetNumBuffers(output_); ++i) {
-        aclDataBuffer* dataBuffer = aclmdlGetDatasetBuffer(output_, i);
+    for (size_t i = 0; i < aclmdlGetDatasetNumBuffers(output); ++i) {
+        aclDataBuffer* dataBuffer = aclmdlGetDatasetBuffer(output, i);
         void* data = aclGetDataBufferAddr(dataBuffer);
-        (void)aclrtFree(data);
+        AclLiteMemPool::GetDevicePool().Free(data);
         (void)aclDestroyDataBuffer(dataBuffer);
         dataBuffer = nullptr;
     }
 
-    (void)aclmdlDestroyDataset(output_);
-    output_ = nullptr;
+    (void)aclmdlDestroyDataset(output);
+    output = nullptr;
 }
 
 void AclLiteModel::Unload()
@@ -16,26 +16,45 @@
 * File AclLiteThreadMgr.cpp
 * Description: handle file operations
 */
+#include <chrono>
 #include "AclLiteThreadMgr.h"
 #include "AclLiteUtils.h"
 using namespace std;
 namespace {
-    const uint32_t kWait10Milliseconds = 10000;
     const uint32_t kWaitThreadStart = 1000;
+    const uint64_t kDropLogInterval = 100;
 }
 
 AclLiteThreadMgr::AclLiteThreadMgr(AclLiteThread* userThreadInstance,
-    const string& threadName, const uint32_t msgQueueSize):isExit_(false),
-    status_(THREAD_READY), userInstance_(userThreadInstance),
-    name_(threadName), msgQueue_(msgQueueSize)
+    const string& threadName, const uint32_t msgQueueSize, AclLiteQueueType msgQueueType)
+    :droppedMsgNum_(0), isExit_(false), status_(THREAD_READY), userInstance_(userThreadInstance),
+    name_(threadName),
+    msgQueue_(CreateMsgQueue<shared_ptr<AclLiteMessage>>(msgQueueType, msgQueueSize))
 {
+    AclLiteMetrics& metrics = AclLiteMetrics::GetInstance();
+    string label = AclLiteMetrics::Label("thread", threadName);
+    queueDepth_ = metrics.GetGauge("acllite_thread_queue_depth",
+        "Messages waiting in the thread queue", label);
+    processedMsgNum_ = metrics.GetCounter("acllite_thread_messages_total",
+        "Messages processed by the thread", label);
+    processTimeUs_ = metrics.GetCounter("acllite_thread_process_microseconds_total",
+        "Time spent in Process of the thread", label);
+    droppedMsgMetric_ = metrics.GetCounter("acllite_thread_dropped_messages_total",
+        "Messages dropped by the queue policy of the thread", label);
+    enqueueTimeoutNum_ = metrics.GetCounter("acllite_thread_enqueue_timeouts_total",
+        "Blocking sends to the thread timed out on a full queue", label);
+    // read on export, the queue fills while the thread is in a long Process
+    queueDepthCollector_ = metrics.AddCollector([this]() {
+        queueDepth_->Set(msgQueue_->Size());
+    });
 }
 
 AclLiteThreadMgr::~AclLiteThreadMgr()
 {
+    AclLiteMetrics::GetInstance().RemoveCollector(queueDepthCollector_);
     userInstance_ = nullptr;
-    while (!msgQueue_.Empty()) {
-        msgQueue_.Pop();
+    while (!msgQueue_->Empty()) {
+        msgQueue_->Pop();
     }
 }
 
@@ -55,6 +74,9 @@ void AclLiteThreadMgr::ThreadEntry(void* arg)
     }
 
     string& instName = userInstance->SelfInstanceName();
+    // before Init, so the threads created in Init inherit the affinity
+    SetThreadName(instName);
+    (void)ApplyThreadSched(instName, thMgr->sched_);
     aclrtContext context = userInstance->GetContext();
     aclError aclRet = aclrtSetCurrentContext(context);
     if (aclRet != ACL_SUCCESS) {
@@ -73,22 +95,32 @@ void AclLiteThreadMgr::ThreadEntry(void* arg)
 
     thMgr->SetStatus(THREAD_RUNNING);
     while (THREAD_RUNNING == thMgr->GetStatus()) {
-        // get data from queue
-        shared_ptr<AclLiteMessage> msg = thMgr->PopMsgFromQueue();
+        // get data from queue, sleep until message arrive or timeout to
+        // recheck the thread status
+        shared_ptr<AclLiteMessage> msg = thMgr->WaitPopMsgFromQueue(userInstance->IdleTimeoutMs());
         if (msg == nullptr) {
-            usleep(kWait10Milliseconds);
+            ret = userInstance->Idle();
+            if (ret) {
+                ACLLITE_LOG_ERROR("Thread %s idle function return "
+                                  "error %d, thread exit", instName.c_str(), ret);
+                thMgr->SetStatus(THREAD_ERROR);
+                return;
+            }
             continue;
         }
         // call function to process thread msg
+        auto startTime = chrono::steady_clock::now();
         ret = userInstance->Process(msg->msgId, msg->data);
         msg->data = nullptr;
+        thMgr->processTimeUs_->Add(chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - startTime).count());
+        thMgr->processedMsgNum_->Add();
         if (ret) {
             ACLLITE_LOG_ERROR("Thread %s process function return "
                               "error %d, thread exit", instName.c_str(), ret);
             thMgr->SetStatus(THREAD_ERROR);
             return;
         }
-        usleep(0);
     }
     thMgr->SetStatus(THREAD_EXITED);
 
@@ -120,5 +152,47 @@ AclLiteError AclLiteThreadMgr::PushMsgToQueue(shared_ptr<AclLiteMessage>& pMessa
                           "can not reveive message", name_.c_str(), status_);
         return ACLLITE_ERROR_THREAD_ABNORMAL;
     }
-    return msgQueue_.Push(pMessage)? ACLLITE_OK : ACLLITE_ERROR_ENQUEUE;
-}
\ No newline at end of file
+    return msgQueue_->Push(pMessage)? ACLLITE_OK : ACLLITE_ERROR_ENQUEUE;
+}
+AclLiteError AclLiteThreadMgr::WaitPushMsgToQueue(shared_ptr<AclLiteMessage>& pMessage,
+                                                  uint32_t timeoutMs)
+{
+    if (status_ != THREAD_RUNNING) {
+        ACLLITE_LOG_ERROR("Thread instance %s status(%d) is invalid, "
+                          "can not reveive message", name_.c_str(), status_);
+        return ACLLITE_ERROR_THREAD_ABNORMAL;
+    }
+    if (!msgQueue_->WaitPush(pMessage, timeoutMs)) {
+        enqueueTimeoutNum_->Add();
+        return ACLLITE_ERROR_ENQUEUE;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError AclLiteThreadMgr::ForcePushMsgToQueue(shared_ptr<AclLiteMessage>& pMessage,
+                                                   shared_ptr<AclLiteMessage>* droppedMsg)
+{
+    if (status_ != THREAD_RUNNING) {
+        ACLLITE_LOG_ERROR("Thread instance %s status(%d) is invalid, "
+                          "can not reveive message", name_.c_str(), status_);
+        return ACLLITE_ERROR_THREAD_ABNORMAL;
+    }
+    shared_ptr<AclLiteMessage> dropped = msgQueue_->ForcePush(pMessage);
+    if (dropped != nullptr) {
+        RecordDroppedMsg();
+    }
+    if (droppedMsg != nullptr) {
+        *droppedMsg = dropped;
+    }
+    return ACLLITE_OK;
+}
+
+void AclLiteThreadMgr::RecordDroppedMsg()
+{
+    uint64_t droppedNum = ++droppedMsgNum_;
+    droppedMsgMetric_->Add();
+    if (droppedNum % kDropLogInterval == 1) {
+        ACLLITE_LOG_WARNING("Thread instance %s queue is full, %lu messages dropped",
+                            name_.c_str(), droppedNum);
+    }
+}
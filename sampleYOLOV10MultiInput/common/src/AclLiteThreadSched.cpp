@@ -0,0 +1,188 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteThreadSched.cpp
+* Description: name, cpu affinity and scheduling policy of the threads
+*/
+#include <dirent.h>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "AclLiteThreadSched.h"
+#include "AclLiteMetrics.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace {
+    const size_t kMaxThreadNameLen = 15;
+    const int kMinNice = -20;
+    const int kMaxNice = 19;
+    // the fields after the thread name in /proc/<pid>/task/<tid>/stat
+    const int kUtimeFieldIndex = 11;
+    const int kStimeFieldIndex = 12;
+    const double kMicrosecondsPerSecond = 1000000.0;
+
+    // read before main, the cpus of the process before any thread is pinned
+    cpu_set_t GetProcessCpuSet()
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+            for (long cpu = 0; (cpu < sysconf(_SC_NPROCESSORS_CONF)) && (cpu < CPU_SETSIZE); cpu++) {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+        return cpuSet;
+    }
+    const cpu_set_t kProcessCpuSet = GetProcessCpuSet();
+
+    using ThreadCpuTimeVisitor = std::function<void(const std::string& tid, const std::string& name,
+                                                    uint64_t utime, uint64_t stime)>;
+
+    // visit the user and system cpu time in clock ticks of every thread
+    void VisitThreadCpuTime(const ThreadCpuTimeVisitor& visitor)
+    {
+        DIR* dir = opendir("/proc/self/task");
+        if (dir == nullptr) {
+            ACLLITE_LOG_WARNING("Open /proc/self/task failed");
+            return;
+        }
+        dirent* entry = nullptr;
+        while ((entry = readdir(dir)) != nullptr) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            ifstream statFile(string("/proc/self/task/") + entry->d_name + "/stat");
+            string stat;
+            if (!getline(statFile, stat)) {
+                continue;
+            }
+            // the thread name is in parentheses and may contain spaces
+            size_t nameStart = stat.find('(');
+            size_t nameEnd = stat.rfind(')');
+            if ((nameStart == string::npos) || (nameEnd == string::npos) || (nameEnd < nameStart)) {
+                continue;
+            }
+            string threadName = stat.substr(nameStart + 1, nameEnd - nameStart - 1);
+            istringstream fields(stat.substr(nameEnd + 1));
+            string field;
+            uint64_t utime = 0;
+            uint64_t stime = 0;
+            for (int i = 0; (i <= kStimeFieldIndex) && (fields >> field); i++) {
+                if (i == kUtimeFieldIndex) {
+                    utime = stoull(field);
+                } else if (i == kStimeFieldIndex) {
+                    stime = stoull(field);
+                }
+            }
+            visitor(entry->d_name, threadName, utime, stime);
+        }
+        closedir(dir);
+    }
+}
+
+void SetThreadName(const string& name)
+{
+    (void)pthread_setname_np(pthread_self(), name.substr(0, kMaxThreadNameLen).c_str());
+}
+
+AclLiteError ApplyThreadSched(const string& name, const ThreadSchedConfig& config)
+{
+    AclLiteError result = ACLLITE_OK;
+    if (!config.cpuAffinity.empty()) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        string cpus;
+        for (int cpu : config.cpuAffinity) {
+            if ((cpu < 0) || (cpu >= CPU_SETSIZE)) {
+                continue;
+            }
+            CPU_SET(cpu, &cpuSet);
+            cpus += (cpus.empty() ? "" : ",") + to_string(cpu);
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (ret != 0) {
+            ACLLITE_LOG_WARNING("Set cpu affinity %s of thread %s failed, error %d",
+                                cpus.c_str(), name.c_str(), ret);
+            result = ACLLITE_ERROR;
+        } else {
+            ACLLITE_LOG_INFO("Thread %s runs on cpu %s", name.c_str(), cpus.c_str());
+        }
+    }
+    if (config.fifoPriority > 0) {
+        sched_param param = {};
+        param.sched_priority = config.fifoPriority;
+        int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (ret != 0) {
+            // SCHED_FIFO needs root or CAP_SYS_NICE
+            ACLLITE_LOG_WARNING("Set SCHED_FIFO priority %d of thread %s failed, error %d",
+                                config.fifoPriority, name.c_str(), ret);
+            result = ACLLITE_ERROR;
+        }
+    } else if (config.nice != 0) {
+        // the nice value is per thread on linux
+        int nice = max(kMinNice, min(kMaxNice, config.nice));
+        if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice) != 0) {
+            ACLLITE_LOG_WARNING("Set nice %d of thread %s failed", nice, name.c_str());
+            result = ACLLITE_ERROR;
+        }
+    }
+    return result;
+}
+
+AclLiteError RunOnAllCpus(const function<AclLiteError()>& func)
+{
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    bool isPinned = (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0) &&
+                    !CPU_EQUAL(&cpuSet, &kProcessCpuSet) &&
+                    (pthread_setaffinity_np(pthread_self(), sizeof(kProcessCpuSet), &kProcessCpuSet) == 0);
+    AclLiteError ret = func();
+    if (isPinned) {
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    }
+    return ret;
+}
+
+void ReportThreadCpuTime()
+{
+    double ticksPerSec = sysconf(_SC_CLK_TCK);
+    VisitThreadCpuTime([ticksPerSec](const string& tid, const string& name, uint64_t utime, uint64_t stime) {
+        ACLLITE_LOG_INFO("Thread %-15s tid %s cpu time: user %.2fs, system %.2fs",
+                         name.c_str(), tid.c_str(), utime / ticksPerSec, stime / ticksPerSec);
+    });
+}
+
+void AddThreadCpuTimeMetrics()
+{
+    AclLiteMetrics::GetInstance().AddCollector([]() {
+        double usPerTick = kMicrosecondsPerSecond / sysconf(_SC_CLK_TCK);
+        VisitThreadCpuTime([usPerTick](const string& tid, const string& name, uint64_t utime, uint64_t stime) {
+            AclLiteMetrics& metrics = AclLiteMetrics::GetInstance();
+            // the names are not unique, such as the codec threads named after their creator
+            string labels = AclLiteMetrics::Label("thread", name) + "," + AclLiteMetrics::Label("tid", tid);
+            const string help = "Cpu time of the thread read from /proc/self/task";
+            metrics.GetCounter("acllite_thread_cpu_microseconds_total", help,
+                labels + "," + AclLiteMetrics::Label("mode", "user"))->Set(utime * usPerTick);
+            metrics.GetCounter("acllite_thread_cpu_microseconds_total", help,
+                labels + "," + AclLiteMetrics::Label("mode", "system"))->Set(stime * usPerTick);
+        });
+    });
+}
@@ -188,10 +188,10 @@ void* MallocMemory(uint32_t dataSize, MemoryType memType)
             aclRet = aclrtMallocHost(&buffer, dataSize);
             break;
         case MEMORY_DEVICE:
-            aclRet = aclrtMalloc(&buffer, dataSize, ACL_MEM_MALLOC_HUGE_FIRST);
+            buffer = AclLiteMemPool::GetDevicePool().Alloc(dataSize);
             break;
         case MEMORY_DVPP:
-            aclRet = acldvppMalloc(&buffer, dataSize);
+            buffer = AclLiteMemPool::GetDvppPool().Alloc(dataSize);
             break;
         default:
             ACLLITE_LOG_ERROR("Invalid memory type %d", memType);
@@ -217,10 +217,10 @@ void FreeMemory(void* mem, MemoryType memType)
             aclrtFreeHost(mem);
             break;
         case MEMORY_DEVICE:
-            aclrtFree(mem);
+            AclLiteMemPool::GetDevicePool().Free(mem);
             break;
         case MEMORY_DVPP:
-            acldvppFree(mem);
+            AclLiteMemPool::GetDvppPool().Free(mem);
             break;
         default:
             ACLLITE_LOG_ERROR("Invalid memory type %d", memType);
@@ -350,6 +350,7 @@ AclLiteError CopyImageToLocal(ImageData& destImage, ImageData& srcImage,
     destImage.alignWidth = srcImage.alignWidth;
     destImage.alignHeight = srcImage.alignHeight;
     destImage.data = SHARED_PTR_U8_BUF(data);
+    destImage.memType = MEMORY_NORMAL;
 
     return ACLLITE_OK;
 }
@@ -374,6 +375,7 @@ AclLiteError CopyImageToDevice(ImageData& destImage, ImageData& srcImage,
     } else {
         destImage.data = SHARED_PTR_DVPP_BUF(data);
     }
+    destImage.memType = (memType == MEMORY_DEVICE) ? MEMORY_DEVICE : MEMORY_DVPP;
 
     return ACLLITE_OK;
 }
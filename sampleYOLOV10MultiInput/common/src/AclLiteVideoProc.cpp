@@ -41,7 +41,9 @@
 #include "AclLiteUtils.h"
 #include "AclLiteVideoProc.h"
 #include "VideoCapture.h"
+#include "SwVideoCapture.h"
 #include "VideoWriter.h"
+#include "SwVideoWriter.h"
 #ifdef ENABLE_BOARD_CAMARE
 #include "CameraCapture.h"
 #endif
@@ -68,15 +70,24 @@ AclLiteVideoProc::AclLiteVideoProc(uint32_t cameraId, uint32_t width,
 #endif
 }
 
-AclLiteVideoProc::AclLiteVideoProc(const string& videoPath, int32_t deviceId, aclrtContext context)
+AclLiteVideoProc::AclLiteVideoProc(const string& videoPath, int32_t deviceId, aclrtContext context,
+                                   bool swDecode)
 {
-    cap_ = new VideoCapture(videoPath, deviceId, context);
+    if (swDecode) {
+        cap_ = new SwVideoCapture(videoPath, deviceId, context);
+    } else {
+        cap_ = new VideoCapture(videoPath, deviceId, context);
+    }
     Open();
 }
 
 AclLiteVideoProc::AclLiteVideoProc(VencConfig& vencConfig, aclrtContext context)
 {
-    cap_ = new VideoWriter(vencConfig, context);
+    if (vencConfig.swEncode) {
+        cap_ = new SwVideoWriter(vencConfig, context);
+    } else {
+        cap_ = new VideoWriter(vencConfig, context);
+    }
     Open();
 }
 
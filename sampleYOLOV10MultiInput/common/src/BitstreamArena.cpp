@@ -0,0 +1,159 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File BitstreamArena.cpp
+* Description: dvpp buffer ring for the h26x packets sent to vdec
+*/
+#include <chrono>
+#include <cstring>
+#include "acl/ops/acl_dvpp.h"
+#include "AclLiteUtils.h"
+#include "BitstreamArena.h"
+
+using namespace std;
+
+namespace {
+    // keep every packet start aligned like a dvpp malloced buffer
+    const uint32_t kPacketAlign = 128;
+}
+
+BitstreamArena::BitstreamArena(uint32_t capacity, aclrtRunMode runMode)
+    :capacity_(capacity), runMode_(runMode), base_(nullptr), writeNum_(0), waitNum_(0)
+{
+}
+
+BitstreamArena::~BitstreamArena()
+{
+    if (base_ != nullptr) {
+        if (!packets_.empty()) {
+            ACLLITE_LOG_ERROR("%zu packets are still in vdec when the arena is freed", packets_.size());
+        }
+        (void)acldvppFree(base_);
+        base_ = nullptr;
+    }
+}
+
+AclLiteError BitstreamArena::Init()
+{
+    void* buffer = nullptr;
+    aclError aclRet = acldvppMalloc(&buffer, capacity_);
+    if ((aclRet != ACL_SUCCESS) || (buffer == nullptr)) {
+        ACLLITE_LOG_ERROR("Malloc bitstream arena failed, size %u, errorno:%d", capacity_, aclRet);
+        return ACLLITE_ERROR_MALLOC_DVPP;
+    }
+    base_ = (uint8_t*)buffer;
+    return ACLLITE_OK;
+}
+
+bool BitstreamArena::Reserve(uint32_t size, uint32_t& offset)
+{
+    uint32_t alignSize = (size + kPacketAlign - 1) / kPacketAlign * kPacketAlign;
+    if (packets_.empty()) {
+        offset = 0;
+    } else {
+        uint32_t head = packets_.front().offset;
+        uint32_t tail = packets_.back().offset + packets_.back().size;
+        if (tail > head) {
+            // the free space is [tail, capacity) and [0, head)
+            if (tail + alignSize <= capacity_) {
+                offset = tail;
+            } else if (alignSize <= head) {
+                offset = 0;
+            } else {
+                return false;
+            }
+        } else if (tail + alignSize <= head) {
+            // wrapped, the free space is [tail, head)
+            offset = tail;
+        } else {
+            return false;
+        }
+    }
+    Packet packet;
+    packet.offset = offset;
+    packet.size = alignSize;
+    packet.released = false;
+    packets_.push_back(packet);
+    return true;
+}
+
+AclLiteError BitstreamArena::Write(const void* data, uint32_t size, void*& buffer, uint32_t timeoutMs)
+{
+    buffer = nullptr;
+    if ((base_ == nullptr) || (size == 0) || (size > capacity_)) {
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    uint32_t offset = 0;
+    {
+        unique_lock<mutex> lock(mutex_);
+        if (!Reserve(size, offset)) {
+            waitNum_++;
+            bool reserved = released_.wait_for(lock, chrono::milliseconds(timeoutMs),
+                                               [this, size, &offset] { return Reserve(size, offset); });
+            if (!reserved) {
+                return ACLLITE_ERROR_BITSTREAM_ARENA_FULL;
+            }
+        }
+        writeNum_++;
+    }
+
+    // the space is reserved, copy without the lock
+    buffer = base_ + offset;
+    if (runMode_ == ACL_DEVICE) {
+        // the dvpp memory is mapped to the device cpu, the demuxed packet is written directly
+        memcpy(buffer, data, size);
+        return ACLLITE_OK;
+    }
+    aclError aclRet = aclrtMemcpy(buffer, capacity_ - offset, data, size, ACL_MEMCPY_HOST_TO_DEVICE);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Copy packet to bitstream arena failed, size %u, errorno:%d", size, aclRet);
+        (void)Release(buffer);
+        buffer = nullptr;
+        return ACLLITE_ERROR_COPY_DATA;
+    }
+    return ACLLITE_OK;
+}
+
+bool BitstreamArena::Release(void* buffer)
+{
+    uint8_t* ptr = (uint8_t*)buffer;
+    if ((base_ == nullptr) || (ptr < base_) || (ptr >= base_ + capacity_)) {
+        return false;
+    }
+    uint32_t offset = ptr - base_;
+    lock_guard<mutex> lock(mutex_);
+    for (size_t i = 0; i < packets_.size(); i++) {
+        if (packets_[i].offset == offset) {
+            packets_[i].released = true;
+            break;
+        }
+    }
+    bool freed = false;
+    while (!packets_.empty() && packets_.front().released) {
+        packets_.pop_front();
+        freed = true;
+    }
+    if (freed) {
+        released_.notify_all();
+    }
+    return true;
+}
+
+void BitstreamArena::GetStats(uint64_t& writeNum, uint64_t& waitNum)
+{
+    lock_guard<mutex> lock(mutex_);
+    writeNum = writeNum_;
+    waitNum = waitNum_;
+}
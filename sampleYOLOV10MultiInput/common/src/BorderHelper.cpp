@@ -91,10 +91,10 @@ AclLiteError BorderHelper::InitBorderOutputDesc()
     }
 
     vpcOutBufferSize_ = YUV420SP_SIZE(borderOutWidthStride, borderOutHeightStride);
-    aclError aclRet = acldvppMalloc(&vpcOutBufferDev_, vpcOutBufferSize_);
-    if (aclRet != ACL_SUCCESS) {
+    vpcOutBufferDev_ = AclLiteMemPool::GetDvppPool().Alloc(vpcOutBufferSize_);
+    if (vpcOutBufferDev_ == nullptr) {
         ACLLITE_LOG_ERROR("Dvpp border malloc output buffer failed, "
-                          "size %d, error %d", vpcOutBufferSize_, aclRet);
+                          "size %d", vpcOutBufferSize_);
         return ACLLITE_ERROR_MALLOC_DVPP;
     }
 
@@ -211,6 +211,7 @@ AclLiteError BorderHelper::Process(ImageData& borderImage, ImageData& srcImage)
     borderImage.alignHeight = ALIGN_UP2(size_.height);
     borderImage.size = vpcOutBufferSize_;
     borderImage.data = SHARED_PTR_DVPP_BUF(vpcOutBufferDev_);
+    borderImage.memType = MEMORY_DVPP;
 
     DestroyBorderResource();
 
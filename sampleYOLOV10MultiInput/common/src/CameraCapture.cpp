@@ -218,6 +218,7 @@ AclLiteError CameraCapture::Read(ImageData& image)
     image.alignHeight = height_;
     image.size = (uint32_t)size_;
     image.data = SHARED_PTR_DVPP_BUF(buffer);
+    image.memType = MEMORY_DVPP;
 
     return ACLLITE_OK;
 }
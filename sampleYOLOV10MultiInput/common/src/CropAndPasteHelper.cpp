@@ -16,14 +16,28 @@
 * File AclLiteImageProc.cpp
 * Description: handle dvpp process
 */
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <vector>
 #include "acl/acl.h"
 #include "AclLiteUtils.h"
 #include "CropAndPasteHelper.h"
 
 using namespace std;
 
+namespace {
+    // the pad color of letterbox, gray in YUV
+    const int32_t kPadY = 114;
+    const int32_t kPadUV = 128;
+    const uint32_t kPasteLeftAlign = 16;
+    struct PadFill {
+        uint8_t* addr;
+        uint32_t size;
+        int32_t value;
+    };
+}
+
 CropAndPasteHelper::CropAndPasteHelper(aclrtStream& stream,
     acldvppChannelDesc *dvppChannelDesc,
     uint32_t ltHorz, uint32_t ltVert,
@@ -122,12 +136,12 @@ AclLiteError CropAndPasteHelper::InitCropAndPasteOutputDesc()
 
     vpcOutBufferSize_ = YUV420SP_SIZE(cropOutWidthStride,
                                       cropOutHeightStride);
-    aclError aclRet = acldvppMalloc(&vpcOutBufferDev_, vpcOutBufferSize_);
-    if (aclRet != ACL_SUCCESS) {
+    vpcOutBufferDev_ = AclLiteMemPool::GetDvppPool().Alloc(vpcOutBufferSize_);
+    if (vpcOutBufferDev_ == nullptr) {
         ACLLITE_LOG_ERROR("Dvpp crop malloc output memory failed, crop "
-                          "width %d, height %d size %d, error %d",
+                          "width %d, height %d size %d",
                           size_.width, size_.height,
-                          vpcOutBufferSize_, aclRet);
+                          vpcOutBufferSize_);
         return ACLLITE_ERROR;
     }
     aclrtMemset(vpcOutBufferDev_, vpcOutBufferSize_, 0, vpcOutBufferSize_);
@@ -222,6 +236,7 @@ AclLiteError CropAndPasteHelper::Process(ImageData& cropedImage, ImageData& srcI
     cropedImage.alignHeight = ALIGN_UP2(size_.height);
     cropedImage.size = vpcOutBufferSize_;
     cropedImage.data = SHARED_PTR_DVPP_BUF(vpcOutBufferDev_);
+    cropedImage.memType = MEMORY_DVPP;
 
     DestroyCropAndPasteResource();
 
@@ -288,6 +303,7 @@ AclLiteError CropAndPasteHelper::ProcessCropPaste(ImageData& cropedImage, ImageD
     cropedImage.alignHeight = ALIGN_UP2(size_.height);
     cropedImage.size = vpcOutBufferSize_;
     cropedImage.data = SHARED_PTR_DVPP_BUF(vpcOutBufferDev_);
+    cropedImage.memType = MEMORY_DVPP;
 
     DestroyCropAndPasteResource();
 
@@ -373,6 +389,7 @@ AclLiteError CropAndPasteHelper::ProportionProcess(ImageData& resizedImage, Imag
     resizedImage.alignHeight = ALIGN_UP2(pasteHeight);
     resizedImage.size = vpcOutBufferSize_;
     resizedImage.data = SHARED_PTR_DVPP_BUF(vpcOutBufferDev_);
+    resizedImage.memType = MEMORY_DVPP;
 
     DestroyCropAndPasteResource();
 
@@ -460,12 +477,132 @@ AclLiteError CropAndPasteHelper::ProportionCenterProcess(ImageData& resizedImage
     resizedImage.alignHeight = ALIGN_UP2(pasteHeight);
     resizedImage.size = vpcOutBufferSize_;
     resizedImage.data = SHARED_PTR_DVPP_BUF(vpcOutBufferDev_);
+    resizedImage.memType = MEMORY_DVPP;
 
     DestroyCropAndPasteResource();
 
     return ACLLITE_OK;
 }
 
+AclLiteError CropAndPasteHelper::InitLetterboxOutputDesc(void* dest)
+{
+    // the output is the caller's buffer, its stride is the image size
+    vpcOutBufferSize_ = YUV420SP_SIZE(size_.width, size_.height);
+    vpcOutputDesc_ = acldvppCreatePicDesc();
+    if (vpcOutputDesc_ == nullptr) {
+        ACLLITE_LOG_ERROR("Dvpp letterbox create pic desc failed");
+        return ACLLITE_ERROR_CREATE_PIC_DESC;
+    }
+    acldvppSetPicDescData(vpcOutputDesc_, dest);
+    acldvppSetPicDescFormat(vpcOutputDesc_, PIXEL_FORMAT_YUV_SEMIPLANAR_420);
+    acldvppSetPicDescWidth(vpcOutputDesc_, size_.width);
+    acldvppSetPicDescHeight(vpcOutputDesc_, size_.height);
+    acldvppSetPicDescWidthStride(vpcOutputDesc_, size_.width);
+    acldvppSetPicDescHeightStride(vpcOutputDesc_, size_.height);
+    acldvppSetPicDescSize(vpcOutputDesc_, vpcOutBufferSize_);
+
+    return ACLLITE_OK;
+}
+
+AclLiteError CropAndPasteHelper::FillLetterboxPad(uint8_t* dest, uint32_t pasteLeft, uint32_t pasteTop,
+                                                  uint32_t pasteWidth, uint32_t pasteHeight)
+{
+    // vpc keeps the output outside the paste area, so only the pad is filled
+    uint32_t ySize = size_.width * size_.height;
+    uint32_t uvSize = ySize / 2;
+    vector<PadFill> fills;
+    if ((pasteLeft == 0) && (pasteWidth == size_.width)) {
+        // the pad is the rows above and below the image
+        uint32_t topSize = pasteTop * size_.width;
+        uint32_t bottomOffset = (pasteTop + pasteHeight) * size_.width;
+        fills.push_back({dest, topSize, kPadY});
+        fills.push_back({dest + bottomOffset, ySize - bottomOffset, kPadY});
+        fills.push_back({dest + ySize, topSize / 2, kPadUV});
+        fills.push_back({dest + ySize + bottomOffset / 2, (ySize - bottomOffset) / 2, kPadUV});
+    } else {
+        fills.push_back({dest, ySize, kPadY});
+        fills.push_back({dest + ySize, uvSize, kPadUV});
+    }
+    for (size_t i = 0; i < fills.size(); i++) {
+        if (fills[i].size == 0) {
+            continue;
+        }
+        aclError aclRet = aclrtMemsetAsync(fills[i].addr, fills[i].size, fills[i].value,
+                                           fills[i].size, stream_);
+        if (aclRet != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("Fill letterbox pad failed, aclRet = %d", aclRet);
+            return ACLLITE_ERROR;
+        }
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError CropAndPasteHelper::LetterboxProcess(void* dest, ImageData& srcImage, LetterboxInfo& info)
+{
+    if ((size_.width % kPasteLeftAlign != 0) || (size_.height % 2 != 0)) {
+        ACLLITE_LOG_ERROR("Letterbox output width %d must be 16 aligned and height %d must be even",
+                          size_.width, size_.height);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    if ((ACLLITE_OK != InitCropAndPasteInputDesc(srcImage)) ||
+        (ACLLITE_OK != InitLetterboxOutputDesc(dest))) {
+        ACLLITE_LOG_ERROR("Dvpp letterbox failed for init error");
+        DestroyCropAndPasteResource();
+        return ACLLITE_ERROR;
+    }
+
+    // crop the whole image, must even/odd
+    uint32_t cropRightOffset = ((originalImageWidth_ >> 1) << 1) - 1;
+    uint32_t cropBottomOffset = ((originalImageHeight_ >> 1) << 1) - 1;
+    cropArea_ = acldvppCreateRoiConfig(0, cropRightOffset, 0, cropBottomOffset);
+    if (cropArea_ == nullptr) {
+        ACLLITE_LOG_ERROR("acldvppCreateRoiConfig cropArea_ failed");
+        DestroyCropAndPasteResource();
+        return ACLLITE_ERROR;
+    }
+
+    // paste the image resized keeping the aspect ratio to the center,
+    // the left offset must be 16 aligned and the other offsets even
+    float scale = min((float)size_.width / originalImageWidth_,
+                      (float)size_.height / originalImageHeight_);
+    uint32_t pasteWidth = min(((uint32_t)(originalImageWidth_ * scale) >> 1) << 1, size_.width);
+    uint32_t pasteHeight = min(((uint32_t)(originalImageHeight_ * scale) >> 1) << 1, size_.height);
+    uint32_t pasteLeft = (size_.width - pasteWidth) / 2 / kPasteLeftAlign * kPasteLeftAlign;
+    uint32_t pasteTop = ((size_.height - pasteHeight) / 2 >> 1) << 1;
+    pasteArea_ = acldvppCreateRoiConfig(pasteLeft, pasteLeft + pasteWidth - 1,
+                                        pasteTop, pasteTop + pasteHeight - 1);
+    if (pasteArea_ == nullptr) {
+        ACLLITE_LOG_ERROR("acldvppCreateRoiConfig pasteArea_ failed");
+        DestroyCropAndPasteResource();
+        return ACLLITE_ERROR;
+    }
+
+    if (ACLLITE_OK != FillLetterboxPad((uint8_t *)dest, pasteLeft, pasteTop, pasteWidth, pasteHeight)) {
+        DestroyCropAndPasteResource();
+        return ACLLITE_ERROR;
+    }
+    aclError aclRet = acldvppVpcCropAndPasteAsync(dvppChannelDesc_, vpcInputDesc_,
+                                                  vpcOutputDesc_, cropArea_,
+                                                  pasteArea_, stream_);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("acldvppVpcCropAndPasteAsync failed, aclRet = %d", aclRet);
+        DestroyCropAndPasteResource();
+        return ACLLITE_ERROR;
+    }
+    aclRet = aclrtSynchronizeStream(stream_);
+    DestroyCropAndPasteResource();
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("letterbox aclrtSynchronizeStream failed, aclRet = %d", aclRet);
+        return ACLLITE_ERROR;
+    }
+
+    info.scaleX = (float)pasteWidth / (cropRightOffset + 1);
+    info.scaleY = (float)pasteHeight / (cropBottomOffset + 1);
+    info.padLeft = pasteLeft;
+    info.padTop = pasteTop;
+    return ACLLITE_OK;
+}
+
 void CropAndPasteHelper::DestroyCropAndPasteResource()
 {
     if (cropArea_ != nullptr) {
@@ -57,9 +57,9 @@ AclLiteError JpegDHelper::InitDecodeOutputDesc(ImageData& inputImage)
 
     decodeOutBufferSize_ = YUV420SP_SIZE(decodeOutWidthStride_, decodeOutHeightStride_);
 
-    aclError aclRet = acldvppMalloc(&decodeOutBufferDev_, decodeOutBufferSize_);
-    if (aclRet != ACL_SUCCESS) {
-        ACLLITE_LOG_ERROR("Malloc dvpp memory failed, error:%d", aclRet);
+    decodeOutBufferDev_ = AclLiteMemPool::GetDvppPool().Alloc(decodeOutBufferSize_);
+    if (decodeOutBufferDev_ == nullptr) {
+        ACLLITE_LOG_ERROR("Malloc dvpp memory failed");
         return ACLLITE_ERROR_MALLOC_DVPP;
     }
 
@@ -108,6 +108,7 @@ AclLiteError JpegDHelper::Process(ImageData& dest, ImageData& src)
     dest.alignHeight = decodeOutHeightStride_;
     dest.size = decodeOutBufferSize_;
     dest.data = SHARED_PTR_DVPP_BUF(decodeOutBufferDev_);
+    dest.memType = MEMORY_DVPP;
 
     return ACLLITE_OK;
 }
@@ -0,0 +1,247 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File LatencyTracer.cpp
+* Description: per channel latency of the pipeline stages
+*/
+#include <chrono>
+#include <fstream>
+#include "LatencyTracer.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace {
+    // 16 buckets per power of 2, the percentiles are within 6.25%
+    const uint32_t kSubBucketBits = 4;
+    const uint32_t kSubBucketNum = 1 << kSubBucketBits;
+    const uint32_t kBucketNum = (64 - kSubBucketBits + 1) * kSubBucketNum;
+    const double kUsPerMs = 1000.0;
+
+    uint32_t BucketIndex(uint64_t us)
+    {
+        if (us < kSubBucketNum) {
+            return us;
+        }
+        uint32_t msb = 63 - __builtin_clzll(us);
+        uint32_t sub = (us >> (msb - kSubBucketBits)) & (kSubBucketNum - 1);
+        return (msb - kSubBucketBits + 1) * kSubBucketNum + sub;
+    }
+
+    uint64_t BucketValue(uint32_t index)
+    {
+        if (index < kSubBucketNum) {
+            return index;
+        }
+        uint32_t msb = index / kSubBucketNum + kSubBucketBits - 1;
+        uint64_t sub = index % kSubBucketNum;
+        return (kSubBucketNum + sub) << (msb - kSubBucketBits);
+    }
+}
+
+atomic<bool> LatencyTracer::isEnabled_(false);
+
+LatencyTracer::LatencyHistogram::LatencyHistogram()
+    :buckets_(kBucketNum, 0), count_(0), maxUs_(0)
+{
+}
+
+void LatencyTracer::LatencyHistogram::Add(uint64_t us)
+{
+    buckets_[BucketIndex(us)]++;
+    count_++;
+    maxUs_ = max(maxUs_, us);
+}
+
+uint64_t LatencyTracer::LatencyHistogram::Percentile(double percent) const
+{
+    if (count_ == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(count_ * percent / 100.0);
+    rank = (rank == 0) ? 1 : rank;
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < kBucketNum; i++) {
+        sum += buckets_[i];
+        if (sum >= rank) {
+            return min(BucketValue(i), maxUs_);
+        }
+    }
+    return maxUs_;
+}
+
+LatencyTracer& LatencyTracer::GetInstance()
+{
+    static LatencyTracer tracer;
+    return tracer;
+}
+
+LatencyTracer::LatencyTracer()
+    :maxTraceFrames_(0), droppedTraceNum_(0), isReported_(false)
+{
+}
+
+uint64_t LatencyTracer::NowUs()
+{
+    return chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyTracer::Enable(const vector<string>& stageNames, const string& traceFile,
+                           uint32_t maxTraceFrames)
+{
+    unique_lock<mutex> lock(mutex_);
+    stageNames_ = stageNames;
+    traceFile_ = traceFile;
+    maxTraceFrames_ = traceFile.empty() ? 0 : maxTraceFrames;
+    traceFrames_.reserve(maxTraceFrames_);
+    isEnabled_ = true;
+    ACLLITE_LOG_INFO("Latency trace is enabled, trace file: %s, max trace frames %u",
+                     traceFile.empty() ? "none" : traceFile.c_str(), maxTraceFrames_);
+}
+
+void LatencyTracer::Record(uint32_t channelId, int frameId, const uint64_t* stageTimeUs)
+{
+    if (!IsEnabled()) {
+        return;
+    }
+    unique_lock<mutex> lock(mutex_);
+    ChannelLatency& channel = channels_[channelId];
+    if (channel.stages.empty()) {
+        channel.stages.resize(stageNames_.size());
+    }
+    uint64_t firstUs = 0;
+    uint64_t prevUs = 0;
+    for (size_t i = 0; i < stageNames_.size(); i++) {
+        if (stageTimeUs[i] == 0) {
+            continue;
+        }
+        if (prevUs == 0) {
+            firstUs = stageTimeUs[i];
+        } else if (stageTimeUs[i] >= prevUs) {
+            channel.stages[i].Add(stageTimeUs[i] - prevUs);
+        }
+        prevUs = stageTimeUs[i];
+    }
+    if (prevUs > firstUs) {
+        channel.endToEnd.Add(prevUs - firstUs);
+    }
+
+    if (traceFrames_.size() < maxTraceFrames_) {
+        TraceFrame frame;
+        frame.channelId = channelId;
+        frame.frameId = frameId;
+        frame.stageTimeUs.assign(stageTimeUs, stageTimeUs + stageNames_.size());
+        traceFrames_.push_back(frame);
+    } else if (maxTraceFrames_ > 0) {
+        droppedTraceNum_++;
+    }
+}
+
+void LatencyTracer::PrintHistogram(uint32_t channelId, const string& name, const LatencyHistogram& histogram)
+{
+    if (histogram.GetCount() == 0) {
+        return;
+    }
+    ACLLITE_LOG_INFO("Channel %u latency %-14s p50 %8.2fms, p95 %8.2fms, p99 %8.2fms, max %8.2fms, count %lu",
+                     channelId, name.c_str(), histogram.Percentile(50) / kUsPerMs,
+                     histogram.Percentile(95) / kUsPerMs, histogram.Percentile(99) / kUsPerMs,
+                     histogram.GetMax() / kUsPerMs, histogram.GetCount());
+}
+
+void LatencyTracer::Report()
+{
+    if (!IsEnabled()) {
+        return;
+    }
+    unique_lock<mutex> lock(mutex_);
+    if (isReported_) {
+        return;
+    }
+    isReported_ = true;
+    for (auto& channel : channels_) {
+        // the first stamp starts the frame, it has no latency
+        for (size_t i = 1; i < stageNames_.size(); i++) {
+            PrintHistogram(channel.first, stageNames_[i], channel.second.stages[i]);
+        }
+        PrintHistogram(channel.first, "end_to_end", channel.second.endToEnd);
+    }
+    if (!traceFile_.empty()) {
+        WriteTraceFile();
+    }
+}
+
+AclLiteError LatencyTracer::WriteTraceFile()
+{
+    ofstream traceFile(traceFile_);
+    if (!traceFile.is_open()) {
+        ACLLITE_LOG_ERROR("Open trace file %s failed", traceFile_.c_str());
+        return ACLLITE_ERROR_OPEN_FILE;
+    }
+    uint64_t startUs = UINT64_MAX;
+    for (auto& frame : traceFrames_) {
+        for (auto stamp : frame.stageTimeUs) {
+            if (stamp != 0) {
+                startUs = min(startUs, stamp);
+            }
+        }
+    }
+
+    // async events: every frame is a row of its channel, nesting one slice per stage
+    traceFile << "{\"traceEvents\":[";
+    bool isFirst = true;
+    for (auto& channel : channels_) {
+        traceFile << (isFirst ? "" : ",") << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+                  << channel.first << ",\"args\":{\"name\":\"channel " << channel.first << "\"}}";
+        isFirst = false;
+    }
+    for (auto& frame : traceFrames_) {
+        string common = "\"cat\":\"frame\",\"id\":\"" + to_string(frame.channelId) + "-" +
+            to_string(frame.frameId) + "\",\"pid\":" + to_string(frame.channelId) +
+            ",\"tid\":" + to_string(frame.channelId);
+        string frameName = "frame " + to_string(frame.frameId);
+        string stages;
+        uint64_t firstUs = 0;
+        uint64_t prevUs = 0;
+        for (size_t i = 0; i < frame.stageTimeUs.size(); i++) {
+            uint64_t stamp = frame.stageTimeUs[i];
+            if ((stamp == 0) || (stamp < prevUs)) {
+                continue;
+            }
+            if (prevUs == 0) {
+                firstUs = stamp;
+            } else {
+                stages += ",\n{\"name\":\"" + stageNames_[i] + "\",\"ph\":\"b\"," + common +
+                    ",\"ts\":" + to_string(prevUs - startUs) + "}";
+                stages += ",\n{\"name\":\"" + stageNames_[i] + "\",\"ph\":\"e\"," + common +
+                    ",\"ts\":" + to_string(stamp - startUs) + "}";
+            }
+            prevUs = stamp;
+        }
+        if (prevUs == firstUs) {
+            continue;
+        }
+        traceFile << (isFirst ? "" : ",") << "\n{\"name\":\"" << frameName << "\",\"ph\":\"b\","
+                  << common << ",\"ts\":" << (firstUs - startUs) << "}" << stages;
+        traceFile << ",\n{\"name\":\"" << frameName << "\",\"ph\":\"e\","
+                  << common << ",\"ts\":" << (prevUs - startUs) << "}";
+        isFirst = false;
+    }
+    traceFile << "\n]}\n";
+    traceFile.close();
+    ACLLITE_LOG_INFO("Write %zu frames to trace file %s, %lu frames are not traced",
+                     traceFrames_.size(), traceFile_.c_str(), droppedTraceNum_);
+    return ACLLITE_OK;
+}
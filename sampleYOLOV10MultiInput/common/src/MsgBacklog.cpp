@@ -0,0 +1,152 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File MsgBacklog.cpp
+* Description: non-blocking message sending with a backlog per key
+*/
+#include <chrono>
+#include "MsgBacklog.h"
+#include "AclLiteApp.h"
+#include "AclLiteThreadSched.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace {
+    // the destination queues do not notify, the full ones are retried at this interval
+    const uint32_t kRetryIntervalMs = 1;
+}
+
+MsgBacklog::MsgBacklog()
+    :MsgBacklog(SendFunc([](int dest, int msgId, shared_ptr<void> data) {
+        return SendMessage(dest, msgId, data);
+    }))
+{
+}
+
+MsgBacklog::MsgBacklog(SendFunc sendFunc)
+    :sendFunc_(sendFunc), waitingNum_(0), backloggedNum_(0), maxWaitingNum_(0),
+    isRunning_(false), isStopping_(false)
+{
+}
+
+MsgBacklog::~MsgBacklog()
+{
+    Stop();
+}
+
+AclLiteError MsgBacklog::Start(const string& name)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (isRunning_) {
+        ACLLITE_LOG_ERROR("The message backlog %s is started already", name_.c_str());
+        return ACLLITE_ERROR_INITED_ALREADY;
+    }
+    name_ = name;
+    isStopping_ = false;
+    isRunning_ = true;
+    flushThread_ = thread(&MsgBacklog::FlushRun, this);
+    return ACLLITE_OK;
+}
+
+AclLiteError MsgBacklog::Send(uint32_t key, int dest, int msgId, shared_ptr<void> data)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (!isRunning_) {
+        return ACLLITE_ERROR_POOL_STOPPED;
+    }
+    deque<WaitingMsg>& backlog = backlogs_[key];
+    if (backlog.empty()) {
+        AclLiteError ret = sendFunc_(dest, msgId, data);
+        if (ret != ACLLITE_ERROR_ENQUEUE) {
+            return ret;
+        }
+    }
+    backlog.push_back(WaitingMsg{dest, msgId, data});
+    waitingNum_++;
+    backloggedNum_++;
+    maxWaitingNum_ = max(maxWaitingNum_, backlog.size());
+    msgAdded_.notify_one();
+    return ACLLITE_OK;
+}
+
+bool MsgBacklog::WaitBelow(uint32_t key, size_t maxNum, uint32_t timeoutMs)
+{
+    unique_lock<mutex> lock(mutex_);
+    return msgSent_.wait_for(lock, chrono::milliseconds(timeoutMs), [this, key, maxNum]() {
+        auto it = backlogs_.find(key);
+        return (it == backlogs_.end()) || (it->second.size() < maxNum);
+    });
+}
+
+void MsgBacklog::FlushKey(deque<WaitingMsg>& backlog)
+{
+    while (!backlog.empty()) {
+        WaitingMsg& msg = backlog.front();
+        AclLiteError ret = sendFunc_(msg.dest, msg.msgId, msg.data);
+        if (ret == ACLLITE_ERROR_ENQUEUE) {
+            return;
+        }
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Drop the message %d to %d of backlog %s, error %d",
+                              msg.msgId, msg.dest, name_.c_str(), ret);
+        }
+        backlog.pop_front();
+        waitingNum_--;
+    }
+}
+
+void MsgBacklog::FlushRun()
+{
+    SetThreadName(name_);
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        if (waitingNum_ == 0) {
+            if (isStopping_) {
+                break;
+            }
+            msgAdded_.wait(lock);
+            continue;
+        }
+        size_t waitingNum = waitingNum_;
+        for (auto& backlog : backlogs_) {
+            FlushKey(backlog.second);
+        }
+        if (waitingNum_ < waitingNum) {
+            msgSent_.notify_all();
+        }
+        if (waitingNum_ > 0) {
+            (void)msgAdded_.wait_for(lock, chrono::milliseconds(kRetryIntervalMs));
+        }
+    }
+}
+
+void MsgBacklog::Stop()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!isRunning_ || isStopping_) {
+            return;
+        }
+        // the messages sent before Stop are flushed first
+        isStopping_ = true;
+        msgAdded_.notify_all();
+    }
+    flushThread_.join();
+    lock_guard<mutex> lock(mutex_);
+    isRunning_ = false;
+    ACLLITE_LOG_INFO("Message backlog %s stopped, %lu messages were backlogged, max %zu of one key",
+                     name_.c_str(), backloggedNum_, maxWaitingNum_);
+}
@@ -47,9 +47,9 @@ AclLiteError PngDHelper::InitDecodeOutputDesc(ImageData& inputImage)
     uint32_t decodeOutBufferSize =
     RGBU8_IMAGE_SIZE(decodeOutWidthStride, decodeOutHeightStride);
 
-    aclError aclRet = acldvppMalloc(&decodeOutBufferDev_, decodeOutBufferSize);
-    if (aclRet != ACL_SUCCESS) {
-        ACLLITE_LOG_ERROR("Malloc dvpp memory failed, error:%d", aclRet);
+    decodeOutBufferDev_ = AclLiteMemPool::GetDvppPool().Alloc(decodeOutBufferSize);
+    if (decodeOutBufferDev_ == nullptr) {
+        ACLLITE_LOG_ERROR("Malloc dvpp memory failed");
         return ACLLITE_ERROR_MALLOC_DVPP;
     }
 
@@ -99,6 +99,7 @@ AclLiteError PngDHelper::Process(ImageData& dest, ImageData& src)
     dest.alignHeight = ALIGN_UP16(src.height);
     dest.size = RGBU8_IMAGE_SIZE(dest.alignWidth, dest.alignHeight);
     dest.data = SHARED_PTR_DVPP_BUF(decodeOutBufferDev_);
+    dest.memType = MEMORY_DVPP;
 
     return ACLLITE_OK;
 }
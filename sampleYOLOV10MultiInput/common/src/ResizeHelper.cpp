@@ -91,10 +91,10 @@ AclLiteError ResizeHelper::InitResizeOutputDesc()
     }
 
     vpcOutBufferSize_ = YUV420SP_SIZE(resizeOutWidthStride, resizeOutHeightStride);
-    aclError aclRet = acldvppMalloc(&vpcOutBufferDev_, vpcOutBufferSize_);
-    if (aclRet != ACL_SUCCESS) {
+    vpcOutBufferDev_ = AclLiteMemPool::GetDvppPool().Alloc(vpcOutBufferSize_);
+    if (vpcOutBufferDev_ == nullptr) {
         ACLLITE_LOG_ERROR("Dvpp resize malloc output buffer failed, "
-                          "size %d, error %d", vpcOutBufferSize_, aclRet);
+                          "size %d", vpcOutBufferSize_);
         return ACLLITE_ERROR_MALLOC_DVPP;
     }
 
@@ -166,6 +166,7 @@ AclLiteError ResizeHelper::Process(ImageData& resizedImage, ImageData& srcImage)
     resizedImage.alignHeight = ALIGN_UP2(size_.height);
     resizedImage.size = vpcOutBufferSize_;
     resizedImage.data = SHARED_PTR_DVPP_BUF(vpcOutBufferDev_);
+    resizedImage.memType = MEMORY_DVPP;
 
     DestroyResizeResource();
 
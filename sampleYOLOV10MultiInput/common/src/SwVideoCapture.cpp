@@ -0,0 +1,503 @@
+/**
+ * ============================================================================
+ *
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   1 Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *   2 Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *   3 Neither the names of the copyright holders nor the names of the
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ============================================================================
+ */
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "AclLiteUtils.h"
+#include "AclLiteThreadSched.h"
+#include "SwVideoCapture.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kFrameQueueSize = 8; // the decoded frames waiting for read
+    const uint32_t kQueueWaitSliceMs = 100; // wake up to check the stop flag
+    const uint32_t kFrameReadTimeoutMs = 10000;
+    const uint32_t kFramePoolWaitMs = 1000;
+    const int kDefaultFps = 1;
+    // the statistics ids of the frame pool, after the vdec channels
+    atomic<int> gSwStatsId(VIDEO_CHANNEL_MAX);
+}
+
+SwVideoCapture::SwVideoCapture(const string& videoName, int32_t deviceId, aclrtContext context)
+    :isReleased_(false), isStop_(false), status_(DECODE_UNINIT), deviceId_(deviceId),
+    context_(context), runMode_(ACL_HOST), statsId_(gSwStatsId++), streamName_(videoName),
+    captureMode_(CAPTURE_MODE_QUEUE), skipNonRefFrame_(false), isRtsp_(IsRtspAddr(videoName)), threadNum_(0),
+    ffmpegDecoder_(nullptr), codec_(nullptr), codecCtx_(nullptr), pkt_(nullptr),
+    frame_(nullptr), swsCtx_(nullptr), decodedFrameNum_(0), overwrittenFrameNum_(0),
+    frameImageQueue_(kFrameQueueSize), latestFrame_(1)
+{
+    AclLiteMetrics& metrics = AclLiteMetrics::GetInstance();
+    string stream = AclLiteMetrics::Label("stream", videoName);
+    decodedFrameMetric_ = metrics.GetCounter("acllite_video_decoded_frames_total",
+        "Frames decoded by the video capture", stream + "," + AclLiteMetrics::Label("decoder", "sw"));
+    overwrittenFrameMetric_ = metrics.GetCounter("acllite_video_dropped_frames_total",
+        "Frames dropped by the video capture", stream + "," + AclLiteMetrics::Label("reason", "overwritten"));
+}
+
+SwVideoCapture::~SwVideoCapture()
+{
+    DestroyResource();
+}
+
+void SwVideoCapture::DestroyResource()
+{
+    if (isReleased_) return;
+    isStop_ = true;
+    if (ffmpegDecoder_ != nullptr) {
+        ffmpegDecoder_->StopDecode();
+    }
+    if (decodeThread_.joinable()) {
+        decodeThread_.join();
+    }
+    if (ffmpegDecoder_ != nullptr) {
+        delete ffmpegDecoder_;
+        ffmpegDecoder_ = nullptr;
+    }
+    if (codecCtx_ != nullptr) {
+        avcodec_free_context(&codecCtx_);
+    }
+    if (pkt_ != nullptr) {
+        av_packet_free(&pkt_);
+    }
+    if (frame_ != nullptr) {
+        av_frame_free(&frame_);
+    }
+    if (swsCtx_ != nullptr) {
+        sws_freeContext(swsCtx_);
+        swsCtx_ = nullptr;
+    }
+    // the deleter of the frame data returns the buffer to the frame pool
+    while (frameImageQueue_.Pop() != nullptr) {}
+    while (latestFrame_.Pop() != nullptr) {}
+    FramePoolStats stats;
+    AclLiteFramePool::GetInstance().GetChannelStats(statsId_, stats);
+    ACLLITE_LOG_INFO("Video %s sw decoded %lu frames, %lu overwritten in latest mode, "
+                     "frame pool: alloc %lu, malloc %lu, wait %lu times %lu us",
+                     streamName_.c_str(), decodedFrameNum_, overwrittenFrameNum_,
+                     stats.allocNum, stats.mallocNum, stats.waitNum, stats.waitTimeUs);
+    isReleased_ = true;
+}
+
+AclLiteError SwVideoCapture::InitResource()
+{
+    aclError aclRet;
+    // use current thread context default
+    if (context_ == nullptr) {
+        aclRet = aclrtGetCurrentContext(&context_);
+        if ((aclRet != ACL_SUCCESS) || (context_ == nullptr)) {
+            ACLLITE_LOG_ERROR("Get current acl context error:%d", aclRet);
+            return ACLLITE_ERROR_GET_ACL_CONTEXT;
+        }
+    }
+    aclRet = aclrtGetRunMode(&runMode_);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("acl get run mode failed");
+        return ACLLITE_ERROR_GET_RUM_MODE;
+    }
+
+    return ACLLITE_OK;
+}
+
+AclLiteError SwVideoCapture::Open()
+{
+    if (status_ == DECODE_ERROR)
+        return ACLLITE_ERROR_OPEN_VIDEO_UNREADY;
+    if (status_ != DECODE_UNINIT)
+        return ACLLITE_OK;
+
+    AclLiteError ret = InitResource();
+    if (ret != ACLLITE_OK) {
+        status_ = DECODE_ERROR;
+        ACLLITE_LOG_ERROR("Open %s failed for init resource error: %d",
+                          streamName_.c_str(), ret);
+        return ret;
+    }
+    ffmpegDecoder_ = new FFmpegDecoder(streamName_);
+    codec_ = avcodec_find_decoder((AVCodecID)ffmpegDecoder_->GetVideoType());
+    if ((codec_ == nullptr) || (ffmpegDecoder_->GetFrameWidth() <= 0) ||
+        (ffmpegDecoder_->GetFrameHeight() <= 0)) {
+        status_ = DECODE_ERROR;
+        ACLLITE_LOG_ERROR("Open %s failed, no decoder for video type %d, size %dx%d",
+                          streamName_.c_str(), ffmpegDecoder_->GetVideoType(),
+                          ffmpegDecoder_->GetFrameWidth(), ffmpegDecoder_->GetFrameHeight());
+        return ACLLITE_ERROR_FFMPEG_DECODER_INIT;
+    }
+
+    int fps = (ffmpegDecoder_->GetFps() > 0) ? ffmpegDecoder_->GetFps() : kDefaultFps;
+    framePacer_.Init(fps);
+    status_ = DECODE_READY;
+    ACLLITE_LOG_INFO("Video %s sw decode init ok, decoder %s", streamName_.c_str(), codec_->name);
+    return ACLLITE_OK;
+}
+
+AclLiteError SwVideoCapture::InitCodec()
+{
+    codecCtx_ = avcodec_alloc_context3(codec_);
+    pkt_ = av_packet_alloc();
+    frame_ = av_frame_alloc();
+    if ((codecCtx_ == nullptr) || (pkt_ == nullptr) || (frame_ == nullptr)) {
+        ACLLITE_LOG_ERROR("Alloc decoder context of %s failed", streamName_.c_str());
+        return ACLLITE_ERROR_FFMPEG_DECODER_INIT;
+    }
+    // the packets are annexb with the parameter sets inline, no extradata is needed.
+    // frame threading decodes several frames at once, 0 threads means one per core
+    codecCtx_->thread_count = threadNum_;
+    codecCtx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    if (skipNonRefFrame_) {
+        codecCtx_->skip_frame = AVDISCARD_NONREF;
+    }
+    int ret = avcodec_open2(codecCtx_, codec_, nullptr);
+    if (ret < 0) {
+        ACLLITE_LOG_ERROR("Open decoder %s of %s failed, error %d",
+                          codec_->name, streamName_.c_str(), ret);
+        return ACLLITE_ERROR_FFMPEG_DECODER_INIT;
+    }
+    ACLLITE_LOG_INFO("Video %s sw decoder %s uses %d threads",
+                     streamName_.c_str(), codec_->name, codecCtx_->thread_count);
+    return ACLLITE_OK;
+}
+
+void SwVideoCapture::DecodeThreadEntry(SwVideoCapture* thisPtr)
+{
+    SetThreadName("sw_dec" + to_string(thisPtr->statsId_));
+    aclError aclRet = aclrtSetCurrentContext(thisPtr->context_);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Set sw decoder context failed, errorno:%d", aclRet);
+        thisPtr->status_ = DECODE_ERROR;
+        thisPtr->PushEndOfStream();
+        return;
+    }
+    // the frame threads of libavcodec are not pinned with the input thread
+    if (RunOnAllCpus([thisPtr]() { return thisPtr->InitCodec(); }) != ACLLITE_OK) {
+        thisPtr->status_ = DECODE_ERROR;
+        thisPtr->PushEndOfStream();
+        return;
+    }
+
+    auto startTime = chrono::steady_clock::now();
+    thisPtr->ffmpegDecoder_->Decode(&SwVideoCapture::PacketCallback, (void*)thisPtr);
+    // flush the frames delayed by frame threading
+    if (!thisPtr->isStop_) {
+        (void)thisPtr->DecodePacket(nullptr);
+    }
+    int64_t costMs = chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now() - startTime).count();
+    double fps = (costMs > 0) ? (thisPtr->decodedFrameNum_ * 1000.0 / costMs) : 0;
+    ACLLITE_LOG_INFO("Video %s sw decode finished, %lu frames in %ld ms, %.1f fps",
+                     thisPtr->streamName_.c_str(), thisPtr->decodedFrameNum_, costMs, fps);
+    thisPtr->PushEndOfStream();
+}
+
+AclLiteError SwVideoCapture::PacketCallback(void* decoder, void* frameData, int frameSize)
+{
+    if ((frameData == nullptr) || (frameSize == 0)) {
+        ACLLITE_LOG_ERROR("Frame data is null");
+        return ACLLITE_ERROR_H26X_FRAME;
+    }
+    SwVideoCapture* thisPtr = (SwVideoCapture*)decoder;
+    // the packet data is owned by the demuxer, the decoder copies what it keeps
+    thisPtr->pkt_->data = (uint8_t*)frameData;
+    thisPtr->pkt_->size = frameSize;
+    AclLiteError ret = thisPtr->DecodePacket(thisPtr->pkt_);
+    thisPtr->pkt_->data = nullptr;
+    thisPtr->pkt_->size = 0;
+    // latest mode does not wait for the reader, a file is read at its frame rate
+    if ((thisPtr->captureMode_ == CAPTURE_MODE_LATEST) && !thisPtr->isRtsp_) {
+        thisPtr->framePacer_.Wait();
+    }
+    // a broken packet is skipped like vdec does, only stop stops the demux
+    return thisPtr->isStop_ ? ACLLITE_ERROR : ACLLITE_OK;
+}
+
+AclLiteError SwVideoCapture::DecodePacket(AVPacket* packet)
+{
+    int ret = avcodec_send_packet(codecCtx_, packet);
+    if ((ret < 0) && (ret != AVERROR_EOF)) {
+        ACLLITE_LOG_ERROR("Send packet to decoder of %s failed, error %d",
+                          streamName_.c_str(), ret);
+        return ACLLITE_ERROR_H26X_FRAME;
+    }
+    while (!isStop_) {
+        ret = avcodec_receive_frame(codecCtx_, frame_);
+        if ((ret == AVERROR(EAGAIN)) || (ret == AVERROR_EOF)) {
+            break;
+        }
+        if (ret < 0) {
+            ACLLITE_LOG_ERROR("Decode frame of %s failed, error %d", streamName_.c_str(), ret);
+            return ACLLITE_ERROR_H26X_FRAME;
+        }
+        AclLiteError outRet = OutputFrame(frame_);
+        av_frame_unref(frame_);
+        if (outRet != ACLLITE_OK) {
+            return outRet;
+        }
+    }
+
+    return ACLLITE_OK;
+}
+
+AclLiteError SwVideoCapture::OutputFrame(AVFrame* frame)
+{
+    uint32_t alignWidth = ALIGN_UP16(frame->width);
+    uint32_t alignHeight = ALIGN_UP2(frame->height);
+    void* buffer = nullptr;
+    AclLiteError ret = AclLiteFramePool::GetInstance().Alloc(statsId_, alignWidth, alignHeight,
+                                                             buffer, kFramePoolWaitMs);
+    // all frames are in the pipeline, wait for one like vdec does
+    while ((ret == ACLLITE_ERROR_FRAME_POOL_TIMEOUT) && !isStop_) {
+        ret = AclLiteFramePool::GetInstance().Alloc(statsId_, alignWidth, alignHeight,
+                                                    buffer, kFramePoolWaitMs);
+    }
+    if (ret != ACLLITE_OK) {
+        return ret;
+    }
+
+    shared_ptr<ImageData> image = make_shared<ImageData>();
+    image->format = PIXEL_FORMAT_YUV_SEMIPLANAR_420;
+    image->width = frame->width;
+    image->height = frame->height;
+    image->alignWidth = alignWidth;
+    image->alignHeight = alignHeight;
+    image->size = YUV420SP_SIZE(alignWidth, alignHeight);
+    image->data = SHARED_PTR_FRAME_BUF(buffer);
+    image->memType = MEMORY_DVPP;
+
+    if (runMode_ == ACL_DEVICE) {
+        // dvpp memory is accessible by cpu on the device, convert in place
+        ret = ConvertToNv12(frame, (uint8_t*)buffer, alignWidth, alignHeight);
+    } else {
+        hostFrame_.resize(image->size);
+        ret = ConvertToNv12(frame, hostFrame_.data(), alignWidth, alignHeight);
+        if (ret == ACLLITE_OK) {
+            aclError aclRet = aclrtMemcpy(buffer, image->size, hostFrame_.data(), image->size,
+                                          ACL_MEMCPY_HOST_TO_DEVICE);
+            if (aclRet != ACL_SUCCESS) {
+                ACLLITE_LOG_ERROR("Copy decoded frame to device failed, error %d", aclRet);
+                ret = ACLLITE_ERROR_COPY_DATA;
+            }
+        }
+    }
+    if (ret != ACLLITE_OK) {
+        return ret;
+    }
+    decodedFrameNum_++;
+    decodedFrameMetric_->Add();
+    return FrameEnQueue(image);
+}
+
+AclLiteError SwVideoCapture::ConvertToNv12(AVFrame* frame, uint8_t* dest,
+                                           uint32_t alignWidth, uint32_t alignHeight)
+{
+    swsCtx_ = sws_getCachedContext(swsCtx_, frame->width, frame->height,
+                                   (AVPixelFormat)frame->format,
+                                   frame->width, frame->height, AV_PIX_FMT_NV12,
+                                   SWS_POINT, nullptr, nullptr, nullptr);
+    if (swsCtx_ == nullptr) {
+        ACLLITE_LOG_ERROR("Can not convert pixel format %d of %s to nv12",
+                          frame->format, streamName_.c_str());
+        return ACLLITE_ERROR;
+    }
+    uint8_t* dstData[] = { dest, dest + alignWidth * alignHeight, nullptr, nullptr };
+    int dstStride[] = { (int)alignWidth, (int)alignWidth, 0, 0 };
+    sws_scale(swsCtx_, frame->data, frame->linesize, 0, frame->height, dstData, dstStride);
+    return ACLLITE_OK;
+}
+
+AclLiteError SwVideoCapture::FrameEnQueue(shared_ptr<ImageData> image)
+{
+    // latest mode never blocks the decoder, the newer frame replaces the unread one
+    if (captureMode_ == CAPTURE_MODE_LATEST) {
+        if (latestFrame_.ForcePush(image) != nullptr) {
+            overwrittenFrameNum_++;
+            overwrittenFrameMetric_->Add();
+        }
+        return ACLLITE_OK;
+    }
+    // the queue is short, the decoder waits for the reader
+    while (!frameImageQueue_.WaitPush(image, kQueueWaitSliceMs)) {
+        if (isStop_) {
+            return ACLLITE_ERROR_VDEC_QUEUE_FULL;
+        }
+    }
+    return ACLLITE_OK;
+}
+
+void SwVideoCapture::PushEndOfStream()
+{
+    // an image without data tells the reader there is no frame anymore, it waits for
+    // the reader instead of dropping the last decoded frames, after stop the reader
+    // does not wait for it
+    shared_ptr<ImageData> eos = make_shared<ImageData>();
+    eos->data = nullptr;
+    while (!OutputQueue().WaitPush(eos, kQueueWaitSliceMs)) {
+        if (isStop_) {
+            return;
+        }
+    }
+}
+
+ThreadSafeQueue<shared_ptr<ImageData>>& SwVideoCapture::OutputQueue()
+{
+    return (captureMode_ == CAPTURE_MODE_LATEST) ? latestFrame_ : frameImageQueue_;
+}
+
+bool SwVideoCapture::IsOpened()
+{
+    ACLLITE_LOG_INFO("Video %s sw decode status %d", streamName_.c_str(), (int)status_);
+    return (status_ == DECODE_READY) || (status_ == DECODE_START);
+}
+
+AclLiteError SwVideoCapture::Read(ImageData& image)
+{
+    if (status_ == DECODE_ERROR) {
+        ACLLITE_LOG_ERROR("Read failed for decode %s failed", streamName_.c_str());
+        return ACLLITE_ERROR_VIDEO_DECODER_STATUS;
+    }
+    if (status_ == DECODE_FINISHED) {
+        ACLLITE_LOG_INFO("No frame to read for decode %s finished", streamName_.c_str());
+        return ACLLITE_ERROR_DECODE_FINISH;
+    }
+    if (status_ == DECODE_READY) {
+        status_ = DECODE_START;
+        decodeThread_ = thread(DecodeThreadEntry, this);
+    }
+
+    shared_ptr<ImageData> frame = nullptr;
+    for (uint32_t waitMs = 0; (waitMs < kFrameReadTimeoutMs) && (frame == nullptr) && !isStop_;
+         waitMs += kQueueWaitSliceMs) {
+        frame = OutputQueue().WaitPop(kQueueWaitSliceMs);
+    }
+    if (frame == nullptr) {
+        ACLLITE_LOG_ERROR("No frame image to read abnormally");
+        return ACLLITE_ERROR_READ_EMPTY;
+    }
+    if (frame->data == nullptr) {
+        int expected = DECODE_START;
+        (void)status_.compare_exchange_strong(expected, DECODE_FINISHED);
+        ACLLITE_LOG_INFO("No frame to read anymore");
+        return (status_ == DECODE_ERROR) ? ACLLITE_ERROR_VIDEO_DECODER_STATUS :
+                                           ACLLITE_ERROR_DECODE_FINISH;
+    }
+
+    image.format = frame->format;
+    image.width = frame->width;
+    image.height = frame->height;
+    image.alignWidth = frame->alignWidth;
+    image.alignHeight = frame->alignHeight;
+    image.size = frame->size;
+    image.data = frame->data;
+    image.memType = frame->memType;
+    return ACLLITE_OK;
+}
+
+AclLiteError SwVideoCapture::Set(StreamProperty key, uint32_t value)
+{
+    if (ffmpegDecoder_ == nullptr) {
+        ACLLITE_LOG_ERROR("Set property %d of video %s failed, it is not opened",
+                          (int)key, streamName_.c_str());
+        return ACLLITE_ERROR_OPEN_VIDEO_UNREADY;
+    }
+    // the decoder is opened when decode starts, the properties are set before
+    if ((key != RTSP_TRANSPORT) && (status_ != DECODE_READY)) {
+        ACLLITE_LOG_ERROR("Set property %d of video %s failed, decode status %d",
+                          (int)key, streamName_.c_str(), (int)status_);
+        return ACLLITE_ERROR_VIDEO_DECODER_STATUS;
+    }
+    AclLiteError ret = ACLLITE_OK;
+    switch (key) {
+        case RTSP_TRANSPORT:
+            if (value == RTSP_TRANS_UDP) {
+                ffmpegDecoder_->SetTransport(RTSP_TRANSPORT_UDP);
+            } else if (value == RTSP_TRANS_TCP) {
+                ffmpegDecoder_->SetTransport(RTSP_TRANSPORT_TCP);
+            } else {
+                ret = ACLLITE_ERROR_INVALID_PROPERTY_VALUE;
+                ACLLITE_LOG_ERROR("Unsurport rtsp transport property value %u", value);
+            }
+            break;
+        case CAPTURE_MODE:
+            if ((value != CAPTURE_MODE_QUEUE) && (value != CAPTURE_MODE_LATEST)) {
+                ret = ACLLITE_ERROR_INVALID_PROPERTY_VALUE;
+                ACLLITE_LOG_ERROR("Unsurport capture mode property value %u", value);
+            } else {
+                captureMode_ = value;
+            }
+            break;
+        case SKIP_NON_REF_FRAME:
+            skipNonRefFrame_ = (value != 0);
+            break;
+        case DECODE_THREAD_NUM:
+            threadNum_ = value;
+            break;
+        default:
+            ret = ACLLITE_ERROR_UNSURPPORT_PROPERTY;
+            ACLLITE_LOG_ERROR("Unsurpport property %d to set for video %s",
+                              (int)key, streamName_.c_str());
+            break;
+    }
+
+    return ret;
+}
+
+uint32_t SwVideoCapture::Get(StreamProperty key)
+{
+    uint32_t value = 0;
+    if (ffmpegDecoder_ == nullptr) {
+        return value;
+    }
+    switch (key) {
+        case FRAME_WIDTH:
+            value = ffmpegDecoder_->GetFrameWidth();
+            break;
+        case FRAME_HEIGHT:
+            value = ffmpegDecoder_->GetFrameHeight();
+            break;
+        case VIDEO_FPS:
+            value = (ffmpegDecoder_->GetFps() > 0) ? ffmpegDecoder_->GetFps() : kDefaultFps;
+            break;
+        default:
+            ACLLITE_LOG_ERROR("Unsurpport property %d to get for video", key);
+            break;
+    }
+
+    return value;
+}
+
+AclLiteError SwVideoCapture::Close()
+{
+    DestroyResource();
+    return ACLLITE_OK;
+}
@@ -0,0 +1,304 @@
+/**
+ * ============================================================================
+ *
+ * Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   1 Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *   2 Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ *   3 Neither the names of the copyright holders nor the names of the
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * ============================================================================
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "AclLiteUtils.h"
+#include "AclLiteThreadSched.h"
+#include "SwVideoWriter.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+using namespace std;
+
+namespace {
+    const uint32_t kVencQueueSize = 256;
+    const uint32_t kEnqueueTimeoutMs = 30;
+    const uint32_t kDequeueTimeoutMs = 10;
+    const int kFrameRate = 25;
+    const int kGopSize = 25;
+    const char* kPreset = "superfast";
+
+    // the encoder releases the frame buffer, the image is kept until then
+    void FreeImageData(void* opaque, uint8_t* data)
+    {
+        delete static_cast<shared_ptr<uint8_t>*>(opaque);
+    }
+}
+
+SwVideoWriter::SwVideoWriter(VencConfig& vencConfig, aclrtContext context)
+    :isReleased_(false), status_(STATUS_VENC_INIT), context_(context),
+    vencInfo_(vencConfig), codecCtx_(nullptr), pkt_(nullptr), outFp_(nullptr),
+    pts_(0), frameImageQueue_(kVencQueueSize)
+{
+}
+
+SwVideoWriter::~SwVideoWriter()
+{
+    DestroyResource();
+}
+
+void SwVideoWriter::DestroyResource()
+{
+    if (isReleased_) return;
+    // the encode thread exits after the queued images are encoded
+    if (status_ == STATUS_VENC_WORK) {
+        status_ = STATUS_VENC_FINISH;
+    }
+    if (encodeThread_.joinable()) {
+        encodeThread_.join();
+    }
+    if (codecCtx_ != nullptr) {
+        // flush the delayed frames
+        if (avcodec_send_frame(codecCtx_, nullptr) == 0) {
+            (void)WritePackets();
+        }
+        avcodec_free_context(&codecCtx_);
+    }
+    if (pkt_ != nullptr) {
+        av_packet_free(&pkt_);
+    }
+    if (outFp_ != nullptr) {
+        fclose(outFp_);
+        outFp_ = nullptr;
+    }
+    status_ = STATUS_VENC_EXIT;
+    isReleased_ = true;
+}
+
+AclLiteError SwVideoWriter::InitEncoder()
+{
+    if ((vencInfo_.maxWidth == 0) || (vencInfo_.maxHeight == 0) ||
+        (vencInfo_.maxWidth % 2 != 0) || (vencInfo_.maxHeight % 2 != 0)) {
+        ACLLITE_LOG_ERROR("Invalid video size %ux%u, it must be even",
+                          vencInfo_.maxWidth, vencInfo_.maxHeight);
+        return ACLLITE_ERROR;
+    }
+    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
+    if (codec == nullptr) {
+        codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    }
+    if (codec == nullptr) {
+        ACLLITE_LOG_ERROR("Can not find h264 encoder");
+        return ACLLITE_ERROR;
+    }
+    codecCtx_ = avcodec_alloc_context3(codec);
+    if (codecCtx_ == nullptr) {
+        ACLLITE_LOG_ERROR("Alloc h264 encoder context failed");
+        return ACLLITE_ERROR_MALLOC;
+    }
+    codecCtx_->width = vencInfo_.maxWidth;
+    codecCtx_->height = vencInfo_.maxHeight;
+    codecCtx_->pix_fmt = (vencInfo_.format == PIXEL_FORMAT_YVU_SEMIPLANAR_420) ?
+                         AV_PIX_FMT_NV21 : AV_PIX_FMT_NV12;
+    codecCtx_->time_base = (AVRational){1, kFrameRate};
+    codecCtx_->framerate = (AVRational){kFrameRate, 1};
+    codecCtx_->gop_size = kGopSize;
+    codecCtx_->max_b_frames = 0;
+    codecCtx_->profile = (vencInfo_.enType == H264_BASELINE_LEVEL) ?
+                         FF_PROFILE_H264_BASELINE : FF_PROFILE_H264_MAIN;
+    if (codecCtx_->priv_data != nullptr) {
+        av_opt_set(codecCtx_->priv_data, "preset", kPreset, 0);
+    }
+    int ret = avcodec_open2(codecCtx_, codec, nullptr);
+    if (ret < 0) {
+        ACLLITE_LOG_ERROR("Open h264 encoder %s failed, error %d", codec->name, ret);
+        return ACLLITE_ERROR;
+    }
+    pkt_ = av_packet_alloc();
+    if (pkt_ == nullptr) {
+        ACLLITE_LOG_ERROR("Alloc encode packet failed");
+        return ACLLITE_ERROR_MALLOC;
+    }
+    outFp_ = fopen(vencInfo_.outFile.c_str(), "wb");
+    if (outFp_ == nullptr) {
+        ACLLITE_LOG_ERROR("Open output video %s failed", vencInfo_.outFile.c_str());
+        return ACLLITE_ERROR_OPEN_FILE;
+    }
+    ACLLITE_LOG_INFO("Video %s is encoded by %s, %ux%u", vencInfo_.outFile.c_str(),
+                     codec->name, vencInfo_.maxWidth, vencInfo_.maxHeight);
+    return ACLLITE_OK;
+}
+
+AclLiteError SwVideoWriter::Open()
+{
+    if (status_ != STATUS_VENC_INIT) {
+        return ACLLITE_ERROR_VENC_STATUS;
+    }
+    // the threads of libx264 are not pinned with the output thread
+    AclLiteError ret = RunOnAllCpus([this]() { return InitEncoder(); });
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Init h264 encoder failed");
+        status_ = STATUS_VENC_ERROR;
+        return ret;
+    }
+    status_ = STATUS_VENC_WORK;
+    encodeThread_ = thread(SwVideoWriter::EncodeThreadEntry, this);
+    return ACLLITE_OK;
+}
+
+void SwVideoWriter::EncodeThreadEntry(SwVideoWriter* thisPtr)
+{
+    SetThreadName("sw_enc");
+    while (true) {
+        // the images queued before finish are still encoded
+        int status = thisPtr->status_;
+        if ((status != STATUS_VENC_WORK) && (status != STATUS_VENC_FINISH)) {
+            break;
+        }
+        shared_ptr<ImageData> image = thisPtr->frameImageQueue_.WaitPop(kDequeueTimeoutMs);
+        if (image == nullptr) {
+            if (status == STATUS_VENC_FINISH) {
+                break;
+            }
+            continue;
+        }
+        AclLiteError ret = thisPtr->EncodeImage(image);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Encode image of video %s failed, error %d",
+                              thisPtr->vencInfo_.outFile.c_str(), ret);
+            thisPtr->status_ = STATUS_VENC_ERROR;
+            break;
+        }
+    }
+}
+
+AclLiteError SwVideoWriter::EncodeImage(shared_ptr<ImageData> image)
+{
+    uint32_t stride = (image->alignWidth > 0) ? image->alignWidth : image->width;
+    uint32_t rows = (image->alignHeight > 0) ? image->alignHeight : image->height;
+    AVFrame* frame = av_frame_alloc();
+    if (frame == nullptr) {
+        return ACLLITE_ERROR_MALLOC;
+    }
+    // wrap the image without copy, the last reference is released by the encoder
+    shared_ptr<uint8_t>* holder = new shared_ptr<uint8_t>(image->data);
+    frame->buf[0] = av_buffer_create(image->data.get(), image->size, FreeImageData, holder, 0);
+    if (frame->buf[0] == nullptr) {
+        delete holder;
+        av_frame_free(&frame);
+        return ACLLITE_ERROR_MALLOC;
+    }
+    frame->format = codecCtx_->pix_fmt;
+    frame->width = codecCtx_->width;
+    frame->height = codecCtx_->height;
+    frame->data[0] = image->data.get();
+    frame->data[1] = image->data.get() + stride * rows;
+    frame->linesize[0] = stride;
+    frame->linesize[1] = stride;
+    frame->pts = pts_++;
+    int ret = avcodec_send_frame(codecCtx_, frame);
+    av_frame_free(&frame);
+    if (ret < 0) {
+        ACLLITE_LOG_ERROR("Send frame to h264 encoder failed, error %d", ret);
+        return ACLLITE_ERROR_VENC_SEND_FRAME;
+    }
+    return WritePackets();
+}
+
+AclLiteError SwVideoWriter::WritePackets()
+{
+    while (true) {
+        int ret = avcodec_receive_packet(codecCtx_, pkt_);
+        if ((ret == AVERROR(EAGAIN)) || (ret == AVERROR_EOF)) {
+            return ACLLITE_OK;
+        }
+        if (ret < 0) {
+            ACLLITE_LOG_ERROR("Receive packet from h264 encoder failed, error %d", ret);
+            return ACLLITE_ERROR;
+        }
+        size_t pktSize = pkt_->size;
+        size_t size = fwrite(pkt_->data, 1, pktSize, outFp_);
+        av_packet_unref(pkt_);
+        if (size != pktSize) {
+            ACLLITE_LOG_ERROR("Write video %s failed", vencInfo_.outFile.c_str());
+            return ACLLITE_ERROR_WRITE_FILE;
+        }
+    }
+}
+
+bool SwVideoWriter::IsOpened()
+{
+    return (status_ == STATUS_VENC_INIT) || (status_ == STATUS_VENC_WORK);
+}
+
+// the image is queued and encoded by the encode thread
+AclLiteError SwVideoWriter::Read(ImageData& image)
+{
+    if (status_ != STATUS_VENC_WORK) {
+        ACLLITE_LOG_ERROR("The sw venc(status %d) is not working", (int)status_);
+        return ACLLITE_ERROR_VENC_STATUS;
+    }
+    uint32_t stride = (image.alignWidth > 0) ? image.alignWidth : image.width;
+    uint32_t rows = (image.alignHeight > 0) ? image.alignHeight : image.height;
+    if ((image.data == nullptr) || (image.width != vencInfo_.maxWidth) ||
+        (image.height != vencInfo_.maxHeight) || (YUV420SP_SIZE(stride, rows) > image.size)) {
+        ACLLITE_LOG_ERROR("Invalid image %ux%u, size %u for video %ux%u",
+                          image.width, image.height, image.size, vencInfo_.maxWidth, vencInfo_.maxHeight);
+        return ACLLITE_ERROR;
+    }
+    shared_ptr<ImageData> imagePtr = make_shared<ImageData>(image);
+    if (!frameImageQueue_.WaitPush(imagePtr, kEnqueueTimeoutMs)) {
+        ACLLITE_LOG_ERROR("Sw venc(%s) lost image for queue full", vencInfo_.outFile.c_str());
+        return ACLLITE_ERROR_VENC_QUEUE_FULL;
+    }
+    return ACLLITE_OK;
+}
+
+uint32_t SwVideoWriter::Get(StreamProperty key)
+{
+    uint32_t value = 0;
+    switch (key) {
+        case FRAME_WIDTH:
+            value = vencInfo_.maxWidth;
+            break;
+        case FRAME_HEIGHT:
+            value = vencInfo_.maxHeight;
+            break;
+        default:
+            ACLLITE_LOG_ERROR("Unsurpport property %d to get for video", key);
+            break;
+    }
+
+    return value;
+}
+
+AclLiteError SwVideoWriter::Close()
+{
+    DestroyResource();
+    return ACLLITE_OK;
+}
@@ -8,6 +8,7 @@
 * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 */
 #include "AclLiteUtils.h"
+#include "AclLiteThreadSched.h"
 #include "VdecHelper.h"
 
 using namespace std;
@@ -15,13 +16,14 @@ using namespace std;
 namespace {
     const uint32_t kFrameWidthMax = 4096;
     const uint32_t kFrameHeightMax = 4096;
+    const uint32_t kFrameWaitMs = 1000;
 }
 
 VdecHelper::VdecHelper(int channelId, uint32_t width, uint32_t height,
     int type, aclvdecCallback callback, uint32_t outFormat)
     :channelId_(channelId), format_(outFormat), enType_(type),
     frameWidth_(width), frameHeight_(height), callback_(callback),
-    isExit_(false), isReleased_(false)
+    isExit_(false), isReleased_(false), isStopped_(false)
 {
     alignWidth_ = ALIGN_UP16(frameWidth_);
     alignHeight_ = ALIGN_UP2(frameHeight_);
@@ -51,29 +53,7 @@ void VdecHelper::DestroyResource()
     }
 
     aclError ret;
-    if (inputStreamDesc_ != nullptr) {
-        void* inputBuf = acldvppGetStreamDescData(inputStreamDesc_);
-        if (inputBuf != nullptr) {
-            acldvppFree(inputBuf);
-        }
-        aclError ret = acldvppDestroyStreamDesc(inputStreamDesc_);
-        if (ret != ACL_SUCCESS) {
-            ACLLITE_LOG_ERROR("fail to destroy input stream desc");
-        }
-        inputStreamDesc_ = nullptr;
-    }
-
-    if (outputPicDesc_ != nullptr) {
-        void* outputBuf = acldvppGetPicDescData(outputPicDesc_);
-        if (outputBuf != nullptr) {
-            acldvppFree(outputBuf);
-        }
-        aclError ret = acldvppDestroyPicDesc(outputPicDesc_);
-        if (ret != ACL_SUCCESS) {
-            ACLLITE_LOG_ERROR("fail to destroy output pic desc");
-        }
-        outputPicDesc_ = nullptr;
-    }
+    DestroyUnsentDesc();
 
     if (vdecChannelDesc_ != nullptr) {
         ret = aclvdecDestroyChannel(vdecChannelDesc_);
@@ -103,6 +83,7 @@ void* VdecHelper::SubscribeReportThreadFunc(void *arg)
 
     // Notice: create context for this thread
     VdecHelper* vdec = (VdecHelper *)arg;
+    SetThreadName("vdec_cb" + std::to_string(vdec->channelId_));
     aclrtContext context = vdec->GetContext();
     aclError ret = aclrtSetCurrentContext(context);
     if (ret != ACL_SUCCESS) {
@@ -264,12 +245,21 @@ AclLiteError VdecHelper::CreateInputStreamDesc(shared_ptr<FrameData> frameData)
 
 AclLiteError VdecHelper::CreateOutputPicDesc(size_t size)
 {
-    // Malloc output device memory
-    aclError ret = acldvppMalloc(&outputPicBuf_, size);
-    if (ret != ACL_SUCCESS) {
-        ACLLITE_LOG_ERROR("Malloc vdec output buffer failed when create "
-                          "vdec output desc, errorno:%d", ret);
-        return ACLLITE_ERROR_MALLOC_DVPP;
+    // Get the output frame from the frame pool, it is returned after the frame is used.
+    // When all frames are in the pipeline, decoding waits here
+    AclLiteError atlRet = AclLiteFramePool::GetInstance().Alloc(channelId_, alignWidth_, alignHeight_,
+                                                                outputPicBuf_, kFrameWaitMs);
+    while ((atlRet == ACLLITE_ERROR_FRAME_POOL_TIMEOUT) && !isStopped_ && !isExit_) {
+        ACLLITE_LOG_WARNING("Vdec channel %d waits for a free frame more than %u ms",
+                            channelId_, kFrameWaitMs);
+        atlRet = AclLiteFramePool::GetInstance().Alloc(channelId_, alignWidth_, alignHeight_,
+                                                       outputPicBuf_, kFrameWaitMs);
+    }
+    if (atlRet != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Get vdec output frame failed when create "
+                          "vdec output desc, error %d", atlRet);
+        outputPicBuf_ = nullptr;
+        return atlRet;
     }
 
     outputPicDesc_ = acldvppCreatePicDesc();
@@ -278,7 +268,7 @@ AclLiteError VdecHelper::CreateOutputPicDesc(size_t size)
         return ACLLITE_ERROR_CREATE_PIC_DESC;
     }
 
-    ret = acldvppSetPicDescData(outputPicDesc_, outputPicBuf_);
+    aclError ret = acldvppSetPicDescData(outputPicDesc_, outputPicBuf_);
     if (ret != ACL_SUCCESS) {
         ACLLITE_LOG_ERROR("Set vdec output pic desc data failed, errorno:%d", ret);
         return ACLLITE_ERROR_SET_PIC_DESC_DATA;
@@ -324,8 +314,34 @@ AclLiteError VdecHelper::CreateOutputPicDesc(size_t size)
     return ACLLITE_OK;
 }
 
+void VdecHelper::DestroyUnsentDesc()
+{
+    // the input data is owned by the caller, it is released when Process fails
+    if (inputStreamDesc_ != nullptr) {
+        aclError ret = acldvppDestroyStreamDesc(inputStreamDesc_);
+        if (ret != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("fail to destroy input stream desc");
+        }
+        inputStreamDesc_ = nullptr;
+    }
+
+    if (outputPicDesc_ != nullptr) {
+        aclError ret = acldvppDestroyPicDesc(outputPicDesc_);
+        if (ret != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("fail to destroy output pic desc");
+        }
+        outputPicDesc_ = nullptr;
+    }
+    if (outputPicBuf_ != nullptr) {
+        AclLiteFramePool::GetInstance().Free(outputPicBuf_);
+        outputPicBuf_ = nullptr;
+    }
+}
+
 AclLiteError VdecHelper::Process(shared_ptr<FrameData> frameData, void* userData)
 {
+    // the desc left by a failed frame
+    DestroyUnsentDesc();
     // create input desc
     AclLiteError atlRet = CreateInputStreamDesc(frameData);
     if (atlRet != ACLLITE_OK) {
@@ -353,8 +369,14 @@ AclLiteError VdecHelper::Process(shared_ptr<FrameData> frameData, void* userData
                                     outputPicDesc_, nullptr, userData);
     if (ret != ACL_SUCCESS) {
         ACLLITE_LOG_ERROR("Send frame to vdec failed, errorno:%d", ret);
+        // the frame is not used by vdec, it counts to the high water mark until returned
+        DestroyUnsentDesc();
         return ACLLITE_ERROR_VDEC_SEND_FRAME;
     }
+    // the descs are destroyed by the vdec callback
+    inputStreamDesc_ = nullptr;
+    outputPicDesc_ = nullptr;
+    outputPicBuf_ = nullptr;
 
     return ACLLITE_OK;
 }
@@ -7,11 +7,14 @@
 * but WITHOUT ANY WARRANTY; without even the implied warranty of
 * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
 */
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <cerrno>
 #include <cstring>
+#include <unistd.h>
 
+#include "AclLiteThreadSched.h"
 #include "VencHelper.h"
 
 using namespace std;
@@ -23,13 +26,16 @@ namespace {
     uint32_t kImageEnQueueRetryTimes = 3;
     uint32_t kEnqueueWait = 10000;
     uint32_t kOutqueueWait = 10000;
-    uint32_t kAsyncWait = 10000;
+    uint32_t kVencInputSlotNum = 8;
+    uint32_t kSlotWaitMs = 1000;
+    uint32_t kEncodeFinishWaitMs = 1000;
+    uint32_t kEncodeFinishWaitTimes = 10;
     bool g_runFlag = true;
 }
 
 VencHelper::VencHelper(VencConfig &vencInfo)
-    :vencInfo_(vencInfo), status_(STATUS_VENC_INIT),
-    vencProc_(nullptr), frameImageQueue_(kVencQueueSize)
+    :vencInfo_(vencInfo), status_(STATUS_VENC_INIT), dvppImageNum_(0),
+    frameImageQueue_(kVencQueueSize)
 {
 }
 
@@ -54,15 +60,14 @@ AclLiteError VencHelper::Init()
 
     thread asyncVencTh = thread(VencHelper::AsyncVencThreadEntry, (void*)this);
     asyncVencTh.detach();
-    while (status_ == STATUS_VENC_INIT) {
-        usleep(kAsyncWait);
-    }
+    WaitStatusLeave(STATUS_VENC_INIT);
     return (status_ == STATUS_VENC_WORK)? ACLLITE_OK : ACLLITE_ERROR_VENC_STATUS;
 }
 
 void VencHelper::AsyncVencThreadEntry(void* arg)
 {
     VencHelper* thisPtr =  (VencHelper*)arg;
+    SetThreadName("venc");
     DvppVenc venc(thisPtr->vencInfo_);
 
     AclLiteError ret = venc.Init();
@@ -73,9 +78,17 @@ void VencHelper::AsyncVencThreadEntry(void* arg)
     }
 
     thisPtr->SetStatus(STATUS_VENC_WORK);
-    while (thisPtr->GetStatus() == STATUS_VENC_WORK) {
+    while (true) {
+        // the images queued before finish are still encoded
+        VencStatus status = thisPtr->GetStatus();
+        if ((status != STATUS_VENC_WORK) && (status != STATUS_VENC_FINISH)) {
+            break;
+        }
         shared_ptr<ImageData> image = thisPtr->GetEncodeImage();
         if (image == nullptr) {
+            if (status == STATUS_VENC_FINISH) {
+                break;
+            }
             usleep(kOutqueueWait);
             continue;
         }
@@ -89,6 +102,10 @@ void VencHelper::AsyncVencThreadEntry(void* arg)
     }
 
     venc.Finish();
+    if ((thisPtr->dvppImageNum_ > 0) && (venc.GetZeroCopyFrameNum() == 0)) {
+        ACLLITE_LOG_ERROR("Venc(%s) received %lu dvpp images, but none is encoded without copy",
+                          thisPtr->vencInfo_.outFile.c_str(), (uint64_t)thisPtr->dvppImageNum_);
+    }
     thisPtr->SetStatus(STATUS_VENC_EXIT);
 }
 
@@ -106,6 +123,11 @@ AclLiteError VencHelper::Process(ImageData& image)
     imagePtr->alignHeight = image.alignHeight;
     imagePtr->size = image.size;
     imagePtr->data = image.data;
+    // the dvpp image is sent to venc without copy
+    imagePtr->memType = image.memType;
+    if (image.memType == MEMORY_DVPP) {
+        dvppImageNum_++;
+    }
 
     for (uint32_t count = 0; count < kImageEnQueueRetryTimes; count++) {
         if (frameImageQueue_.Push(imagePtr)) {
@@ -124,14 +146,25 @@ shared_ptr<ImageData> VencHelper::GetEncodeImage()
     return image;
 }
 
+void VencHelper::WaitStatusLeave(VencStatus status)
+{
+    std::unique_lock<std::mutex> lock(statusMutex_);
+    statusCond_.wait(lock, [this, status]() { return status_ != status; });
+}
+
 void VencHelper::DestroyResource()
 {
-    vencProc_->Finish();
+    // the encode thread sends eos and exits after the queued images are encoded
+    if (status_ == STATUS_VENC_WORK) {
+        SetStatus(STATUS_VENC_FINISH);
+    }
+    WaitStatusLeave(STATUS_VENC_FINISH);
 }
 
 DvppVenc::DvppVenc(VencConfig& vencInfo)
     :vencInfo_(vencInfo), threadId_(0), vencChannelDesc_(nullptr), vencFrameConfig_(nullptr),
-    inputPicDesc_(nullptr), vencStream_(nullptr), outFp_(nullptr), isFinished_(false)
+    vencStream_(nullptr), freeSlots_(kVencInputSlotNum), inFlightNum_(0), maxInFlightNum_(0),
+    sendFrameNum_(0), zeroCopyFrameNum_(0), outFp_(nullptr), isFinished_(false)
 {
 }
 
@@ -143,12 +176,12 @@ DvppVenc::~DvppVenc()
 void DvppVenc::Callback(acldvppPicDesc *input,
                         acldvppStreamDesc *output, void *userData)
 {
+    DvppVenc* venc = (DvppVenc*)userData;
     void* data = acldvppGetStreamDescData(output);
     uint32_t retCode = acldvppGetStreamDescRetCode(output);
-    if (retCode == 0) {
+    if ((retCode == 0) && (venc != nullptr)) {
         // encode success, then process output pic
         uint32_t size = acldvppGetStreamDescSize(output);
-        DvppVenc* venc = (DvppVenc*)userData;
         AclLiteError ret = venc->SaveVencFile(data, size);
         if (ret != ACLLITE_OK) {
             ACLLITE_LOG_ERROR("Save venc file failed, error %d", ret);
@@ -158,11 +191,25 @@ void DvppVenc::Callback(acldvppPicDesc *input,
     } else {
         ACLLITE_LOG_ERROR("venc encode frame failed, ret = %u.", retCode);
     }
-    void* data_input = acldvppGetPicDescData(input);
-    if(data_input != nullptr){
-        acldvppFree(data_input);
+    // the input buffer and pic desc are reused by the next frame
+    if ((input != nullptr) && (venc != nullptr)) {
+        venc->ReleaseInputSlot(input);
+    }
+}
+
+void DvppVenc::ReleaseInputSlot(acldvppPicDesc* picDesc)
+{
+    for (size_t i = 0; i < inputSlots_.size(); i++) {
+        if (inputSlots_[i].picDesc == picDesc) {
+            inputSlots_[i].image = nullptr;
+            freeSlots_.Push(&inputSlots_[i]);
+            std::lock_guard<std::mutex> lock(inFlightMutex_);
+            inFlightNum_--;
+            inFlightCond_.notify_all();
+            return;
+        }
     }
-    acldvppDestroyPicDesc(input);
+    ACLLITE_LOG_ERROR("The encoded pic desc is not an input slot of venc");
 }
 
 AclLiteError DvppVenc::SaveVencFile(void* vencData, uint32_t size)
@@ -172,6 +219,16 @@ AclLiteError DvppVenc::SaveVencFile(void* vencData, uint32_t size)
     if (vencInfo_.runMode == ACL_HOST) {
         data = CopyDataToHost(vencData, size, vencInfo_.runMode, MEMORY_NORMAL);
     }
+    std::unique_lock<std::mutex> lock(fileMutex_);
+    if (outFp_ == nullptr) {
+        // the frame is encoded after the file is closed
+        lock.unlock();
+        ACLLITE_LOG_ERROR("Venc file %s is closed, drop %u bytes", vencInfo_.outFile.c_str(), size);
+        if (vencInfo_.runMode == ACL_HOST) {
+            delete[]((uint8_t *)data);
+        }
+        return ACLLITE_ERROR_WRITE_FILE;
+    }
     size_t ret = fwrite(data, 1, size, outFp_);
     if (ret != size) {
         ACLLITE_LOG_ERROR("Save venc file %s failed, need write %u bytes, "
@@ -181,6 +238,7 @@ AclLiteError DvppVenc::SaveVencFile(void* vencData, uint32_t size)
     } else {
         fflush(outFp_);
     }
+    lock.unlock();
 
     if (vencInfo_.runMode == ACL_HOST) {
         delete[]((uint8_t *)data);
@@ -203,6 +261,7 @@ AclLiteError DvppVenc::Init()
 
 void* DvppVenc::SubscribleThreadFunc(aclrtContext sharedContext)
 {
+    SetThreadName("venc_cb");
     if (sharedContext == nullptr) {
         ACLLITE_LOG_ERROR("sharedContext can not be nullptr");
         return ((void*)(-1));
@@ -262,6 +321,12 @@ AclLiteError DvppVenc::InitResource()
         return ret;
     }
 
+    ret = CreateInputSlots();
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Create venc input slots failed, error %d", ret);
+        return ret;
+    }
+
     ACLLITE_LOG_INFO("venc init resource success");
     return ACLLITE_OK;
 }
@@ -293,6 +358,55 @@ AclLiteError DvppVenc::CreateVencChannel()
     return ACLLITE_OK;
 }
 
+AclLiteError DvppVenc::CreateInputSlots()
+{
+    // the buffers are allocated once for the max image, a bigger image grows its slot buffer
+    uint32_t bufferSize = YUV420SP_SIZE(ALIGN_UP16(vencInfo_.maxWidth), ALIGN_UP2(vencInfo_.maxHeight));
+    inputSlots_.resize(kVencInputSlotNum);
+    for (size_t i = 0; i < inputSlots_.size(); i++) {
+        VencInputSlot& slot = inputSlots_[i];
+        slot.picDesc = acldvppCreatePicDesc();
+        if (slot.picDesc == nullptr) {
+            ACLLITE_LOG_ERROR("Create input pic desc failed");
+            return ACLLITE_ERROR_CREATE_PIC_DESC;
+        }
+        if (bufferSize > 0) {
+            aclError aclRet = acldvppMalloc(&slot.buffer, bufferSize);
+            if (aclRet != ACL_SUCCESS) {
+                ACLLITE_LOG_ERROR("Malloc venc input buffer failed, size %u, error %d", bufferSize, aclRet);
+                slot.buffer = nullptr;
+                return ACLLITE_ERROR_MALLOC_DVPP;
+            }
+            slot.bufferSize = bufferSize;
+        }
+        freeSlots_.Push(&slot);
+    }
+    return ACLLITE_OK;
+}
+
+void DvppVenc::DestroyInputSlots()
+{
+    // called after the channel is destroyed, the venc does not access the buffers any more
+    if (inFlightNum_ > 0) {
+        ACLLITE_LOG_WARNING("%u frames are not called back before the venc channel is destroyed",
+                            (uint32_t)inFlightNum_);
+    }
+    for (size_t i = 0; i < inputSlots_.size(); i++) {
+        VencInputSlot& slot = inputSlots_[i];
+        if (slot.picDesc != nullptr) {
+            (void)acldvppDestroyPicDesc(slot.picDesc);
+            slot.picDesc = nullptr;
+        }
+        if (slot.buffer != nullptr) {
+            (void)acldvppFree(slot.buffer);
+            slot.buffer = nullptr;
+            slot.bufferSize = 0;
+        }
+        slot.image = nullptr;
+    }
+    inputSlots_.clear();
+}
+
 AclLiteError DvppVenc::CreateFrameConfig()
 {
     vencFrameConfig_ = aclvencCreateFrameConfig();
@@ -330,61 +444,86 @@ AclLiteError DvppVenc::SetFrameConfig(uint8_t eos, uint8_t forceIFrame)
 
 AclLiteError DvppVenc::Process(ImageData& image)
 {
-    // create picture desc
-    AclLiteError ret = CreateInputPicDesc(image);
+    // all slots are in flight when the venc is slower than the input
+    VencInputSlot* slot = freeSlots_.WaitPop(kSlotWaitMs);
+    if (slot == nullptr) {
+        ACLLITE_LOG_ERROR("No free venc input slot, %u frames in flight", (uint32_t)inFlightNum_);
+        return ACLLITE_ERROR_VENC_QUEUE_FULL;
+    }
+
+    // fill picture desc
+    AclLiteError ret = CreateInputPicDesc(image, slot);
     if (ret != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("fail to create picture description");
+        slot->image = nullptr;
+        freeSlots_.Push(slot);
         return ret;
     }
 
     // send frame
     acldvppStreamDesc *outputStreamDesc = nullptr;
-
-    ret = aclvencSendFrame(vencChannelDesc_, inputPicDesc_,
+    uint32_t inFlightNum = ++inFlightNum_;
+    if (inFlightNum > maxInFlightNum_) {
+        maxInFlightNum_ = inFlightNum;
+    }
+    ret = aclvencSendFrame(vencChannelDesc_, slot->picDesc,
         static_cast<void *>(outputStreamDesc), vencFrameConfig_, (void *)this);
     if (ret != ACL_SUCCESS) {
         ACLLITE_LOG_ERROR("send venc frame failed, error %d", ret);
+        inFlightNum_--;
+        slot->image = nullptr;
+        freeSlots_.Push(slot);
         return ACLLITE_ERROR_VENC_SEND_FRAME;
     }
+    sendFrameNum_++;
 
     return ACLLITE_OK;
 }
 
-AclLiteError DvppVenc::CreateInputPicDesc(ImageData& image)
+AclLiteError DvppVenc::CreateInputPicDesc(ImageData& image, VencInputSlot* slot)
 {
-    inputPicDesc_ = acldvppCreatePicDesc();
-    if (inputPicDesc_ == nullptr) {
-        ACLLITE_LOG_ERROR("Create input pic desc failed");
-        return ACLLITE_ERROR_CREATE_PIC_DESC;
-    }
-    void *inBufferDev_ = nullptr;
-    uint32_t inBufferSize_ = image.size;
-    auto aclRet = acldvppMalloc(&inBufferDev_, inBufferSize_);
-    if (vencInfo_.runMode != ACL_DEVICE) {
-        aclRet = aclrtMemcpy(inBufferDev_, inBufferSize_, image.data.get(), image.size, ACL_MEMCPY_HOST_TO_DEVICE);
-        if (aclRet != ACL_SUCCESS) {
-            ACLLITE_LOG_ERROR("acl memcpy data to dev failed, image.size=%u, ret=%d.\n", image.size, aclRet);
-            (void)acldvppFree(inBufferDev_);
-            inBufferDev_ = nullptr;
-            return false;
-        }
+    if ((image.data == nullptr) || (image.size == 0)) {
+        ACLLITE_LOG_ERROR("The venc input image is empty");
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    void* picData = nullptr;
+    if (image.memType == MEMORY_DVPP) {
+        // dvpp reads the image directly, it is kept by the slot until encoded
+        slot->image = image.data;
+        picData = image.data.get();
+        zeroCopyFrameNum_++;
     } else {
-        // copy input to device memory
-        aclRet = aclrtMemcpy(inBufferDev_, inBufferSize_, image.data.get(), image.size, ACL_MEMCPY_DEVICE_TO_DEVICE);
+        if (image.size > slot->bufferSize) {
+            if (slot->buffer != nullptr) {
+                (void)acldvppFree(slot->buffer);
+                slot->buffer = nullptr;
+                slot->bufferSize = 0;
+            }
+            aclError aclRet = acldvppMalloc(&slot->buffer, image.size);
+            if (aclRet != ACL_SUCCESS) {
+                ACLLITE_LOG_ERROR("Malloc venc input buffer failed, size %u, error %d", image.size, aclRet);
+                slot->buffer = nullptr;
+                return ACLLITE_ERROR_MALLOC_DVPP;
+            }
+            slot->bufferSize = image.size;
+        }
+        aclrtMemcpyKind kind = (vencInfo_.runMode != ACL_DEVICE) ?
+                               ACL_MEMCPY_HOST_TO_DEVICE : ACL_MEMCPY_DEVICE_TO_DEVICE;
+        aclError aclRet = aclrtMemcpy(slot->buffer, slot->bufferSize, image.data.get(), image.size, kind);
         if (aclRet != ACL_SUCCESS) {
             ACLLITE_LOG_ERROR("acl memcpy data to dev failed, image.size=%u, ret=%d.\n", image.size, aclRet);
-            (void)acldvppFree(inBufferDev_);
-            inBufferDev_ = nullptr;
-            return false;
+            return ACLLITE_ERROR_COPY_DATA;
         }
+        picData = slot->buffer;
     }
-    acldvppSetPicDescFormat(inputPicDesc_, vencInfo_.format);
-    acldvppSetPicDescWidth(inputPicDesc_, image.width);
-    acldvppSetPicDescHeight(inputPicDesc_, image.height);
-    acldvppSetPicDescWidthStride(inputPicDesc_, ALIGN_UP16(image.width));
-    acldvppSetPicDescHeightStride(inputPicDesc_, ALIGN_UP2(image.height));
-    acldvppSetPicDescData(inputPicDesc_, inBufferDev_);
-    acldvppSetPicDescSize(inputPicDesc_, image.size);
+    acldvppSetPicDescFormat(slot->picDesc, vencInfo_.format);
+    acldvppSetPicDescWidth(slot->picDesc, image.width);
+    acldvppSetPicDescHeight(slot->picDesc, image.height);
+    // the decoded image keeps its own stride
+    acldvppSetPicDescWidthStride(slot->picDesc, (image.alignWidth > 0) ? image.alignWidth : ALIGN_UP16(image.width));
+    acldvppSetPicDescHeightStride(slot->picDesc, (image.alignHeight > 0) ? image.alignHeight : ALIGN_UP2(image.height));
+    acldvppSetPicDescData(slot->picDesc, picData);
+    acldvppSetPicDescSize(slot->picDesc, image.size);
 
     return ACLLITE_OK;
 }
@@ -395,23 +534,39 @@ void DvppVenc::Finish()
         return;
     }
 
-    // set frame config, eos frame
+    // set frame config and send eos frame, the file is closed even if eos fails
     AclLiteError ret = SetFrameConfig(1, 0);
     if (ret != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("Set eos frame config failed, error %d", ret);
-        return;
+    } else {
+        ret = aclvencSendFrame(vencChannelDesc_, nullptr,
+                               nullptr, vencFrameConfig_, nullptr);
+        if (ret != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("fail to send eos frame, ret=%u", ret);
+        }
     }
 
-    // send eos frame
-    ret = aclvencSendFrame(vencChannelDesc_, nullptr,
-                           nullptr, vencFrameConfig_, nullptr);
-    if (ret != ACL_SUCCESS) {
-        ACLLITE_LOG_ERROR("fail to send eos frame, ret=%u", ret);
-        return;
+    // the callbacks of the in-flight frames still write the file
+    std::unique_lock<std::mutex> inFlightLock(inFlightMutex_);
+    for (uint32_t i = 0; (i < kEncodeFinishWaitTimes) && (inFlightNum_ > 0); i++) {
+        if (inFlightCond_.wait_for(inFlightLock, std::chrono::milliseconds(kEncodeFinishWaitMs),
+                                   [this]() { return inFlightNum_ == 0; })) {
+            break;
+        }
+        ACLLITE_LOG_WARNING("Venc %s waits for %u frames in flight",
+                            vencInfo_.outFile.c_str(), (uint32_t)inFlightNum_);
     }
+    inFlightLock.unlock();
+    ACLLITE_LOG_INFO("Venc %s sent %lu frames, %lu without copy, max %u frames in flight, %u not finished",
+                     vencInfo_.outFile.c_str(), sendFrameNum_, zeroCopyFrameNum_,
+                     maxInFlightNum_, (uint32_t)inFlightNum_);
 
-    fclose(outFp_);
-    outFp_ = nullptr;
+    // a late callback finds the file closed and drops its stream
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    if (outFp_ != nullptr) {
+        fclose(outFp_);
+        outFp_ = nullptr;
+    }
     isFinished_ = true;
     ACLLITE_LOG_INFO("venc process success");
 
@@ -428,10 +583,7 @@ void DvppVenc::DestroyResource()
         vencChannelDesc_ = nullptr;
     }
 
-    if (inputPicDesc_ != nullptr) {
-        (void)acldvppDestroyPicDesc(inputPicDesc_);
-        inputPicDesc_ = nullptr;
-    }
+    DestroyInputSlots();
 
     if (vencStream_ != nullptr) {
         aclError ret = aclrtDestroyStream(vencStream_);
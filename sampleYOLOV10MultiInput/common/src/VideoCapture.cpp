@@ -42,6 +42,7 @@
 #include <cstring>
 #include <iostream>
 #include "AclLiteUtils.h"
+#include "AclLiteThreadSched.h"
 #include "VideoCapture.h"
 
 using namespace std;
@@ -50,14 +51,27 @@ using namespace std;
 namespace {
     const int64_t kUsec = 1000000;
     const uint32_t kDecodeFrameQueueSize = 256;
-    const int kDecodeQueueOpWait = 10000; // decode wait 10ms/frame
-    const int kFrameEnQueueRetryTimes = 1000; // max wait time for the frame to enter in queue
-    const int kQueueOpRetryTimes = 1000;
-    const int kOutputJamWait = 10000;
+    // blocking waits wake up at least every 100ms to check the stop flag
+    const uint32_t kQueueWaitSliceMs = 100;
+    const uint32_t kFrameEnQueueTimeoutMs = 10000; // max wait time for the frame to enter in queue
+    const uint32_t kFrameReadTimeoutMs = 10000; // max wait time for reading a frame
     const int kInvalidTpye = -1;
-    const int kWaitDecodeFinishInterval = 1000;
     const int kDefaultFps = 1;
     const int kReadSlow = 5;
+    const uint8_t kAnnexbStartCode = 0x01;
+    const uint8_t kH264NalTypeMask = 0x1f;
+    const uint8_t kH264NalRefIdcShift = 5;
+    const uint8_t kH264NalRefIdcMask = 0x03;
+    const uint8_t kH264NalTypeIdr = 5;
+    const uint8_t kH265NalTypeShift = 1;
+    const uint8_t kH265NalTypeMask = 0x3f;
+    const uint8_t kH265NalTypeVclMax = 31;
+    const uint8_t kH265NalTypeNonRefMax = 14; // TRAIL_N ~ RSV_VCL_N14
+    // the arena holds at least 2 raw frames, so no compressed packet is bigger than it
+    const uint32_t kBitstreamArenaSize = 8 * 1024 * 1024;
+    const uint32_t kBitstreamArenaFrameNum = 2;
+    const uint64_t kPoolPacketLogInterval = 100;
+    const uint32_t kArenaWaitMs = 1000;
     const uint32_t kVideoChannelMax310 = 32;
     const uint32_t kVideoChannelMax310P = 256;
 
@@ -307,11 +321,25 @@ VideoCapture::VideoCapture(const std::string& videoName, int32_t deviceId, aclrt
     channelId_(INVALID_CHANNEL_ID), streamFormat_(H264_MAIN_LEVEL),
     frameId_(0), finFrameCnt_(0), lastDecodeTime_(0),
     fpsInterval_(0), streamName_(videoName), ffmpegDecoder_(nullptr),
-    dvppVdec_(nullptr), frameImageQueue_(kDecodeFrameQueueSize)
+    dvppVdec_(nullptr), bitstreamArena_(nullptr), poolPacketNum_(0), frameImageQueue_(kDecodeFrameQueueSize),
+    latestFrame_(1), captureMode_(CAPTURE_MODE_QUEUE), skipNonRefFrame_(false),
+    skippedFrameNum_(0), overwrittenFrameNum_(0)
 {
     if (IsRtspAddr(videoName)) {
         streamType_ = STREAM_RTSP;
     }
+    AclLiteMetrics& metrics = AclLiteMetrics::GetInstance();
+    string stream = AclLiteMetrics::Label("stream", videoName);
+    decodedFrameMetric_ = metrics.GetCounter("acllite_video_decoded_frames_total",
+        "Frames decoded by the video capture", stream + "," + AclLiteMetrics::Label("decoder", "dvpp"));
+    string dropped = "acllite_video_dropped_frames_total";
+    string droppedHelp = "Frames dropped by the video capture";
+    skippedFrameMetric_ = metrics.GetCounter(dropped, droppedHelp,
+        stream + "," + AclLiteMetrics::Label("reason", "non_reference"));
+    overwrittenFrameMetric_ = metrics.GetCounter(dropped, droppedHelp,
+        stream + "," + AclLiteMetrics::Label("reason", "overwritten"));
+    lostFrameMetric_ = metrics.GetCounter(dropped, droppedHelp,
+        stream + "," + AclLiteMetrics::Label("reason", "queue_full"));
 }
 
 VideoCapture::~VideoCapture()
@@ -323,38 +351,64 @@ void VideoCapture::DestroyResource()
 {
     if (isReleased_) return;
     // 1. stop ffmpeg
-    isStop_ = true;
+    {
+        lock_guard<mutex> lock(statusMutex_);
+        isStop_ = true;
+    }
+    statusCond_.notify_all();
+    if (dvppVdec_ != nullptr) {
+        dvppVdec_->Stop();
+    }
 
     // 2. delete ffmpeg decoder
     if(ffmpegDecoder_ != nullptr){
         ffmpegDecoder_->StopDecode();
-        while ((status_ >= DECODE_START) && (status_ < DECODE_FFMPEG_FINISHED)) {
-            usleep(kWaitDecodeFinishInterval);
-        }
+        unique_lock<mutex> lock(statusMutex_);
+        statusCond_.wait(lock, [this] {
+            return (status_ < DECODE_START) || (status_ >= DECODE_FFMPEG_FINISHED);
+        });
+        lock.unlock();
         delete ffmpegDecoder_;
         ffmpegDecoder_ = nullptr;
     }
  
     // 3. release dvpp vdec
     if(dvppVdec_ != nullptr) {
-        while (!isFrameDecodeEnd_) {
-            usleep(kWaitDecodeFinishInterval);
-        }
+        WaitDecodeEnd();
         delete dvppVdec_;
         dvppVdec_ = nullptr;
     }
+    // vdec returns all packets before it is destroyed
+    if (bitstreamArena_ != nullptr) {
+        uint64_t writeNum = 0;
+        uint64_t waitNum = 0;
+        bitstreamArena_->GetStats(writeNum, waitNum);
+        ACLLITE_LOG_INFO("Video %s bitstream arena: %lu packets, waited %lu times, %lu packets in dvpp pool",
+                         streamName_.c_str(), writeNum, waitNum, poolPacketNum_);
+        delete bitstreamArena_;
+        bitstreamArena_ = nullptr;
+    }
     // 4. release image memory in decode output queue
     do {
-        shared_ptr<ImageData> frame = FrameImageOutQueue(true);
+        shared_ptr<ImageData> frame = frameImageQueue_.Pop();
+        if (frame == nullptr) {
+            frame = latestFrame_.Pop();
+        }
         if (frame == nullptr) {
             break;
         }
 
-        if (frame->data != nullptr) {
-            acldvppFree(frame->data.get());
-            frame->data = nullptr;
-        }
+        // the deleter of the frame data returns the buffer to the frame pool
+        frame->data = nullptr;
     } while (1);
+    ACLLITE_LOG_INFO("Video %s skipped %lu non-reference frames before vdec, "
+                     "%lu frames overwritten in latest mode",
+                     streamName_.c_str(), skippedFrameNum_, overwrittenFrameNum_);
+    FramePoolStats stats;
+    AclLiteFramePool::GetInstance().GetChannelStats(channelId_, stats);
+    ACLLITE_LOG_INFO("Video %s frame pool: alloc %lu, malloc %lu, wait %lu times %lu us, in use %u",
+                     streamName_.c_str(), stats.allocNum, stats.mallocNum,
+                     stats.waitNum, stats.waitTimeUs, stats.inUseNum);
     // 5. release channel id
     channelIdGenerator[deviceId_].ReleaseChannelId(channelId_);
 
@@ -405,9 +459,23 @@ AclLiteError VideoCapture::InitVdecDecoder()
     AclLiteError ret = dvppVdec_->Init();
     if (ret != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("Dvpp vdec init failed");
+        return ret;
     }
 
-    return ret;
+    // the packets are copied to the arena instead of a dvpp buffer malloced per packet
+    uint32_t arenaSize = max(kBitstreamArenaSize, kBitstreamArenaFrameNum *
+        YUV420SP_SIZE(ALIGN_UP16(ffmpegDecoder_->GetFrameWidth()), ALIGN_UP2(ffmpegDecoder_->GetFrameHeight())));
+    bitstreamArena_ = new BitstreamArena(arenaSize, runMode_);
+    ret = bitstreamArena_->Init();
+    if (ret != ACLLITE_OK) {
+        // decode with a dvpp pool buffer per packet as without the arena
+        ACLLITE_LOG_WARNING("Bitstream arena of %u bytes init failed, copy the packets to the dvpp pool",
+                            arenaSize);
+        delete bitstreamArena_;
+        bitstreamArena_ = nullptr;
+    }
+
+    return ACLLITE_OK;
 }
 
 AclLiteError VideoCapture::InitFFmpegDecoder()
@@ -433,6 +501,7 @@ AclLiteError VideoCapture::InitFFmpegDecoder()
     }
     // Cal the frame interval time(us)
     fpsInterval_ = kUsec / fps;
+    framePacer_.Init(fps);
 
     return ACLLITE_OK;
 }
@@ -521,6 +590,15 @@ void VideoCapture::DvppVdecCallback(acldvppStreamDesc *input,
 {
     VideoCapture* decoder = (VideoCapture*)userData;
     if (decoder->GetEnd()) {
+        // return the frame and the packet, nobody reads them
+        if (output != nullptr) {
+            AclLiteFramePool::GetInstance().Free(acldvppGetPicDescData(output));
+            (void)acldvppDestroyPicDesc(output);
+        }
+        if (input != nullptr) {
+            decoder->ReleasePacket(acldvppGetStreamDescData(input));
+            (void)acldvppDestroyStreamDesc(input);
+        }
         return;
     }
     // Get decoded image parameters
@@ -533,7 +611,8 @@ void VideoCapture::DvppVdecCallback(acldvppStreamDesc *input,
     image->size = acldvppGetPicDescSize(output);
 
     void* vdecOutBufferDev = acldvppGetPicDescData(output);
-    image->data = SHARED_PTR_DVPP_BUF(vdecOutBufferDev);
+    image->data = SHARED_PTR_FRAME_BUF(vdecOutBufferDev);
+    image->memType = MEMORY_DVPP;
 
     // Put the decoded image to queue for read
     decoder->ProcessDecodedImage(image);
@@ -544,10 +623,7 @@ void VideoCapture::DvppVdecCallback(acldvppStreamDesc *input,
     }
 
     if (input != nullptr) {
-        void* inputBuf = acldvppGetStreamDescData(input);
-        if (inputBuf != nullptr) {
-            acldvppFree(inputBuf);
-        }
+        decoder->ReleasePacket(acldvppGetStreamDescData(input));
         aclError ret = acldvppDestroyStreamDesc(input);
         if (ret != ACL_SUCCESS) {
             ACLLITE_LOG_ERROR("fail to destroy input stream desc");
@@ -557,30 +633,40 @@ void VideoCapture::DvppVdecCallback(acldvppStreamDesc *input,
 
 void VideoCapture::ProcessDecodedImage(shared_ptr<ImageData> frameData)
 {
-    finFrameCnt_++;
     if (YUV420SP_SIZE(frameData->alignWidth, frameData->alignHeight) != frameData->size) {
         ACLLITE_LOG_ERROR("Invalid decoded frame parameter, "
                           "width %d, height %d, size %d, buffer %p\n",
                           frameData->width, frameData->height,
                           frameData->size, frameData->data.get());
-        return;
+    } else {
+        decodedFrameMetric_->Add();
+        if (FrameImageEnQueue(frameData) != ACLLITE_OK) {
+            lostFrameMetric_->Add();
+        }
     }
-
-    FrameImageEnQueue(frameData);
-
-    if ((status_ == DECODE_FFMPEG_FINISHED) && (finFrameCnt_ >= frameId_)) {
-        ACLLITE_LOG_INFO("Last frame decoded by dvpp, change status to %d",
-                         DECODE_DVPP_FINISHED);
-        this->SetStatus(DECODE_DVPP_FINISHED);
+    // count the frame after it is queued, so eos always follows the last frame
+    {
+        lock_guard<mutex> lock(statusMutex_);
+        finFrameCnt_++;
     }
+    CheckDvppFinished();
 }
 
 AclLiteError VideoCapture::FrameImageEnQueue(shared_ptr<ImageData> frameData)
 {
-    for (int count = 0; count < kFrameEnQueueRetryTimes; count++) {
-        if (frameImageQueue_.Push(frameData))
+    // latest mode never blocks vdec, the newer frame replaces the unread one
+    if (captureMode_ == CAPTURE_MODE_LATEST) {
+        if (latestFrame_.ForcePush(frameData) != nullptr) {
+            overwrittenFrameNum_++;
+            overwrittenFrameMetric_->Add();
+        }
+        return ACLLITE_OK;
+    }
+    for (uint32_t waitMs = 0; waitMs < kFrameEnQueueTimeoutMs; waitMs += kQueueWaitSliceMs) {
+        if (frameImageQueue_.WaitPush(frameData, kQueueWaitSliceMs))
             return ACLLITE_OK;
-        usleep(kDecodeQueueOpWait);
+        if (isStop_)
+            break;
     }
     ACLLITE_LOG_ERROR("Video %s lost decoded image for queue full",
                       streamName_.c_str());
@@ -588,13 +674,72 @@ AclLiteError VideoCapture::FrameImageEnQueue(shared_ptr<ImageData> frameData)
     return ACLLITE_ERROR_VDEC_QUEUE_FULL;
 }
 
+void VideoCapture::PushEndOfStream()
+{
+    // an image without data tells the reader there is no frame anymore, it waits for
+    // the reader instead of dropping the last decoded frames, after stop the reader
+    // does not wait for it
+    shared_ptr<ImageData> eos = make_shared<ImageData>();
+    eos->data = nullptr;
+    while (!OutputQueue().WaitPush(eos, kQueueWaitSliceMs)) {
+        if (isStop_) {
+            return;
+        }
+    }
+}
+
+ThreadSafeQueue<shared_ptr<ImageData>>& VideoCapture::OutputQueue()
+{
+    return (captureMode_ == CAPTURE_MODE_LATEST) ? latestFrame_ : frameImageQueue_;
+}
+
+void VideoCapture::CheckDvppFinished()
+{
+    {
+        lock_guard<mutex> lock(statusMutex_);
+        if ((status_ != DECODE_FFMPEG_FINISHED) || (finFrameCnt_ < frameId_)) {
+            return;
+        }
+        status_ = DECODE_DVPP_FINISHED;
+    }
+    ACLLITE_LOG_INFO("Last frame decoded by dvpp, change status to %d",
+                     DECODE_DVPP_FINISHED);
+    PushEndOfStream();
+    statusCond_.notify_all();
+}
+
+void VideoCapture::SetStatus(DecodeStatus status)
+{
+    {
+        lock_guard<mutex> lock(statusMutex_);
+        status_ = status;
+    }
+    statusCond_.notify_all();
+}
+
+void VideoCapture::SetEnd()
+{
+    {
+        lock_guard<mutex> lock(statusMutex_);
+        isFrameDecodeEnd_ = true;
+    }
+    statusCond_.notify_all();
+}
+
+void VideoCapture::WaitDecodeEnd()
+{
+    unique_lock<mutex> lock(statusMutex_);
+    statusCond_.wait(lock, [this] { return isFrameDecodeEnd_; });
+}
+
 // start decoder
 void VideoCapture::StartFrameDecoder()
 {
     if (status_ == DECODE_READY) {
+        // change status before the thread runs, it may finish at once
+        SetStatus(DECODE_START);
         decodeThread_ = thread(FrameDecodeThreadFunction, (void*)this);
         decodeThread_.detach();
-        status_ = DECODE_START;
     }
 }
 
@@ -602,6 +747,7 @@ void VideoCapture::StartFrameDecoder()
 void VideoCapture::FrameDecodeThreadFunction(void* decoderSelf)
 {
     VideoCapture* thisPtr = (VideoCapture*)decoderSelf;
+    SetThreadName("demux" + to_string(thisPtr->channelId_));
 
     aclError aclRet = thisPtr->SetAclContext();
     if (aclRet != ACL_SUCCESS) {
@@ -613,6 +759,8 @@ void VideoCapture::FrameDecodeThreadFunction(void* decoderSelf)
     if (thisPtr->IsStop()) {
         thisPtr->SetEnd();
         thisPtr->SetStatus(DECODE_FINISHED);
+        // wake up the reader blocked on the empty queue
+        thisPtr->PushEndOfStream();
         return;
     }
     thisPtr->SetStatus(DECODE_FFMPEG_FINISHED);
@@ -622,9 +770,13 @@ void VideoCapture::FrameDecodeThreadFunction(void* decoderSelf)
     videoFrame->data = nullptr;
     videoFrame->size = 0;
     thisPtr->dvppVdec_->Process(videoFrame, decoderSelf);
-    while ((thisPtr->GetStatus() != DECODE_DVPP_FINISHED)) {
-        usleep(kWaitDecodeFinishInterval);
-    }
+    // the last frame may have been decoded before the status changed
+    thisPtr->CheckDvppFinished();
+    unique_lock<mutex> lock(thisPtr->statusMutex_);
+    thisPtr->statusCond_.wait(lock, [thisPtr] {
+        return (thisPtr->status_ == DECODE_DVPP_FINISHED) || thisPtr->isStop_;
+    });
+    lock.unlock();
     thisPtr->SetEnd();
 }
 
@@ -636,11 +788,18 @@ AclLiteError VideoCapture::FrameDecodeCallback(void* decoder, void* frameData, i
         return ACLLITE_ERROR_H26X_FRAME;
     }
 
-    // copy data to dvpp memory
     VideoCapture* videoDecoder = (VideoCapture*)decoder;
+    // nothing refers to a non-reference frame, drop it before it costs dvpp anything
+    if (videoDecoder->skipNonRefFrame_ &&
+        videoDecoder->IsNonRefFrame((uint8_t*)frameData, frameSize)) {
+        videoDecoder->skippedFrameNum_++;
+        videoDecoder->skippedFrameMetric_->Add();
+        return ACLLITE_OK;
+    }
 
-    void* buffer = CopyDataToDevice(frameData, frameSize,
-                                    videoDecoder->runMode_, MEMORY_DVPP);
+    // copy data to dvpp memory
+
+    void* buffer = videoDecoder->WritePacket(frameData, frameSize);
     if (buffer == nullptr) {
         ACLLITE_LOG_ERROR("Copy frame h26x data to dvpp failed");
         return ACLLITE_ERROR_COPY_DATA;
@@ -656,6 +815,7 @@ AclLiteError VideoCapture::FrameDecodeCallback(void* decoder, void* frameData, i
     if (ret != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("Dvpp vdec process %dth frame failed, error:%d",
                           videoDecoder->frameId_, ret);
+        videoDecoder->ReleasePacket(buffer);
         return ret;
     }
 
@@ -664,13 +824,54 @@ AclLiteError VideoCapture::FrameDecodeCallback(void* decoder, void* frameData, i
     return ACLLITE_OK;
 }
 
+void* VideoCapture::WritePacket(void* frameData, int frameSize)
+{
+    if ((bitstreamArena_ != nullptr) && ((uint32_t)frameSize <= bitstreamArena_->GetCapacity())) {
+        void* buffer = nullptr;
+        AclLiteError ret = bitstreamArena_->Write(frameData, frameSize, buffer, kArenaWaitMs);
+        // the arena is full when vdec is slower than demux, wait until vdec returns packets
+        while ((ret == ACLLITE_ERROR_BITSTREAM_ARENA_FULL) && !isStop_) {
+            ret = bitstreamArena_->Write(frameData, frameSize, buffer, kArenaWaitMs);
+        }
+        return (ret == ACLLITE_OK) ? buffer : nullptr;
+    }
+    // no arena, or the packet is bigger than 2 raw frames
+    poolPacketNum_++;
+    if ((bitstreamArena_ != nullptr) && (poolPacketNum_ % kPoolPacketLogInterval == 1)) {
+        ACLLITE_LOG_WARNING("Video %s packet of %d bytes exceeds the bitstream arena of %u bytes, "
+                            "%lu packets copied to the dvpp pool",
+                            streamName_.c_str(), frameSize, bitstreamArena_->GetCapacity(), poolPacketNum_);
+    }
+    return CopyDataToDevice(frameData, frameSize, runMode_, MEMORY_DVPP);
+}
+
+void VideoCapture::ReleasePacket(void* buffer)
+{
+    if (buffer == nullptr) {
+        return;
+    }
+    // the packets not in the arena are malloced by CopyDataToDevice from the dvpp pool
+    if ((bitstreamArena_ == nullptr) || !bitstreamArena_->Release(buffer)) {
+        AclLiteMemPool::GetDvppPool().Free(buffer);
+    }
+}
+
 void VideoCapture::SleeptoNextFrameTime()
 {
-    while (frameImageQueue_.Size() >  kReadSlow) {
+    // latest mode does not wait for the reader, the mailbox drops what the reader misses.
+    // a live stream arrives at its own rate, a file is read at its frame rate, as fast
+    // as demux runs nearly all of its frames would be overwritten
+    if (captureMode_ == CAPTURE_MODE_LATEST) {
+        if (streamType_ == STREAM_VIDEO) {
+            framePacer_.Wait();
+        }
+        return;
+    }
+    // hold demux while the reader is slow, woken up as soon as a frame is read
+    while (!frameImageQueue_.WaitSizeBelow(kReadSlow + 1, kQueueWaitSliceMs)) {
         if (isStop_) {
             return;
         }
-        usleep(kOutputJamWait);
     }
 
     if (streamType_ == STREAM_RTSP) {
@@ -726,25 +927,21 @@ AclLiteError VideoCapture::Read(ImageData& image)
     // start decode if status is ok
     if (status_ == DECODE_READY) {
         StartFrameDecoder();
-        usleep(kDecodeQueueOpWait);
-    }
-    // read frame from decode queue
-    bool noWait = (status_ == DECODE_DVPP_FINISHED);
-    shared_ptr<ImageData> frame = FrameImageOutQueue(noWait);
-    if (noWait && (frame == nullptr)) {
-        while (!isFrameDecodeEnd_) {
-            usleep(kWaitDecodeFinishInterval);
-        }
-        SetStatus(DECODE_FINISHED);
-        ACLLITE_LOG_INFO("No frame to read anymore");
-        return ACLLITE_ERROR_DECODE_FINISH;
     }
-
+    // read frame from decode queue, block until a frame or eos arrives
+    shared_ptr<ImageData> frame = FrameImageOutQueue();
     if (frame == nullptr) {
         ACLLITE_LOG_ERROR("No frame image to read abnormally");
         return ACLLITE_ERROR_READ_EMPTY;
     }
 
+    if (frame->data == nullptr) {
+        WaitDecodeEnd();
+        SetStatus(DECODE_FINISHED);
+        ACLLITE_LOG_INFO("No frame to read anymore");
+        return ACLLITE_ERROR_DECODE_FINISH;
+    }
+
     image.format = frame->format;
     image.width = frame->width;
     image.height = frame->height;
@@ -752,28 +949,23 @@ AclLiteError VideoCapture::Read(ImageData& image)
     image.alignHeight = frame->alignHeight;
     image.size = frame->size;
     image.data = frame->data;
+    image.memType = frame->memType;
 
     return ACLLITE_OK;
 }
 
-shared_ptr<ImageData> VideoCapture::FrameImageOutQueue(bool noWait)
+shared_ptr<ImageData> VideoCapture::FrameImageOutQueue()
 {
-    shared_ptr<ImageData> image = frameImageQueue_.Pop();
-
-    if (noWait || (image != nullptr)) return image;
-
-    for (int count = 0; count < kQueueOpRetryTimes - 1; count++) {
-        usleep(kDecodeQueueOpWait);
-
-        image = frameImageQueue_.Pop();
-        if (image != nullptr)
+    for (uint32_t waitMs = 0; waitMs < kFrameReadTimeoutMs; waitMs += kQueueWaitSliceMs) {
+        shared_ptr<ImageData> image = OutputQueue().WaitPop(kQueueWaitSliceMs);
+        if ((image != nullptr) || isStop_)
             return image;
     }
 
     return nullptr;
 }
 
-AclLiteError VideoCapture::Set(StreamProperty key, int value)
+AclLiteError VideoCapture::Set(StreamProperty key, uint32_t value)
 {
     AclLiteError ret = ACLLITE_OK;
     switch (key) {
@@ -783,6 +975,12 @@ AclLiteError VideoCapture::Set(StreamProperty key, int value)
         case RTSP_TRANSPORT:
             ret = SetRtspTransType(value);
             break;
+        case CAPTURE_MODE:
+            ret = SetCaptureMode(value);
+            break;
+        case SKIP_NON_REF_FRAME:
+            skipNonRefFrame_ = (value != 0);
+            break;
         default:
             ret = ACLLITE_ERROR_UNSURPPORT_PROPERTY;
             ACLLITE_LOG_ERROR("Unsurpport property %d to set for video %s",
@@ -810,6 +1008,52 @@ AclLiteError VideoCapture::SetRtspTransType(uint32_t transCode)
     return ret;
 }
 
+AclLiteError VideoCapture::SetCaptureMode(uint32_t mode)
+{
+    if ((mode != CAPTURE_MODE_QUEUE) && (mode != CAPTURE_MODE_LATEST)) {
+        ACLLITE_LOG_ERROR("Unsurport capture mode property value %u", mode);
+        return ACLLITE_ERROR_INVALID_PROPERTY_VALUE;
+    }
+    // the decoded frames are queued by mode, it can not change after decode starts
+    if (status_ != DECODE_READY) {
+        ACLLITE_LOG_ERROR("Set capture mode of video %s failed, decode status %d",
+                          streamName_.c_str(), status_);
+        return ACLLITE_ERROR_VIDEO_DECODER_STATUS;
+    }
+    captureMode_ = mode;
+    return ACLLITE_OK;
+}
+
+bool VideoCapture::IsNonRefFrame(const uint8_t* data, int size)
+{
+    int videoType = ffmpegDecoder_->GetVideoType();
+    // the packet is annexb after the mp4toannexb filter, check the first slice nal
+    for (int i = 0; i + 3 < size; i++) {
+        if ((data[i] != 0) || (data[i + 1] != 0) || (data[i + 2] != kAnnexbStartCode)) {
+            continue;
+        }
+        uint8_t header = data[i + 3];
+        if (videoType == AV_CODEC_ID_H264) {
+            uint8_t nalType = header & kH264NalTypeMask;
+            if ((nalType >= 1) && (nalType <= kH264NalTypeIdr)) {
+                return ((header >> kH264NalRefIdcShift) & kH264NalRefIdcMask) == 0;
+            }
+        } else if (videoType == AV_CODEC_ID_HEVC) {
+            // sub-layer non-reference pictures have even types up to 14,
+            // a stream with temporal sub-layers should not enable skipping
+            uint8_t nalType = (header >> kH265NalTypeShift) & kH265NalTypeMask;
+            if (nalType <= kH265NalTypeVclMax) {
+                return (nalType <= kH265NalTypeNonRefMax) && ((nalType % 2) == 0);
+            }
+        } else {
+            return false;
+        }
+        i += 3;
+    }
+
+    return false;
+}
+
 uint32_t VideoCapture::Get(StreamProperty key)
 {
     uint32_t value = 0;
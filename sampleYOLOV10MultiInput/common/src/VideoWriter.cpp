@@ -60,7 +60,9 @@ VideoWriter::~VideoWriter()
 void VideoWriter::DestroyResource()
 {
     if (isReleased_) return;
-    dvppVenc_->DestroyResource();
+    if (dvppVenc_ != nullptr) {
+        dvppVenc_->DestroyResource();
+    }
     // release dvpp venc
     delete dvppVenc_;
     dvppVenc_ = nullptr;
@@ -111,6 +113,9 @@ AclLiteError VideoWriter::Open()
 bool VideoWriter::IsOpened()
 {
     string outvideo = vencInfo_.outFile;
+    if (dvppVenc_ == nullptr) {
+        return false;
+    }
     status_ = dvppVenc_->GetStatus();
     ACLLITE_LOG_INFO("Video %s encode status %d", outvideo.c_str(), status_);
     return (status_ == STATUS_VENC_INIT) || (status_ == STATUS_VENC_WORK);
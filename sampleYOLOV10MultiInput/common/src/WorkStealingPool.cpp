@@ -0,0 +1,183 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File WorkStealingPool.cpp
+* Description: thread pool with one task deque per worker
+*/
+#include "WorkStealingPool.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool()
+    :isRunning_(false), pendingNum_(0), isStopping_(false)
+{
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Stop();
+}
+
+AclLiteError WorkStealingPool::Start(uint32_t workerNum, const string& name, const ThreadSchedConfig& sched)
+{
+    if (!workers_.empty()) {
+        ACLLITE_LOG_ERROR("The work stealing pool is started already");
+        return ACLLITE_ERROR_INITED_ALREADY;
+    }
+    if (workerNum == 0) {
+        workerNum = thread::hardware_concurrency();
+        workerNum = (workerNum == 0) ? 1 : workerNum;
+    }
+    for (uint32_t i = 0; i < workerNum; i++) {
+        workers_.push_back(unique_ptr<Worker>(new Worker));
+    }
+    name_ = name;
+    sched_ = sched;
+    isStopping_ = false;
+    isRunning_ = true;
+    for (uint32_t i = 0; i < workerNum; i++) {
+        workers_[i]->thread = thread(&WorkStealingPool::WorkerRun, this, i);
+    }
+    ACLLITE_LOG_INFO("Work stealing pool started with %u workers", workerNum);
+    return ACLLITE_OK;
+}
+
+AclLiteError WorkStealingPool::Submit(Task task, uint32_t hint)
+{
+    if (!isRunning_) {
+        return ACLLITE_ERROR_POOL_STOPPED;
+    }
+    Worker& worker = *workers_[hint % workers_.size()];
+    {
+        unique_lock<mutex> lock(worker.mutex);
+        worker.tasks.push_back(move(task));
+    }
+    pendingNum_++;
+    // the owner may be busy, any sleeping worker can steal the task
+    unique_lock<mutex> lock(idleMutex_);
+    taskAdded_.notify_one();
+    return ACLLITE_OK;
+}
+
+void WorkStealingPool::Stop()
+{
+    if (!isRunning_) {
+        return;
+    }
+    isRunning_ = false;
+    {
+        unique_lock<mutex> lock(idleMutex_);
+        isStopping_ = true;
+        taskAdded_.notify_all();
+    }
+    size_t droppedNum = 0;
+    for (uint32_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->thread.join();
+    }
+    for (uint32_t i = 0; i < workers_.size(); i++) {
+        // only the tasks submitted while the workers were exiting are left
+        droppedNum += workers_[i]->tasks.size();
+        workers_[i]->tasks.clear();
+        ACLLITE_LOG_INFO("Work stealing worker %u executed %lu tasks, stole %lu tasks in %lu steals",
+                         i, workers_[i]->executedNum.load(), workers_[i]->stolenNum.load(),
+                         workers_[i]->stealNum.load());
+    }
+    if (droppedNum > 0) {
+        ACLLITE_LOG_WARNING("Work stealing pool dropped %zu tasks at stop", droppedNum);
+    }
+}
+
+void WorkStealingPool::GetWorkerStats(uint32_t workerId, WorkStealingStats& stats) const
+{
+    if (workerId >= workers_.size()) {
+        return;
+    }
+    stats.executedNum = workers_[workerId]->executedNum;
+    stats.stolenNum = workers_[workerId]->stolenNum;
+    stats.stealNum = workers_[workerId]->stealNum;
+}
+
+bool WorkStealingPool::PopLocal(uint32_t workerId, Task& task)
+{
+    Worker& worker = *workers_[workerId];
+    unique_lock<mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = move(worker.tasks.front());
+    worker.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::Steal(uint32_t workerId, Task& task)
+{
+    vector<Task> stolen;
+    uint32_t workerNum = workers_.size();
+    for (uint32_t i = 1; i < workerNum; i++) {
+        Worker& victim = *workers_[(workerId + i) % workerNum];
+        unique_lock<mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) {
+            continue;
+        }
+        // take the newer half, the victim keeps running the older ones in order
+        size_t stealNum = (victim.tasks.size() + 1) / 2;
+        auto first = victim.tasks.end() - stealNum;
+        for (auto it = first; it != victim.tasks.end(); ++it) {
+            stolen.push_back(move(*it));
+        }
+        victim.tasks.erase(first, victim.tasks.end());
+        break;
+    }
+    if (stolen.empty()) {
+        return false;
+    }
+
+    Worker& worker = *workers_[workerId];
+    task = move(stolen[0]);
+    if (stolen.size() > 1) {
+        unique_lock<mutex> lock(worker.mutex);
+        // keep the stolen tasks ahead of the ones submitted to this worker meanwhile
+        for (size_t i = stolen.size() - 1; i > 0; i--) {
+            worker.tasks.push_front(move(stolen[i]));
+        }
+    }
+    worker.stolenNum += stolen.size();
+    worker.stealNum++;
+    return true;
+}
+
+void WorkStealingPool::WorkerRun(uint32_t workerId)
+{
+    Worker& worker = *workers_[workerId];
+    string name = name_ + to_string(workerId);
+    SetThreadName(name);
+    (void)ApplyThreadSched(name, sched_);
+    Task task;
+    while (true) {
+        if (PopLocal(workerId, task) || Steal(workerId, task)) {
+            pendingNum_--;
+            task(workerId);
+            task = nullptr;
+            worker.executedNum++;
+            continue;
+        }
+        unique_lock<mutex> lock(idleMutex_);
+        taskAdded_.wait(lock, [this]() { return (pendingNum_ > 0) || isStopping_; });
+        if (isStopping_ && (pendingNum_ == 0)) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,185 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File acl_dvpp.h
+* Description: cpu stand-in of the dvpp interfaces used by the sample
+*/
+#ifndef HOSTACL_ACL_DVPP_H
+#define HOSTACL_ACL_DVPP_H
+
+#include "acl/acl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct acldvppPicDesc acldvppPicDesc;
+typedef struct acldvppStreamDesc acldvppStreamDesc;
+typedef struct acldvppChannelDesc acldvppChannelDesc;
+typedef struct acldvppRoiConfig acldvppRoiConfig;
+typedef struct acldvppResizeConfig acldvppResizeConfig;
+typedef struct acldvppBorderConfig acldvppBorderConfig;
+typedef struct acldvppJpegeConfig acldvppJpegeConfig;
+typedef struct aclvdecChannelDesc aclvdecChannelDesc;
+typedef struct aclvdecFrameConfig aclvdecFrameConfig;
+typedef struct aclvencChannelDesc aclvencChannelDesc;
+typedef struct aclvencFrameConfig aclvencFrameConfig;
+
+typedef enum acldvppPixelFormat {
+    PIXEL_FORMAT_YUV_400 = 0,
+    PIXEL_FORMAT_YUV_SEMIPLANAR_420 = 1,
+    PIXEL_FORMAT_YVU_SEMIPLANAR_420 = 2,
+    PIXEL_FORMAT_RGB_888 = 12,
+    PIXEL_FORMAT_BGR_888 = 13,
+} acldvppPixelFormat;
+
+typedef enum acldvppStreamFormat {
+    H265_MAIN_LEVEL = 0,
+    H264_BASELINE_LEVEL = 1,
+    H264_MAIN_LEVEL = 2,
+    H264_HIGH_LEVEL = 3,
+} acldvppStreamFormat;
+
+typedef enum acldvppChannelMode {
+    DVPP_CHNMODE_VPC = 1,
+    DVPP_CHNMODE_JPEGD = 2,
+    DVPP_CHNMODE_JPEGE = 4,
+    DVPP_CHNMODE_PNGD = 8,
+} acldvppChannelMode;
+
+typedef enum acldvppBorderType {
+    BORDER_CONSTANT = 0,
+    BORDER_REPLICATE,
+    BORDER_REFLECT,
+    BORDER_REFLECT_101,
+} acldvppBorderType;
+
+typedef void (*aclvdecCallback)(acldvppStreamDesc* input, acldvppPicDesc* output, void* userData);
+typedef void (*aclvencCallback)(acldvppPicDesc* input, acldvppStreamDesc* output, void* userdata);
+
+aclError acldvppMalloc(void** devPtr, size_t size);
+aclError acldvppFree(void* devPtr);
+
+acldvppChannelDesc* acldvppCreateChannelDesc();
+aclError acldvppDestroyChannelDesc(acldvppChannelDesc* channelDesc);
+aclError acldvppSetChannelDescMode(acldvppChannelDesc* channelDesc, uint32_t mode);
+aclError acldvppCreateChannel(acldvppChannelDesc* channelDesc);
+aclError acldvppDestroyChannel(acldvppChannelDesc* channelDesc);
+
+acldvppPicDesc* acldvppCreatePicDesc();
+aclError acldvppDestroyPicDesc(acldvppPicDesc* picDesc);
+aclError acldvppSetPicDescData(acldvppPicDesc* picDesc, void* dataDev);
+aclError acldvppSetPicDescSize(acldvppPicDesc* picDesc, uint32_t size);
+aclError acldvppSetPicDescFormat(acldvppPicDesc* picDesc, acldvppPixelFormat format);
+aclError acldvppSetPicDescWidth(acldvppPicDesc* picDesc, uint32_t width);
+aclError acldvppSetPicDescHeight(acldvppPicDesc* picDesc, uint32_t height);
+aclError acldvppSetPicDescWidthStride(acldvppPicDesc* picDesc, uint32_t widthStride);
+aclError acldvppSetPicDescHeightStride(acldvppPicDesc* picDesc, uint32_t heightStride);
+void* acldvppGetPicDescData(const acldvppPicDesc* picDesc);
+uint32_t acldvppGetPicDescSize(const acldvppPicDesc* picDesc);
+acldvppPixelFormat acldvppGetPicDescFormat(const acldvppPicDesc* picDesc);
+uint32_t acldvppGetPicDescWidth(const acldvppPicDesc* picDesc);
+uint32_t acldvppGetPicDescHeight(const acldvppPicDesc* picDesc);
+uint32_t acldvppGetPicDescWidthStride(const acldvppPicDesc* picDesc);
+uint32_t acldvppGetPicDescHeightStride(const acldvppPicDesc* picDesc);
+
+acldvppRoiConfig* acldvppCreateRoiConfig(uint32_t left, uint32_t right, uint32_t top, uint32_t bottom);
+aclError acldvppDestroyRoiConfig(acldvppRoiConfig* roiConfig);
+acldvppResizeConfig* acldvppCreateResizeConfig();
+aclError acldvppDestroyResizeConfig(acldvppResizeConfig* resizeConfig);
+acldvppBorderConfig* acldvppCreateBorderConfig();
+aclError acldvppDestroyBorderConfig(acldvppBorderConfig* borderConfig);
+aclError acldvppSetBorderConfigValue(acldvppBorderConfig* borderConfig, uint32_t index, double value);
+aclError acldvppSetBorderConfigBorderType(acldvppBorderConfig* borderConfig, acldvppBorderType borderType);
+aclError acldvppSetBorderConfigTop(acldvppBorderConfig* borderConfig, uint32_t top);
+aclError acldvppSetBorderConfigBottom(acldvppBorderConfig* borderConfig, uint32_t bottom);
+aclError acldvppSetBorderConfigLeft(acldvppBorderConfig* borderConfig, uint32_t left);
+aclError acldvppSetBorderConfigRight(acldvppBorderConfig* borderConfig, uint32_t right);
+acldvppJpegeConfig* acldvppCreateJpegeConfig();
+aclError acldvppDestroyJpegeConfig(acldvppJpegeConfig* jpegeConfig);
+aclError acldvppSetJpegeConfigLevel(acldvppJpegeConfig* jpegeConfig, uint32_t level);
+
+aclError acldvppVpcResizeAsync(acldvppChannelDesc* channelDesc, acldvppPicDesc* inputDesc,
+                               acldvppPicDesc* outputDesc, acldvppResizeConfig* resizeConfig,
+                               aclrtStream stream);
+aclError acldvppVpcCropAndPasteAsync(acldvppChannelDesc* channelDesc, acldvppPicDesc* inputDesc,
+                                     acldvppPicDesc* outputDesc, acldvppRoiConfig* cropArea,
+                                     acldvppRoiConfig* pasteArea, aclrtStream stream);
+aclError acldvppVpcMakeBorderAsync(const acldvppChannelDesc* channelDesc, const acldvppPicDesc* inputDesc,
+                                   acldvppPicDesc* outputDesc, const acldvppBorderConfig* borderConfig,
+                                   aclrtStream stream);
+aclError acldvppJpegGetImageInfo(const void* data, uint32_t size, uint32_t* width, uint32_t* height,
+                                 int32_t* components);
+aclError acldvppPngGetImageInfo(const void* data, uint32_t dataSize, uint32_t* width, uint32_t* height,
+                                int32_t* components);
+aclError acldvppJpegPredictEncSize(const acldvppPicDesc* inputDesc, const acldvppJpegeConfig* config,
+                                   uint32_t* size);
+aclError acldvppJpegDecodeAsync(acldvppChannelDesc* channelDesc, const void* data, uint32_t size,
+                                acldvppPicDesc* outputDesc, aclrtStream stream);
+aclError acldvppJpegEncodeAsync(acldvppChannelDesc* channelDesc, acldvppPicDesc* inputDesc, const void* data,
+                                uint32_t* size, acldvppJpegeConfig* config, aclrtStream stream);
+aclError acldvppPngDecodeAsync(acldvppChannelDesc* channelDesc, const void* data, uint32_t size,
+                               acldvppPicDesc* outputDesc, aclrtStream stream);
+
+acldvppStreamDesc* acldvppCreateStreamDesc();
+aclError acldvppDestroyStreamDesc(acldvppStreamDesc* streamDesc);
+aclError acldvppSetStreamDescData(acldvppStreamDesc* streamDesc, void* dataDev);
+aclError acldvppSetStreamDescSize(acldvppStreamDesc* streamDesc, uint32_t size);
+aclError acldvppSetStreamDescFormat(acldvppStreamDesc* streamDesc, acldvppStreamFormat format);
+aclError acldvppSetStreamDescTimestamp(acldvppStreamDesc* streamDesc, uint64_t timestamp);
+aclError acldvppSetStreamDescEos(acldvppStreamDesc* streamDesc, uint8_t eos);
+void* acldvppGetStreamDescData(const acldvppStreamDesc* streamDesc);
+uint32_t acldvppGetStreamDescSize(const acldvppStreamDesc* streamDesc);
+uint32_t acldvppGetStreamDescRetCode(const acldvppStreamDesc* streamDesc);
+
+// vdec and venc are not simulated, the channels fail to create so that the
+// sample uses its software decoder and encoder
+aclvdecChannelDesc* aclvdecCreateChannelDesc();
+aclError aclvdecDestroyChannelDesc(aclvdecChannelDesc* channelDesc);
+aclError aclvdecSetChannelDescChannelId(aclvdecChannelDesc* channelDesc, uint32_t channelId);
+aclError aclvdecSetChannelDescThreadId(aclvdecChannelDesc* channelDesc, uint64_t threadId);
+aclError aclvdecSetChannelDescCallback(aclvdecChannelDesc* channelDesc, aclvdecCallback callback);
+aclError aclvdecSetChannelDescEnType(aclvdecChannelDesc* channelDesc, acldvppStreamFormat enType);
+aclError aclvdecSetChannelDescOutPicFormat(aclvdecChannelDesc* channelDesc, acldvppPixelFormat outPicFormat);
+aclError aclvdecCreateChannel(aclvdecChannelDesc* channelDesc);
+aclError aclvdecDestroyChannel(aclvdecChannelDesc* channelDesc);
+aclError aclvdecSendFrame(aclvdecChannelDesc* channelDesc, acldvppStreamDesc* input, acldvppPicDesc* output,
+                          aclvdecFrameConfig* config, void* userData);
+
+aclvencChannelDesc* aclvencCreateChannelDesc();
+aclError aclvencDestroyChannelDesc(aclvencChannelDesc* channelDesc);
+aclError aclvencSetChannelDescThreadId(aclvencChannelDesc* channelDesc, uint64_t threadId);
+aclError aclvencSetChannelDescCallback(aclvencChannelDesc* channelDesc, aclvencCallback callback);
+aclError aclvencSetChannelDescEnType(aclvencChannelDesc* channelDesc, acldvppStreamFormat enType);
+aclError aclvencSetChannelDescPicFormat(aclvencChannelDesc* channelDesc, acldvppPixelFormat picFormat);
+aclError aclvencSetChannelDescPicWidth(aclvencChannelDesc* channelDesc, uint32_t picWidth);
+aclError aclvencSetChannelDescPicHeight(aclvencChannelDesc* channelDesc, uint32_t picHeight);
+aclError aclvencSetChannelDescKeyFrameInterval(aclvencChannelDesc* channelDesc, uint32_t keyFrameInterval);
+aclError aclvencSetChannelDescMaxBitRate(aclvencChannelDesc* channelDesc, uint32_t maxBitRate);
+aclError aclvencSetChannelDescRcMode(aclvencChannelDesc* channelDesc, uint32_t rcMode);
+aclError aclvencCreateChannel(aclvencChannelDesc* channelDesc);
+aclError aclvencDestroyChannel(aclvencChannelDesc* channelDesc);
+aclvencFrameConfig* aclvencCreateFrameConfig();
+aclError aclvencDestroyFrameConfig(aclvencFrameConfig* vencFrameConfig);
+aclError aclvencSetFrameConfigForceIFrame(aclvencFrameConfig* config, uint8_t forceIFrame);
+aclError aclvencSetFrameConfigEos(aclvencFrameConfig* config, uint8_t eos);
+aclError aclvencSendFrame(aclvencChannelDesc* channelDesc, acldvppPicDesc* input, void* reserve,
+                          aclvencFrameConfig* config, void* userdata);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
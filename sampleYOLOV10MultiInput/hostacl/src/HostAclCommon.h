@@ -0,0 +1,57 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File HostAclCommon.h
+* Description: internal helpers shared by the cpu stand-in of acl
+*/
+#ifndef HOSTACL_COMMON_H
+#define HOSTACL_COMMON_H
+
+#include <cstdint>
+#include <functional>
+#include "acl/acl.h"
+
+namespace hostacl {
+/**
+ * @brief Run a task on the stream in submission order, the task runs
+ *        inline when stream is nullptr like the default stream of acl
+ * @param [in] stream: the stream created by aclrtCreateStream
+ * @param [in] task: the work to do
+ * @return ACL_SUCCESS or the error code
+ */
+aclError Submit(aclrtStream stream, const std::function<void()>& task);
+
+/**
+ * @brief Get the device of the current context of the calling thread
+ * @return the device id, 0 when no context is set
+ */
+int32_t CurrentDeviceId();
+
+/**
+ * @brief Read a positive integer from the environment
+ * @param [in] name: the environment variable name
+ * @param [in] defaultValue: the value when the variable is absent or invalid
+ * @return the value
+ */
+uint32_t EnvUint(const char* name, uint32_t defaultValue);
+
+/**
+ * @brief Sleep the calling thread
+ * @param [in] us: microseconds to sleep, 0 returns at once
+ */
+void SleepUs(uint64_t us);
+}
+
+#endif
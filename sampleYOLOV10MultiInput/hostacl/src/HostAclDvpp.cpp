@@ -0,0 +1,752 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File HostAclDvpp.cpp
+* Description: cpu stand-in of the dvpp interfaces, vpc and image codecs run
+*              on opencv, the video codecs are not supported
+*/
+#include <cstring>
+#include <vector>
+#include "opencv2/opencv.hpp"
+#include "HostAclCommon.h"
+#include "acl/ops/acl_dvpp.h"
+
+using namespace std;
+
+struct acldvppPicDesc {
+    void* data;
+    uint32_t size;
+    acldvppPixelFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t widthStride;
+    uint32_t heightStride;
+};
+
+struct acldvppStreamDesc {
+    void* data;
+    uint32_t size;
+    acldvppStreamFormat format;
+    uint64_t timestamp;
+    uint8_t eos;
+};
+
+struct acldvppChannelDesc {
+    uint32_t mode;
+};
+
+struct acldvppRoiConfig {
+    uint32_t left;
+    uint32_t right;
+    uint32_t top;
+    uint32_t bottom;
+};
+
+struct acldvppResizeConfig {
+    uint32_t interpolation;
+};
+
+struct acldvppBorderConfig {
+    double value[4];
+    acldvppBorderType type;
+    uint32_t top;
+    uint32_t bottom;
+    uint32_t left;
+    uint32_t right;
+};
+
+struct acldvppJpegeConfig {
+    uint32_t level;
+};
+
+struct aclvdecChannelDesc {
+    uint32_t channelId;
+};
+
+struct aclvdecFrameConfig {
+    uint32_t reserved;
+};
+
+struct aclvencChannelDesc {
+    uint32_t reserved;
+};
+
+struct aclvencFrameConfig {
+    uint8_t forceIFrame;
+    uint8_t eos;
+};
+
+namespace {
+    const uint32_t kJpegHeaderReserve = 8192;
+    const uint32_t kPngHeaderSize = 24;
+    const uint8_t kPngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+    bool IsYuv420sp(acldvppPixelFormat format)
+    {
+        return (format == PIXEL_FORMAT_YUV_SEMIPLANAR_420) || (format == PIXEL_FORMAT_YVU_SEMIPLANAR_420);
+    }
+
+    bool IsPicValid(const acldvppPicDesc* pic)
+    {
+        return (pic != nullptr) && (pic->data != nullptr) && (pic->width > 0) && (pic->height > 0) &&
+            (pic->widthStride >= pic->width) && (pic->heightStride >= pic->height);
+    }
+
+    cv::Mat YPlane(const acldvppPicDesc& pic)
+    {
+        return cv::Mat(pic.height, pic.width, CV_8UC1, pic.data, pic.widthStride);
+    }
+
+    cv::Mat UvPlane(const acldvppPicDesc& pic)
+    {
+        uint8_t* uv = static_cast<uint8_t*>(pic.data) + static_cast<size_t>(pic.widthStride) * pic.heightStride;
+        return cv::Mat(pic.height / 2, pic.width / 2, CV_8UC2, uv, pic.widthStride);
+    }
+
+    void LogAsyncError(const char* func, aclError ret)
+    {
+        if (ret != ACL_SUCCESS) {
+            aclAppLog(ACL_ERROR, func, __FILE__, __LINE__, "dvpp task failed, error %d", ret);
+        }
+    }
+
+    /**
+     * Resize rect of the semi planar input into rect of the semi planar output,
+     * the rects are even aligned by the callers like the vpc hardware requires
+     */
+    void ResizeYuv420sp(const acldvppPicDesc& input, const cv::Rect& crop,
+                        const acldvppPicDesc& output, const cv::Rect& paste)
+    {
+        cv::Mat dstY = YPlane(output)(paste);
+        cv::resize(YPlane(input)(crop), dstY, dstY.size(), 0, 0, cv::INTER_LINEAR);
+        cv::Rect cropUv(crop.x / 2, crop.y / 2, crop.width / 2, crop.height / 2);
+        cv::Rect pasteUv(paste.x / 2, paste.y / 2, paste.width / 2, paste.height / 2);
+        if ((cropUv.area() == 0) || (pasteUv.area() == 0)) {
+            return;
+        }
+        cv::Mat dstUv = UvPlane(output)(pasteUv);
+        cv::resize(UvPlane(input)(cropUv), dstUv, dstUv.size(), 0, 0, cv::INTER_LINEAR);
+    }
+
+    void I420ToYuv420sp(const cv::Mat& i420, uint32_t width, uint32_t height, const acldvppPicDesc& output)
+    {
+        const uint8_t* y = i420.data;
+        const uint8_t* u = y + static_cast<size_t>(width) * height;
+        const uint8_t* v = u + static_cast<size_t>(width / 2) * (height / 2);
+        if (output.format == PIXEL_FORMAT_YVU_SEMIPLANAR_420) {
+            swap(u, v);
+        }
+        uint8_t* dstY = static_cast<uint8_t*>(output.data);
+        uint8_t* dstUv = dstY + static_cast<size_t>(output.widthStride) * output.heightStride;
+        for (uint32_t row = 0; row < height; row++) {
+            memcpy(dstY + static_cast<size_t>(row) * output.widthStride, y + static_cast<size_t>(row) * width, width);
+        }
+        for (uint32_t row = 0; row < height / 2; row++) {
+            uint8_t* dst = dstUv + static_cast<size_t>(row) * output.widthStride;
+            const uint8_t* srcU = u + static_cast<size_t>(row) * (width / 2);
+            const uint8_t* srcV = v + static_cast<size_t>(row) * (width / 2);
+            for (uint32_t col = 0; col < width / 2; col++) {
+                dst[2 * col] = srcU[col];
+                dst[2 * col + 1] = srcV[col];
+            }
+        }
+    }
+
+    aclError JpegDecode(const vector<uint8_t>& jpeg, const acldvppPicDesc& output)
+    {
+        cv::Mat bgr = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+        if (bgr.empty()) {
+            return ACL_ERROR_INVALID_FILE;
+        }
+        // the output is even aligned, replicate the last row and column
+        uint32_t width = (bgr.cols + 1) & ~1u;
+        uint32_t height = (bgr.rows + 1) & ~1u;
+        if ((width > output.widthStride) || (height > output.heightStride)) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        if ((width != static_cast<uint32_t>(bgr.cols)) || (height != static_cast<uint32_t>(bgr.rows))) {
+            cv::copyMakeBorder(bgr, bgr, 0, height - bgr.rows, 0, width - bgr.cols, cv::BORDER_REPLICATE);
+        }
+        cv::Mat i420;
+        cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+        I420ToYuv420sp(i420, width, height, output);
+        return ACL_SUCCESS;
+    }
+
+    aclError PngDecode(const vector<uint8_t>& png, const acldvppPicDesc& output)
+    {
+        cv::Mat image = cv::imdecode(png, cv::IMREAD_COLOR);
+        if (image.empty()) {
+            return ACL_ERROR_INVALID_FILE;
+        }
+        // the width stride of rgb pictures is in bytes
+        uint32_t rowSize = image.cols * 3;
+        if ((rowSize > output.widthStride) || (static_cast<uint32_t>(image.rows) > output.heightStride)) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        if (output.format == PIXEL_FORMAT_RGB_888) {
+            cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+        }
+        uint8_t* dst = static_cast<uint8_t*>(output.data);
+        for (int row = 0; row < image.rows; row++) {
+            memcpy(dst + static_cast<size_t>(row) * output.widthStride, image.ptr(row), rowSize);
+        }
+        return ACL_SUCCESS;
+    }
+
+    aclError JpegEncode(const acldvppPicDesc& input, uint8_t* data, uint32_t* size, uint32_t level)
+    {
+        // pack the strided planes into a contiguous nv12/nv21 image for opencv
+        uint32_t width = input.width & ~1u;
+        uint32_t height = input.height & ~1u;
+        cv::Mat yuv(height * 3 / 2, width, CV_8UC1);
+        const uint8_t* src = static_cast<const uint8_t*>(input.data);
+        const uint8_t* srcUv = src + static_cast<size_t>(input.widthStride) * input.heightStride;
+        for (uint32_t row = 0; row < height; row++) {
+            memcpy(yuv.ptr(row), src + static_cast<size_t>(row) * input.widthStride, width);
+        }
+        for (uint32_t row = 0; row < height / 2; row++) {
+            memcpy(yuv.ptr(height + row), srcUv + static_cast<size_t>(row) * input.widthStride, width);
+        }
+        cv::Mat bgr;
+        cv::cvtColor(yuv, bgr, (input.format == PIXEL_FORMAT_YVU_SEMIPLANAR_420) ?
+                     cv::COLOR_YUV2BGR_NV21 : cv::COLOR_YUV2BGR_NV12);
+        vector<uint8_t> jpeg;
+        vector<int> params = { cv::IMWRITE_JPEG_QUALITY, static_cast<int>((level == 0) ? 1 : level) };
+        if (!cv::imencode(".jpg", bgr, jpeg, params)) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        if (jpeg.size() > *size) {
+            return ACL_ERROR_BAD_ALLOC;
+        }
+        memcpy(data, jpeg.data(), jpeg.size());
+        *size = static_cast<uint32_t>(jpeg.size());
+        return ACL_SUCCESS;
+    }
+
+    int ToCvBorder(acldvppBorderType type)
+    {
+        switch (type) {
+            case BORDER_REPLICATE:
+                return cv::BORDER_REPLICATE;
+            case BORDER_REFLECT:
+                return cv::BORDER_REFLECT;
+            case BORDER_REFLECT_101:
+                return cv::BORDER_REFLECT_101;
+            default:
+                return cv::BORDER_CONSTANT;
+        }
+    }
+}
+
+aclError acldvppMalloc(void** devPtr, size_t size)
+{
+    return aclrtMalloc(devPtr, size, ACL_MEM_MALLOC_NORMAL_ONLY);
+}
+
+aclError acldvppFree(void* devPtr)
+{
+    return aclrtFree(devPtr);
+}
+
+acldvppChannelDesc* acldvppCreateChannelDesc()
+{
+    return new acldvppChannelDesc{ 0 };
+}
+
+aclError acldvppDestroyChannelDesc(acldvppChannelDesc* channelDesc)
+{
+    delete channelDesc;
+    return ACL_SUCCESS;
+}
+
+aclError acldvppSetChannelDescMode(acldvppChannelDesc* channelDesc, uint32_t mode)
+{
+    if (channelDesc == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    channelDesc->mode = mode;
+    return ACL_SUCCESS;
+}
+
+aclError acldvppCreateChannel(acldvppChannelDesc* channelDesc)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError acldvppDestroyChannel(acldvppChannelDesc* channelDesc)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+acldvppPicDesc* acldvppCreatePicDesc()
+{
+    return new acldvppPicDesc{ nullptr, 0, PIXEL_FORMAT_YUV_SEMIPLANAR_420, 0, 0, 0, 0 };
+}
+
+aclError acldvppDestroyPicDesc(acldvppPicDesc* picDesc)
+{
+    delete picDesc;
+    return ACL_SUCCESS;
+}
+
+#define HOSTACL_DESC_SETTER(func, type, field, valueType) \
+    aclError func(type* desc, valueType value) \
+    { \
+        if (desc == nullptr) { \
+            return ACL_ERROR_INVALID_PARAM; \
+        } \
+        desc->field = value; \
+        return ACL_SUCCESS; \
+    }
+
+#define HOSTACL_DESC_GETTER(func, type, field, valueType) \
+    valueType func(const type* desc) \
+    { \
+        return (desc == nullptr) ? static_cast<valueType>(0) : desc->field; \
+    }
+
+HOSTACL_DESC_SETTER(acldvppSetPicDescData, acldvppPicDesc, data, void*)
+HOSTACL_DESC_SETTER(acldvppSetPicDescSize, acldvppPicDesc, size, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetPicDescFormat, acldvppPicDesc, format, acldvppPixelFormat)
+HOSTACL_DESC_SETTER(acldvppSetPicDescWidth, acldvppPicDesc, width, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetPicDescHeight, acldvppPicDesc, height, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetPicDescWidthStride, acldvppPicDesc, widthStride, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetPicDescHeightStride, acldvppPicDesc, heightStride, uint32_t)
+HOSTACL_DESC_GETTER(acldvppGetPicDescData, acldvppPicDesc, data, void*)
+HOSTACL_DESC_GETTER(acldvppGetPicDescSize, acldvppPicDesc, size, uint32_t)
+HOSTACL_DESC_GETTER(acldvppGetPicDescFormat, acldvppPicDesc, format, acldvppPixelFormat)
+HOSTACL_DESC_GETTER(acldvppGetPicDescWidth, acldvppPicDesc, width, uint32_t)
+HOSTACL_DESC_GETTER(acldvppGetPicDescHeight, acldvppPicDesc, height, uint32_t)
+HOSTACL_DESC_GETTER(acldvppGetPicDescWidthStride, acldvppPicDesc, widthStride, uint32_t)
+HOSTACL_DESC_GETTER(acldvppGetPicDescHeightStride, acldvppPicDesc, heightStride, uint32_t)
+
+acldvppRoiConfig* acldvppCreateRoiConfig(uint32_t left, uint32_t right, uint32_t top, uint32_t bottom)
+{
+    if ((right < left) || (bottom < top)) {
+        return nullptr;
+    }
+    return new acldvppRoiConfig{ left, right, top, bottom };
+}
+
+aclError acldvppDestroyRoiConfig(acldvppRoiConfig* roiConfig)
+{
+    delete roiConfig;
+    return ACL_SUCCESS;
+}
+
+acldvppResizeConfig* acldvppCreateResizeConfig()
+{
+    return new acldvppResizeConfig{ 0 };
+}
+
+aclError acldvppDestroyResizeConfig(acldvppResizeConfig* resizeConfig)
+{
+    delete resizeConfig;
+    return ACL_SUCCESS;
+}
+
+acldvppBorderConfig* acldvppCreateBorderConfig()
+{
+    return new acldvppBorderConfig{ { 0, 0, 0, 0 }, BORDER_CONSTANT, 0, 0, 0, 0 };
+}
+
+aclError acldvppDestroyBorderConfig(acldvppBorderConfig* borderConfig)
+{
+    delete borderConfig;
+    return ACL_SUCCESS;
+}
+
+aclError acldvppSetBorderConfigValue(acldvppBorderConfig* borderConfig, uint32_t index, double value)
+{
+    if ((borderConfig == nullptr) || (index >= sizeof(borderConfig->value) / sizeof(borderConfig->value[0]))) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    borderConfig->value[index] = value;
+    return ACL_SUCCESS;
+}
+
+HOSTACL_DESC_SETTER(acldvppSetBorderConfigBorderType, acldvppBorderConfig, type, acldvppBorderType)
+HOSTACL_DESC_SETTER(acldvppSetBorderConfigTop, acldvppBorderConfig, top, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetBorderConfigBottom, acldvppBorderConfig, bottom, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetBorderConfigLeft, acldvppBorderConfig, left, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetBorderConfigRight, acldvppBorderConfig, right, uint32_t)
+
+acldvppJpegeConfig* acldvppCreateJpegeConfig()
+{
+    return new acldvppJpegeConfig{ 100 };
+}
+
+aclError acldvppDestroyJpegeConfig(acldvppJpegeConfig* jpegeConfig)
+{
+    delete jpegeConfig;
+    return ACL_SUCCESS;
+}
+
+HOSTACL_DESC_SETTER(acldvppSetJpegeConfigLevel, acldvppJpegeConfig, level, uint32_t)
+
+aclError acldvppVpcResizeAsync(acldvppChannelDesc* channelDesc, acldvppPicDesc* inputDesc,
+                               acldvppPicDesc* outputDesc, acldvppResizeConfig* resizeConfig,
+                               aclrtStream stream)
+{
+    if ((channelDesc == nullptr) || !IsPicValid(inputDesc) || !IsPicValid(outputDesc) ||
+        !IsYuv420sp(inputDesc->format) || (inputDesc->format != outputDesc->format)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    acldvppPicDesc input = *inputDesc;
+    acldvppPicDesc output = *outputDesc;
+    return hostacl::Submit(stream, [input, output] {
+        ResizeYuv420sp(input, cv::Rect(0, 0, input.width, input.height),
+                       output, cv::Rect(0, 0, output.width, output.height));
+    });
+}
+
+aclError acldvppVpcCropAndPasteAsync(acldvppChannelDesc* channelDesc, acldvppPicDesc* inputDesc,
+                                     acldvppPicDesc* outputDesc, acldvppRoiConfig* cropArea,
+                                     acldvppRoiConfig* pasteArea, aclrtStream stream)
+{
+    if ((channelDesc == nullptr) || !IsPicValid(inputDesc) || !IsPicValid(outputDesc) ||
+        !IsYuv420sp(inputDesc->format) || (inputDesc->format != outputDesc->format) ||
+        (cropArea == nullptr) || (pasteArea == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    // the right and bottom of the roi are inclusive
+    cv::Rect crop(cropArea->left, cropArea->top, cropArea->right - cropArea->left + 1,
+                  cropArea->bottom - cropArea->top + 1);
+    cv::Rect paste(pasteArea->left, pasteArea->top, pasteArea->right - pasteArea->left + 1,
+                   pasteArea->bottom - pasteArea->top + 1);
+    if (((crop & cv::Rect(0, 0, inputDesc->width, inputDesc->height)) != crop) ||
+        ((paste & cv::Rect(0, 0, outputDesc->width, outputDesc->height)) != paste)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    acldvppPicDesc input = *inputDesc;
+    acldvppPicDesc output = *outputDesc;
+    return hostacl::Submit(stream, [input, crop, output, paste] {
+        ResizeYuv420sp(input, crop, output, paste);
+    });
+}
+
+aclError acldvppVpcMakeBorderAsync(const acldvppChannelDesc* channelDesc, const acldvppPicDesc* inputDesc,
+                                   acldvppPicDesc* outputDesc, const acldvppBorderConfig* borderConfig,
+                                   aclrtStream stream)
+{
+    if ((channelDesc == nullptr) || !IsPicValid(inputDesc) || !IsPicValid(outputDesc) ||
+        !IsYuv420sp(inputDesc->format) || (inputDesc->format != outputDesc->format) ||
+        (borderConfig == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    if ((inputDesc->width + borderConfig->left + borderConfig->right != outputDesc->width) ||
+        (inputDesc->height + borderConfig->top + borderConfig->bottom != outputDesc->height)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    acldvppPicDesc input = *inputDesc;
+    acldvppPicDesc output = *outputDesc;
+    acldvppBorderConfig border = *borderConfig;
+    return hostacl::Submit(stream, [input, output, border] {
+        int type = ToCvBorder(border.type);
+        cv::Mat dstY = YPlane(output);
+        cv::copyMakeBorder(YPlane(input), dstY, border.top, border.bottom, border.left, border.right,
+                           type, cv::Scalar(border.value[0]));
+        // the chroma borders follow the even aligned luma borders
+        uint32_t uvTop = border.top / 2;
+        uint32_t uvLeft = border.left / 2;
+        cv::Mat dstUv = UvPlane(output);
+        cv::Mat srcUv = UvPlane(input);
+        uint32_t uvBottom = dstUv.rows - srcUv.rows - uvTop;
+        uint32_t uvRight = dstUv.cols - srcUv.cols - uvLeft;
+        double u = border.value[1];
+        double v = border.value[2];
+        if (output.format == PIXEL_FORMAT_YVU_SEMIPLANAR_420) {
+            swap(u, v);
+        }
+        cv::copyMakeBorder(srcUv, dstUv, uvTop, uvBottom, uvLeft, uvRight, type, cv::Scalar(u, v));
+    });
+}
+
+aclError acldvppJpegGetImageInfo(const void* data, uint32_t size, uint32_t* width, uint32_t* height,
+                                 int32_t* components)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    if ((p == nullptr) || (size < 4) || (p[0] != 0xFF) || (p[1] != 0xD8)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    uint32_t pos = 2;
+    while (pos + 4 <= size) {
+        if (p[pos] != 0xFF) {
+            return ACL_ERROR_INVALID_FILE;
+        }
+        uint8_t marker = p[pos + 1];
+        if ((marker == 0xFF) || (marker == 0x01) || ((marker >= 0xD0) && (marker <= 0xD7))) {
+            // fill bytes and markers without a segment
+            pos += (marker == 0xFF) ? 1 : 2;
+            continue;
+        }
+        uint32_t segLen = (p[pos + 2] << 8) | p[pos + 3];
+        bool isSof = (marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) && (marker != 0xC8) &&
+            (marker != 0xCC);
+        if (isSof) {
+            if (pos + 10 > size) {
+                break;
+            }
+            if (height != nullptr) {
+                *height = (p[pos + 5] << 8) | p[pos + 6];
+            }
+            if (width != nullptr) {
+                *width = (p[pos + 7] << 8) | p[pos + 8];
+            }
+            if (components != nullptr) {
+                *components = p[pos + 9];
+            }
+            return ACL_SUCCESS;
+        }
+        pos += 2 + segLen;
+    }
+    return ACL_ERROR_INVALID_FILE;
+}
+
+aclError acldvppPngGetImageInfo(const void* data, uint32_t dataSize, uint32_t* width, uint32_t* height,
+                                int32_t* components)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    if ((p == nullptr) || (dataSize < kPngHeaderSize + 2) ||
+        (memcmp(p, kPngSignature, sizeof(kPngSignature)) != 0) || (memcmp(p + 12, "IHDR", 4) != 0)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    if (width != nullptr) {
+        *width = (p[16] << 24) | (p[17] << 16) | (p[18] << 8) | p[19];
+    }
+    if (height != nullptr) {
+        *height = (p[20] << 24) | (p[21] << 16) | (p[22] << 8) | p[23];
+    }
+    if (components != nullptr) {
+        // gray, -, rgb, palette, gray alpha, -, rgba
+        const int32_t channels[] = { 1, 0, 3, 3, 2, 0, 4 };
+        uint8_t colorType = p[kPngHeaderSize + 1];
+        *components = (colorType < sizeof(channels) / sizeof(channels[0])) ? channels[colorType] : 0;
+    }
+    return ACL_SUCCESS;
+}
+
+aclError acldvppJpegPredictEncSize(const acldvppPicDesc* inputDesc, const acldvppJpegeConfig* config,
+                                   uint32_t* size)
+{
+    if (!IsPicValid(inputDesc) || (size == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *size = inputDesc->widthStride * inputDesc->heightStride * 3 / 2 + kJpegHeaderReserve;
+    return ACL_SUCCESS;
+}
+
+aclError acldvppJpegDecodeAsync(acldvppChannelDesc* channelDesc, const void* data, uint32_t size,
+                                acldvppPicDesc* outputDesc, aclrtStream stream)
+{
+    if ((channelDesc == nullptr) || (data == nullptr) || (size == 0) || !IsPicValid(outputDesc) ||
+        !IsYuv420sp(outputDesc->format)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    vector<uint8_t> jpeg(begin, begin + size);
+    acldvppPicDesc output = *outputDesc;
+    return hostacl::Submit(stream, [jpeg, output] { LogAsyncError("acldvppJpegDecodeAsync", JpegDecode(jpeg, output)); });
+}
+
+aclError acldvppJpegEncodeAsync(acldvppChannelDesc* channelDesc, acldvppPicDesc* inputDesc, const void* data,
+                                uint32_t* size, acldvppJpegeConfig* config, aclrtStream stream)
+{
+    if ((channelDesc == nullptr) || !IsPicValid(inputDesc) || !IsYuv420sp(inputDesc->format) ||
+        (data == nullptr) || (size == nullptr) || (config == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    acldvppPicDesc input = *inputDesc;
+    uint8_t* out = static_cast<uint8_t*>(const_cast<void*>(data));
+    uint32_t level = config->level;
+    return hostacl::Submit(stream, [input, out, size, level] {
+        LogAsyncError("acldvppJpegEncodeAsync", JpegEncode(input, out, size, level));
+    });
+}
+
+aclError acldvppPngDecodeAsync(acldvppChannelDesc* channelDesc, const void* data, uint32_t size,
+                               acldvppPicDesc* outputDesc, aclrtStream stream)
+{
+    if ((channelDesc == nullptr) || (data == nullptr) || (size == 0) || !IsPicValid(outputDesc) ||
+        ((outputDesc->format != PIXEL_FORMAT_RGB_888) && (outputDesc->format != PIXEL_FORMAT_BGR_888))) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    vector<uint8_t> png(begin, begin + size);
+    acldvppPicDesc output = *outputDesc;
+    return hostacl::Submit(stream, [png, output] { LogAsyncError("acldvppPngDecodeAsync", PngDecode(png, output)); });
+}
+
+acldvppStreamDesc* acldvppCreateStreamDesc()
+{
+    return new acldvppStreamDesc{ nullptr, 0, H264_MAIN_LEVEL, 0, 0 };
+}
+
+aclError acldvppDestroyStreamDesc(acldvppStreamDesc* streamDesc)
+{
+    delete streamDesc;
+    return ACL_SUCCESS;
+}
+
+HOSTACL_DESC_SETTER(acldvppSetStreamDescData, acldvppStreamDesc, data, void*)
+HOSTACL_DESC_SETTER(acldvppSetStreamDescSize, acldvppStreamDesc, size, uint32_t)
+HOSTACL_DESC_SETTER(acldvppSetStreamDescFormat, acldvppStreamDesc, format, acldvppStreamFormat)
+HOSTACL_DESC_SETTER(acldvppSetStreamDescTimestamp, acldvppStreamDesc, timestamp, uint64_t)
+HOSTACL_DESC_SETTER(acldvppSetStreamDescEos, acldvppStreamDesc, eos, uint8_t)
+HOSTACL_DESC_GETTER(acldvppGetStreamDescData, acldvppStreamDesc, data, void*)
+HOSTACL_DESC_GETTER(acldvppGetStreamDescSize, acldvppStreamDesc, size, uint32_t)
+
+uint32_t acldvppGetStreamDescRetCode(const acldvppStreamDesc* streamDesc)
+{
+    return 0;
+}
+
+// the video codecs are out of the scope of the stand-in, the descriptors
+// work but the channels fail so that the sample takes its software codecs
+aclvdecChannelDesc* aclvdecCreateChannelDesc()
+{
+    return new aclvdecChannelDesc{ 0 };
+}
+
+aclError aclvdecDestroyChannelDesc(aclvdecChannelDesc* channelDesc)
+{
+    delete channelDesc;
+    return ACL_SUCCESS;
+}
+
+HOSTACL_DESC_SETTER(aclvdecSetChannelDescChannelId, aclvdecChannelDesc, channelId, uint32_t)
+
+aclError aclvdecSetChannelDescThreadId(aclvdecChannelDesc* channelDesc, uint64_t threadId)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvdecSetChannelDescCallback(aclvdecChannelDesc* channelDesc, aclvdecCallback callback)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvdecSetChannelDescEnType(aclvdecChannelDesc* channelDesc, acldvppStreamFormat enType)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvdecSetChannelDescOutPicFormat(aclvdecChannelDesc* channelDesc, acldvppPixelFormat outPicFormat)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvdecCreateChannel(aclvdecChannelDesc* channelDesc)
+{
+    return ACL_ERROR_RT_FEATURE_NOT_SUPPORT;
+}
+
+aclError aclvdecDestroyChannel(aclvdecChannelDesc* channelDesc)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclvdecSendFrame(aclvdecChannelDesc* channelDesc, acldvppStreamDesc* input, acldvppPicDesc* output,
+                          aclvdecFrameConfig* config, void* userData)
+{
+    return ACL_ERROR_RT_FEATURE_NOT_SUPPORT;
+}
+
+aclvencChannelDesc* aclvencCreateChannelDesc()
+{
+    return new aclvencChannelDesc{ 0 };
+}
+
+aclError aclvencDestroyChannelDesc(aclvencChannelDesc* channelDesc)
+{
+    delete channelDesc;
+    return ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescThreadId(aclvencChannelDesc* channelDesc, uint64_t threadId)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescCallback(aclvencChannelDesc* channelDesc, aclvencCallback callback)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescEnType(aclvencChannelDesc* channelDesc, acldvppStreamFormat enType)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescPicFormat(aclvencChannelDesc* channelDesc, acldvppPixelFormat picFormat)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescPicWidth(aclvencChannelDesc* channelDesc, uint32_t picWidth)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescPicHeight(aclvencChannelDesc* channelDesc, uint32_t picHeight)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescKeyFrameInterval(aclvencChannelDesc* channelDesc, uint32_t keyFrameInterval)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescMaxBitRate(aclvencChannelDesc* channelDesc, uint32_t maxBitRate)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencSetChannelDescRcMode(aclvencChannelDesc* channelDesc, uint32_t rcMode)
+{
+    return (channelDesc == nullptr) ? ACL_ERROR_INVALID_PARAM : ACL_SUCCESS;
+}
+
+aclError aclvencCreateChannel(aclvencChannelDesc* channelDesc)
+{
+    return ACL_ERROR_RT_FEATURE_NOT_SUPPORT;
+}
+
+aclError aclvencDestroyChannel(aclvencChannelDesc* channelDesc)
+{
+    return ACL_SUCCESS;
+}
+
+aclvencFrameConfig* aclvencCreateFrameConfig()
+{
+    return new aclvencFrameConfig{ 0, 0 };
+}
+
+aclError aclvencDestroyFrameConfig(aclvencFrameConfig* vencFrameConfig)
+{
+    delete vencFrameConfig;
+    return ACL_SUCCESS;
+}
+
+HOSTACL_DESC_SETTER(aclvencSetFrameConfigForceIFrame, aclvencFrameConfig, forceIFrame, uint8_t)
+HOSTACL_DESC_SETTER(aclvencSetFrameConfigEos, aclvencFrameConfig, eos, uint8_t)
+
+aclError aclvencSendFrame(aclvencChannelDesc* channelDesc, acldvppPicDesc* input, void* reserve,
+                          aclvencFrameConfig* config, void* userdata)
+{
+    return ACL_ERROR_RT_FEATURE_NOT_SUPPORT;
+}
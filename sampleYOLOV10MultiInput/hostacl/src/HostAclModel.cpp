@@ -0,0 +1,344 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File HostAclModel.cpp
+* Description: cpu stand-in of the acl model interfaces, it simulates the
+*              latency of a yolov10 model and outputs synthetic detections
+*/
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "HostAclCommon.h"
+#include "acl/acl.h"
+
+using namespace std;
+
+struct aclDataBuffer {
+    void* data;
+    size_t size;
+};
+
+struct aclmdlDataset {
+    vector<aclDataBuffer*> buffers;
+};
+
+struct aclmdlDesc {
+    uint32_t width;
+    uint32_t height;
+    uint32_t batch;
+};
+
+namespace {
+    const uint32_t kDefaultModelSize = 640;
+    const uint32_t kDefaultBatch = 1;
+    const uint32_t kDefaultLatencyUs = 20000;
+    const uint32_t kDefaultImageLatencyUs = 2000;
+    const uint32_t kDefaultDetections = 8;
+    // yolov10 end to end output: [batch, 300, (x1, y1, x2, y2, score, class)]
+    const uint32_t kBoxNum = 300;
+    const uint32_t kBoxAttrNum = 6;
+    const uint32_t kClassNum = 80;
+    const char* kOutputName = "output0";
+
+    struct HostAclModel {
+        aclmdlDesc desc;
+        uint64_t execCnt;
+    };
+
+    mutex g_modelMutex;
+    map<uint32_t, HostAclModel> g_models;
+    uint32_t g_nextModelId = 1;
+    // one ai core per device, the models of a device execute one at a time
+    mutex g_deviceExecMutex[8];
+
+    size_t InputSize(const aclmdlDesc& desc)
+    {
+        return static_cast<size_t>(desc.width) * desc.height * 3 / 2 * desc.batch;
+    }
+
+    size_t OutputSize(const aclmdlDesc& desc)
+    {
+        return static_cast<size_t>(desc.batch) * kBoxNum * kBoxAttrNum * sizeof(float);
+    }
+
+    aclError LoadModel(uint32_t* modelId)
+    {
+        if (modelId == nullptr) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        HostAclModel model;
+        model.desc.width = hostacl::EnvUint("HOSTACL_MODEL_WIDTH", kDefaultModelSize);
+        model.desc.height = hostacl::EnvUint("HOSTACL_MODEL_HEIGHT", kDefaultModelSize);
+        model.desc.batch = hostacl::EnvUint("HOSTACL_MODEL_BATCH", kDefaultBatch);
+        if ((model.desc.width == 0) || (model.desc.height == 0) || (model.desc.batch == 0)) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        model.execCnt = 0;
+        lock_guard<mutex> lock(g_modelMutex);
+        *modelId = g_nextModelId++;
+        g_models[*modelId] = model;
+        return ACL_SUCCESS;
+    }
+
+    /**
+     * Boxes slide over the model input frame by frame so the postprocess,
+     * render and output stages have stable but changing work
+     */
+    void FillDetections(float* output, const aclmdlDesc& desc, uint64_t execCnt)
+    {
+        uint32_t detNum = hostacl::EnvUint("HOSTACL_DETECTIONS", kDefaultDetections);
+        detNum = (detNum > kBoxNum) ? kBoxNum : detNum;
+        memset(output, 0, OutputSize(desc));
+        float boxW = desc.width / 8.0f;
+        float boxH = desc.height / 6.0f;
+        for (uint32_t b = 0; b < desc.batch; b++) {
+            float* p = output + static_cast<size_t>(b) * kBoxNum * kBoxAttrNum;
+            for (uint32_t i = 0; i < detNum; i++, p += kBoxAttrNum) {
+                uint64_t step = execCnt * 4 + i * 97 + b * 31;
+                float x = static_cast<float>(step % static_cast<uint64_t>(desc.width - boxW));
+                float y = static_cast<float>((i * 53 + b * 17) % static_cast<uint64_t>(desc.height - boxH));
+                p[0] = x;
+                p[1] = y;
+                p[2] = x + boxW;
+                p[3] = y + boxH;
+                p[4] = 0.95f - 0.05f * (i % 10);
+                p[5] = static_cast<float>(i % kClassNum);
+            }
+        }
+    }
+
+    aclError Execute(uint32_t modelId, const aclmdlDataset* input, aclmdlDataset* output, int32_t deviceId)
+    {
+        aclmdlDesc desc;
+        uint64_t execCnt = 0;
+        {
+            lock_guard<mutex> lock(g_modelMutex);
+            auto it = g_models.find(modelId);
+            if (it == g_models.end()) {
+                return ACL_ERROR_INVALID_PARAM;
+            }
+            desc = it->second.desc;
+            execCnt = it->second.execCnt++;
+        }
+        if ((input == nullptr) || (output == nullptr) || (input->buffers.size() != 1) ||
+            (output->buffers.size() != 1)) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+        const aclDataBuffer* inBuf = input->buffers[0];
+        aclDataBuffer* outBuf = output->buffers[0];
+        if ((inBuf->data == nullptr) || (inBuf->size < InputSize(desc)) ||
+            (outBuf->data == nullptr) || (outBuf->size < OutputSize(desc))) {
+            return ACL_ERROR_INVALID_PARAM;
+        }
+
+        uint64_t latencyUs = hostacl::EnvUint("HOSTACL_INFER_LATENCY_US", kDefaultLatencyUs) +
+            static_cast<uint64_t>(hostacl::EnvUint("HOSTACL_INFER_IMAGE_LATENCY_US", kDefaultImageLatencyUs)) *
+            desc.batch;
+        uint32_t core = static_cast<uint32_t>(deviceId) % (sizeof(g_deviceExecMutex) / sizeof(g_deviceExecMutex[0]));
+        lock_guard<mutex> lock(g_deviceExecMutex[core]);
+        hostacl::SleepUs(latencyUs);
+        FillDetections(static_cast<float*>(outBuf->data), desc, execCnt);
+        return ACL_SUCCESS;
+    }
+}
+
+aclDataBuffer* aclCreateDataBuffer(void* data, size_t size)
+{
+    return new aclDataBuffer{ data, size };
+}
+
+aclError aclDestroyDataBuffer(const aclDataBuffer* dataBuffer)
+{
+    delete dataBuffer;
+    return ACL_SUCCESS;
+}
+
+aclError aclUpdateDataBuffer(aclDataBuffer* dataBuffer, void* data, size_t size)
+{
+    if (dataBuffer == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    dataBuffer->data = data;
+    dataBuffer->size = size;
+    return ACL_SUCCESS;
+}
+
+void* aclGetDataBufferAddr(const aclDataBuffer* dataBuffer)
+{
+    return (dataBuffer == nullptr) ? nullptr : dataBuffer->data;
+}
+
+uint32_t aclGetDataBufferSize(const aclDataBuffer* dataBuffer)
+{
+    return (dataBuffer == nullptr) ? 0 : static_cast<uint32_t>(dataBuffer->size);
+}
+
+aclError aclmdlLoadFromFile(const char* modelPath, uint32_t* modelId)
+{
+    // the om file is not parsed, the model shape comes from the environment
+    return LoadModel(modelId);
+}
+
+aclError aclmdlLoadFromMem(const void* model, size_t modelSize, uint32_t* modelId)
+{
+    return LoadModel(modelId);
+}
+
+aclError aclmdlUnload(uint32_t modelId)
+{
+    lock_guard<mutex> lock(g_modelMutex);
+    return (g_models.erase(modelId) > 0) ? ACL_SUCCESS : ACL_ERROR_INVALID_PARAM;
+}
+
+aclmdlDesc* aclmdlCreateDesc()
+{
+    return new aclmdlDesc{ 0, 0, 0 };
+}
+
+aclError aclmdlDestroyDesc(aclmdlDesc* modelDesc)
+{
+    delete modelDesc;
+    return ACL_SUCCESS;
+}
+
+aclError aclmdlGetDesc(aclmdlDesc* modelDesc, uint32_t modelId)
+{
+    if (modelDesc == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    lock_guard<mutex> lock(g_modelMutex);
+    auto it = g_models.find(modelId);
+    if (it == g_models.end()) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *modelDesc = it->second.desc;
+    return ACL_SUCCESS;
+}
+
+size_t aclmdlGetNumInputs(aclmdlDesc* modelDesc)
+{
+    return (modelDesc == nullptr) ? 0 : 1;
+}
+
+size_t aclmdlGetNumOutputs(aclmdlDesc* modelDesc)
+{
+    return (modelDesc == nullptr) ? 0 : 1;
+}
+
+size_t aclmdlGetInputSizeByIndex(aclmdlDesc* modelDesc, size_t index)
+{
+    return ((modelDesc == nullptr) || (index != 0)) ? 0 : InputSize(*modelDesc);
+}
+
+size_t aclmdlGetOutputSizeByIndex(aclmdlDesc* modelDesc, size_t index)
+{
+    return ((modelDesc == nullptr) || (index != 0)) ? 0 : OutputSize(*modelDesc);
+}
+
+aclError aclmdlGetInputIndexByName(const aclmdlDesc* modelDesc, const char* name, size_t* index)
+{
+    // the simulated model has a static batch, there is no dynamic batch input
+    return ACL_ERROR_INVALID_PARAM;
+}
+
+aclError aclmdlGetOutputDims(const aclmdlDesc* modelDesc, size_t index, aclmdlIODims* dims)
+{
+    if ((modelDesc == nullptr) || (index != 0) || (dims == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    memset(dims, 0, sizeof(aclmdlIODims));
+    strncpy(dims->name, kOutputName, ACL_MAX_TENSOR_NAME_LEN - 1);
+    dims->dimCount = 3;
+    dims->dims[0] = modelDesc->batch;
+    dims->dims[1] = kBoxNum;
+    dims->dims[2] = kBoxAttrNum;
+    return ACL_SUCCESS;
+}
+
+const char* aclmdlGetOutputNameByIndex(const aclmdlDesc* modelDesc, size_t index)
+{
+    return ((modelDesc == nullptr) || (index != 0)) ? "" : kOutputName;
+}
+
+aclFormat aclmdlGetOutputFormat(const aclmdlDesc* modelDesc, size_t index)
+{
+    return ((modelDesc == nullptr) || (index != 0)) ? ACL_FORMAT_UNDEFINED : ACL_FORMAT_ND;
+}
+
+aclDataType aclmdlGetOutputDataType(const aclmdlDesc* modelDesc, size_t index)
+{
+    return ((modelDesc == nullptr) || (index != 0)) ? ACL_DT_UNDEFINED : ACL_FLOAT;
+}
+
+aclmdlDataset* aclmdlCreateDataset()
+{
+    return new aclmdlDataset();
+}
+
+aclError aclmdlDestroyDataset(const aclmdlDataset* dataset)
+{
+    delete dataset;
+    return ACL_SUCCESS;
+}
+
+aclError aclmdlAddDatasetBuffer(aclmdlDataset* dataset, aclDataBuffer* dataBuffer)
+{
+    if ((dataset == nullptr) || (dataBuffer == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    dataset->buffers.push_back(dataBuffer);
+    return ACL_SUCCESS;
+}
+
+size_t aclmdlGetDatasetNumBuffers(const aclmdlDataset* dataset)
+{
+    return (dataset == nullptr) ? 0 : dataset->buffers.size();
+}
+
+aclDataBuffer* aclmdlGetDatasetBuffer(const aclmdlDataset* dataset, size_t index)
+{
+    if ((dataset == nullptr) || (index >= dataset->buffers.size())) {
+        return nullptr;
+    }
+    return dataset->buffers[index];
+}
+
+aclError aclmdlExecute(uint32_t modelId, const aclmdlDataset* input, aclmdlDataset* output)
+{
+    return Execute(modelId, input, output, hostacl::CurrentDeviceId());
+}
+
+aclError aclmdlExecuteAsync(uint32_t modelId, const aclmdlDataset* input, aclmdlDataset* output,
+                            aclrtStream stream)
+{
+    if ((input == nullptr) || (output == nullptr)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    // the stream worker has no context, take the device at submission
+    int32_t deviceId = hostacl::CurrentDeviceId();
+    return hostacl::Submit(stream, [modelId, input, output, deviceId] {
+        aclError ret = Execute(modelId, input, output, deviceId);
+        if (ret != ACL_SUCCESS) {
+            aclAppLog(ACL_ERROR, __FUNCTION__, __FILE__, __LINE__, "execute model %u failed, error %d",
+                      modelId, ret);
+        }
+    });
+}
+
+aclError aclmdlSetDynamicBatchSize(uint32_t modelId, aclmdlDataset* dataset, size_t index, uint64_t batchSize)
+{
+    return ACL_ERROR_RT_FEATURE_NOT_SUPPORT;
+}
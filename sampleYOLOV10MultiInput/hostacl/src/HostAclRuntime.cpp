@@ -0,0 +1,423 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File HostAclRuntime.cpp
+* Description: cpu stand-in of the acl runtime, streams are worker threads
+*              and the device memory is host memory
+*/
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include "HostAclCommon.h"
+#include "acl/acl.h"
+
+using namespace std;
+
+namespace {
+    const size_t kMemAlign = 128;
+    // aclAppLog only prints when HOSTACL_LOG_LEVEL is set, the AclLite log
+    // macros already print every message to stdout
+    const uint32_t kLogSilent = ACL_ERROR + 1;
+    const char* kSocName = "HostACL";
+    const char* kLogLevelName[] = { "DEBUG", "INFO", "WARNING", "ERROR" };
+
+    struct HostAclContext {
+        int32_t deviceId;
+    };
+
+    struct HostAclEvent {
+        mutex mtx;
+        condition_variable cond;
+        uint64_t recorded = 0;
+        uint64_t completed = 0;
+    };
+
+    class HostAclStream {
+    public:
+        HostAclStream() : stop_(false), busy_(false)
+        {
+            worker_ = thread(&HostAclStream::Run, this);
+        }
+
+        ~HostAclStream()
+        {
+            {
+                lock_guard<mutex> lock(mtx_);
+                stop_ = true;
+            }
+            taskCond_.notify_all();
+            worker_.join();
+        }
+
+        void Push(const function<void()>& task)
+        {
+            {
+                lock_guard<mutex> lock(mtx_);
+                tasks_.push_back(task);
+            }
+            taskCond_.notify_one();
+        }
+
+        void Synchronize()
+        {
+            unique_lock<mutex> lock(mtx_);
+            idleCond_.wait(lock, [this] { return tasks_.empty() && !busy_; });
+        }
+
+    private:
+        void Run()
+        {
+            unique_lock<mutex> lock(mtx_);
+            while (true) {
+                taskCond_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    break;
+                }
+                function<void()> task = tasks_.front();
+                tasks_.pop_front();
+                busy_ = true;
+                lock.unlock();
+                task();
+                lock.lock();
+                busy_ = false;
+                if (tasks_.empty()) {
+                    idleCond_.notify_all();
+                }
+            }
+        }
+
+    private:
+        mutex mtx_;
+        condition_variable taskCond_;
+        condition_variable idleCond_;
+        deque<function<void()>> tasks_;
+        bool stop_;
+        bool busy_;
+        thread worker_;
+    };
+
+    mutex g_deviceMutex;
+    map<int32_t, HostAclContext*> g_defaultContext;
+    thread_local HostAclContext* g_currentContext = nullptr;
+
+    uint32_t LogLevel()
+    {
+        static uint32_t level = hostacl::EnvUint("HOSTACL_LOG_LEVEL", kLogSilent);
+        return level;
+    }
+}
+
+namespace hostacl {
+aclError Submit(aclrtStream stream, const function<void()>& task)
+{
+    if (stream == nullptr) {
+        task();
+    } else {
+        static_cast<HostAclStream*>(stream)->Push(task);
+    }
+    return ACL_SUCCESS;
+}
+
+int32_t CurrentDeviceId()
+{
+    return (g_currentContext == nullptr) ? 0 : g_currentContext->deviceId;
+}
+
+uint32_t EnvUint(const char* name, uint32_t defaultValue)
+{
+    const char* value = getenv(name);
+    if ((value == nullptr) || (*value == '\0')) {
+        return defaultValue;
+    }
+    char* end = nullptr;
+    unsigned long ret = strtoul(value, &end, 10);
+    if (*end != '\0') {
+        return defaultValue;
+    }
+    return static_cast<uint32_t>(ret);
+}
+
+void SleepUs(uint64_t us)
+{
+    if (us > 0) {
+        this_thread::sleep_for(chrono::microseconds(us));
+    }
+}
+}
+
+aclError aclInit(const char* configPath)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclFinalize()
+{
+    return ACL_SUCCESS;
+}
+
+void aclAppLog(aclLogLevel logLevel, const char* func, const char* file, uint32_t line, const char* fmt, ...)
+{
+    if ((logLevel < ACL_DEBUG) || (logLevel > ACL_ERROR) || (static_cast<uint32_t>(logLevel) < LogLevel())) {
+        return;
+    }
+    char msg[1024];
+    va_list args;
+    va_start(args, fmt);
+    (void)vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    fprintf(stderr, "[HostACL][%s] %s:%u %s: %s\n", kLogLevelName[logLevel], file, line, func, msg);
+}
+
+aclError aclrtSetDevice(int32_t deviceId)
+{
+    if (deviceId < 0) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    lock_guard<mutex> lock(g_deviceMutex);
+    HostAclContext*& context = g_defaultContext[deviceId];
+    if (context == nullptr) {
+        context = new HostAclContext{ deviceId };
+    }
+    if (g_currentContext == nullptr) {
+        g_currentContext = context;
+    }
+    return ACL_SUCCESS;
+}
+
+aclError aclrtResetDevice(int32_t deviceId)
+{
+    lock_guard<mutex> lock(g_deviceMutex);
+    auto it = g_defaultContext.find(deviceId);
+    if (it == g_defaultContext.end()) {
+        return ACL_SUCCESS;
+    }
+    if (g_currentContext == it->second) {
+        g_currentContext = nullptr;
+    }
+    delete it->second;
+    g_defaultContext.erase(it);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtCreateContext(aclrtContext* context, int32_t deviceId)
+{
+    if ((context == nullptr) || (deviceId < 0)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    HostAclContext* ctx = new HostAclContext{ deviceId };
+    g_currentContext = ctx;
+    *context = ctx;
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyContext(aclrtContext context)
+{
+    if (context == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    if (g_currentContext == context) {
+        g_currentContext = nullptr;
+    }
+    delete static_cast<HostAclContext*>(context);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSetCurrentContext(aclrtContext context)
+{
+    if (context == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    g_currentContext = static_cast<HostAclContext*>(context);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtGetCurrentContext(aclrtContext* context)
+{
+    if (context == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *context = g_currentContext;
+    return (g_currentContext == nullptr) ? ACL_ERROR_RT_CONTEXT_NULL : ACL_SUCCESS;
+}
+
+aclError aclrtGetRunMode(aclrtRunMode* runMode)
+{
+    if (runMode == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    // HOSTACL_RUN_MODE=host exercises the host to device copy paths
+    const char* mode = getenv("HOSTACL_RUN_MODE");
+    *runMode = ((mode != nullptr) && (strcmp(mode, "host") == 0)) ? ACL_HOST : ACL_DEVICE;
+    return ACL_SUCCESS;
+}
+
+const char* aclrtGetSocName()
+{
+    return kSocName;
+}
+
+aclError aclrtCreateStream(aclrtStream* stream)
+{
+    if (stream == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *stream = new HostAclStream();
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyStream(aclrtStream stream)
+{
+    if (stream == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    delete static_cast<HostAclStream*>(stream);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSynchronizeStream(aclrtStream stream)
+{
+    if (stream != nullptr) {
+        static_cast<HostAclStream*>(stream)->Synchronize();
+    }
+    return ACL_SUCCESS;
+}
+
+aclError aclrtSubscribeReport(uint64_t threadId, aclrtStream stream)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclrtUnSubscribeReport(uint64_t threadId, aclrtStream stream)
+{
+    return ACL_SUCCESS;
+}
+
+aclError aclrtProcessReport(int32_t timeout)
+{
+    // no callback is ever reported, behave like an idle report thread
+    hostacl::SleepUs(static_cast<uint64_t>((timeout > 0) ? timeout : 0) * 1000);
+    return ACL_ERROR_RT_REPORT_TIMEOUT;
+}
+
+aclError aclrtCreateEvent(aclrtEvent* event)
+{
+    if (event == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    *event = new HostAclEvent();
+    return ACL_SUCCESS;
+}
+
+aclError aclrtDestroyEvent(aclrtEvent event)
+{
+    if (event == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    delete static_cast<HostAclEvent*>(event);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtRecordEvent(aclrtEvent event, aclrtStream stream)
+{
+    if (event == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    HostAclEvent* hostEvent = static_cast<HostAclEvent*>(event);
+    uint64_t seq = 0;
+    {
+        lock_guard<mutex> lock(hostEvent->mtx);
+        seq = ++hostEvent->recorded;
+    }
+    return hostacl::Submit(stream, [hostEvent, seq] {
+        {
+            lock_guard<mutex> lock(hostEvent->mtx);
+            hostEvent->completed = seq;
+        }
+        hostEvent->cond.notify_all();
+    });
+}
+
+aclError aclrtSynchronizeEvent(aclrtEvent event)
+{
+    if (event == nullptr) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    HostAclEvent* hostEvent = static_cast<HostAclEvent*>(event);
+    unique_lock<mutex> lock(hostEvent->mtx);
+    hostEvent->cond.wait(lock, [hostEvent] { return hostEvent->completed >= hostEvent->recorded; });
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMalloc(void** devPtr, size_t size, aclrtMemMallocPolicy policy)
+{
+    if ((devPtr == nullptr) || (size == 0)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    if (posix_memalign(devPtr, kMemAlign, size) != 0) {
+        *devPtr = nullptr;
+        return ACL_ERROR_BAD_ALLOC;
+    }
+    return ACL_SUCCESS;
+}
+
+aclError aclrtFree(void* devPtr)
+{
+    free(devPtr);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMallocHost(void** hostPtr, size_t size)
+{
+    return aclrtMalloc(hostPtr, size, ACL_MEM_MALLOC_NORMAL_ONLY);
+}
+
+aclError aclrtFreeHost(void* hostPtr)
+{
+    free(hostPtr);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemcpy(void* dst, size_t destMax, const void* src, size_t count, aclrtMemcpyKind kind)
+{
+    if ((dst == nullptr) || (src == nullptr) || (count > destMax)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    memcpy(dst, src, count);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemset(void* devPtr, size_t maxCount, int32_t value, size_t count)
+{
+    if ((devPtr == nullptr) || (count > maxCount)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    memset(devPtr, value, count);
+    return ACL_SUCCESS;
+}
+
+aclError aclrtMemsetAsync(void* devPtr, size_t maxCount, int32_t value, size_t count, aclrtStream stream)
+{
+    if ((devPtr == nullptr) || (count > maxCount)) {
+        return ACL_ERROR_INVALID_PARAM;
+    }
+    return hostacl::Submit(stream, [devPtr, value, count] { memset(devPtr, value, count); });
+}
@@ -29,6 +29,7 @@
 #include "AclLiteType.h"
 #include "AclLiteModel.h"
 #include "AclLiteImageProc.h"
+#include "LatencyTracer.h"
 #include "opencv2/opencv.hpp"
 #include "opencv2/imgproc/types_c.h"
 #include "opencv2/highgui/highgui.hpp"
@@ -44,6 +45,7 @@ const int MSG_OUTPUT_FRAME = 6;
 const int MSG_ENCODE_FINISH = 7;
 const int MSG_RTSP_DISPLAY = 8;
 const int MSG_APP_EXIT = 9;
+const int MSG_OUTPUT_DROPPED = 10;
 
 const std::string kDataInputName = "dataInput";
 const std::string kPreName = "pre";
@@ -53,6 +55,27 @@ const std::string kDataOutputName = "dataOutput";
 const std::string kRtspDisplayName = "rtspDisplay";
 }
 
+// the timestamps of a message, stamped in the order of the pipeline
+enum FrameStage {
+    STAGE_DECODE = 0,  // the decoded frames are read by dataInput
+    STAGE_PRE_ENQUEUE,  // sent to detectPreprocess
+    STAGE_PRE_DONE,  // the model input is prepared
+    STAGE_INFER_ENQUEUE,  // sent to detectInference
+    STAGE_INFER_DONE,  // the inference output is ready
+    STAGE_POST_DONE,  // the detections are decoded and rendered
+    STAGE_OUTPUT,  // output by dataOutput in order
+    STAGE_NUM
+};
+
+struct DetectBox {
+    float left;
+    float top;
+    float right;
+    float bottom;
+    float score;
+    uint32_t classIndex;
+};
+
 struct DetectDataMsg {
     int detectPreThreadId;
     int detectInferThreadId;
@@ -66,9 +89,29 @@ struct DetectDataMsg {
     int msgNum;  // record frameID in rtsp/video of this channel
     std::vector<ImageData> decodedImg;  // original image (NV12)
     ImageData modelInputImg;  // image after detect preprocess
-    std::vector<cv::Mat> frame;  // original image (BGR) needed by postprocess
+    int64_t batchSeq = -1;  // the DetectBatchInput batch holding the preprocessed images, -1: in modelInputImg
+    uint32_t batchImgIndex = 0;  // the index of the first image in the batch
+    std::vector<LetterboxInfo> letterbox;  // the resize scale and pad of every image in modelInputImg
+    std::vector<cv::Mat> frame;  // original image (BGR) with boxes, only rendered for the outputs showing pixels
+    std::vector<ImageData> yuvFrame;  // original image (NV12) on host with boxes, rendered for the nv12 rtsp output
     std::vector<InferenceOutput> inferenceOutput;  // yolo detect output
+    std::shared_ptr<std::vector<ModelOutputInfo>> modelOutputInfo;  // the shape of inferenceOutput
+    std::vector<std::vector<DetectBox>> detections;  // the boxes of every image in the source image coordinates
     std::vector<std::string> textPrint;
+    uint64_t stageTimeUs[STAGE_NUM] = {0};  // monotonic time of every FrameStage, 0: not stamped
 };
 
+/**
+ * @brief stamp the stage of the message when the latency trace is enabled
+ * @param [in] detectDataMsg: the message held by the calling thread
+ * @param [in] stage: the stage just reached
+ */
+inline void StampFrameStage(DetectDataMsg& detectDataMsg, FrameStage stage)
+{
+    // the last frame message is sent once per postprocess thread and may be held by several threads at once
+    if (LatencyTracer::IsEnabled() && !detectDataMsg.isLastFrame) {
+        detectDataMsg.stageTimeUs[stage] = LatencyTracer::NowUs();
+    }
+}
+
 #endif
\ No newline at end of file
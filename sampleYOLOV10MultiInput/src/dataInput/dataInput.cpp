@@ -19,12 +19,11 @@
 #include <iostream>
 #include "Params.h"
 #include "dataInput.h"
+#include "../detectPostprocess/detectPostprocessPool.h"
 #include <sys/time.h>
 
 namespace{
-    const uint32_t kYuvMultiplier = 3;
-    const uint32_t kYuvDivisor = 2;
-    const uint32_t kSleepTime = 500;
+    const uint32_t kSendTimeoutMs = 100;
     const uint32_t kOneSec = 1000000;
     const uint32_t kOneMSec = 1000;
 }
@@ -33,14 +32,16 @@ using namespace std;
 DataInputThread::DataInputThread(
     int32_t deviceId, int32_t channelId, aclrtRunMode& runMode,
     string inputDataType, string inputDataPath, string inferName,
-    int postThreadNum, uint32_t batch, int framesPerSecond)
+    int postThreadNum, uint32_t batch, int framesPerSecond, AclLiteQueuePolicy queuePolicy,
+    string captureMode, bool skipNonRefFrame, string videoDecoder, uint32_t swDecodeThreads)
     :deviceId_(deviceId), channelId_(channelId), runMode_(runMode), postproId_(0),
     inputDataType_(inputDataType), inputDataPath_(inputDataPath),
     inferName_(inferName), cap_(nullptr), frameCnt_(0), postThreadNum_(postThreadNum),
     selfThreadId_(INVALID_INSTANCE_ID), preThreadId_(INVALID_INSTANCE_ID),
     inferThreadId_(INVALID_INSTANCE_ID), dataOutputThreadId_(INVALID_INSTANCE_ID),
     rtspDisplayThreadId_(INVALID_INSTANCE_ID), batch_(batch), framesPerSecond_(framesPerSecond),
-    msgNum_(0)
+    msgNum_(0), queuePolicy_(queuePolicy), captureMode_(captureMode), skipNonRefFrame_(skipNonRefFrame),
+    videoDecoder_(videoDecoder), swDecodeThreads_(swDecodeThreads)
 {
     for (int i = 0; i < postThreadNum; i++) {
         postThreadId_.push_back(INVALID_INSTANCE_ID);
@@ -73,14 +74,15 @@ AclLiteError DataInputThread::OpenPicsDir()
 
 AclLiteError DataInputThread::OpenVideoCapture()
 {
+    bool swDecode = (videoDecoder_ == "sw");
     if (IsRtspAddr(inputDataPath_)) {
-        cap_ = new AclLiteVideoProc(inputDataPath_, deviceId_);
+        cap_ = new AclLiteVideoProc(inputDataPath_, deviceId_, nullptr, swDecode);
     } else if (IsVideoFile(inputDataPath_)) {
         if (!IsPathExist(inputDataPath_)) {
             ACLLITE_LOG_ERROR("The %s is inaccessible", inputDataPath_.c_str());
             return ACLLITE_ERROR;
         }
-        cap_ = new AclLiteVideoProc(inputDataPath_, deviceId_);
+        cap_ = new AclLiteVideoProc(inputDataPath_, deviceId_, nullptr, swDecode);
     } else {
         ACLLITE_LOG_ERROR("Invalid param. The arg should be accessible rtsp,"
                           " video file or camera id");
@@ -94,6 +96,18 @@ AclLiteError DataInputThread::OpenVideoCapture()
         return ACLLITE_ERROR;
     }
 
+    uint32_t captureMode = (captureMode_ == "latest") ? CAPTURE_MODE_LATEST : CAPTURE_MODE_QUEUE;
+    if ((cap_->Set(CAPTURE_MODE, captureMode) != ACLLITE_OK) ||
+        (cap_->Set(SKIP_NON_REF_FRAME, skipNonRefFrame_ ? 1 : 0) != ACLLITE_OK)) {
+        ACLLITE_LOG_ERROR("Failed to set capture mode %s of video %s",
+                          captureMode_.c_str(), inputDataPath_.c_str());
+        return ACLLITE_ERROR;
+    }
+    if (swDecode && (cap_->Set(DECODE_THREAD_NUM, swDecodeThreads_) != ACLLITE_OK)) {
+        ACLLITE_LOG_ERROR("Failed to set sw decode threads of video %s", inputDataPath_.c_str());
+        return ACLLITE_ERROR;
+    }
+
     return ACLLITE_OK;
 }
 
@@ -122,7 +136,9 @@ AclLiteError DataInputThread::Init()
     preThreadId_ = GetAclLiteThreadIdByName(kPreName + to_string(channelId_));
     dataOutputThreadId_ = GetAclLiteThreadIdByName(kDataOutputName + to_string(channelId_));
     rtspDisplayThreadId_ = GetAclLiteThreadIdByName(kRtspDisplayName + to_string(channelId_));
-    for (int i = 0; i < postThreadNum_; i++) {
+    // the inference thread submits the messages of the channel in the postprocess pool
+    bool usePostPool = DetectPostprocessPool::GetInstance().HasChannel(channelId_);
+    for (int i = 0; (i < postThreadNum_) && !usePostPool; i++) {
         postThreadId_[i] = GetAclLiteThreadIdByName(kPostName + to_string(channelId_) + "_" + to_string(i));
         if (postThreadId_[i] == INVALID_INSTANCE_ID) {
             ACLLITE_LOG_ERROR("%d postprocess instance id %d",
@@ -201,14 +217,48 @@ AclLiteError DataInputThread::ReadPic(shared_ptr<DetectDataMsg> &detectDataMsg)
         ACLLITE_LOG_ERROR("Pic decode failed");
         return ACLLITE_ERROR;
     }
-    cv::Mat frame = cv::imread(picFile);
+    // the BGR frame is rendered from decodedImg by postprocess when the output needs it
     detectDataMsg->decodedImg.push_back(decodedImg);
-    detectDataMsg->frame.push_back(frame);
+    return ACLLITE_OK;
+}
+
+AclLiteError DataInputThread::ReadLatestFrame(shared_ptr<DetectDataMsg> &detectDataMsg)
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    int64_t now = ((int64_t)tv.tv_sec * kOneSec + (int64_t)tv.tv_usec) / kOneMSec;
+    if (lastDecodeTime_ == 0) {
+        lastDecodeTime_ = now;
+    }
+    // the decoder keeps only the newest frame, sleep to the next read instead of
+    // reading and discarding frames
+    realWaitTime_ = (now - lastDecodeTime_);
+    if (realWaitTime_ < waitTime_) {
+        usleep((waitTime_ - realWaitTime_) * kOneMSec);
+    }
+
+    ImageData decodedImg;
+    AclLiteError ret = cap_->Read(decodedImg);
+    if (ret == ACLLITE_ERROR_DECODE_FINISH) {
+        detectDataMsg->isLastFrame = true;
+        return ACLLITE_ERROR_DECODE_FINISH;
+    } else if (ret != ACLLITE_OK) {
+        detectDataMsg->isLastFrame = true;
+        ACLLITE_LOG_ERROR("Read frame failed, error %d", ret);
+        return ACLLITE_ERROR;
+    }
+    detectDataMsg->decodedImg.push_back(decodedImg);
+    gettimeofday(&tv, 0);
+    lastDecodeTime_ = ((int64_t)tv.tv_sec * kOneSec + (int64_t)tv.tv_usec) / kOneMSec;
     return ACLLITE_OK;
 }
 
 AclLiteError DataInputThread::ReadStream(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
+    if (captureMode_ == "latest") {
+        return ReadLatestFrame(detectDataMsg);
+    }
+
     // get time now
     timeval tv;
     gettimeofday(&tv, 0);
@@ -249,18 +299,9 @@ AclLiteError DataInputThread::ReadStream(shared_ptr<DetectDataMsg> &detectDataMs
         ACLLITE_LOG_ERROR("Read frame failed, error %d", ret);
         return ACLLITE_ERROR;
     }
-    // get frame
-    ImageData yuvImage;
-    ret = CopyImageToLocal(yuvImage, decodedImg, runMode_);
-    if (ret == ACLLITE_ERROR) {
-        ACLLITE_LOG_ERROR("Copy image to host failed");
-        return ACLLITE_ERROR;
-    }
-    cv::Mat frame;
-    cv::Mat yuvimg(yuvImage.height * kYuvMultiplier / kYuvDivisor, yuvImage.width, CV_8UC1, yuvImage.data.get());
-    cv::cvtColor(yuvimg, frame, CV_YUV2BGR_NV12);
+    // the decoded image stays in device memory, the BGR frame is rendered from it
+    // by postprocess only when the output needs pixels
     detectDataMsg->decodedImg.push_back(decodedImg);
-    detectDataMsg->frame.push_back(frame);
     lastDecodeTime_ = now;
     return ACLLITE_OK;
 }
@@ -314,23 +355,59 @@ AclLiteError DataInputThread::MsgRead(shared_ptr<DetectDataMsg> &detectDataMsg)
         }
         frameCnt_++;
     }
+    StampFrameStage(*detectDataMsg, STAGE_DECODE);
 
     return ACLLITE_OK;
 }
 
+AclLiteError DataInputThread::HandleDroppedMsg(shared_ptr<AclLiteMessage> &droppedMsg)
+{
+    // the oldest message dropped from the queue may be of any channel sharing it
+    if (droppedMsg->msgId != MSG_PREPROC_DETECTDATA) {
+        return ACLLITE_OK;
+    }
+    shared_ptr<DetectDataMsg> detectDataMsg = static_pointer_cast<DetectDataMsg>(droppedMsg->data);
+    AclLiteError ret;
+    if (detectDataMsg->isLastFrame) {
+        // the last frame message must not be dropped, it is queued again
+        do {
+            ret = SendMessageBlocking(detectDataMsg->detectPreThreadId, MSG_PREPROC_DETECTDATA,
+                                      detectDataMsg, kSendTimeoutMs);
+        } while (ret == ACLLITE_ERROR_ENQUEUE);
+    } else {
+        // the message number is numbered already, the output skips it instead of waiting for it
+        do {
+            ret = SendMessageBlocking(detectDataMsg->dataOutputThreadId, MSG_OUTPUT_DROPPED,
+                                      detectDataMsg, kSendTimeoutMs);
+        } while (ret == ACLLITE_ERROR_ENQUEUE);
+    }
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Send dropped message %d of channel %u failed, error %d",
+                          detectDataMsg->msgNum, detectDataMsg->channelId, ret);
+    }
+    return ret;
+}
+
 AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
     AclLiteError ret;
     if (detectDataMsg->isLastFrame == false) {
-        while (1) {
-            ret = SendMessage(detectDataMsg->detectPreThreadId, MSG_PREPROC_DETECTDATA, detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE) {
-                usleep(kSleepTime);
-                continue;
-            } else if(ret == ACLLITE_OK) {
-                break;
-            } else {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+        StampFrameStage(*detectDataMsg, STAGE_PRE_ENQUEUE);
+        shared_ptr<AclLiteMessage> droppedMsg = nullptr;
+        do {
+            ret = SendMessageBlocking(detectDataMsg->detectPreThreadId, MSG_PREPROC_DETECTDATA,
+                                      detectDataMsg, kSendTimeoutMs, queuePolicy_, &droppedMsg);
+        } while ((ret == ACLLITE_ERROR_ENQUEUE) && (queuePolicy_ == QUEUE_POLICY_BLOCK));
+        if (ret == ACLLITE_ERROR_ENQUEUE) {
+            // the frame is dropped, its message number is taken by the next frame
+            msgNum_--;
+        } else if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+            return ret;
+        }
+        if (droppedMsg != nullptr) {
+            ret = HandleDroppedMsg(droppedMsg);
+            if (ret != ACLLITE_OK) {
                 return ret;
             }
         }
@@ -341,18 +418,15 @@ AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
             return ret;
         }
     } else {
+        // the last frame message must not be dropped
         for (int i = 0; i < postThreadNum_; i++) {
-            while (1) {
-                ret = SendMessage(detectDataMsg->detectPreThreadId, MSG_PREPROC_DETECTDATA, detectDataMsg);
-                if (ret == ACLLITE_ERROR_ENQUEUE) {
-                    usleep(kSleepTime);
-                    continue;
-                } else if (ret == ACLLITE_OK) {
-                    break;
-                } else {
-                    ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-                    return ret;
-                }
+            do {
+                ret = SendMessageBlocking(detectDataMsg->detectPreThreadId, MSG_PREPROC_DETECTDATA,
+                                          detectDataMsg, kSendTimeoutMs);
+            } while (ret == ACLLITE_ERROR_ENQUEUE);
+            if (ret != ACLLITE_OK) {
+                ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+                return ret;
             }
         }
     }
@@ -33,7 +33,9 @@ class DataInputThread : public AclLiteThread {
 public:
     DataInputThread(int32_t deviceId, int32_t channelId, aclrtRunMode& runMode,
         std::string inputDataType, std::string inputDataPath,
-        std::string inferName, int postThreadNum, uint32_t batch, int framesPerSecond);
+        std::string inferName, int postThreadNum, uint32_t batch, int framesPerSecond,
+        AclLiteQueuePolicy queuePolicy = QUEUE_POLICY_BLOCK, std::string captureMode = "queue",
+        bool skipNonRefFrame = false, std::string videoDecoder = "dvpp", uint32_t swDecodeThreads = 0);
 
     ~DataInputThread();
     AclLiteError Init();
@@ -43,10 +45,12 @@ private:
     AclLiteError AppStart();
     AclLiteError MsgRead(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    AclLiteError HandleDroppedMsg(std::shared_ptr<AclLiteMessage> &droppedMsg);
     AclLiteError OpenPicsDir();
     AclLiteError OpenVideoCapture();
     AclLiteError ReadPic(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError ReadStream(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    AclLiteError ReadLatestFrame(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError GetOneFrame(std::shared_ptr<DetectDataMsg> &detectDataMsg);
 
 private:
@@ -78,6 +82,11 @@ private:
     int64_t realWaitTime_;
     int64_t waitTime_;
     int framesPerSecond_;
+    AclLiteQueuePolicy queuePolicy_;
+    std::string captureMode_;
+    bool skipNonRefFrame_;
+    std::string videoDecoder_;
+    uint32_t swDecodeThreads_;
 };
 
 #endif
\ No newline at end of file
@@ -16,6 +16,7 @@
 * File sample_process.cpp
 * Description: handle acl resource
 */
+#include <algorithm>
 #include <iostream>
 #include "acl/acl.h"
 #include "label.h"
@@ -27,16 +28,24 @@ using namespace std;
 namespace {
 const uint32_t kOutputWidth = 640;
 const uint32_t kOutputHeigth = 320;
-const uint32_t kSleepTime = 500;
+const uint32_t kSendTimeoutMs = 100;
 uint32_t kWaitTime = 1000;
 const uint32_t kOneSec = 1000000;
 const uint32_t kOneMSec = 1000;
 const uint32_t kCountFps = 100;
+// the messages waiting for a missing one hold decoded frames, skip the missing
+// message at once when the window is full
+const size_t kMaxReorderWindowSize = 32;
 }
 
-DataOutputThread::DataOutputThread(aclrtRunMode& runMode, string outputDataType, string outputPath, int postThreadNum)
-    :runMode_(runMode), outputDataType_(outputDataType),
-    outputPath_(outputPath), shutdown_(0), postNum_(postThreadNum)
+DataOutputThread::DataOutputThread(aclrtRunMode& runMode, string outputDataType, string outputPath,
+    int postThreadNum, AclLiteQueuePolicy displayQueuePolicy, string videoEncoder, uint32_t reorderWaitMs)
+    :runMode_(runMode), h264Writer_(nullptr), videoEncoder_(videoEncoder), outputDataType_(outputDataType),
+    outputPath_(outputPath), shutdown_(0), postNum_(postThreadNum),
+    displayQueuePolicy_(displayQueuePolicy), nextMsgNum_(0), reorderWaitMs_(reorderWaitMs),
+    waitingMissing_(false), lastMsgOutput_(false), isShutDown_(false), droppedMsgNum_(0), skippedMsgNum_(0),
+    lateMsgNum_(0), maxWindowSize_(0), outputFrameMetric_(nullptr), outputErrorMetric_(nullptr),
+    skippedMsgMetric_(nullptr), lateMsgMetric_(nullptr)
 {
 }
 
@@ -44,6 +53,7 @@ DataOutputThread::~DataOutputThread() {
     if (outputDataType_ == "video") {
         outputVideo_.release();
     }
+    CloseH264Writer();
 }
 
 AclLiteError DataOutputThread::SetOutputVideo()
@@ -69,6 +79,16 @@ AclLiteError DataOutputThread::Init()
     if (outputDataType_ == "imshow") {
         kWaitTime = 1;
     }
+    // the output fps is rate(detect_output_frames_total)
+    AclLiteMetrics& metrics = AclLiteMetrics::GetInstance();
+    string label = AclLiteMetrics::Label("thread", SelfInstanceName()) + "," +
+        AclLiteMetrics::Label("output", outputDataType_);
+    outputFrameMetric_ = metrics.GetCounter("detect_output_frames_total", "Frames written to the output", label);
+    outputErrorMetric_ = metrics.GetCounter("detect_output_errors_total", "Messages failed to be output", label);
+    skippedMsgMetric_ = metrics.GetCounter("detect_output_skipped_messages_total",
+        "Missing messages skipped by the output reorder window", label);
+    lateMsgMetric_ = metrics.GetCounter("detect_output_late_messages_total",
+        "Messages dropped for arriving after they were skipped", label);
     return ACLLITE_OK;
 }
 
@@ -77,14 +97,25 @@ AclLiteError DataOutputThread::Process(int msgId, shared_ptr<void> data)
     AclLiteError ret = ACLLITE_OK;
     switch (msgId) {
         case MSG_OUTPUT_FRAME:
+            if (isShutDown_) {
+                ACLLITE_LOG_WARNING("Drop the output message after the output is finished");
+                break;
+            }
             RecordQueue(static_pointer_cast<DetectDataMsg>(data));
             DataProcess();
+            TryShutDown();
+            break;
+        case MSG_OUTPUT_DROPPED:
+            if (isShutDown_) {
+                break;
+            }
+            RecordDropped(static_pointer_cast<DetectDataMsg>(data));
+            DataProcess();
+            TryShutDown();
             break;
         case MSG_ENCODE_FINISH:
             shutdown_++;
-            if (shutdown_ == postNum_) {
-                ShutDownProcess();
-            }
+            TryShutDown();
             break;
         default:
             ACLLITE_LOG_INFO("Detect PostprocessThread thread ignore msg %d", msgId);
@@ -94,17 +125,46 @@ AclLiteError DataOutputThread::Process(int msgId, shared_ptr<void> data)
     return ret;
 }
 
-AclLiteError DataOutputThread::ShutDownProcess()
+uint32_t DataOutputThread::IdleTimeoutMs()
 {
-    int flag = 0;
-    for (int i = 0; i < postNum_; i++) {
-        if (!postQueue_[i].empty()) {
-            shared_ptr<DetectDataMsg> detectDataMsg = postQueue_[i].front();
-            ProcessOutput(detectDataMsg);
-            postQueue_[i].pop();
-            flag++;
-        }
+    if (!waitingMissing_) {
+        return DEFAULT_IDLE_TIMEOUT_MS;
+    }
+    auto now = chrono::steady_clock::now();
+    if (now >= skipDeadline_) {
+        return 0;
+    }
+    int64_t remainUs = chrono::duration_cast<chrono::microseconds>(skipDeadline_ - now).count();
+    return (remainUs + kOneMSec - 1) / kOneMSec;
+}
+
+AclLiteError DataOutputThread::Idle()
+{
+    if (waitingMissing_ && (chrono::steady_clock::now() >= skipDeadline_)) {
+        SkipMissingMsg();
+        DataProcess();
+        TryShutDown();
+    }
+    return ACLLITE_OK;
+}
+
+void DataOutputThread::TryShutDown()
+{
+    // every post thread has finished and the last message is output in order
+    if (isShutDown_ || (shutdown_ < postNum_) || !lastMsgOutput_) {
+        return;
     }
+    ShutDownProcess();
+}
+
+AclLiteError DataOutputThread::ShutDownProcess()
+{
+    isShutDown_ = true;
+    ACLLITE_LOG_INFO("Output reorder: %d messages, %u dropped by input, %u missing skipped, "
+                     "%u late dropped, max window %zu",
+                     nextMsgNum_, droppedMsgNum_, skippedMsgNum_, lateMsgNum_, maxWindowSize_);
+    // the queued frames are encoded and the stream is flushed before exit
+    CloseH264Writer();
     if (outputDataType_ != "rtsp") {
         SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr);
     }
@@ -113,29 +173,97 @@ AclLiteError DataOutputThread::ShutDownProcess()
 
 AclLiteError DataOutputThread::RecordQueue(shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    if (detectDataMsg->postId >= postNum_) {
-        ACLLITE_LOG_ERROR("Support up to 4 post-processing of 1 inputdata.");
-        return ACLLITE_ERROR;
+    if (detectDataMsg->msgNum < nextMsgNum_) {
+        // the message has been skipped, output it now would break the order
+        if (detectDataMsg->isLastFrame) {
+            lastMsgOutput_ = true;
+            return ProcessOutput(detectDataMsg);
+        }
+        lateMsgNum_++;
+        lateMsgMetric_->Add();
+        ACLLITE_LOG_WARNING("Drop the late message %d of channel %u, the output is at %d",
+                            detectDataMsg->msgNum, detectDataMsg->channelId, nextMsgNum_);
+        return ACLLITE_OK;
     }
-    postQueue_[detectDataMsg->postId].push(detectDataMsg);
+    reorderWindow_[detectDataMsg->msgNum] = detectDataMsg;
+    maxWindowSize_ = max(maxWindowSize_, reorderWindow_.size());
     return ACLLITE_OK;
 }
 
-AclLiteError DataOutputThread::DataProcess()
+void DataOutputThread::RecordDropped(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    // the message is dropped before preprocess, the window passes its number without output
+    droppedMsgNum_++;
+    if (detectDataMsg->msgNum >= nextMsgNum_) {
+        reorderWindow_[detectDataMsg->msgNum] = nullptr;
+    }
+}
+
+void DataOutputThread::SkipMissingMsg()
 {
-    int flag = 0;
-    for (int i = 0; i < postNum_; i++) {
-        if (!postQueue_[i].empty())
-            flag++;
+    if (reorderWindow_.empty()) {
+        return;
     }
-    if (flag == postNum_) {
-        for (int i = 0; i < postNum_; i++) {
-            shared_ptr<DetectDataMsg> detectDataMsg = postQueue_[i].front();
-            ProcessOutput(detectDataMsg);
-            postQueue_[i].pop();
+    int msgNum = reorderWindow_.begin()->first;
+    skippedMsgNum_ += msgNum - nextMsgNum_;
+    skippedMsgMetric_->Add(msgNum - nextMsgNum_);
+    ACLLITE_LOG_WARNING("Skip the missing messages [%d, %d) of output, %zu messages are waiting",
+                        nextMsgNum_, msgNum, reorderWindow_.size());
+    nextMsgNum_ = msgNum;
+    waitingMissing_ = false;
+}
+
+AclLiteError DataOutputThread::DataProcess()
+{
+    while (true) {
+        while (!reorderWindow_.empty() && (reorderWindow_.begin()->first == nextMsgNum_)) {
+            shared_ptr<DetectDataMsg> detectDataMsg = reorderWindow_.begin()->second;
+            reorderWindow_.erase(reorderWindow_.begin());
+            nextMsgNum_++;
+            waitingMissing_ = false;
+            if (detectDataMsg == nullptr) {
+                continue;
+            }
+            if (detectDataMsg->isLastFrame) {
+                lastMsgOutput_ = true;
+            }
+            RecordOutput(*detectDataMsg, ProcessOutput(detectDataMsg));
+            RecordLatency(*detectDataMsg);
+        }
+        if (reorderWindow_.empty()) {
+            return ACLLITE_OK;
         }
+        // a message before the window is still in post processing or lost
+        if (!waitingMissing_) {
+            waitingMissing_ = true;
+            skipDeadline_ = chrono::steady_clock::now() + chrono::milliseconds(reorderWaitMs_);
+        }
+        if ((reorderWindow_.size() < kMaxReorderWindowSize) && (reorderWaitMs_ > 0)) {
+            return ACLLITE_OK;
+        }
+        SkipMissingMsg();
+    }
+}
+
+void DataOutputThread::RecordOutput(DetectDataMsg& detectDataMsg, AclLiteError ret)
+{
+    if (ret != ACLLITE_OK) {
+        outputErrorMetric_->Add();
+    } else {
+        outputFrameMetric_->Add(detectDataMsg.decodedImg.size());
+    }
+}
+
+void DataOutputThread::RecordLatency(DetectDataMsg& detectDataMsg)
+{
+    if (!LatencyTracer::IsEnabled()) {
+        return;
+    }
+    StampFrameStage(detectDataMsg, STAGE_OUTPUT);
+    if (detectDataMsg.stageTimeUs[STAGE_OUTPUT] != 0) {
+        LatencyTracer::GetInstance().Record(detectDataMsg.channelId, detectDataMsg.msgNum,
+                                            detectDataMsg.stageTimeUs);
     }
-    return ACLLITE_OK;
 }
 
 AclLiteError DataOutputThread::ProcessOutput(shared_ptr<DetectDataMsg> detectDataMsg)
@@ -147,6 +275,12 @@ AclLiteError DataOutputThread::ProcessOutput(shared_ptr<DetectDataMsg> detectDat
             ACLLITE_LOG_ERROR("Draw classify result on video failed, error %d", ret);
             return ACLLITE_ERROR;
         }
+    } else if (outputDataType_ == "h264file") {
+        ret = SaveResultH264(detectDataMsg);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Encode result to h264 file failed, error %d", ret);
+            return ACLLITE_ERROR;
+        }
     } else if (outputDataType_ == "pic") {
         ret = SaveResultPic(detectDataMsg);
         if (ret != ACLLITE_OK) {
@@ -187,6 +321,64 @@ AclLiteError DataOutputThread::SaveResultVideo(shared_ptr<DetectDataMsg> &detect
     return ACLLITE_OK;
 }
 
+AclLiteError DataOutputThread::OpenH264Writer(const ImageData& image)
+{
+    VencConfig vencConfig;
+    vencConfig.maxWidth = image.width;
+    vencConfig.maxHeight = image.height;
+    vencConfig.outFile = outputPath_;
+    vencConfig.runMode = runMode_;
+    vencConfig.swEncode = (videoEncoder_ == "sw");
+    aclError aclRet = aclrtGetCurrentContext(&vencConfig.context);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Get current acl context failed, error %d", aclRet);
+        return ACLLITE_ERROR_GET_ACL_CONTEXT;
+    }
+    h264Writer_ = new AclLiteVideoProc(vencConfig, vencConfig.context);
+    if (!h264Writer_->IsOpened() && !vencConfig.swEncode) {
+        // the dvpp venc is not available, encode on cpu instead
+        ACLLITE_LOG_WARNING("Open dvpp venc for %s failed, use libx264 instead", outputPath_.c_str());
+        delete h264Writer_;
+        vencConfig.swEncode = true;
+        h264Writer_ = new AclLiteVideoProc(vencConfig, vencConfig.context);
+    }
+    if (!h264Writer_->IsOpened()) {
+        ACLLITE_LOG_ERROR("Open h264 writer for %s failed", outputPath_.c_str());
+        delete h264Writer_;
+        h264Writer_ = nullptr;
+        return ACLLITE_ERROR;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError DataOutputThread::SaveResultH264(shared_ptr<DetectDataMsg> &detectDataMsg)
+{
+    // the post thread has drawn the detections on the NV12 images, the encoder
+    // keeps a reference of every image until it is encoded
+    for (size_t i = 0; i < detectDataMsg->yuvFrame.size(); i++) {
+        ImageData& image = detectDataMsg->yuvFrame[i];
+        if (h264Writer_ == nullptr) {
+            AclLiteError ret = OpenH264Writer(image);
+            if (ret != ACLLITE_OK) {
+                return ret;
+            }
+        }
+        AclLiteError ret = h264Writer_->Read(image);
+        if (ret != ACLLITE_OK) {
+            return ret;
+        }
+    }
+    return ACLLITE_OK;
+}
+
+void DataOutputThread::CloseH264Writer()
+{
+    if (h264Writer_ != nullptr) {
+        delete h264Writer_;
+        h264Writer_ = nullptr;
+    }
+}
+
 AclLiteError DataOutputThread::SaveResultPic(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
     for(int i = 0; i < detectDataMsg->frame.size(); i++) {
@@ -216,9 +408,12 @@ AclLiteError DataOutputThread::PrintResult(shared_ptr<DetectDataMsg> &detectData
             if (lastRecordTime_ == 0) {
                 lastRecordTime_ = now;
             } else {
-                uint32_t fps = kCountFps / ((now - lastRecordTime_) / kOneMSec);
+                // now is in milliseconds
+                double fps = (now > lastRecordTime_) ? (kCountFps * kOneMSec * 1.0 / (now - lastRecordTime_)) : 0;
                 lastRecordTime_ = now;
-                detectDataMsg->textPrint[i] = detectDataMsg->textPrint[i] + "[fps:" + to_string(fps) + "]";
+                char fpsText[32];
+                snprintf(fpsText, sizeof(fpsText), "[fps:%.1f]", fps);
+                detectDataMsg->textPrint[i] = detectDataMsg->textPrint[i] + fpsText;
             }
         }
         frameCnt_++;
@@ -240,19 +435,15 @@ AclLiteError DataOutputThread::SendCVImshow(shared_ptr<DetectDataMsg> &detectDat
 AclLiteError DataOutputThread::DisplayMsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 {
     AclLiteError ret;
-    while (1) {
-        if (outputDataType_ == "rtsp") {
-            ret = SendMessage(detectDataMsg->rtspDisplayThreadId, MSG_RTSP_DISPLAY, detectDataMsg);
-        }
-        if (ret == ACLLITE_ERROR_ENQUEUE) {
-            usleep(kSleepTime);
-            continue;
-        } else if (ret == ACLLITE_OK) {
-            break;
-        } else {
-            ACLLITE_LOG_ERROR("Send rtsp display message failed, error %d", ret);
-            return ret;
-        }
+    // the last frame message ends the rtsp stream, it must not be dropped
+    AclLiteQueuePolicy policy = detectDataMsg->isLastFrame ? QUEUE_POLICY_BLOCK : displayQueuePolicy_;
+    do {
+        ret = SendMessageBlocking(detectDataMsg->rtspDisplayThreadId, MSG_RTSP_DISPLAY,
+                                  detectDataMsg, kSendTimeoutMs, policy);
+    } while ((ret == ACLLITE_ERROR_ENQUEUE) && (policy == QUEUE_POLICY_BLOCK));
+    if ((ret != ACLLITE_OK) && (ret != ACLLITE_ERROR_ENQUEUE)) {
+        ACLLITE_LOG_ERROR("Send rtsp display message failed, error %d", ret);
+        return ret;
     }
 
     return ACLLITE_OK;
@@ -20,35 +20,49 @@
 #define DATAOUTPUTTHREAD_H
 #pragma once
 
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <mutex>
-#include <queue>
 #include <unistd.h>
 #include "acl/acl.h"
 #include "Params.h"
 #include "AclLiteError.h"
 #include "AclLiteUtils.h"
 #include "AclLiteThread.h"
+#include "AclLiteMetrics.h"
 #include "AclLiteApp.h"
+#include "AclLiteVideoProc.h"
 
 class DataOutputThread : public AclLiteThread {
 public:
     DataOutputThread(aclrtRunMode& runMode,
         std::string outputDataType, std::string outputPath,
-        int postThreadNum);
+        int postThreadNum, AclLiteQueuePolicy displayQueuePolicy = QUEUE_POLICY_BLOCK,
+        std::string videoEncoder = "dvpp", uint32_t reorderWaitMs = 1000);
     ~DataOutputThread();
 
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
+    uint32_t IdleTimeoutMs();
+    AclLiteError Idle();
 
 private:
     AclLiteError SetOutputVideo();
     AclLiteError ShutDownProcess();
     AclLiteError RecordQueue(std::shared_ptr<DetectDataMsg> detectDataMsg);
     AclLiteError DataProcess();
+    void RecordDropped(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    void SkipMissingMsg();
+    void TryShutDown();
     AclLiteError ProcessOutput(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    void RecordLatency(DetectDataMsg& detectDataMsg);
+    void RecordOutput(DetectDataMsg& detectDataMsg, AclLiteError ret);
 
     AclLiteError SaveResultVideo(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    AclLiteError OpenH264Writer(const ImageData& image);
+    AclLiteError SaveResultH264(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    void CloseH264Writer();
     AclLiteError SaveResultPic(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError PrintResult(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError SendCVImshow(std::shared_ptr<DetectDataMsg> &detectDataMsg);
@@ -58,11 +72,30 @@ private:
 private:
     aclrtRunMode runMode_;
     cv::VideoWriter outputVideo_;
+    AclLiteVideoProc* h264Writer_; // dvpp venc or libx264, created by the first frame
+    std::string videoEncoder_;
     std::string outputDataType_;
     std::string outputPath_;
     int shutdown_;
     int postNum_;
-    std::queue<std::shared_ptr<DetectDataMsg>> postQueue_[4];
+    AclLiteQueuePolicy displayQueuePolicy_;
+    // the post threads finish out of order, the messages wait here by msgNum
+    // until all the messages before them are output or skipped, nullptr: dropped by input
+    std::map<int, std::shared_ptr<DetectDataMsg>> reorderWindow_;
+    int nextMsgNum_;
+    uint32_t reorderWaitMs_;
+    bool waitingMissing_;
+    std::chrono::steady_clock::time_point skipDeadline_;
+    bool lastMsgOutput_;
+    bool isShutDown_;
+    uint32_t droppedMsgNum_;
+    uint32_t skippedMsgNum_;
+    uint32_t lateMsgNum_;
+    MetricCounter* outputFrameMetric_;
+    MetricCounter* outputErrorMetric_;
+    MetricCounter* skippedMsgMetric_;
+    MetricCounter* lateMsgMetric_;
+    size_t maxWindowSize_;
     uint32_t frameCnt_;
     int64_t lastDecodeTime_;
     int64_t lastRecordTime_;
@@ -0,0 +1,240 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File detectBatchInput.cpp
+* Description: model batch buffers written by the preprocess threads in place
+*/
+#include "acl/ops/acl_dvpp.h"
+#include "AclLiteUtils.h"
+#include "detectBatchInput.h"
+
+using namespace std;
+
+namespace {
+    // a reserved message lost on the way is not waited for longer than this after the deadline
+    const uint32_t kLateMsgWaitMs = 1000;
+    const uint32_t kUsPerMs = 1000;
+}
+
+DetectBatchInput::DetectBatchInput(uint32_t batch, uint32_t bufferNum, uint32_t timeoutMs)
+    :batch_(batch), bufferNum_(bufferNum), timeoutMs_(timeoutMs), imgSize_(0),
+    openSeq_(-1), nextSeq_(0)
+{
+}
+
+DetectBatchInput::~DetectBatchInput()
+{
+    Release();
+}
+
+AclLiteError DetectBatchInput::Init(uint32_t imgSize)
+{
+    lock_guard<mutex> lock(mutex_);
+    if ((imgSize == 0) || (bufferNum_ == 0)) {
+        ACLLITE_LOG_ERROR("Invalid batch input, image size %u, buffer num %u", imgSize, bufferNum_);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    // vpc writes the images, so the buffers are dvpp memory
+    uint32_t bufferSize = batch_ * imgSize;
+    for (uint32_t i = 0; i < bufferNum_; i++) {
+        void* buf = nullptr;
+        aclError aclRet = acldvppMalloc(&buf, bufferSize);
+        if ((buf == nullptr) || (aclRet != ACL_SUCCESS)) {
+            ACLLITE_LOG_ERROR("Malloc inference batch buffer failed, error %d", aclRet);
+            for (size_t j = 0; j < buffers_.size(); j++) {
+                (void)acldvppFree(buffers_[j]);
+            }
+            buffers_.clear();
+            return ACLLITE_ERROR_MALLOC_DVPP;
+        }
+        // the images not reserved in a batch are inferred but not sent to any channel
+        (void)aclrtMemset(buf, bufferSize, 0, bufferSize);
+        buffers_.push_back((uint8_t *)buf);
+    }
+    batches_.resize(bufferNum_);
+    imgSize_ = imgSize;
+    freed_.notify_all();
+    return ACLLITE_OK;
+}
+
+void DetectBatchInput::Release()
+{
+    lock_guard<mutex> lock(mutex_);
+    for (size_t i = 0; i < buffers_.size(); i++) {
+        (void)acldvppFree(buffers_[i]);
+    }
+    buffers_.clear();
+    batches_.clear();
+    order_.clear();
+    openSeq_ = -1;
+    imgSize_ = 0;
+    freed_.notify_all();
+}
+
+void DetectBatchInput::Close(Batch& batch)
+{
+    batch.state = BATCH_CLOSED;
+    if (batch.seq == openSeq_) {
+        openSeq_ = -1;
+    }
+}
+
+AclLiteError DetectBatchInput::Reserve(shared_ptr<DetectDataMsg> detectDataMsg, uint32_t imgSize,
+                                       uint8_t*& buffer, uint32_t timeoutMs)
+{
+    buffer = nullptr;
+    uint32_t imgNum = detectDataMsg->decodedImg.size();
+    if ((imgNum == 0) || (imgNum > batch_)) {
+        ACLLITE_LOG_ERROR("Channel %u message with %u images does not fit the model batch %u",
+                          detectDataMsg->channelId, imgNum, batch_);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    auto waitEnd = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        // the buffers are malloced by the inference thread init
+        if (!buffers_.empty()) {
+            if (imgSize != imgSize_) {
+                ACLLITE_LOG_ERROR("Channel %u image size %u is not the model input size %u",
+                                  detectDataMsg->channelId, imgSize, imgSize_);
+                return ACLLITE_ERROR_INVALID_ARGS;
+            }
+            if ((openSeq_ >= 0) && (batches_[openSeq_ % bufferNum_].imgNum + imgNum > batch_)) {
+                Close(batches_[openSeq_ % bufferNum_]);
+            }
+            // the oldest batch is freed first, so the next seq is the next free buffer
+            Batch& next = batches_[nextSeq_ % bufferNum_];
+            if ((openSeq_ < 0) && (next.state == BATCH_FREE)) {
+                next.seq = nextSeq_++;
+                next.state = BATCH_OPEN;
+                next.deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs_);
+                order_.push_back(next.seq);
+                openSeq_ = next.seq;
+            }
+            if (openSeq_ >= 0) {
+                break;
+            }
+        }
+        if (freed_.wait_until(lock, waitEnd) == cv_status::timeout) {
+            return ACLLITE_ERROR_ENQUEUE;
+        }
+    }
+    Batch& open = batches_[openSeq_ % bufferNum_];
+    detectDataMsg->batchSeq = open.seq;
+    detectDataMsg->batchImgIndex = open.imgNum;
+    buffer = buffers_[openSeq_ % bufferNum_] + open.imgNum * imgSize_;
+    open.imgNum += imgNum;
+    open.reservedMsgNum++;
+    if (open.imgNum == batch_) {
+        Close(open);
+    }
+    return ACLLITE_OK;
+}
+
+bool DetectBatchInput::Arrive(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (batches_.empty() || (detectDataMsg->batchSeq < 0)) {
+        return false;
+    }
+    Batch& batch = batches_[detectDataMsg->batchSeq % bufferNum_];
+    if ((batch.seq != detectDataMsg->batchSeq) ||
+        ((batch.state != BATCH_OPEN) && (batch.state != BATCH_CLOSED))) {
+        return false;
+    }
+    batch.msgs.push_back(detectDataMsg);
+    batch.arrivedMsgNum++;
+    return true;
+}
+
+bool DetectBatchInput::AppendToLatest(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (order_.empty()) {
+        return false;
+    }
+    batches_[order_.back() % bufferNum_].msgs.push_back(detectDataMsg);
+    return true;
+}
+
+bool DetectBatchInput::PopReady(int64_t& batchSeq, vector<shared_ptr<DetectDataMsg>>& msgs, uint32_t& imgNum)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (order_.empty()) {
+        return false;
+    }
+    Batch& batch = batches_[order_.front() % bufferNum_];
+    auto now = chrono::steady_clock::now();
+    if ((batch.state == BATCH_OPEN) && (now >= batch.deadline)) {
+        Close(batch);
+    }
+    if (batch.state != BATCH_CLOSED) {
+        return false;
+    }
+    if (batch.arrivedMsgNum < batch.reservedMsgNum) {
+        if (now < batch.deadline + chrono::milliseconds(kLateMsgWaitMs)) {
+            return false;
+        }
+        ACLLITE_LOG_WARNING("Batch %ld executed with %u of %u reserved messages arrived",
+                            batch.seq, batch.arrivedMsgNum, batch.reservedMsgNum);
+    }
+    order_.pop_front();
+    batch.state = BATCH_RUNNING;
+    batchSeq = batch.seq;
+    imgNum = batch.imgNum;
+    msgs.swap(batch.msgs);
+    batch.msgs.clear();
+    return true;
+}
+
+void DetectBatchInput::Free(int64_t batchSeq)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (batches_.empty() || (batchSeq < 0)) {
+        return;
+    }
+    Batch& batch = batches_[batchSeq % bufferNum_];
+    if (batch.seq != batchSeq) {
+        return;
+    }
+    batch.state = BATCH_FREE;
+    batch.imgNum = 0;
+    batch.reservedMsgNum = 0;
+    batch.arrivedMsgNum = 0;
+    batch.msgs.clear();
+    freed_.notify_all();
+}
+
+uint32_t DetectBatchInput::WaitTimeMs()
+{
+    lock_guard<mutex> lock(mutex_);
+    if (order_.empty()) {
+        return DEFAULT_IDLE_TIMEOUT_MS;
+    }
+    Batch& batch = batches_[order_.front() % bufferNum_];
+    auto readyTime = batch.deadline;
+    if (batch.state == BATCH_CLOSED) {
+        if (batch.arrivedMsgNum == batch.reservedMsgNum) {
+            return 0;
+        }
+        readyTime += chrono::milliseconds(kLateMsgWaitMs);
+    }
+    auto now = chrono::steady_clock::now();
+    if (now >= readyTime) {
+        return 0;
+    }
+    int64_t remainUs = chrono::duration_cast<chrono::microseconds>(readyTime - now).count();
+    return (remainUs + kUsPerMs - 1) / kUsPerMs;
+}
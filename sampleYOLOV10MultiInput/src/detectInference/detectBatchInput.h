@@ -0,0 +1,152 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File detectBatchInput.h
+* Description: model batch buffers written by the preprocess threads in place
+*/
+#ifndef DETECTBATCHINPUT_H
+#define DETECTBATCHINPUT_H
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "acl/acl.h"
+#include "AclLiteError.h"
+#include "AclLiteThread.h"
+#include "Params.h"
+
+/**
+* DetectBatchInput
+* The model batch buffers of an inference thread gathering the frames of several
+* channels. The preprocess thread of a channel reserves the images of its message
+* in the open batch and vpc writes them there, so the batch is executed without
+* copying the frames into it. A batch is closed when it is full or timeoutMs after
+* its first reservation, and is ready when all its reserved messages have arrived
+* at the inference thread. The batches are executed in the reservation order, so
+* the frames of every channel stay in order.
+*/
+class DetectBatchInput {
+public:
+    DetectBatchInput(uint32_t batch, uint32_t bufferNum, uint32_t timeoutMs);
+    ~DetectBatchInput();
+
+    /**
+    * @brief malloc the batch buffers in the current context, called by the inference thread
+    * @param [in]: imgSize: the model input size of one image
+    * @return ACLLITE_OK: success; others: malloc failed
+    */
+    AclLiteError Init(uint32_t imgSize);
+
+    /**
+    * @brief free the batch buffers, the reservations fail after it
+    */
+    void Release();
+
+    /**
+    * @brief reserve the images of a message in the open batch, called by the preprocess
+    * thread, the batch and the image index are set to the message
+    * @param [in]: detectDataMsg: the message
+    * @param [in]: imgSize: the model input size of one image
+    * @param [out]: buffer: the address of the first image of the message
+    * @param [in]: timeoutMs: the max wait time when all the batches are in use
+    * @return ACLLITE_OK: success; ACLLITE_ERROR_ENQUEUE: no batch is free after timeout;
+    * others: the message does not fit the batches
+    */
+    AclLiteError Reserve(std::shared_ptr<DetectDataMsg> detectDataMsg, uint32_t imgSize,
+                         uint8_t*& buffer, uint32_t timeoutMs);
+
+    /**
+    * @brief the message with reserved images arrived at the inference thread
+    * @param [in]: detectDataMsg: the message
+    * @return true: it is sent with its batch; false: its batch is not pending any more
+    */
+    bool Arrive(std::shared_ptr<DetectDataMsg> detectDataMsg);
+
+    /**
+    * @brief keep a message behind the frames of the batches not executed yet
+    * @param [in]: detectDataMsg: the message
+    * @return true: it is sent with the latest batch; false: no batch is pending
+    */
+    bool AppendToLatest(std::shared_ptr<DetectDataMsg> detectDataMsg);
+
+    /**
+    * @brief take the oldest batch if it is ready
+    * @param [out]: batchSeq: the batch
+    * @param [out]: msgs: the messages of the batch, in arrival order
+    * @param [out]: imgNum: the images reserved in the batch
+    * @return true: a batch is taken, it is freed by Free after its inference
+    */
+    bool PopReady(int64_t& batchSeq, std::vector<std::shared_ptr<DetectDataMsg>>& msgs, uint32_t& imgNum);
+
+    /**
+    * @brief reuse a batch taken by PopReady
+    * @param [in]: batchSeq: the batch
+    */
+    void Free(int64_t batchSeq);
+
+    uint8_t* GetBuffer(int64_t batchSeq)
+    {
+        return buffers_[batchSeq % bufferNum_];
+    }
+
+    uint32_t GetBufferSize()
+    {
+        return batch_ * imgSize_;
+    }
+
+    /**
+    * @brief the time until the oldest batch may become ready without a new message
+    * @return the wait time in ms; DEFAULT_IDLE_TIMEOUT_MS: no batch is pending
+    */
+    uint32_t WaitTimeMs();
+
+private:
+    enum BatchState {
+        BATCH_FREE = 0,
+        BATCH_OPEN,  // accepting reservations
+        BATCH_CLOSED,  // waiting for the reserved messages
+        BATCH_RUNNING,  // taken by PopReady
+    };
+    // the batches are executed and freed in order, so the batch seq uses the buffer seq % bufferNum
+    struct Batch {
+        int64_t seq = -1;
+        BatchState state = BATCH_FREE;
+        uint32_t imgNum = 0;
+        uint32_t reservedMsgNum = 0;
+        uint32_t arrivedMsgNum = 0;
+        std::vector<std::shared_ptr<DetectDataMsg>> msgs;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    void Close(Batch& batch);
+
+private:
+    uint32_t batch_;
+    uint32_t bufferNum_;
+    uint32_t timeoutMs_;
+    uint32_t imgSize_;
+    std::vector<uint8_t*> buffers_;
+    std::vector<Batch> batches_;
+    std::deque<int64_t> order_;  // the open and closed batches, the oldest first
+    int64_t openSeq_;  // -1: no batch is open
+    int64_t nextSeq_;
+    std::mutex mutex_;
+    std::condition_variable freed_;
+};
+
+#endif
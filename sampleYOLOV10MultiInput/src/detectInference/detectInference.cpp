@@ -25,33 +25,82 @@
 #include "AclLiteModel.h"
 #include "Params.h"
 #include "detectInference.h"
+#include "../detectPostprocess/detectPostprocessPool.h"
 
 using namespace std;
 
 namespace {
-const uint32_t kSleepTime = 500;
+const uint32_t kSendTimeoutMs = 100;
+const uint64_t kFillRateLogInterval = 100;
+const uint32_t kPercent = 100;
 }
 
-DetectInferenceThread::DetectInferenceThread(string modelPath)
-    :model_(modelPath), isReleased(false)
+DetectInferenceThread::DetectInferenceThread(string modelPath, uint32_t batch,
+    uint32_t batchTimeoutMs, uint32_t asyncSlotNum)
+    :model_(modelPath), isReleased(false), batch_(batch), batchTimeoutMs_(batchTimeoutMs),
+    asyncSlotNum_(asyncSlotNum), batchInput_(nullptr),
+    nextSlot_(0), inFlightNum_(0), batchCnt_(0), batchImgCnt_(0),
+    batchMetric_(nullptr), batchImgMetric_(nullptr)
 {
+    if (batchTimeoutMs_ > 0) {
+        // every slot in flight holds a batch, one more batch is written by the preprocess threads
+        uint32_t bufferNum = ((asyncSlotNum_ > 0) ? asyncSlotNum_ : 1) + 1;
+        batchInput_ = make_shared<DetectBatchInput>(batch_, bufferNum, batchTimeoutMs_);
+    }
 }
 
 DetectInferenceThread::~DetectInferenceThread()
 {
     if(!isReleased) {
         model_.DestroyResource();
+        if (batchInput_ != nullptr) {
+            batchInput_->Release();
+        }
     }
     isReleased = true;
 }
 
 AclLiteError DetectInferenceThread::Init()
 {
+    // the batch fill rate is images_total / (batches_total * batch_size)
+    AclLiteMetrics& metrics = AclLiteMetrics::GetInstance();
+    string label = AclLiteMetrics::Label("thread", SelfInstanceName());
+    batchMetric_ = metrics.GetCounter("detect_infer_batches_total", "Model executions of the inference thread", label);
+    batchImgMetric_ = metrics.GetCounter("detect_infer_images_total", "Images inferred by the inference thread", label);
+    metrics.GetGauge("detect_infer_batch_size", "Model batch size of the inference thread", label)->Set(batch_);
     AclLiteError ret = model_.Init();
     if (ret != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("Model init failed, error:%d", ret);
         return ret;
     }
+    outputInfo_ = make_shared<vector<ModelOutputInfo>>();
+    ret = model_.GetModelOutputInfo(*outputInfo_);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Get model output info failed, error:%d", ret);
+        return ret;
+    }
+    if (asyncSlotNum_ > 0) {
+        ret = model_.InitAsync(asyncSlotNum_);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Model async execution init failed, error:%d", ret);
+            return ret;
+        }
+        slotMsgs_.resize(asyncSlotNum_);
+        slotBatchSeqs_.resize(asyncSlotNum_, -1);
+    }
+    if (batchInput_ == nullptr) {
+        return ACLLITE_OK;
+    }
+    uint32_t modelInputSize = model_.GetModelInputSize(0);
+    if ((modelInputSize == 0) || (modelInputSize % batch_ != 0)) {
+        ACLLITE_LOG_ERROR("Invalid model input size %u for batch %u", modelInputSize, batch_);
+        return ACLLITE_ERROR;
+    }
+    ret = batchInput_->Init(modelInputSize / batch_);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Batch input init failed, error:%d", ret);
+        return ret;
+    }
     return ACLLITE_OK;
 }
 
@@ -75,28 +124,259 @@ AclLiteError DetectInferenceThread::ModelExecute(shared_ptr<DetectDataMsg> detec
 
 AclLiteError DetectInferenceThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    while (1) {
-        AclLiteError ret = SendMessage(detectDataMsg->detectPostThreadId, MSG_POSTPROC_DETECTDATA, detectDataMsg);
-        if (ret == ACLLITE_ERROR_ENQUEUE) {
-            usleep(kSleepTime);
+    AclLiteError ret;
+    detectDataMsg->modelOutputInfo = outputInfo_;
+    StampFrameStage(*detectDataMsg, STAGE_INFER_DONE);
+    DetectPostprocessPool& postPool = DetectPostprocessPool::GetInstance();
+    if (postPool.HasChannel(detectDataMsg->channelId)) {
+        ret = postPool.Submit(detectDataMsg);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Submit message to postprocess pool failed, error %d", ret);
+        }
+        return ret;
+    }
+    do {
+        ret = SendMessageBlocking(detectDataMsg->detectPostThreadId, MSG_POSTPROC_DETECTDATA,
+                                  detectDataMsg, kSendTimeoutMs);
+    } while (ret == ACLLITE_ERROR_ENQUEUE);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+        return ret;
+    }
+
+    return ACLLITE_OK;
+}
+
+AclLiteError DetectInferenceThread::SendAfterInFlight(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    // the message without image must not overtake the frames of its channel in flight,
+    // it is sent when the latest slot is finished
+    if (inFlightNum_ == 0) {
+        return MsgSend(detectDataMsg);
+    }
+    uint32_t latestSlot = (nextSlot_ + asyncSlotNum_ - 1) % asyncSlotNum_;
+    slotMsgs_[latestSlot].push_back(detectDataMsg);
+    return ACLLITE_OK;
+}
+
+AclLiteError DetectInferenceThread::AsyncExecute(vector<shared_ptr<DetectDataMsg>>& msgs,
+                                                 void* input, uint32_t inputSize, int64_t batchSeq)
+{
+    if (inFlightNum_ == asyncSlotNum_) {
+        FinishOldestSlot();
+    }
+    vector<DataInfo> inputData = {{input, inputSize}};
+    AclLiteError ret = model_.ExecuteAsync(nextSlot_, inputData);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Launch detect model inference failed, error: %d", ret);
+        // keep the message order of the channels, send them after the slots in flight
+        for (size_t i = 0; i < msgs.size(); i++) {
+            SendAfterInFlight(msgs[i]);
+        }
+        msgs.clear();
+        if (batchSeq >= 0) {
+            batchInput_->Free(batchSeq);
+        }
+        return ret;
+    }
+    // the messages or the batch keep the input buffer alive until the slot is finished
+    slotBatchSeqs_[nextSlot_] = batchSeq;
+    slotMsgs_[nextSlot_].swap(msgs);
+    msgs.clear();
+    nextSlot_ = (nextSlot_ + 1) % asyncSlotNum_;
+    inFlightNum_++;
+    return ACLLITE_OK;
+}
+
+AclLiteError DetectInferenceThread::FinishOldestSlot()
+{
+    if (inFlightNum_ == 0) {
+        return ACLLITE_OK;
+    }
+    uint32_t slot = (nextSlot_ + asyncSlotNum_ - inFlightNum_) % asyncSlotNum_;
+    vector<InferenceOutput> batchOutput;
+    AclLiteError ret = model_.WaitAsync(slot, batchOutput);
+    inFlightNum_--;
+    if (slotBatchSeqs_[slot] >= 0) {
+        batchInput_->Free(slotBatchSeqs_[slot]);
+        slotBatchSeqs_[slot] = -1;
+    }
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Execute detect model inference failed, error: %d", ret);
+    } else if (batchInput_ != nullptr) {
+        ScatterOutput(slotMsgs_[slot], batchOutput);
+    } else {
+        for (size_t i = 0; i < slotMsgs_[slot].size(); i++) {
+            if (!slotMsgs_[slot][i]->decodedImg.empty()) {
+                slotMsgs_[slot][i]->inferenceOutput = batchOutput;
+            }
+        }
+    }
+    // send the messages even if the inference failed, so the channels do not wait for them
+    for (size_t i = 0; i < slotMsgs_[slot].size(); i++) {
+        MsgSend(slotMsgs_[slot][i]);
+    }
+    slotMsgs_[slot].clear();
+    return ret;
+}
+
+AclLiteError DetectInferenceThread::SendAfterBatches(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    // keep the message behind the frames of its channel in the pending batches
+    if (batchInput_->AppendToLatest(detectDataMsg)) {
+        return ACLLITE_OK;
+    }
+    return (asyncSlotNum_ > 0) ? SendAfterInFlight(detectDataMsg) : MsgSend(detectDataMsg);
+}
+
+AclLiteError DetectInferenceThread::GatherMsg(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    // the images of the message are already in its batch, written by the preprocess thread
+    AclLiteError ret = ACLLITE_OK;
+    if (detectDataMsg->decodedImg.empty()) {
+        // the last frame message has no image, keep it behind the frames of its channel
+        SendAfterBatches(detectDataMsg);
+    } else if (!batchInput_->Arrive(detectDataMsg)) {
+        // the preprocess failed or the batch was executed without the frame,
+        // send it without inference so the channel does not lose it
+        ACLLITE_LOG_WARNING("Channel %u frame %d is not in a pending batch, send it without inference",
+                            detectDataMsg->channelId, detectDataMsg->msgNum);
+        detectDataMsg->batchSeq = -1;
+        SendAfterBatches(detectDataMsg);
+        ret = ACLLITE_ERROR;
+    }
+    AclLiteError execRet = ExecuteReadyBatches();
+    return (ret == ACLLITE_OK) ? execRet : ret;
+}
+
+AclLiteError DetectInferenceThread::ExecuteReadyBatches()
+{
+    AclLiteError ret = ACLLITE_OK;
+    int64_t batchSeq = -1;
+    uint32_t imgNum = 0;
+    vector<shared_ptr<DetectDataMsg>> msgs;
+    while (batchInput_->PopReady(batchSeq, msgs, imgNum)) {
+        AclLiteError batchRet = BatchExecute(batchSeq, msgs, imgNum);
+        ret = (ret == ACLLITE_OK) ? batchRet : ret;
+        msgs.clear();
+    }
+    return ret;
+}
+
+void DetectInferenceThread::RecordBatch(uint32_t imgNum)
+{
+    batchMetric_->Add();
+    batchImgMetric_->Add(imgNum);
+}
+
+void DetectInferenceThread::ScatterOutput(vector<shared_ptr<DetectDataMsg>>& msgs,
+                                          vector<InferenceOutput>& batchOutput)
+{
+    // every message gets the slices of its images, which share the batch output buffers
+    for (size_t i = 0; i < msgs.size(); i++) {
+        uint32_t imgNum = msgs[i]->decodedImg.size();
+        uint32_t imgIndex = msgs[i]->batchImgIndex;
+        if ((imgNum == 0) || (msgs[i]->batchSeq < 0)) {
             continue;
-        } else if(ret == ACLLITE_OK) {
-            break;
+        }
+        for (size_t j = 0; j < batchOutput.size(); j++) {
+            uint32_t imgOutputSize = batchOutput[j].size / batch_;
+            InferenceOutput out;
+            out.data = shared_ptr<void>(batchOutput[j].data,
+                (uint8_t *)batchOutput[j].data.get() + imgIndex * imgOutputSize);
+            out.size = imgOutputSize * imgNum;
+            msgs[i]->inferenceOutput.push_back(out);
+        }
+    }
+}
+
+AclLiteError DetectInferenceThread::BatchExecute(int64_t batchSeq, vector<shared_ptr<DetectDataMsg>>& msgs,
+                                                 uint32_t imgNum)
+{
+    batchCnt_++;
+    batchImgCnt_ += imgNum;
+    RecordBatch(imgNum);
+    if (batchCnt_ % kFillRateLogInterval == 0) {
+        ACLLITE_LOG_INFO("Inference thread %s batch fill rate %.1f%%, %lu images in %lu batches",
+                         SelfInstanceName().c_str(),
+                         batchImgCnt_ * kPercent * 1.0 / (batchCnt_ * batch_),
+                         batchImgCnt_, batchCnt_);
+    }
+    // the images not reserved in this batch keep the data of an older batch,
+    // their outputs are not sent to any channel
+    if (asyncSlotNum_ > 0) {
+        return AsyncExecute(msgs, batchInput_->GetBuffer(batchSeq), batchInput_->GetBufferSize(), batchSeq);
+    }
+
+    AclLiteError ret = model_.CreateInput(batchInput_->GetBuffer(batchSeq), batchInput_->GetBufferSize());
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Create model input dataset failed");
+    } else {
+        vector<InferenceOutput> batchOutput;
+        ret = model_.ExecuteV2(batchOutput);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Execute detect model inference failed, error: %d", ret);
         } else {
-            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-            return ret;
+            ScatterOutput(msgs, batchOutput);
         }
+        model_.DestroyInput();
+    }
+    batchInput_->Free(batchSeq);
+    // send the messages even if the inference failed, so the channels do not wait for them
+    for (size_t i = 0; i < msgs.size(); i++) {
+        MsgSend(msgs[i]);
+    }
+    return ret;
+}
+
+uint32_t DetectInferenceThread::IdleTimeoutMs()
+{
+    // finish the inferences in flight as soon as no message is waiting
+    if (inFlightNum_ > 0) {
+        return 0;
     }
+    return (batchInput_ != nullptr) ? batchInput_->WaitTimeMs() : DEFAULT_IDLE_TIMEOUT_MS;
+}
 
+AclLiteError DetectInferenceThread::Idle()
+{
+    if (inFlightNum_ > 0) {
+        FinishOldestSlot();
+    }
+    if (batchInput_ != nullptr) {
+        ExecuteReadyBatches();
+    }
     return ACLLITE_OK;
 }
 
 AclLiteError DetectInferenceThread::Process(int msgId, shared_ptr<void> data)
 {
+    shared_ptr<DetectDataMsg> detectDataMsg = static_pointer_cast<DetectDataMsg>(data);
     switch (msgId) {
         case MSG_DO_DETECT_INFER:
-            ModelExecute(static_pointer_cast<DetectDataMsg>(data));
-            MsgSend(static_pointer_cast<DetectDataMsg>(data));
+            if (batchInput_ != nullptr) {
+                // the message is sent on even if it fails, so the last frame is not lost
+                AclLiteError ret = GatherMsg(detectDataMsg);
+                if (ret != ACLLITE_OK) {
+                    ACLLITE_LOG_ERROR("Gather channel %u frame %d failed, error %d",
+                                      detectDataMsg->channelId, detectDataMsg->msgNum, ret);
+                }
+            } else if (asyncSlotNum_ > 0) {
+                if (detectDataMsg->decodedImg.empty()) {
+                    SendAfterInFlight(detectDataMsg);
+                    break;
+                }
+                RecordBatch(detectDataMsg->decodedImg.size());
+                vector<shared_ptr<DetectDataMsg>> msgs = {detectDataMsg};
+                AsyncExecute(msgs, detectDataMsg->modelInputImg.data.get(),
+                             detectDataMsg->modelInputImg.size);
+            } else {
+                if (!detectDataMsg->decodedImg.empty()) {
+                    RecordBatch(detectDataMsg->decodedImg.size());
+                }
+                ModelExecute(detectDataMsg);
+                MsgSend(detectDataMsg);
+            }
             break;
         default:
             ACLLITE_LOG_INFO("Inference thread ignore msg %d", msgId);
@@ -22,28 +22,75 @@
 
 #include <iostream>
 #include <mutex>
+#include <vector>
 #include <unistd.h>
 #include "acl/acl.h"
 #include "AclLiteModel.h"
 #include "AclLiteImageProc.h"
 #include "AclLiteThread.h"
+#include "AclLiteMetrics.h"
 #include "Params.h"
+#include "detectBatchInput.h"
 
 /**
 * DetectInferenceThread
+* batchTimeoutMs 0: every message carries a whole model batch of one channel.
+* batchTimeoutMs > 0: every message carries the frames of one channel, the
+* preprocess threads of all channels sharing the thread write the frames into
+* the batches of GetBatchInput, a batch is executed when it is full or
+* batchTimeoutMs after its first frame and all its frames have arrived.
+* asyncSlotNum > 0: up to asyncSlotNum inferences are launched on the model stream
+* without waiting, the oldest one is finished when all slots are in flight or
+* no message is waiting, so the next batch is prepared while the device is busy.
 */
 class DetectInferenceThread : public AclLiteThread {
 public:
-    DetectInferenceThread(std::string modelPath);
+    DetectInferenceThread(std::string modelPath, uint32_t batch = 1, uint32_t batchTimeoutMs = 0,
+                          uint32_t asyncSlotNum = 0);
     ~DetectInferenceThread();
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
+    uint32_t IdleTimeoutMs();
+    AclLiteError Idle();
+    /**
+    * @brief get the batch buffers the preprocess threads write
+    * @return nullptr: batchTimeoutMs is 0, every message has its own input
+    */
+    std::shared_ptr<DetectBatchInput> GetBatchInput()
+    {
+        return batchInput_;
+    }
 private:
     AclLiteError ModelExecute(std::shared_ptr<DetectDataMsg> detectDataMsg);
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError SendAfterInFlight(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError AsyncExecute(std::vector<std::shared_ptr<DetectDataMsg>>& msgs,
+                              void* input, uint32_t inputSize, int64_t batchSeq = -1);
+    AclLiteError FinishOldestSlot();
+    AclLiteError GatherMsg(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError SendAfterBatches(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError ExecuteReadyBatches();
+    AclLiteError BatchExecute(int64_t batchSeq, std::vector<std::shared_ptr<DetectDataMsg>>& msgs,
+                              uint32_t imgNum);
+    void ScatterOutput(std::vector<std::shared_ptr<DetectDataMsg>>& msgs,
+                       std::vector<InferenceOutput>& batchOutput);
+    void RecordBatch(uint32_t imgNum);
 private:
     AclLiteModel model_;
+    std::shared_ptr<std::vector<ModelOutputInfo>> outputInfo_;
     bool isReleased;
+    uint32_t batch_;
+    uint32_t batchTimeoutMs_;
+    uint32_t asyncSlotNum_;
+    std::shared_ptr<DetectBatchInput> batchInput_;
+    std::vector<std::vector<std::shared_ptr<DetectDataMsg>>> slotMsgs_; // messages of every slot
+    std::vector<int64_t> slotBatchSeqs_; // the batch input of every slot, -1: the message input
+    uint32_t nextSlot_;
+    uint32_t inFlightNum_;
+    uint64_t batchCnt_;
+    uint64_t batchImgCnt_;
+    MetricCounter* batchMetric_;
+    MetricCounter* batchImgMetric_;
 };
 
 #endif
@@ -27,38 +27,23 @@
 using namespace std;
 
 namespace {
-    const uint32_t kSleepTime = 500;
-    const double kFountScale = 1;
-    const cv::Scalar kFountColor(0, 0, 255);
-    const uint32_t kLabelOffset = 11;
-    const uint32_t kLineSolid = 2;
-    const vector <cv::Scalar> kColors{
-        cv::Scalar(237, 149, 100), cv::Scalar(0, 215, 255),
-        cv::Scalar(50, 205, 50), cv::Scalar(139, 85, 26)};
-    typedef struct BoundBox {
-        float left;
-        float top;
-        float right;
-        float bottom;
-        float score;
-        size_t classIndex;
-        size_t index;
-    } BoundBox;
-
-    bool sortScore(BoundBox box1, BoundBox box2)
-    {
-        return box1.score > box2.score;
-    }
+    const uint32_t kSendTimeoutMs = 100;
 }
 
 DetectPostprocessThread::DetectPostprocessThread(uint32_t modelWidth, uint32_t modelHeight,
-    aclrtRunMode& runMode, uint32_t batch)
+    aclrtRunMode& runMode, uint32_t batch, const YoloV10DecoderConfig& decoderConfig,
+    RenderFormat renderFormat)
     :modelWidth_(modelWidth), modelHeight_(modelHeight), runMode_(runMode),
-    sendLastBatch_(false), batch_(batch)
+    sendLastBatch_(false), batch_(batch), decoder_(decoderConfig),
+    render_(runMode, renderFormat), hostOutput_(nullptr), hostOutputSize_(0)
 {
 }
 
 DetectPostprocessThread::~DetectPostprocessThread() {
+    if (hostOutput_ != nullptr) {
+        aclrtFreeHost(hostOutput_);
+        hostOutput_ = nullptr;
+    }
 }
 
 AclLiteError DetectPostprocessThread::Init()
@@ -71,7 +56,7 @@ AclLiteError DetectPostprocessThread::Process(int msgId, shared_ptr<void> data)
     AclLiteError ret = ACLLITE_OK;
     switch (msgId) {
         case MSG_POSTPROC_DETECTDATA:
-            InferOutputProcess(static_pointer_cast<DetectDataMsg>(data));
+            Postprocess(static_pointer_cast<DetectDataMsg>(data));
             MsgSend(static_pointer_cast<DetectDataMsg>(data));
             break;
         default:
@@ -82,66 +67,96 @@ AclLiteError DetectPostprocessThread::Process(int msgId, shared_ptr<void> data)
     return ret;
 }
 
-AclLiteError DetectPostprocessThread::InferOutputProcess(shared_ptr<DetectDataMsg> detectDataMsg)
+AclLiteError DetectPostprocessThread::Postprocess(shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    size_t pos = 0;
-    for (int n = 0; n < detectDataMsg->decodedImg.size(); n++) {
-        void* dataBuffer = CopyDataToHost(detectDataMsg->inferenceOutput[0].data.get() + pos,
-            detectDataMsg->inferenceOutput[0].size / batch_, runMode_, MEMORY_NORMAL);
-        if (dataBuffer == nullptr) {
-            ACLLITE_LOG_ERROR("Copy inference output to host failed");
-            return ACLLITE_ERROR_COPY_DATA;
-        }
-        pos = pos + detectDataMsg->inferenceOutput[0].size / batch_;
-        float* detectBuff = static_cast<float*>(dataBuffer);
+    // the images are still rendered without detections, so the output keeps every frame
+    AclLiteError ret = InferOutputProcess(detectDataMsg);
+    AclLiteError renderRet = render_.Render(detectDataMsg);
+    StampFrameStage(*detectDataMsg, STAGE_POST_DONE);
+    return (ret != ACLLITE_OK) ? ret : renderRet;
+}
 
-        // confidence threshold
-        float confidenceThreshold = 0.5;
+float* DetectPostprocessThread::GetOutputOnHost(shared_ptr<DetectDataMsg> detectDataMsg, uint32_t size)
+{
+    void* output = detectDataMsg->inferenceOutput[0].data.get();
+    // the app runs on the device (SoC), the output memory is accessible without copy
+    if (runMode_ == ACL_DEVICE) {
+        return static_cast<float*>(output);
+    }
 
-        // total number = (left, top, right, bottom, confidence, class)
-        size_t totalNumber = 6;
+    if (size > hostOutputSize_) {
+        if (hostOutput_ != nullptr) {
+            aclrtFreeHost(hostOutput_);
+            hostOutput_ = nullptr;
+            hostOutputSize_ = 0;
+        }
+        aclError aclRet = aclrtMallocHost(&hostOutput_, size);
+        if (aclRet != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("Malloc host output buffer failed, size %u, error %d", size, aclRet);
+            hostOutput_ = nullptr;
+            return nullptr;
+        }
+        hostOutputSize_ = size;
+    }
+    aclError aclRet = aclrtMemcpy(hostOutput_, hostOutputSize_, output, size, ACL_MEMCPY_DEVICE_TO_HOST);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Copy inference output to host failed, error %d", aclRet);
+        return nullptr;
+    }
+    return static_cast<float*>(hostOutput_);
+}
 
-        // total number of boxs
-        size_t modelOutputBoxNum = 300;
+AclLiteError DetectPostprocessThread::InferOutputProcess(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    if (detectDataMsg->decodedImg.empty()) {
+        return ACLLITE_OK;
+    }
+    // the output shape is known after the model is loaded by the inference thread
+    if (!decoder_.IsInited()) {
+        if ((detectDataMsg->modelOutputInfo == nullptr) || detectDataMsg->modelOutputInfo->empty()) {
+            ACLLITE_LOG_ERROR("The detect output info is not given");
+            return ACLLITE_ERROR;
+        }
+        AclLiteError ret = decoder_.Init((*detectDataMsg->modelOutputInfo)[0]);
+        if (ret != ACLLITE_OK) {
+            return ret;
+        }
+    }
+    uint32_t imgOutputSize = decoder_.GetImageOutputSize();
+    uint32_t outputSize = imgOutputSize * detectDataMsg->decodedImg.size();
+    if (outputSize > detectDataMsg->inferenceOutput[0].size) {
+        ACLLITE_LOG_ERROR("The inference output size %u is less than %u",
+                          detectDataMsg->inferenceOutput[0].size, outputSize);
+        return ACLLITE_ERROR;
+    }
+    // copy the output of all images in the message to host at once
+    float* outputBuff = GetOutputOnHost(detectDataMsg, outputSize);
+    if (outputBuff == nullptr) {
+        return ACLLITE_ERROR_COPY_DATA;
+    }
+    for (int n = 0; n < detectDataMsg->decodedImg.size(); n++) {
+        float* detectBuff = outputBuff + n * (imgOutputSize / sizeof(float));
 
         // get srcImage width height
         int srcWidth = detectDataMsg->decodedImg[n].width;
         int srcHeight = detectDataMsg->decodedImg[n].height;
 
-        float scale = min(modelWidth_ * 1.0 / srcWidth * 1.0, modelHeight_ * 1.0 / srcHeight * 1.0);
-        uint32_t borderLeftOffset = (modelWidth_ - scale * srcWidth) / 2;
-        uint32_t borderTopOffset = (modelHeight_ - scale * srcHeight) / 2;        
-
-        // filter boxes by confidence threshold
-        vector <BoundBox> result;
-        result.clear();
-        size_t leftIndex = 0;
-        size_t topIndex = 1;
-        size_t rightIndex =2;
-        size_t bottomIndex = 3;
-        size_t confidenceIndex = 4;
-        size_t classIndex = 5;
-        for (size_t i = 0; i < modelOutputBoxNum; ++i) {
-            float confidence = detectBuff[i * totalNumber + confidenceIndex];
-            if (confidence >= confidenceThreshold) {
-                BoundBox box;
-                box.left = (detectBuff[i * totalNumber + leftIndex] - borderLeftOffset) / scale;
-                box.top = (detectBuff[i * totalNumber + topIndex] - borderTopOffset) / scale;
-                box.right = (detectBuff[i * totalNumber + rightIndex] - borderLeftOffset) / scale;
-                box.bottom = (detectBuff[i * totalNumber + bottomIndex] - borderTopOffset) / scale;
-                box.score = confidence;
-                box.classIndex = detectBuff[i * totalNumber + classIndex];
-                box.index = i;
-                result.push_back(box);
-            }
+        // the geometry of the image in the model input, given by preprocess
+        LetterboxInfo letterbox;
+        if (n < detectDataMsg->letterbox.size()) {
+            letterbox = detectDataMsg->letterbox[n];
+        } else {
+            float scale = min(modelWidth_ * 1.0 / srcWidth * 1.0, modelHeight_ * 1.0 / srcHeight * 1.0);
+            letterbox.scaleX = scale;
+            letterbox.scaleY = scale;
+            letterbox.padLeft = (modelWidth_ - scale * srcWidth) / 2;
+            letterbox.padTop = (modelHeight_ - scale * srcHeight) / 2;
         }
 
-        // opencv draw label params
-        int half = 2;
-
-        cv::Point leftTopPoint;  // left top
-        cv::Point rightBottomPoint;  // right bottom
-        string className;  // yolo detect output
+        // filter boxes by confidence threshold and class, map them to the source image
+        detectDataMsg->detections.push_back(vector<DetectBox>());
+        vector<DetectBox>& result = detectDataMsg->detections.back();
+        decoder_.Decode(detectBuff, letterbox, result);
 
         // calculate framenum
         int frameCnt = (detectDataMsg->msgNum) * batch_ + n + 1;
@@ -154,19 +169,11 @@ AclLiteError DetectPostprocessThread::InferOutputProcess(shared_ptr<DetectDataMs
         sstream >> textHead;
         string textMid = "[";
         for (size_t i = 0; i < result.size(); ++i) {
-            leftTopPoint.x = result[i].left;
-            leftTopPoint.y = result[i].top;
-            rightBottomPoint.x = result[i].right;
-            rightBottomPoint.y = result[i].bottom;
-            className = label[result[i].classIndex] + ":" + to_string(result[i].score);
-            cv::rectangle(detectDataMsg->frame[n], leftTopPoint, rightBottomPoint, kColors[i % kColors.size()], kLineSolid);
-            cv::putText(detectDataMsg->frame[n], className, cv::Point(leftTopPoint.x, leftTopPoint.y + kLabelOffset), cv::FONT_HERSHEY_COMPLEX, kFountScale, kFountColor);
+            string className = label[result[i].classIndex] + ":" + to_string(result[i].score);
             textMid = textMid + className + " ";            
         }
         string textPrint = textHead + textMid + "]";
         detectDataMsg->textPrint.push_back(textPrint);
-        free(detectBuff);
-        detectBuff = nullptr;
     }
     return ACLLITE_OK;
 }
@@ -174,49 +181,28 @@ AclLiteError DetectPostprocessThread::InferOutputProcess(shared_ptr<DetectDataMs
     
 AclLiteError DetectPostprocessThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 {
+    AclLiteError ret = ACLLITE_OK;
     if (!sendLastBatch_) {
-        while (1) {
-            AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId, MSG_OUTPUT_FRAME, detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE) {
-                usleep(kSleepTime);
-                continue;
-            } else if(ret == ACLLITE_OK) {
-                break;
-            } else {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-                return ret;
-            }
+        do {
+            ret = SendMessageBlocking(detectDataMsg->dataOutputThreadId, MSG_OUTPUT_FRAME,
+                                      detectDataMsg, kSendTimeoutMs);
+        } while (ret == ACLLITE_ERROR_ENQUEUE);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+            return ret;
         }
     }
-    if (detectDataMsg->isLastFrame && sendLastBatch_) {
-        while (1) {
-            AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId, MSG_ENCODE_FINISH, detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE) {
-                usleep(kSleepTime);
-                continue;
-            } else if(ret == ACLLITE_OK) {
-                break;
-            } else {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-                return ret;
-            }
-        }
-    }
-    if (detectDataMsg->isLastFrame && !sendLastBatch_) {
-        while (1) {
-            AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId, MSG_ENCODE_FINISH, detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE) {
-                usleep(kSleepTime);
-                continue;
-            } else if(ret == ACLLITE_OK) {
-                break;
-            } else {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-                return ret;
-            }
+    if (detectDataMsg->isLastFrame) {
+        do {
+            ret = SendMessageBlocking(detectDataMsg->dataOutputThreadId, MSG_ENCODE_FINISH,
+                                      detectDataMsg, kSendTimeoutMs);
+        } while (ret == ACLLITE_ERROR_ENQUEUE);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+            return ret;
         }
         sendLastBatch_ = true;
     }
 
     return ACLLITE_OK;
-}
\ No newline at end of file
+}
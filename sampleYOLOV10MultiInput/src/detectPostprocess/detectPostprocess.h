@@ -28,19 +28,37 @@
 #include "AclLiteImageProc.h"
 #include "AclLiteThread.h"
 #include "Params.h"
+#include "yolov10Decoder.h"
+#include "detectRender.h"
 
 class DetectPostprocessThread : public AclLiteThread {
 public:
     DetectPostprocessThread(uint32_t modelWidth, uint32_t modelHeight,
-    aclrtRunMode& runMode, uint32_t batch);
+    aclrtRunMode& runMode, uint32_t batch, const YoloV10DecoderConfig& decoderConfig,
+    RenderFormat renderFormat);
     ~DetectPostprocessThread();
 
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
 
+    /**
+     * @brief decode the detections and render the images of the message,
+     * DetectPostprocessPool calls it directly without running the thread
+     * @param [in] detectDataMsg: the message with inference output
+     * @return ACLLITE_OK: success; others: failed
+     */
+    AclLiteError Postprocess(std::shared_ptr<DetectDataMsg> detectDataMsg);
+
 private:
     AclLiteError InferOutputProcess(std::shared_ptr<DetectDataMsg> detectDataMsg);
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    /**
+     * @brief get the inference output of all images in the message on host
+     * @param [in] detectDataMsg: the message with inference output
+     * @param [in] size: the output size of all images in the message
+     * @return the host address of the output; nullptr: failed
+     */
+    float* GetOutputOnHost(std::shared_ptr<DetectDataMsg> detectDataMsg, uint32_t size);
 
 private:
     uint32_t modelWidth_;
@@ -48,6 +66,10 @@ private:
     aclrtRunMode runMode_;
     bool sendLastBatch_;
     uint32_t batch_;
+    YoloV10Decoder decoder_;
+    DetectRender render_;
+    void* hostOutput_; // pinned host buffer reused by every message
+    uint32_t hostOutputSize_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,161 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File detectPostprocessPool.cpp
+* Description: postprocess workers shared by all channels
+*/
+#include "detectPostprocessPool.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kSubmitWaitMs = 100;
+    // the results of one channel waiting for its output queue, Submit waits above it
+    const size_t kMaxOutputBacklog = 32;
+}
+
+DetectPostprocessPool& DetectPostprocessPool::GetInstance()
+{
+    static DetectPostprocessPool postPool;
+    return postPool;
+}
+
+DetectPostprocessPool::DetectPostprocessPool()
+{
+}
+
+DetectPostprocessPool::~DetectPostprocessPool()
+{
+    Stop();
+}
+
+void DetectPostprocessPool::AddChannel(uint32_t channelId, const PostChannelConfig& config)
+{
+    channels_[channelId] = config;
+}
+
+bool DetectPostprocessPool::HasChannel(uint32_t channelId) const
+{
+    return channels_.find(channelId) != channels_.end();
+}
+
+AclLiteError DetectPostprocessPool::Start(uint32_t workerNum, const ThreadSchedConfig& sched)
+{
+    if (channels_.empty()) {
+        return ACLLITE_OK;
+    }
+    AclLiteError ret = pool_.Start(workerNum, "post_pool", sched);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Start postprocess pool failed, error %d", ret);
+        return ret;
+    }
+    workers_.resize(pool_.GetWorkerNum());
+    ret = outputBacklog_.Start("post_backlog");
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Start postprocess output backlog failed, error %d", ret);
+        return ret;
+    }
+    ACLLITE_LOG_INFO("Postprocess pool started, %zu channels on %u workers",
+                     channels_.size(), pool_.GetWorkerNum());
+    return ACLLITE_OK;
+}
+
+AclLiteError DetectPostprocessPool::Submit(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    auto it = channels_.find(detectDataMsg->channelId);
+    if (it == channels_.end()) {
+        ACLLITE_LOG_ERROR("Channel %u is not postprocessed in the pool", detectDataMsg->channelId);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    const PostChannelConfig* config = &it->second;
+    // back pressure on the channel whose output is slow, the other channels go on
+    while (!outputBacklog_.WaitBelow(detectDataMsg->channelId, kMaxOutputBacklog, kSubmitWaitMs)) {
+        ACLLITE_LOG_WARNING("The output of channel %u is %zu messages behind, wait",
+                            detectDataMsg->channelId, kMaxOutputBacklog);
+    }
+    return pool_.Submit([this, config, detectDataMsg](uint32_t workerId) {
+        Postprocess(workerId, *config, detectDataMsg);
+    }, detectDataMsg->channelId);
+}
+
+void DetectPostprocessPool::Stop()
+{
+    pool_.Stop();
+    outputBacklog_.Stop();
+    for (size_t i = 0; i < workers_.size(); i++) {
+        for (auto& processor : workers_[i].processors) {
+            // the pinned host buffers belong to the context
+            aclrtSetCurrentContext(processor.second.context);
+            delete processor.second.processor;
+        }
+        workers_[i].processors.clear();
+    }
+    workers_.clear();
+}
+
+DetectPostprocessThread* DetectPostprocessPool::GetProcessor(WorkerState& worker,
+                                                              const PostChannelConfig& config)
+{
+    ProcessorKey key(config.modelId, config.renderFormat);
+    auto it = worker.processors.find(key);
+    if (it != worker.processors.end()) {
+        return it->second.processor;
+    }
+    aclrtRunMode runMode = config.runMode;
+    Processor processor;
+    processor.context = config.context;
+    processor.processor = new DetectPostprocessThread(config.modelWidth, config.modelHeight,
+        runMode, config.batch, config.decoderConfig, config.renderFormat);
+    worker.processors[key] = processor;
+    return processor.processor;
+}
+
+void DetectPostprocessPool::Postprocess(uint32_t workerId, const PostChannelConfig& config,
+                                        shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    WorkerState& worker = workers_[workerId];
+    if (worker.context != config.context) {
+        aclError aclRet = aclrtSetCurrentContext(config.context);
+        if (aclRet != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("Set postprocess worker %u context failed, error %d", workerId, aclRet);
+        } else {
+            worker.context = config.context;
+        }
+    }
+    GetProcessor(worker, config)->Postprocess(detectDataMsg);
+    MsgSend(detectDataMsg);
+}
+
+AclLiteError DetectPostprocessPool::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    // the last frame message comes once per channel in the pool mode, the messages
+    // queued by the backlog keep their order
+    AclLiteError ret = outputBacklog_.Send(detectDataMsg->channelId, detectDataMsg->dataOutputThreadId,
+                                           MSG_OUTPUT_FRAME, detectDataMsg);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Send output frame message failed, error %d", ret);
+        return ret;
+    }
+    if (detectDataMsg->isLastFrame) {
+        ret = outputBacklog_.Send(detectDataMsg->channelId, detectDataMsg->dataOutputThreadId,
+                                  MSG_ENCODE_FINISH, detectDataMsg);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Send encode finish message failed, error %d", ret);
+            return ret;
+        }
+    }
+    return ACLLITE_OK;
+}
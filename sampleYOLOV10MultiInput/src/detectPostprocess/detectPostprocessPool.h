@@ -0,0 +1,127 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File detectPostprocessPool.h
+* Description: postprocess workers shared by all channels
+*/
+#ifndef DETECTPOSTPROCESSPOOL_H
+#define DETECTPOSTPROCESSPOOL_H
+#pragma once
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "acl/acl.h"
+#include "AclLiteError.h"
+#include "MsgBacklog.h"
+#include "WorkStealingPool.h"
+#include "Params.h"
+#include "detectPostprocess.h"
+
+struct PostChannelConfig {
+    uint32_t modelId;  // the channels of one model with the same render format share the processors
+    uint32_t modelWidth;
+    uint32_t modelHeight;
+    uint32_t batch;
+    YoloV10DecoderConfig decoderConfig;
+    RenderFormat renderFormat;
+    aclrtRunMode runMode;
+    aclrtContext context;
+};
+
+/**
+* DetectPostprocessPool
+* Instead of postnum postprocess threads per channel, the inference threads of
+* all channels submit to one work stealing pool sized to the cpu cores. The
+* messages of a channel go to the same worker first, a busy channel is spread
+* over the idle workers by stealing, so the messages may finish out of order
+* and the output thread restores the order by msgNum.
+* Every worker keeps one processor per (model, render format), the decoder and
+* the pinned host buffers are not shared between the workers.
+* The workers never wait for a full output queue, the results of a slow output
+* wait in the backlog of its channel, and Submit waits when that backlog is full.
+*/
+class DetectPostprocessPool {
+public:
+    /**
+    * @brief get the process wide postprocess pool
+    */
+    static DetectPostprocessPool& GetInstance();
+
+    /**
+    * @brief postprocess the channel in the pool, it must be called before Start
+    * @param [in]: channelId: the channel
+    * @param [in]: config: the postprocess config of the channel
+    */
+    void AddChannel(uint32_t channelId, const PostChannelConfig& config);
+
+    /**
+    * @brief whether the channel is postprocessed in the pool
+    * @param [in]: channelId: the channel
+    */
+    bool HasChannel(uint32_t channelId) const;
+
+    /**
+    * @brief start the workers
+    * @param [in]: workerNum: the worker number, 0: the number of cpu cores
+    * @param [in]: sched: the affinity and scheduling policy of the workers
+    * @return ACLLITE_OK: success; others: failed
+    */
+    AclLiteError Start(uint32_t workerNum, const ThreadSchedConfig& sched = ThreadSchedConfig());
+
+    /**
+    * @brief postprocess the message in a worker and send it to the output thread,
+    * wait while the output of the channel is behind by the max backlog
+    * @param [in]: detectDataMsg: the message with inference output
+    * @return ACLLITE_OK: success; others: the channel is not added or the pool is stopped
+    */
+    AclLiteError Submit(std::shared_ptr<DetectDataMsg> detectDataMsg);
+
+    /**
+    * @brief finish the submitted messages, join the workers and free the processors.
+    * It must be called before the contexts are destroyed
+    */
+    void Stop();
+
+private:
+    DetectPostprocessPool();
+    ~DetectPostprocessPool();
+    DetectPostprocessPool(const DetectPostprocessPool&) = delete;
+    DetectPostprocessPool& operator=(const DetectPostprocessPool&) = delete;
+
+    using ProcessorKey = std::pair<uint32_t, RenderFormat>;
+    struct Processor {
+        aclrtContext context;
+        DetectPostprocessThread* processor;
+    };
+    struct WorkerState {
+        aclrtContext context = nullptr;  // the current context of the worker thread
+        std::map<ProcessorKey, Processor> processors;
+    };
+
+    void Postprocess(uint32_t workerId, const PostChannelConfig& config,
+                     std::shared_ptr<DetectDataMsg> detectDataMsg);
+    DetectPostprocessThread* GetProcessor(WorkerState& worker, const PostChannelConfig& config);
+    AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
+
+private:
+    WorkStealingPool pool_;
+    MsgBacklog outputBacklog_;  // the results waiting for the output queue of their channel
+    std::map<uint32_t, PostChannelConfig> channels_;  // not changed after Start
+    std::vector<WorkerState> workers_;  // every worker only uses its own state
+};
+
+#endif
@@ -0,0 +1,217 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File detectRender.cpp
+* Description: draw the detect result on the source image
+*/
+#include "AclLiteUtils.h"
+#include "label.h"
+#include "detectRender.h"
+
+using namespace std;
+
+namespace {
+    const uint32_t kYuvMultiplier = 3;
+    const uint32_t kYuvDivisor = 2;
+    const double kFountScale = 1;
+    const cv::Scalar kFountColor(0, 0, 255);
+    const uint32_t kLabelOffset = 11;
+    const uint32_t kLineSolid = 2;
+    const vector <cv::Scalar> kColors{
+        cv::Scalar(237, 149, 100), cv::Scalar(0, 215, 255),
+        cv::Scalar(50, 205, 50), cv::Scalar(139, 85, 26)};
+    const uint32_t kUvDivisor = 2;
+
+    // BT.601 video range, the color is (B, G, R)
+    cv::Scalar BgrToYuv(const cv::Scalar& bgr)
+    {
+        double b = bgr[0];
+        double g = bgr[1];
+        double r = bgr[2];
+        double y = 0.257 * r + 0.504 * g + 0.098 * b + 16;
+        double u = -0.148 * r - 0.291 * g + 0.439 * b + 128;
+        double v = 0.439 * r - 0.368 * g - 0.071 * b + 128;
+        return cv::Scalar(y, u, v);
+    }
+}
+
+DetectRender::DetectRender(aclrtRunMode runMode, RenderFormat format)
+    :runMode_(runMode), format_(format), hostImage_(nullptr), hostImageSize_(0)
+{
+}
+
+DetectRender::~DetectRender()
+{
+    if (hostImage_ != nullptr) {
+        aclrtFreeHost(hostImage_);
+        hostImage_ = nullptr;
+    }
+}
+
+RenderFormat DetectRender::GetRenderFormat(const string& outputType, const string& rtspFrameFormat)
+{
+    if (outputType == "rtsp") {
+        return (rtspFrameFormat == "nv12") ? RENDER_NV12 : RENDER_BGR;
+    }
+    if (outputType == "h264file") {
+        return RENDER_NV12;
+    }
+    if ((outputType == "video") || (outputType == "pic") || (outputType == "imshow")) {
+        return RENDER_BGR;
+    }
+    return RENDER_NONE;
+}
+
+AclLiteError DetectRender::ConvertToBgr(ImageData& image, cv::Mat& frame)
+{
+    // the decoded image rows are aligned, the stride is alignWidth
+    uint32_t stride = (image.alignWidth > 0) ? image.alignWidth : image.width;
+    uint32_t rows = (image.alignHeight > 0) ? image.alignHeight : image.height;
+    uint32_t size = YUV420SP_SIZE(stride, rows);
+    if ((image.data == nullptr) || (size > image.size)) {
+        ACLLITE_LOG_ERROR("Invalid decoded image %ux%u, stride %u, size %u",
+                          image.width, image.height, stride, image.size);
+        return ACLLITE_ERROR;
+    }
+
+    // the app runs on the device (SoC), the dvpp memory is accessible without copy
+    void* yuv = image.data.get();
+    if (runMode_ == ACL_HOST) {
+        if (size > hostImageSize_) {
+            if (hostImage_ != nullptr) {
+                aclrtFreeHost(hostImage_);
+                hostImage_ = nullptr;
+                hostImageSize_ = 0;
+            }
+            aclError aclRet = aclrtMallocHost(&hostImage_, size);
+            if (aclRet != ACL_SUCCESS) {
+                ACLLITE_LOG_ERROR("Malloc host image buffer failed, size %u, error %d", size, aclRet);
+                hostImage_ = nullptr;
+                return ACLLITE_ERROR_MALLOC;
+            }
+            hostImageSize_ = size;
+        }
+        aclError aclRet = aclrtMemcpy(hostImage_, hostImageSize_, yuv, size, ACL_MEMCPY_DEVICE_TO_HOST);
+        if (aclRet != ACL_SUCCESS) {
+            ACLLITE_LOG_ERROR("Copy decoded image to host failed, error %d", aclRet);
+            return ACLLITE_ERROR_COPY_DATA;
+        }
+        yuv = hostImage_;
+    }
+
+    cv::Mat yuvImg(rows * kYuvMultiplier / kYuvDivisor, stride, CV_8UC1, yuv);
+    cv::Mat bgrImg;
+    cv::cvtColor(yuvImg, bgrImg, CV_YUV2BGR_NV12);
+    frame = bgrImg(cv::Rect(0, 0, image.width, image.height));
+    return ACLLITE_OK;
+}
+
+void DetectRender::DrawDetections(const vector<DetectBox>& boxes, cv::Mat& frame)
+{
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        cv::Point leftTopPoint(boxes[i].left, boxes[i].top);
+        cv::Point rightBottomPoint(boxes[i].right, boxes[i].bottom);
+        string className = label[boxes[i].classIndex] + ":" + to_string(boxes[i].score);
+        cv::rectangle(frame, leftTopPoint, rightBottomPoint, kColors[i % kColors.size()], kLineSolid);
+        cv::putText(frame, className, cv::Point(leftTopPoint.x, leftTopPoint.y + kLabelOffset),
+                    cv::FONT_HERSHEY_COMPLEX, kFountScale, kFountColor);
+    }
+}
+
+AclLiteError DetectRender::GetYuvOnHost(ImageData& image, ImageData& yuvImage)
+{
+    uint32_t stride = (image.alignWidth > 0) ? image.alignWidth : image.width;
+    uint32_t rows = (image.alignHeight > 0) ? image.alignHeight : image.height;
+    uint32_t size = YUV420SP_SIZE(stride, rows);
+    if ((image.data == nullptr) || (size > image.size)) {
+        ACLLITE_LOG_ERROR("Invalid decoded image %ux%u, stride %u, size %u",
+                          image.width, image.height, stride, image.size);
+        return ACLLITE_ERROR;
+    }
+    yuvImage = image;
+    yuvImage.alignWidth = stride;
+    yuvImage.alignHeight = rows;
+    yuvImage.size = size;
+    // the app runs on the device (SoC), the boxes are drawn on the decoded image,
+    // it is not used by other threads after inference
+    if (runMode_ == ACL_DEVICE) {
+        return ACLLITE_OK;
+    }
+    // the image is kept by the rtsp encoder, every image needs its own host buffer
+    uint8_t* data = new(nothrow) uint8_t[size];
+    if (data == nullptr) {
+        ACLLITE_LOG_ERROR("Malloc host yuv image failed, size %u", size);
+        return ACLLITE_ERROR_MALLOC;
+    }
+    yuvImage.data = SHARED_PTR_U8_BUF(data);
+    yuvImage.memType = MEMORY_NORMAL;
+    aclError aclRet = aclrtMemcpy(data, size, image.data.get(), size, ACL_MEMCPY_DEVICE_TO_HOST);
+    if (aclRet != ACL_SUCCESS) {
+        ACLLITE_LOG_ERROR("Copy decoded image to host failed, error %d", aclRet);
+        return ACLLITE_ERROR_COPY_DATA;
+    }
+    return ACLLITE_OK;
+}
+
+void DetectRender::DrawDetectionsYuv(const vector<DetectBox>& boxes, ImageData& yuvImage)
+{
+    cv::Mat yPlane(yuvImage.height, yuvImage.width, CV_8UC1, yuvImage.data.get(), yuvImage.alignWidth);
+    cv::Mat uvPlane(yuvImage.height / kUvDivisor, yuvImage.width / kUvDivisor, CV_8UC2,
+                    yuvImage.data.get() + yuvImage.alignWidth * yuvImage.alignHeight, yuvImage.alignWidth);
+    cv::Scalar fontColor = BgrToYuv(kFountColor);
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        cv::Scalar color = BgrToYuv(kColors[i % kColors.size()]);
+        cv::Point leftTopPoint(boxes[i].left, boxes[i].top);
+        cv::Point rightBottomPoint(boxes[i].right, boxes[i].bottom);
+        cv::rectangle(yPlane, leftTopPoint, rightBottomPoint, cv::Scalar(color[0]), kLineSolid);
+        cv::rectangle(uvPlane, leftTopPoint / (int)kUvDivisor, rightBottomPoint / (int)kUvDivisor,
+                      cv::Scalar(color[1], color[2]), kLineSolid / kUvDivisor);
+        // the label only changes the luma, it is readable without chroma
+        string className = label[boxes[i].classIndex] + ":" + to_string(boxes[i].score);
+        cv::putText(yPlane, className, cv::Point(leftTopPoint.x, leftTopPoint.y + kLabelOffset),
+                    cv::FONT_HERSHEY_COMPLEX, kFountScale, cv::Scalar(fontColor[0]));
+    }
+}
+
+AclLiteError DetectRender::Render(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    if (format_ == RENDER_NONE) {
+        return ACLLITE_OK;
+    }
+    if (format_ == RENDER_NV12) {
+        detectDataMsg->yuvFrame.resize(detectDataMsg->decodedImg.size());
+        for (size_t n = 0; n < detectDataMsg->decodedImg.size(); n++) {
+            AclLiteError ret = GetYuvOnHost(detectDataMsg->decodedImg[n], detectDataMsg->yuvFrame[n]);
+            if (ret != ACLLITE_OK) {
+                return ret;
+            }
+            if (n < detectDataMsg->detections.size()) {
+                DrawDetectionsYuv(detectDataMsg->detections[n], detectDataMsg->yuvFrame[n]);
+            }
+        }
+        return ACLLITE_OK;
+    }
+    detectDataMsg->frame.resize(detectDataMsg->decodedImg.size());
+    for (size_t n = 0; n < detectDataMsg->decodedImg.size(); n++) {
+        AclLiteError ret = ConvertToBgr(detectDataMsg->decodedImg[n], detectDataMsg->frame[n]);
+        if (ret != ACLLITE_OK) {
+            return ret;
+        }
+        if (n < detectDataMsg->detections.size()) {
+            DrawDetections(detectDataMsg->detections[n], detectDataMsg->frame[n]);
+        }
+    }
+    return ACLLITE_OK;
+}
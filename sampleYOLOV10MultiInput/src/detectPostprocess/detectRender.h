@@ -0,0 +1,76 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File detectRender.h
+* Description: draw the detect result on the source image
+*/
+#ifndef DETECTRENDER_H
+#define DETECTRENDER_H
+#pragma once
+
+#include <memory>
+#include "acl/acl.h"
+#include "AclLiteError.h"
+#include "Params.h"
+
+enum RenderFormat {
+    RENDER_NONE = 0,  // the output uses detections only
+    RENDER_BGR = 1,   // BGR frame in DetectDataMsg::frame
+    RENDER_NV12 = 2,  // NV12 image on host in DetectDataMsg::yuvFrame
+};
+
+/**
+* DetectRender
+* Only the outputs showing pixels (video, h264file, pic, imshow, rtsp) need the render.
+* RENDER_BGR converts the decoded NV12 image to BGR on host and draws the detections,
+* RENDER_NV12 draws the detections on the Y and UV planes of the decoded image, so
+* the rtsp and h264file outputs encode it without color conversion.
+* The other outputs use DetectDataMsg::detections directly, so the decoded image
+* is never copied to host.
+*/
+class DetectRender {
+public:
+    DetectRender(aclrtRunMode runMode, RenderFormat format);
+    ~DetectRender();
+
+    /**
+     * @brief render every image of the message into DetectDataMsg::frame or yuvFrame
+     * @param [in] detectDataMsg: the message with decodedImg and detections
+     * @return ACLLITE_OK: success; others: failed
+     */
+    AclLiteError Render(std::shared_ptr<DetectDataMsg> detectDataMsg);
+
+    /**
+     * @brief get the render format needed by the output
+     * @param [in] outputType: output_type of the channel
+     * @param [in] rtspFrameFormat: the frame format of the rtsp output, bgr or nv12
+     * @return the render format
+     */
+    static RenderFormat GetRenderFormat(const std::string& outputType, const std::string& rtspFrameFormat);
+
+private:
+    AclLiteError ConvertToBgr(ImageData& image, cv::Mat& frame);
+    AclLiteError GetYuvOnHost(ImageData& image, ImageData& yuvImage);
+    void DrawDetections(const std::vector<DetectBox>& boxes, cv::Mat& frame);
+    void DrawDetectionsYuv(const std::vector<DetectBox>& boxes, ImageData& yuvImage);
+
+private:
+    aclrtRunMode runMode_;
+    RenderFormat format_;
+    void* hostImage_; // pinned host buffer reused by every image
+    uint32_t hostImageSize_;
+};
+
+#endif
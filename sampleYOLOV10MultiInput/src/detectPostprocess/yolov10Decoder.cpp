@@ -0,0 +1,276 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File yolov10Decoder.cpp
+* Description: decode yolov10 detect output into boxes of the source image
+*/
+#include <algorithm>
+#include <string>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "AclLiteUtils.h"
+#include "label.h"
+#include "yolov10Decoder.h"
+
+using namespace std;
+
+namespace {
+// every box is (left, top, right, bottom, confidence, class)
+const uint32_t kBoxAttrNum = 6;
+const uint32_t kConfidenceIndex = 4;
+const uint32_t kClassIndex = 5;
+const uint32_t kLaneNum = 4;
+const uint32_t kAvxLaneNum = 8;
+const uint32_t kScalarLaneNum = 1;
+const uint32_t kClassNum = sizeof(label) / sizeof(label[0]);
+
+// append the boxes of the set bits, bit n is box first + n
+inline uint32_t AppendMask(uint32_t mask, uint32_t first, uint32_t* candidates, uint32_t num)
+{
+    while (mask != 0) {
+        candidates[num++] = first + __builtin_ctz(mask);
+        mask &= mask - 1;
+    }
+    return num;
+}
+
+uint32_t FilterScalar(const float* output, uint32_t begin, uint32_t boxNum, uint32_t stride,
+                      float threshold, uint32_t* candidates, uint32_t num)
+{
+    for (uint32_t i = begin; i < boxNum; i++) {
+        if (output[i * stride + kConfidenceIndex] >= threshold) {
+            candidates[num++] = i;
+        }
+    }
+    return num;
+}
+
+#if defined(__aarch64__)
+// 4 boxes are 24 floats, vld3 splits 12 floats into 3 vectors of the floats 3n, 3n + 1
+// and 3n + 2, so the confidences 4, 10 and 16, 22 are the odd lanes of the second vectors
+uint32_t FilterSimd4(const float* output, uint32_t boxNum, float threshold, uint32_t* candidates)
+{
+    const float32x4_t thresholdVec = vdupq_n_f32(threshold);
+    const uint32_t bitArr[kLaneNum] = {1, 2, 4, 8};
+    const uint32x4_t bitSel = vld1q_u32(bitArr);
+    uint32_t num = 0;
+    uint32_t i = 0;
+    for (; i + kLaneNum <= boxNum; i += kLaneNum) {
+        const float* p = output + i * kBoxAttrNum;
+        float32x4x3_t box01 = vld3q_f32(p);
+        float32x4x3_t box23 = vld3q_f32(p + 3 * kLaneNum);
+        float32x4_t conf = vuzp2q_f32(box01.val[1], box23.val[1]);
+        uint32_t mask = vaddvq_u32(vandq_u32(vcgeq_f32(conf, thresholdVec), bitSel));
+        num = AppendMask(mask, i, candidates, num);
+    }
+    return FilterScalar(output, i, boxNum, kBoxAttrNum, threshold, candidates, num);
+}
+#elif defined(__SSE2__)
+// 4 boxes are 24 floats, the confidences 4, 10, 16 and 22 are lane 0 of the floats 4~7,
+// lane 2 of 8~11, lane 0 of 16~19 and lane 2 of 20~23
+inline __m128 LoadConfidence4(const float* p)
+{
+    __m128 conf01 = _mm_shuffle_ps(_mm_loadu_ps(p + 4), _mm_loadu_ps(p + 8), _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 conf23 = _mm_shuffle_ps(_mm_loadu_ps(p + 16), _mm_loadu_ps(p + 20), _MM_SHUFFLE(2, 2, 0, 0));
+    return _mm_shuffle_ps(conf01, conf23, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+uint32_t FilterSimd4(const float* output, uint32_t boxNum, float threshold, uint32_t* candidates)
+{
+    const __m128 thresholdVec = _mm_set1_ps(threshold);
+    uint32_t num = 0;
+    uint32_t i = 0;
+    for (; i + kLaneNum <= boxNum; i += kLaneNum) {
+        __m128 conf = LoadConfidence4(output + i * kBoxAttrNum);
+        uint32_t mask = _mm_movemask_ps(_mm_cmpge_ps(conf, thresholdVec));
+        num = AppendMask(mask, i, candidates, num);
+    }
+    return FilterScalar(output, i, boxNum, kBoxAttrNum, threshold, candidates, num);
+}
+
+// the same shuffles in both 128 bit lanes, the low lane is boxes 0~3 and the high lane 4~7,
+// built without -mavx and only called when the cpu supports it
+__attribute__((target("avx")))
+inline __m256 LoadLanes(const float* p, uint32_t offset)
+{
+    const uint32_t highOffset = kLaneNum * kBoxAttrNum;
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + offset)),
+                                _mm_loadu_ps(p + highOffset + offset), 1);
+}
+
+__attribute__((target("avx")))
+uint32_t FilterSimd8(const float* output, uint32_t boxNum, float threshold, uint32_t* candidates)
+{
+    const __m256 thresholdVec = _mm256_set1_ps(threshold);
+    uint32_t num = 0;
+    uint32_t i = 0;
+    for (; i + kAvxLaneNum <= boxNum; i += kAvxLaneNum) {
+        const float* p = output + i * kBoxAttrNum;
+        __m256 conf01 = _mm256_shuffle_ps(LoadLanes(p, 4), LoadLanes(p, 8), _MM_SHUFFLE(2, 2, 0, 0));
+        __m256 conf23 = _mm256_shuffle_ps(LoadLanes(p, 16), LoadLanes(p, 20), _MM_SHUFFLE(2, 2, 0, 0));
+        __m256 conf = _mm256_shuffle_ps(conf01, conf23, _MM_SHUFFLE(2, 0, 2, 0));
+        uint32_t mask = _mm256_movemask_ps(_mm256_cmp_ps(conf, thresholdVec, _CMP_GE_OQ));
+        num = AppendMask(mask, i, candidates, num);
+    }
+    return FilterScalar(output, i, boxNum, kBoxAttrNum, threshold, candidates, num);
+}
+#endif
+
+// the widest simd of the cpu, not wider than the config
+uint32_t SelectSimdWidth(uint32_t configWidth)
+{
+    uint32_t maxWidth = (configWidth == 0) ? kAvxLaneNum : configWidth;
+#if defined(__aarch64__)
+    return (maxWidth >= kLaneNum) ? kLaneNum : kScalarLaneNum;
+#elif defined(__SSE2__)
+    if ((maxWidth >= kAvxLaneNum) && __builtin_cpu_supports("avx")) {
+        return kAvxLaneNum;
+    }
+    return (maxWidth >= kLaneNum) ? kLaneNum : kScalarLaneNum;
+#else
+    return kScalarLaneNum;
+#endif
+}
+}
+
+YoloV10Decoder::YoloV10Decoder(const YoloV10DecoderConfig& config)
+    :config_(config), boxNum_(0), attrNum_(0), simdWidth_(kScalarLaneNum)
+{
+    for (size_t i = 0; i < config_.classFilter.size(); i++) {
+        uint32_t classIndex = config_.classFilter[i];
+        if (classIndex >= classEnabled_.size()) {
+            classEnabled_.resize(classIndex + 1, false);
+        }
+        classEnabled_[classIndex] = true;
+    }
+}
+
+YoloV10Decoder::~YoloV10Decoder()
+{
+}
+
+AclLiteError YoloV10Decoder::Init(const ModelOutputInfo& outputInfo)
+{
+    if (outputInfo.dataType != ACL_FLOAT) {
+        ACLLITE_LOG_ERROR("The detect output data type %d is not float", outputInfo.dataType);
+        return ACLLITE_ERROR;
+    }
+    const aclmdlIODims& dims = outputInfo.dims;
+    if (dims.dimCount < 2) {
+        ACLLITE_LOG_ERROR("The detect output dim count %zu is invalid", dims.dimCount);
+        return ACLLITE_ERROR;
+    }
+    int64_t boxNum = dims.dims[dims.dimCount - 2];
+    int64_t attrNum = dims.dims[dims.dimCount - 1];
+    if ((boxNum <= 0) || (attrNum < kBoxAttrNum)) {
+        ACLLITE_LOG_ERROR("The detect output shape [%ld, %ld] is not [boxNum, %u]",
+                          boxNum, attrNum, kBoxAttrNum);
+        return ACLLITE_ERROR;
+    }
+    boxNum_ = boxNum;
+    attrNum_ = attrNum;
+    candidates_.resize(boxNum_);
+    // the simd filter reads the boxes of 6 values as contiguous vectors
+    simdWidth_ = (attrNum_ == kBoxAttrNum) ? SelectSimdWidth(config_.simdWidth) : kScalarLaneNum;
+    ACLLITE_LOG_INFO("YoloV10 decoder: %u boxes, %u values per box, threshold %f, max dets %u, "
+                     "%u boxes compared at once",
+                     boxNum_, attrNum_, config_.confThreshold, config_.maxDets, simdWidth_);
+    return ACLLITE_OK;
+}
+
+uint32_t YoloV10Decoder::FilterConfidence(const float* output)
+{
+    float threshold = config_.confThreshold;
+    uint32_t* candidates = candidates_.data();
+#if defined(__aarch64__)
+    if (simdWidth_ == kLaneNum) {
+        return FilterSimd4(output, boxNum_, threshold, candidates);
+    }
+#elif defined(__SSE2__)
+    if (simdWidth_ == kAvxLaneNum) {
+        return FilterSimd8(output, boxNum_, threshold, candidates);
+    }
+    if (simdWidth_ == kLaneNum) {
+        return FilterSimd4(output, boxNum_, threshold, candidates);
+    }
+#endif
+    return FilterScalar(output, 0, boxNum_, attrNum_, threshold, candidates, 0);
+}
+
+void YoloV10Decoder::MapBoxes(const float* output, uint32_t candidateNum,
+                              const LetterboxInfo& letterbox, vector<DetectBox>& boxes)
+{
+    // source = (model - pad) / scale, for (left, top, right, bottom) at once
+    const float padLeft = letterbox.padLeft;
+    const float padTop = letterbox.padTop;
+    const float invScaleX = 1.0f / letterbox.scaleX;
+    const float invScaleY = 1.0f / letterbox.scaleY;
+    const float offsetArr[kLaneNum] = {padLeft, padTop, padLeft, padTop};
+    const float scaleArr[kLaneNum] = {invScaleX, invScaleY, invScaleX, invScaleY};
+#if defined(__aarch64__)
+    const float32x4_t offset = vld1q_f32(offsetArr);
+    const float32x4_t scale = vld1q_f32(scaleArr);
+#elif defined(__SSE2__)
+    const __m128 offset = _mm_loadu_ps(offsetArr);
+    const __m128 scale = _mm_loadu_ps(scaleArr);
+#endif
+    bool filterClass = !classEnabled_.empty();
+    for (uint32_t n = 0; n < candidateNum; n++) {
+        const float* p = output + candidates_[n] * attrNum_;
+        // a float out of the uint32 range is undefined to convert, so check it before,
+        // the negated comparison also drops NaN
+        float classValue = p[kClassIndex];
+        if (!((classValue >= 0) && (classValue < kClassNum))) {
+            continue;
+        }
+        uint32_t classIndex = (uint32_t)classValue;
+        if (filterClass && ((classIndex >= classEnabled_.size()) || !classEnabled_[classIndex])) {
+            continue;
+        }
+        float coord[kLaneNum];
+#if defined(__aarch64__)
+        vst1q_f32(coord, vmulq_f32(vsubq_f32(vld1q_f32(p), offset), scale));
+#elif defined(__SSE2__)
+        _mm_storeu_ps(coord, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(p), offset), scale));
+#else
+        for (uint32_t k = 0; k < kLaneNum; k++) {
+            coord[k] = (p[k] - offsetArr[k]) * scaleArr[k];
+        }
+#endif
+        DetectBox box;
+        box.left = coord[0];
+        box.top = coord[1];
+        box.right = coord[2];
+        box.bottom = coord[3];
+        box.score = p[kConfidenceIndex];
+        box.classIndex = classIndex;
+        boxes.push_back(box);
+    }
+}
+
+void YoloV10Decoder::Decode(const float* output, const LetterboxInfo& letterbox, vector<DetectBox>& boxes)
+{
+    boxes.clear();
+    uint32_t candidateNum = FilterConfidence(output);
+    MapBoxes(output, candidateNum, letterbox, boxes);
+    if (boxes.size() > config_.maxDets) {
+        partial_sort(boxes.begin(), boxes.begin() + config_.maxDets, boxes.end(),
+                     [](const DetectBox& box1, const DetectBox& box2) { return box1.score > box2.score; });
+        boxes.resize(config_.maxDets);
+    }
+}
@@ -0,0 +1,96 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File yolov10Decoder.h
+* Description: decode yolov10 detect output into boxes of the source image
+*/
+#ifndef YOLOV10DECODER_H
+#define YOLOV10DECODER_H
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "AclLiteError.h"
+#include "AclLiteType.h"
+#include "Params.h"
+
+struct YoloV10DecoderConfig {
+    float confThreshold = 0.5;  // the boxes below the confidence are dropped
+    uint32_t maxDets = 300;  // keep the boxes with the highest confidence
+    std::vector<uint32_t> classFilter;  // the classes to keep, empty: keep all classes
+    uint32_t simdWidth = 0;  // the boxes compared at once, 0: the widest of the cpu, 1: no simd, 4: sse or neon, 8: avx
+};
+
+/**
+* YoloV10Decoder
+* The output of one image is [boxNum, attrNum], every box starts with
+* (left, top, right, bottom, confidence, class) in the model input coordinates.
+* The confidences of 8 boxes are loaded as contiguous vectors and compared at once
+* with AVX, or 4 boxes with SSE or NEON, only the boxes above the threshold are
+* mapped back to the source image. The boxes of a class out of the label table
+* are dropped.
+*/
+class YoloV10Decoder {
+public:
+    YoloV10Decoder(const YoloV10DecoderConfig& config);
+    ~YoloV10Decoder();
+
+    /**
+     * @brief get the box number and attribute number from the model output
+     * @param [in] outputInfo: the description of the detect output
+     * @return ACLLITE_OK: success; others: the output is not a yolov10 output
+     */
+    AclLiteError Init(const ModelOutputInfo& outputInfo);
+    bool IsInited()
+    {
+        return boxNum_ > 0;
+    }
+    uint32_t GetSimdWidth()
+    {
+        return simdWidth_;
+    }
+
+    /**
+     * @brief get the output size of one image
+     * @return the size in bytes
+     */
+    uint32_t GetImageOutputSize()
+    {
+        return boxNum_ * attrNum_ * sizeof(float);
+    }
+
+    /**
+     * @brief decode the output of one image
+     * @param [in] output: the output of the image on host
+     * @param [in] letterbox: the geometry of the image in the model input
+     * @param [out] boxes: the boxes in the source image coordinates
+     */
+    void Decode(const float* output, const LetterboxInfo& letterbox, std::vector<DetectBox>& boxes);
+
+private:
+    uint32_t FilterConfidence(const float* output);
+    void MapBoxes(const float* output, uint32_t candidateNum,
+                  const LetterboxInfo& letterbox, std::vector<DetectBox>& boxes);
+
+private:
+    YoloV10DecoderConfig config_;
+    uint32_t boxNum_;
+    uint32_t attrNum_;
+    uint32_t simdWidth_;
+    std::vector<bool> classEnabled_;
+    std::vector<uint32_t> candidates_;  // the boxes above the threshold
+};
+
+#endif
@@ -25,12 +25,16 @@
 using namespace std;
 
 namespace {
-const uint32_t kSleepTime = 500;
+const uint32_t kSendTimeoutMs = 100;
+const uint32_t kLetterboxWidthAlign = 16;
+const uint32_t kLetterboxAddrAlign = 128;
+const uint32_t kReserveTimeoutMs = 100;
 }
 
 DetectPreprocessThread::DetectPreprocessThread(uint32_t modelWidth, uint32_t modelHeight,
-    uint32_t batch)
-    :modelWidth_(modelWidth), modelHeight_(modelHeight), isReleased(false), batch_(batch)
+    uint32_t batch, shared_ptr<DetectBatchInput> batchInput)
+    :modelWidth_(modelWidth), modelHeight_(modelHeight), isReleased(false), batch_(batch),
+    letterbox_(false), batchInput_(batchInput)
 {
 }
 
@@ -49,6 +53,13 @@ AclLiteError DetectPreprocessThread::Init()
         ACLLITE_LOG_ERROR("Dvpp init failed, error %d", aclRet);
         return ACLLITE_ERROR;
     }
+    // vpc writes the batch slot directly when the slot meets the stride and address alignment
+    letterbox_ = (modelWidth_ % kLetterboxWidthAlign == 0) && (modelHeight_ % 2 == 0) &&
+        (YUV420SP_SIZE(modelWidth_, modelHeight_) % kLetterboxAddrAlign == 0);
+    if (!letterbox_) {
+        ACLLITE_LOG_WARNING("Model input %ux%u is not aligned for letterbox, use resize and border",
+                            modelWidth_, modelHeight_);
+    }
 
     return ACLLITE_OK;
 }
@@ -58,6 +69,7 @@ AclLiteError DetectPreprocessThread::Process(int msgId, shared_ptr<void> data)
     switch (msgId) {
         case MSG_PREPROC_DETECTDATA:
             MsgProcess(static_pointer_cast<DetectDataMsg>(data));
+            StampFrameStage(*static_pointer_cast<DetectDataMsg>(data), STAGE_PRE_DONE);
             MsgSend(static_pointer_cast<DetectDataMsg>(data));
             break;
         default:
@@ -68,12 +80,87 @@ AclLiteError DetectPreprocessThread::Process(int msgId, shared_ptr<void> data)
     return ACLLITE_OK;
 }
 
+/**
+ * @brief 缩放并填充单张图像到批次缓冲区（旧流程）
+ *
+ * 先Resize再Border到临时图像，然后拷贝到批次缓冲区，用于模型输入尺寸不满足letterbox对齐要求的场景。
+ */
+AclLiteError DetectPreprocessThread::ResizeAndBorder(uint8_t* dest, ImageData& srcImg, LetterboxInfo& info)
+{
+    ImageData resizedImg, BorderImg;
+    // 图像尺寸调整
+    float scale = min(modelWidth_ * 1.0 / srcImg.width * 1.0, modelHeight_ * 1.0 / srcImg.height * 1.0);
+    uint32_t resizeWidth = scale * srcImg.width;
+    uint32_t resizeHeight = scale * srcImg.height;
+
+    AclLiteError ret = dvpp_.Resize(resizedImg, srcImg, resizeWidth, resizeHeight);
+    if (ret == ACLLITE_ERROR) {
+        ACLLITE_LOG_ERROR("Resize image failed");
+        return ACLLITE_ERROR;
+    }
+    ret = dvpp_.Border(BorderImg, resizedImg, modelWidth_, modelHeight_);
+    if (ret == ACLLITE_ERROR) {
+        ACLLITE_LOG_ERROR("Border image failed");
+        return ACLLITE_ERROR;
+    }
+    // 将调整大小后的图像数据拷贝到批次缓冲区
+    uint32_t dataSize = YUV420SP_SIZE(modelWidth_, modelHeight_);
+    aclrtMemcpy(dest, dataSize, BorderImg.data.get(), BorderImg.size, ACL_MEMCPY_DEVICE_TO_DEVICE);
+
+    info.scaleX = scale;
+    info.scaleY = scale;
+    info.padLeft = (modelWidth_ - scale * srcImg.width) / 2;
+    info.padTop = (modelHeight_ - scale * srcImg.height) / 2;
+    return ACLLITE_OK;
+}
+
+/**
+ * @brief 获取消息的模型输入缓冲区
+ *
+ * 推理线程跨通道组批时，在其批次缓冲区中预留本消息的图像位置，VPC直接写入，推理线程无需再拷贝；
+ * 否则从dvpp内存池分配一个完整批次的缓冲区，随消息传递。
+ *
+ * @param detectDataMsg 消息对象
+ * @param bufferSize 输出缓冲区大小
+ * @return uint8_t* 第一张图像的地址，nullptr表示失败
+ */
+uint8_t* DetectPreprocessThread::GetInputBuffer(shared_ptr<DetectDataMsg> detectDataMsg, uint32_t& bufferSize)
+{
+    uint32_t dataSize = YUV420SP_SIZE(modelWidth_, modelHeight_);
+    if (batchInput_ != nullptr) {
+        // 所有批次都在推理时等待，与发送消息一样不丢帧
+        uint8_t* buffer = nullptr;
+        AclLiteError ret;
+        do {
+            ret = batchInput_->Reserve(detectDataMsg, dataSize, buffer, kReserveTimeoutMs);
+        } while (ret == ACLLITE_ERROR_ENQUEUE);
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Reserve batch input failed, error %d", ret);
+            return nullptr;
+        }
+        bufferSize = dataSize * detectDataMsg->decodedImg.size();
+        return buffer;
+    }
+    // 从dvpp内存池分配模型输入缓冲区，VPC可直接写入，消息释放后缓冲区归还内存池
+    bufferSize = dataSize * batch_;
+    void* buf = AclLiteMemPool::GetDvppPool().Alloc(bufferSize);
+    if (buf == nullptr) {
+        ACLLITE_LOG_ERROR("Malloc classify inference input buffer failed");
+        return nullptr;
+    }
+    // 更新消息中的模型输入图像数据
+    detectDataMsg->modelInputImg.data = SHARED_PTR_DVPP_BUF(buf);
+    detectDataMsg->modelInputImg.memType = MEMORY_DVPP;
+    detectDataMsg->modelInputImg.size = bufferSize;
+    return (uint8_t *)buf;
+}
+
 /**
  * @brief 目标检测预处理线程消息处理函数
  * 
  * 本函数负责对输入的图像数据进行预处理，以满足模型输入的要求。预处理过程包括：
- * 1. 从解码后的图像数据中读取并调整图像大小。
- * 2. 将调整大小后的图像数据拷贝到批次缓冲区中。
+ * 1. 等比例缩放解码后的图像并居中填充到模型输入尺寸。
+ * 2. 缩放填充结果由VPC直接写入批次缓冲区中该图像的位置，无中间图像和拷贝。
  * 
  * @param detectDataMsg 包含解码后图像数据的消息对象
  * @return AclLiteError 返回处理结果，ACL_LITE_OK表示成功，其他值表示错误代码
@@ -81,69 +168,54 @@ AclLiteError DetectPreprocessThread::Process(int msgId, shared_ptr<void> data)
 AclLiteError DetectPreprocessThread::MsgProcess(shared_ptr<DetectDataMsg> detectDataMsg)
 {
     AclLiteError ret;
-    
-    // 计算模型输入缓冲区大小
-    uint32_t  modelInputSize = YUV420SP_SIZE(modelWidth_, modelHeight_) * batch_;
-    void* buf = nullptr;
-    // 分配模型输入缓冲区，优先使用大页内存
-    ret = aclrtMalloc(&buf, modelInputSize, ACL_MEM_MALLOC_HUGE_FIRST);
-    if ((buf == nullptr) || (ret != ACL_ERROR_NONE)) {
-        ACLLITE_LOG_ERROR("Malloc classify inference input buffer failed, "
-                          "error %d", ret);
+
+    // 最后一帧消息没有图像，组批时不占用批次位置
+    if ((batchInput_ != nullptr) && detectDataMsg->decodedImg.empty()) {
+        return ACLLITE_OK;
+    }
+    uint32_t modelInputSize = 0;
+    uint8_t* batchBuffer = GetInputBuffer(detectDataMsg, modelInputSize);
+    if (batchBuffer == nullptr) {
         return ACLLITE_ERROR;
     }
-    // 将模型输入缓冲区置零
-    uint8_t* batchBuffer = (uint8_t *)buf;
-    int32_t setValue = 0;
-    aclrtMemset(batchBuffer, modelInputSize, setValue, modelInputSize);
-    
-    // 遍历解码后的图像数据，进行resize并拷贝到批次缓冲区
+    if (!letterbox_) {
+        // 旧流程只拷贝图像区域，将模型输入缓冲区置零
+        int32_t setValue = 0;
+        aclrtMemset(batchBuffer, modelInputSize, setValue, modelInputSize);
+    }
+
+    // 遍历解码后的图像数据，缩放填充到批次缓冲区
     size_t pos = 0;
+    uint32_t dataSize = YUV420SP_SIZE(modelWidth_, modelHeight_);
     for (int i = 0; i < detectDataMsg->decodedImg.size(); i++) {
-        ImageData resizedImg, BorderImg;
-        // 图像尺寸调整
-        float scale = min(modelWidth_ * 1.0 / detectDataMsg->decodedImg[i].width * 1.0, modelHeight_ * 1.0 / detectDataMsg->decodedImg[i].height * 1.0);
-        uint32_t resizeWidth = scale * detectDataMsg->decodedImg[i].width;
-        uint32_t resizeHeight = scale * detectDataMsg->decodedImg[i].height;
-        
-        ret = dvpp_.Resize(resizedImg,
-            detectDataMsg->decodedImg[i], resizeWidth, resizeHeight);
-        if (ret == ACLLITE_ERROR) {
-            ACLLITE_LOG_ERROR("Resize image failed");
-            return ACLLITE_ERROR;
+        LetterboxInfo info;
+        if (letterbox_) {
+            ret = dvpp_.Letterbox(batchBuffer + pos, detectDataMsg->decodedImg[i],
+                                  modelWidth_, modelHeight_, info);
+        } else {
+            ret = ResizeAndBorder(batchBuffer + pos, detectDataMsg->decodedImg[i], info);
         }
-        ret = dvpp_.Border(BorderImg,
-        resizedImg, modelWidth_, modelHeight_);
-        if (ret == ACLLITE_ERROR) {
-            ACLLITE_LOG_ERROR("Border image failed");
+        if (ret != ACLLITE_OK) {
+            ACLLITE_LOG_ERROR("Preprocess image %d failed", i);
             return ACLLITE_ERROR;
         }
-        // 将调整大小后的图像数据拷贝到批次缓冲区
-        uint32_t dataSize = YUV420SP_SIZE(modelWidth_, modelHeight_);
-        ret = aclrtMemcpy(batchBuffer + pos, dataSize,
-        BorderImg.data.get(), BorderImg.size, ACL_MEMCPY_DEVICE_TO_DEVICE);
+        detectDataMsg->letterbox.push_back(info);
         pos = pos + dataSize;
     }
-
-    // 更新消息中的模型输入图像数据
-    detectDataMsg->modelInputImg.data = SHARED_PTR_DEV_BUF(batchBuffer);
-    detectDataMsg->modelInputImg.size = modelInputSize;
     return ACLLITE_OK;
 }
 
 AclLiteError DetectPreprocessThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    while (1) {
-        AclLiteError ret = SendMessage(detectDataMsg->detectInferThreadId, MSG_DO_DETECT_INFER, detectDataMsg);
-        if (ret == ACLLITE_ERROR_ENQUEUE) {
-            usleep(kSleepTime);
-            continue;
-        } else if(ret == ACLLITE_OK) {
-            break;
-        } else {
-            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-            return ret;
-        }
+    AclLiteError ret;
+    StampFrameStage(*detectDataMsg, STAGE_INFER_ENQUEUE);
+    do {
+        ret = SendMessageBlocking(detectDataMsg->detectInferThreadId, MSG_DO_DETECT_INFER,
+                                  detectDataMsg, kSendTimeoutMs);
+    } while (ret == ACLLITE_ERROR_ENQUEUE);
+    if (ret != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+        return ret;
     }
     return ACLLITE_OK;
 }
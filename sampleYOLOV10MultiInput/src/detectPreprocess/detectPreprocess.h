@@ -27,17 +27,20 @@
 #include "AclLiteThread.h"
 #include "AclLiteImageProc.h"
 #include "Params.h"
+#include "../detectInference/detectBatchInput.h"
 
 class DetectPreprocessThread : public AclLiteThread {
 public:
     DetectPreprocessThread(uint32_t modelWidth, uint32_t modelHeight,
-    uint32_t batch);
+    uint32_t batch, std::shared_ptr<DetectBatchInput> batchInput = nullptr);
     ~DetectPreprocessThread();
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
     
 private:
     AclLiteError MsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError ResizeAndBorder(uint8_t* dest, ImageData& srcImg, LetterboxInfo& info);
+    uint8_t* GetInputBuffer(std::shared_ptr<DetectDataMsg> detectDataMsg, uint32_t& bufferSize);
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
 
 private:
@@ -46,6 +49,8 @@ private:
     AclLiteImageProc dvpp_;
     bool isReleased;
     uint32_t batch_;
+    bool letterbox_;  // resize and pad to the batch buffer in one vpc call
+    std::shared_ptr<DetectBatchInput> batchInput_;  // the batches of the inference thread, nullptr: own buffer
 };
 
 #endif
@@ -24,17 +24,21 @@
 #include <map>
 #include <json/json.h>
 #include <fstream>
+#include <unistd.h>
 #include "AclLiteResource.h"
 #include "AclLiteApp.h"
 #include "AclLiteThread.h"
 #include "AclLiteType.h"
 #include "AclLiteUtils.h"
+#include "LatencyTracer.h"
+#include "AclLiteMetrics.h"
 #include "Params.h"
 #include "dataInput/dataInput.h"
 #include "dataOutput/dataOutput.h"
 #include "detectInference/detectInference.h"
 #include "detectPreprocess/detectPreprocess.h"
 #include "detectPostprocess/detectPostprocess.h"
+#include "detectPostprocess/detectPostprocessPool.h"
 #include "pushrtsp/pushrtspthread.h"
 
 using namespace std;
@@ -46,6 +50,29 @@ uint32_t kBatch = 1;
 int kPostNum = 1;
 int kFramesPerSecond = 1000;
 uint32_t kMsgQueueSize = 3;
+uint32_t kBatchTimeoutMs = 0;
+uint32_t kAsyncSlotNum = 0;
+bool kLockFreeQueue = false;
+bool kPostPool = false;
+uint32_t kPostPoolThreads = 0;
+const uint32_t kDefaultMaxTraceFrames = 10000;
+uint32_t kMetricsPort = 0;
+string kMetricsFile = "";
+uint32_t kMetricsIntervalMs = 1000;
+Json::Value kThreadConfig;
+bool kAutoPlacement = false;
+// cpu_placement auto splits the cpus into groups of the pipeline stages
+const uint32_t kPlacementGroupNum = 4;
+const map<string, uint32_t> kPlacementGroups = {
+    {"dataInput", 0}, {"pre", 1}, {"infer", 1}, {"post", 2}, {"dataOutput", 3}, {"rtspDisplay", 3}
+};
+const int kMinNice = -20;
+const int kMaxNice = 19;
+const int kMaxFifoPriority = 99;
+// the names of FrameStage
+const vector<string> kStageNames = {
+    "decode", "pre_enqueue", "pre_done", "infer_enqueue", "infer_done", "post_done", "output"
+};
 uint32_t argNum = 2;
 }
 
@@ -56,6 +83,8 @@ int MainThreadProcess(uint32_t msgId,
         kExitCount--;
     }
      if (!kExitCount) {
+         // the threads are alive until WaitEnd
+         ReportThreadCpuTime();
          AclLiteApp& app = GetAclLiteAppInstance();
          app.WaitEnd();
          ACLLITE_LOG_INFO("Receive exit message, exit now");
@@ -64,6 +93,145 @@ int MainThreadProcess(uint32_t msgId,
     return ACLLITE_OK;
 }
 
+AclLiteQueuePolicy GetQueuePolicy(const Json::Value& ioInfo, const string& key)
+{
+    if (ioInfo[key].type() == Json::nullValue) {
+        return QUEUE_POLICY_BLOCK;
+    }
+    string policy = ioInfo[key].asString();
+    if (policy == "drop_oldest") {
+        return QUEUE_POLICY_DROP_OLDEST;
+    } else if (policy == "drop_newest") {
+        return QUEUE_POLICY_DROP_NEWEST;
+    } else if (policy != "block") {
+        ACLLITE_LOG_WARNING("Invalid %s: %s, use block instead", key.c_str(), policy.c_str());
+    }
+    return QUEUE_POLICY_BLOCK;
+}
+
+string GetVideoEncoder(const Json::Value& ioInfo)
+{
+    if (ioInfo["video_encoder"].type() == Json::nullValue) {
+        return "dvpp";
+    }
+    string encoder = ioInfo["video_encoder"].asString();
+    if ((encoder != "dvpp") && (encoder != "sw")) {
+        ACLLITE_LOG_WARNING("Invalid video_encoder: %s, use dvpp instead", encoder.c_str());
+        return "dvpp";
+    }
+    return encoder;
+}
+
+string GetVideoDecoder(const Json::Value& ioInfo)
+{
+    if (ioInfo["video_decoder"].type() == Json::nullValue) {
+        return "dvpp";
+    }
+    string decoder = ioInfo["video_decoder"].asString();
+    if ((decoder != "dvpp") && (decoder != "sw")) {
+        ACLLITE_LOG_WARNING("Invalid video_decoder: %s, use dvpp instead", decoder.c_str());
+        return "dvpp";
+    }
+    return decoder;
+}
+
+string GetCaptureMode(const Json::Value& ioInfo)
+{
+    if (ioInfo["capture_mode"].type() == Json::nullValue) {
+        return "queue";
+    }
+    string mode = ioInfo["capture_mode"].asString();
+    if ((mode != "queue") && (mode != "latest")) {
+        ACLLITE_LOG_WARNING("Invalid capture_mode: %s, use queue instead", mode.c_str());
+        return "queue";
+    }
+    return mode;
+}
+
+AclLiteError GetRtspEncodeConfig(const Json::Value& ioInfo, RtspEncodeConfig& config)
+{
+    string frameFormat = ioInfo["rtsp_frame_format"].asString();
+    if (!frameFormat.empty()) {
+        config.nv12Input = (frameFormat == "nv12");
+    }
+    if (!ioInfo["rtsp_codec"].isNull()) {
+        config.codec = ioInfo["rtsp_codec"].asString();
+    }
+    if (!ioInfo["rtsp_preset"].isNull()) {
+        config.preset = ioInfo["rtsp_preset"].asString();
+    }
+    config.bitRate = ioInfo.get("rtsp_bitrate", config.bitRate).asUInt();
+    config.gopSize = ioInfo.get("rtsp_gop", config.gopSize).asUInt();
+    config.frameRate = ioInfo.get("rtsp_fps", config.frameRate).asUInt();
+    config.width = ioInfo.get("rtsp_width", config.width).asUInt();
+    config.height = ioInfo.get("rtsp_height", config.height).asUInt();
+    config.encodeThreads = ioInfo.get("rtsp_encode_threads", config.encodeThreads).asInt();
+    config.adaptiveBitRate = ioInfo.get("rtsp_adaptive_bitrate", config.adaptiveBitRate).asBool();
+    if ((!frameFormat.empty() && frameFormat != "bgr" && frameFormat != "nv12") ||
+        (config.codec != "h264" && config.codec != "h265") || config.bitRate == 0 ||
+        config.gopSize == 0 || config.frameRate == 0 || (config.width % 2) || (config.height % 2) ||
+        ((config.width == 0) != (config.height == 0)) || config.encodeThreads < 0) {
+        ACLLITE_LOG_ERROR("Invaild rtsp config is given! rtsp_frame_format: %s, rtsp_codec: %s, "
+                          "rtsp_bitrate: %u, rtsp_gop: %u, rtsp_fps: %u, rtsp_width: %u, rtsp_height: %u, "
+                          "rtsp_encode_threads: %d", frameFormat.c_str(), config.codec.c_str(), config.bitRate,
+                          config.gopSize, config.frameRate, config.width, config.height, config.encodeThreads);
+        return ACLLITE_ERROR;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError ParseThreadSchedConfig(const Json::Value& stageConfig, const string& stage,
+                                   ThreadSchedConfig& config)
+{
+    if (stageConfig.isNull()) {
+        return ACLLITE_OK;
+    }
+    long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+    if (stageConfig["cpu_affinity"].isArray()) {
+        config.cpuAffinity.clear();
+        for (int i = 0; i < stageConfig["cpu_affinity"].size(); i++) {
+            int cpu = stageConfig["cpu_affinity"][i].asInt();
+            if (cpu < 0 || cpu >= cpuNum) {
+                ACLLITE_LOG_ERROR("Invaild cpu_affinity of %s: cpu %d, online cpu number %ld",
+                                  stage.c_str(), cpu, cpuNum);
+                return ACLLITE_ERROR;
+            }
+            config.cpuAffinity.push_back(cpu);
+        }
+    }
+    config.nice = stageConfig.get("nice", config.nice).asInt();
+    config.fifoPriority = stageConfig.get("sched_fifo", config.fifoPriority).asInt();
+    if (config.nice < kMinNice || config.nice > kMaxNice ||
+        config.fifoPriority < 0 || config.fifoPriority > kMaxFifoPriority) {
+        ACLLITE_LOG_ERROR("Invaild thread_config of %s: nice %d, sched_fifo %d",
+                          stage.c_str(), config.nice, config.fifoPriority);
+        return ACLLITE_ERROR;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError GetThreadSchedConfig(const Json::Value& ioInfo, const string& stage, ThreadSchedConfig& config)
+{
+    config = ThreadSchedConfig();
+    auto group = kPlacementGroups.find(stage);
+    if (kAutoPlacement && (group != kPlacementGroups.end())) {
+        long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = cpuNum * group->second / kPlacementGroupNum;
+             cpu < cpuNum * (group->second + 1) / kPlacementGroupNum; cpu++) {
+            config.cpuAffinity.push_back(cpu);
+        }
+    }
+    // the config of the channel overrides the config of the stage
+    AclLiteError ret = ParseThreadSchedConfig(kThreadConfig[stage], stage, config);
+    if (ret != ACLLITE_OK) {
+        return ret;
+    }
+    if (ioInfo.isNull()) {
+        return ACLLITE_OK;
+    }
+    return ParseThreadSchedConfig(ioInfo["thread_config"][stage], stage, config);
+}
+
 void CreateALLThreadInstance(vector<AclLiteThreadParam>& threadTbl, AclLiteResource& aclDev)
 {
     aclrtRunMode runMode = aclDev.GetRunMode();
@@ -77,10 +245,48 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam>& threadTbl, AclLiteResou
     }
     if (reader.parse(srcFile, root))
     {
+        if (root["msg_queue_type"].type() != Json::nullValue) {
+            // the rings are opt in, they beat the mutex queue only when sender and receiver run on their own cores
+            string queueType = root["msg_queue_type"].asString();
+            if ((queueType != "mutex") && (queueType != "lockfree")) {
+                ACLLITE_LOG_WARNING("Invalid msg_queue_type: %s, use mutex instead", queueType.c_str());
+            }
+            kLockFreeQueue = (queueType == "lockfree");
+        }
+        if (root["frame_pool_max_frames"].type() != Json::nullValue) {
+            AclLiteFramePool::GetInstance().SetMaxFrameNum(root["frame_pool_max_frames"].asUInt());
+        }
+        kPostPool = root.get("post_pool", false).asBool();
+        kPostPoolThreads = root.get("post_pool_threads", 0).asUInt();
+        kMetricsPort = root.get("metrics_port", 0).asUInt();
+        kMetricsFile = root.get("metrics_file", "").asString();
+        kMetricsIntervalMs = root.get("metrics_interval_ms", kMetricsIntervalMs).asUInt();
+        kThreadConfig = root["thread_config"];
+        string placement = root.get("cpu_placement", "none").asString();
+        if ((placement != "none") && (placement != "auto")) {
+            ACLLITE_LOG_WARNING("Invalid cpu_placement: %s, use none instead", placement.c_str());
+        }
+        long cpuNum = sysconf(_SC_NPROCESSORS_ONLN);
+        kAutoPlacement = (placement == "auto") && (cpuNum >= kPlacementGroupNum);
+        if ((placement == "auto") && !kAutoPlacement) {
+            ACLLITE_LOG_WARNING("cpu_placement auto needs %u cpus at least, online cpu number %ld",
+                                kPlacementGroupNum, cpuNum);
+        }
+        if (root.get("latency_trace", false).asBool()) {
+            LatencyTracer::GetInstance().Enable(kStageNames, root.get("latency_trace_file", "").asString(),
+                root.get("latency_trace_max_frames", kDefaultMaxTraceFrames).asUInt());
+        }
+        // Every pipeline edge has one sender except the shared inference thread,
+        // the output thread with several postprocess threads, the postprocess
+        // pool or the drop_oldest input, and the rtsp thread which also sends
+        // message to itself.
+        AclLiteQueueType spscQueue = kLockFreeQueue ? QUEUE_TYPE_SPSC : QUEUE_TYPE_MUTEX;
+        AclLiteQueueType mpscQueue = kLockFreeQueue ? QUEUE_TYPE_MPSC : QUEUE_TYPE_MUTEX;
+        uint32_t modelId = 0;
         for (int i = 0; i < root["device_config"].size(); i++)
         {
             // Create context on the device
-            uint32_t deviceId = root["device_config"][i]["device_id"].asInt();
+            int32_t deviceId = root["device_config"][i]["device_id"].asInt();
             if (deviceId < 0) {
                 ACLLITE_LOG_ERROR("Invaild deviceId: %d", deviceId);
                 return;
@@ -112,19 +318,65 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam>& threadTbl, AclLiteResou
                     kFramesPerSecond =  root["device_config"][i]["model_config"][j]["frames_per_second"].asInt();
                 }
 
+                if (root["device_config"][i]["model_config"][j]["batch_timeout_ms"].type() != Json::nullValue)
+                {
+                    kBatchTimeoutMs = root["device_config"][i]["model_config"][j]["batch_timeout_ms"].asUInt();
+                }
+
+                if (root["device_config"][i]["model_config"][j]["async_slots"].type() != Json::nullValue)
+                {
+                    kAsyncSlotNum = root["device_config"][i]["model_config"][j]["async_slots"].asUInt();
+                }
+
+                YoloV10DecoderConfig decoderConfig;
+                if (root["device_config"][i]["model_config"][j]["conf_threshold"].type() != Json::nullValue)
+                {
+                    decoderConfig.confThreshold = root["device_config"][i]["model_config"][j]["conf_threshold"].asFloat();
+                }
+
+                if (root["device_config"][i]["model_config"][j]["max_dets"].type() != Json::nullValue)
+                {
+                    decoderConfig.maxDets = root["device_config"][i]["model_config"][j]["max_dets"].asUInt();
+                }
+
+                for (int k = 0; k < root["device_config"][i]["model_config"][j]["class_filter"].size(); k++)
+                {
+                    decoderConfig.classFilter.push_back(
+                        root["device_config"][i]["model_config"][j]["class_filter"][k].asUInt());
+                }
+
+                if (decoderConfig.confThreshold < 0 || decoderConfig.confThreshold > 1 || decoderConfig.maxDets < 1) {
+                    ACLLITE_LOG_ERROR("Invaild decoder config is given! confThreshold: %f, maxDets: %u",
+                                      decoderConfig.confThreshold, decoderConfig.maxDets);
+                    return;
+                }
+
                 if (modelWidth < 0 || modelHeigth < 0 || kBatch < 1 || kPostNum < 1 || kFramesPerSecond < 1) {
                     ACLLITE_LOG_ERROR("Invaild model config is given! modelWidth: %d, modelHeigth: %d,"
                                       "batch: %d, postNum: %d, framesPerSecond: %d",
                                       modelWidth, modelHeigth, kBatch, kPostNum, kFramesPerSecond);
                     return;
                 }
+                // With batch_timeout_ms the inference thread gathers the frames of all channels
+                // into one model batch, so every channel sends one frame per message.
+                uint32_t batchTimeoutMs = (kBatch > 1) ? kBatchTimeoutMs : 0;
+                uint32_t channelBatch = (batchTimeoutMs > 0) ? 1 : kBatch;
                 // Create inferThread
                 AclLiteThreadParam inferParam;
-                inferParam.threadInst = new DetectInferenceThread(modelPath);
+                DetectInferenceThread* inferThread = new DetectInferenceThread(modelPath, kBatch, batchTimeoutMs,
+                    kAsyncSlotNum);
+                inferParam.threadInst = inferThread;
                 inferParam.threadInstName.assign(inferName.c_str());
                 inferParam.context = context;
                 inferParam.runMode = runMode;
+                inferParam.queueType = mpscQueue;
+                if (GetThreadSchedConfig(Json::Value(), "infer", inferParam.sched) != ACLLITE_OK) {
+                    return;
+                }
                 threadTbl.push_back(inferParam);
+                // the pool replaces the postnum postprocess threads of every channel,
+                // so one last frame message and one encode finish message are sent
+                int postNum = kPostPool ? 1 : kPostNum;
                 for (int k = 0; k < root["device_config"][i]["model_config"][j]["io_info"].size(); k++)
                 {
                     // Get all information for each input data:
@@ -133,6 +385,15 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam>& threadTbl, AclLiteResou
                     string outputPath = root["device_config"][i]["model_config"][j]["io_info"][k]["output_path"].asString();
                     string outputType = root["device_config"][i]["model_config"][j]["io_info"][k]["output_type"].asString();
                     uint32_t channelId =  root["device_config"][i]["model_config"][j]["io_info"][k]["channel_id"].asInt();
+                    AclLiteQueuePolicy inputQueuePolicy =
+                        GetQueuePolicy(root["device_config"][i]["model_config"][j]["io_info"][k], "input_queue_policy");
+                    AclLiteQueuePolicy outputQueuePolicy =
+                        GetQueuePolicy(root["device_config"][i]["model_config"][j]["io_info"][k], "output_queue_policy");
+                    RtspEncodeConfig rtspConfig;
+                    if (GetRtspEncodeConfig(root["device_config"][i]["model_config"][j]["io_info"][k],
+                                            rtspConfig) != ACLLITE_OK) {
+                        return;
+                    }
                     string dataInputName = kDataInputName + to_string(channelId);
                     string preName = kPreName + to_string(channelId);
                     string dataOutputName = kDataOutputName + to_string(channelId);
@@ -140,50 +401,100 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam>& threadTbl, AclLiteResou
                     // Create Thread for the input data:
                     AclLiteThreadParam dataInputParam;
                     dataInputParam.threadInst = new DataInputThread(deviceId, channelId, runMode,
-                        inputType, inputPath, inferName, kPostNum, kBatch, kFramesPerSecond);
+                        inputType, inputPath, inferName, postNum, channelBatch, kFramesPerSecond, inputQueuePolicy,
+                        GetCaptureMode(root["device_config"][i]["model_config"][j]["io_info"][k]),
+                        root["device_config"][i]["model_config"][j]["io_info"][k].get("skip_non_ref_frame", false).asBool(),
+                        GetVideoDecoder(root["device_config"][i]["model_config"][j]["io_info"][k]),
+                        root["device_config"][i]["model_config"][j]["io_info"][k].get("sw_decode_threads", 0).asUInt());
                     dataInputParam.threadInstName.assign(dataInputName.c_str());
                     dataInputParam.context = context;
                     dataInputParam.runMode = runMode;
                     dataInputParam.queueSize = kMsgQueueSize;
+                    dataInputParam.queueType = spscQueue;
+                    if (GetThreadSchedConfig(root["device_config"][i]["model_config"][j]["io_info"][k],
+                                             "dataInput", dataInputParam.sched) != ACLLITE_OK) {
+                        return;
+                    }
                     threadTbl.push_back(dataInputParam);
 
                     AclLiteThreadParam detectPreParam;
-                    detectPreParam.threadInst = new DetectPreprocessThread(modelWidth, modelHeigth, kBatch);
+                    detectPreParam.threadInst = new DetectPreprocessThread(modelWidth, modelHeigth, channelBatch,
+                        inferThread->GetBatchInput());
                     detectPreParam.threadInstName.assign(preName.c_str());
                     detectPreParam.context = context;
                     detectPreParam.runMode = runMode;
                     detectPreParam.queueSize = kMsgQueueSize;
+                    detectPreParam.queueType = spscQueue;
+                    if (GetThreadSchedConfig(root["device_config"][i]["model_config"][j]["io_info"][k],
+                                             "pre", detectPreParam.sched) != ACLLITE_OK) {
+                        return;
+                    }
                     threadTbl.push_back(detectPreParam);
-                    for (int m= 0; m < kPostNum; m++)
+                    RenderFormat renderFormat =
+                        DetectRender::GetRenderFormat(outputType, rtspConfig.nv12Input ? "nv12" : "bgr");
+                    if (kPostPool) {
+                        PostChannelConfig postConfig;
+                        postConfig.modelId = modelId;
+                        postConfig.modelWidth = modelWidth;
+                        postConfig.modelHeight = modelHeigth;
+                        postConfig.batch = channelBatch;
+                        postConfig.decoderConfig = decoderConfig;
+                        postConfig.renderFormat = renderFormat;
+                        postConfig.runMode = runMode;
+                        postConfig.context = context;
+                        DetectPostprocessPool::GetInstance().AddChannel(channelId, postConfig);
+                    }
+                    for (int m = 0; (m < kPostNum) && !kPostPool; m++)
                     {
                         string postName = kPostName + to_string(channelId) + "_" + to_string(m);
                         AclLiteThreadParam detectPostParam;
                         detectPostParam.threadInst = new DetectPostprocessThread(modelWidth, modelHeigth,
-                            runMode, kBatch);
+                            runMode, channelBatch, decoderConfig, renderFormat);
                         detectPostParam.threadInstName.assign(postName.c_str());
                         detectPostParam.context = context;
                         detectPostParam.runMode = runMode;
+                        detectPostParam.queueType = spscQueue;
+                        if (GetThreadSchedConfig(root["device_config"][i]["model_config"][j]["io_info"][k],
+                                                 "post", detectPostParam.sched) != ACLLITE_OK) {
+                            return;
+                        }
                         threadTbl.push_back(detectPostParam);
                     }
                     
                     AclLiteThreadParam dataOutputParam;
-                    dataOutputParam.threadInst = new DataOutputThread(runMode, outputType, outputPath, kPostNum);
+                    dataOutputParam.threadInst = new DataOutputThread(runMode, outputType, outputPath, postNum,
+                        outputQueuePolicy, GetVideoEncoder(root["device_config"][i]["model_config"][j]["io_info"][k]),
+                        root["device_config"][i]["model_config"][j]["io_info"][k].get("output_reorder_wait_ms", 1000).asUInt());
                     dataOutputParam.threadInstName.assign(dataOutputName.c_str());
                     dataOutputParam.context = context;
                     dataOutputParam.runMode = runMode;
+                    // under drop_oldest dataInput also tells dataOutput the frames it evicted
+                    bool multiSender = kPostPool || (kPostNum > 1) || (inputQueuePolicy == QUEUE_POLICY_DROP_OLDEST);
+                    dataOutputParam.queueType = multiSender ? mpscQueue : spscQueue;
+                    if (GetThreadSchedConfig(root["device_config"][i]["model_config"][j]["io_info"][k],
+                                             "dataOutput", dataOutputParam.sched) != ACLLITE_OK) {
+                        return;
+                    }
                     threadTbl.push_back(dataOutputParam);
 
                     if (outputType == "rtsp")
                     {
                         AclLiteThreadParam rtspDisplayThreadParam;
-                        rtspDisplayThreadParam.threadInst = new PushRtspThread(outputPath + to_string(channelId));
+                        rtspDisplayThreadParam.threadInst = new PushRtspThread(outputPath + to_string(channelId),
+                            rtspConfig);
                         rtspDisplayThreadParam.threadInstName.assign(rtspDisplayName.c_str());
                         rtspDisplayThreadParam.context = context;
                         rtspDisplayThreadParam.runMode = runMode;
+                        rtspDisplayThreadParam.queueType = mpscQueue;
+                        if (GetThreadSchedConfig(root["device_config"][i]["model_config"][j]["io_info"][k],
+                                                 "rtspDisplay", rtspDisplayThreadParam.sched) != ACLLITE_OK) {
+                            return;
+                        }
                         threadTbl.push_back(rtspDisplayThreadParam);
                     }
                     kExitCount++;
                 }
+                modelId++;
             }
         }
     }
@@ -192,11 +503,19 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam>& threadTbl, AclLiteResou
 
 void ExitApp(AclLiteApp& app, vector<AclLiteThreadParam>& threadTbl)
 {
+    // the workers send to the output threads and hold buffers of the contexts
+    DetectPostprocessPool::GetInstance().Stop();
+    LatencyTracer::GetInstance().Report();
+    AclLiteMetrics::GetInstance().StopExport();
     for (int i = 0; i < threadTbl.size(); i++) {
         aclrtSetCurrentContext(threadTbl[i].context);
         delete threadTbl[i].threadInst;
     }
     app.Exit();
+    // the cached buffers belong to the contexts
+    AclLiteMemPool::GetDevicePool().Release();
+    AclLiteMemPool::GetDvppPool().Release();
+    AclLiteFramePool::GetInstance().Release();
 
     for (int i = 0; i < kContext.size(); i++) {
         aclrtDestroyContext(kContext[i]);
@@ -217,8 +536,25 @@ void StartApp(AclLiteResource& aclDev)
         ExitApp(app, threadTbl);
         return;
     }
+    // the pool spreads over all cpus unless its workers are placed explicitly
+    ThreadSchedConfig poolSched;
+    if (ParseThreadSchedConfig(kThreadConfig["post_pool"], "post_pool", poolSched) != ACLLITE_OK) {
+        ExitApp(app, threadTbl);
+        return;
+    }
+    ret = DetectPostprocessPool::GetInstance().Start(kPostPoolThreads, poolSched);
+    if (ret != ACLLITE_OK) {
+        ExitApp(app, threadTbl);
+        return;
+    }
+    AddThreadCpuTimeMetrics();
+    // the pipeline runs without metrics if the port is in use
+    (void)AclLiteMetrics::GetInstance().StartExport(kMetricsPort, kMetricsFile, kMetricsIntervalMs);
 
-    for (int i = 0; i < threadTbl.size(); i++) {
+    // Start the downstream threads first, so the start message is the only one
+    // sent by main thread before the upstream thread begins to send data on the
+    // single producer queues.
+    for (int i = threadTbl.size() - 1; i >= 0; i--) {
         ret = SendMessage(threadTbl[i].threadInstId, MSG_APP_START, nullptr);
     }
     app.Wait(MainThreadProcess, nullptr);
@@ -1,14 +1,29 @@
 #include "pictortsp.h"
 #include "AclLiteApp.h"
+#include "AclLiteThreadSched.h"
 using namespace cv;
 using namespace std;
 namespace {
     const string g_avFormat = "rtsp";
-    const uint32_t g_bitRate = 2000000;
-    const uint32_t g_gopSize = 12;
-    const uint16_t g_frameRate = 15;
+    const uint32_t kPacketQueueSize = 64;
+    const uint32_t kPacketWaitMs = 100;
+    // adaptive bitrate: a level down when a quarter of the packet queue is used, a level up
+    // when the queue is drained in kIdleCheckNum checks in a row. the stream size is kept,
+    // it is announced in the sdp of the session and can not change while pushing
+    const uint32_t kCongestedPacketNum = kPacketQueueSize / 4;
+    const uint32_t kIdlePacketNum = 1;
+    const uint32_t kIdleCheckNum = 3;
+    const double kAdaptBitRateRatios[] = {1.0, 0.75, 0.56, 0.42, 0.32, 0.24, 0.18, 0.125};  // of rtsp_bitrate
+    const uint32_t kAdaptLevelNum = sizeof(kAdaptBitRateRatios) / sizeof(kAdaptBitRateRatios[0]);
+    const uint64_t kEncodeStatFrameNum = 300;
+    const double kUsPerMs = 1000.0;
+
+    void FreeFrameData(void* opaque, uint8_t* data)
+    {
+        delete static_cast<std::shared_ptr<uint8_t>*>(opaque);
+    }
 }
-PicToRtsp::PicToRtsp()
+PicToRtsp::PicToRtsp() : g_pktQueue(kPacketQueueSize), g_writeExit(false), g_writeFailed(false)
 {
     this->g_bgrToRtspFlag = false;
     this->g_yuvToRtspFlag = false;
@@ -20,10 +35,17 @@ PicToRtsp::PicToRtsp()
     this->g_imgCtx = NULL;
     this->g_yuvSize = 0;
 	this->g_rgbSize = 0;
+    this->g_nv12ScaleCtx = NULL;
+    this->g_adaptFrameCnt = 0;
+    this->g_adaptLevel = 0;
+    this->g_idleCheckCnt = 0;
+    this->g_encodeFrameCnt = 0;
+    this->g_encodeTimeMs = 0;
 }
 
 PicToRtsp::~PicToRtsp()
 {
+    StopWritePacket();
     av_packet_free(&g_pkt);
     avcodec_close(g_codecCtx);
     if (g_fmtCtx) {
@@ -32,48 +54,30 @@ PicToRtsp::~PicToRtsp()
     }
 }
 
-int PicToRtsp::AvInit(int picWidth, int picHeight, std::string g_outFile)
+int PicToRtsp::OpenEncoder(int width, int height, int64_t bitRate)
 {
-    avformat_network_init();
-    if (avformat_alloc_output_context2(&g_fmtCtx, NULL, g_avFormat.c_str(), g_outFile.c_str()) < 0) {
-        ACLLITE_LOG_ERROR("Cannot alloc output file context");
-        return ACLLITE_ERROR;
-    }
-    av_opt_set(g_fmtCtx->priv_data, "rtsp_transport", "tcp", 0);
-    av_opt_set(g_fmtCtx->priv_data, "tune", "zerolatency", 0);
-    av_opt_set(g_fmtCtx->priv_data, "preset", "superfast", 0);
-
-    g_codec = avcodec_find_encoder(AV_CODEC_ID_H264);
-    if (g_codec == NULL) {
-        ACLLITE_LOG_ERROR("Cannot find any endcoder");
-        return ACLLITE_ERROR;
-    }
-
     g_codecCtx = avcodec_alloc_context3(g_codec);
     if (g_codecCtx == NULL) {
         ACLLITE_LOG_ERROR("Cannot alloc context");
         return ACLLITE_ERROR;
     }
-    
-    g_avStream = avformat_new_stream(g_fmtCtx, g_codec);
-    if (g_avStream == NULL) {
-        ACLLITE_LOG_ERROR("failed create new video stream");
+
+    AVCodecParameters* param = avcodec_parameters_alloc();
+    if (param == NULL) {
+        ACLLITE_LOG_ERROR("Cannot alloc codec parameters");
         return ACLLITE_ERROR;
     }
-
-    g_avStream->time_base = AVRational{1, g_frameRate};
-
-    AVCodecParameters* param = g_fmtCtx->streams[g_avStream->index]->codecpar;
     param->codec_type = AVMEDIA_TYPE_VIDEO;
-    param->width = picWidth;
-    param->height = picHeight;
-
+    param->width = width;
+    param->height = height;
     avcodec_parameters_to_context(g_codecCtx, param);
+    avcodec_parameters_free(&param);
 
-    g_codecCtx->pix_fmt = AV_PIX_FMT_NV12;
-    g_codecCtx->time_base = AVRational{1, g_frameRate};
-    g_codecCtx->bit_rate = g_bitRate;
-    g_codecCtx->gop_size = g_gopSize;
+    // libx265 has no NV12 input, the NV12 image is converted for it
+    g_codecCtx->pix_fmt = (g_codec->id == AV_CODEC_ID_HEVC) ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_NV12;
+    g_codecCtx->time_base = AVRational{1, (int)g_config.frameRate};
+    g_codecCtx->bit_rate = bitRate;
+    g_codecCtx->gop_size = g_config.gopSize;
     g_codecCtx->max_b_frames = 0;
 
     if (g_codecCtx->codec_id == AV_CODEC_ID_H264) {
@@ -85,10 +89,51 @@ int PicToRtsp::AvInit(int picWidth, int picHeight, std::string g_outFile)
     if (g_codecCtx->codec_id == AV_CODEC_ID_MPEG1VIDEO)
         g_codecCtx->mb_decision = 2;
 
-    if (avcodec_open2(g_codecCtx, g_codec, NULL) < 0) {
+    // tune and preset are encoder options, slice threads add no frame delay to the live stream
+    av_opt_set(g_codecCtx->priv_data, "tune", "zerolatency", 0);
+    av_opt_set(g_codecCtx->priv_data, "preset", g_config.preset.c_str(), 0);
+    g_codecCtx->thread_count = g_config.encodeThreads;
+    g_codecCtx->thread_type = FF_THREAD_SLICE;
+
+    // the slice threads of the encoder are not pinned with the rtsp thread
+    AclLiteError openRet = RunOnAllCpus([this]() {
+        return (avcodec_open2(g_codecCtx, g_codec, NULL) < 0) ? ACLLITE_ERROR : ACLLITE_OK;
+    });
+    if (openRet != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("Open encoder failed");
         return ACLLITE_ERROR;
     }
+    return ACLLITE_OK;
+}
+
+int PicToRtsp::AvInit(int picWidth, int picHeight, std::string g_outFile, const RtspEncodeConfig& config)
+{
+    g_config = config;
+    avformat_network_init();
+    if (avformat_alloc_output_context2(&g_fmtCtx, NULL, g_avFormat.c_str(), g_outFile.c_str()) < 0) {
+        ACLLITE_LOG_ERROR("Cannot alloc output file context");
+        return ACLLITE_ERROR;
+    }
+    av_opt_set(g_fmtCtx->priv_data, "rtsp_transport", "tcp", 0);
+
+    AVCodecID codecId = (g_config.codec == "h265") ? AV_CODEC_ID_HEVC : AV_CODEC_ID_H264;
+    g_codec = avcodec_find_encoder(codecId);
+    if (g_codec == NULL) {
+        ACLLITE_LOG_ERROR("Cannot find any endcoder of %s", g_config.codec.c_str());
+        return ACLLITE_ERROR;
+    }
+
+    g_avStream = avformat_new_stream(g_fmtCtx, g_codec);
+    if (g_avStream == NULL) {
+        ACLLITE_LOG_ERROR("failed create new video stream");
+        return ACLLITE_ERROR;
+    }
+
+    g_avStream->time_base = AVRational{1, (int)g_config.frameRate};
+
+    if (OpenEncoder(picWidth, picHeight, g_config.bitRate) != ACLLITE_OK) {
+        return ACLLITE_ERROR;
+    }
 
     avcodec_parameters_from_context(g_avStream->codecpar, g_codecCtx);
     av_dump_format(g_fmtCtx, 0, g_outFile.c_str(), 1);
@@ -99,38 +144,155 @@ int PicToRtsp::AvInit(int picWidth, int picHeight, std::string g_outFile)
         return ACLLITE_ERROR;
     }
     g_pkt = av_packet_alloc();
+    g_writeThread = std::thread(&PicToRtsp::WritePacketThread, this);
 
     return ACLLITE_OK;
 }
 
+void PicToRtsp::WritePacketThread()
+{
+    SetThreadName("rtsp_write");
+    while (true) {
+        AVPacket* pkt = g_pktQueue.WaitPop(kPacketWaitMs);
+        if (pkt == nullptr) {
+            // the packets queued before exit are still written
+            if (g_writeExit.load() && g_pktQueue.Empty()) {
+                break;
+            }
+            continue;
+        }
+        int ret = av_interleaved_write_frame(g_fmtCtx, pkt);
+        av_packet_free(&pkt);
+        if (ret < 0) {
+            // the connection is lost, the encoder stops waiting for this thread
+            ACLLITE_LOG_ERROR("Write rtsp packet failed, error %d, the following frames are dropped", ret);
+            g_writeFailed.store(true);
+            break;
+        }
+    }
+}
+
+void PicToRtsp::StopWritePacket()
+{
+    if (!g_writeThread.joinable()) {
+        return;
+    }
+    g_writeExit.store(true);
+    g_writeThread.join();
+    // the packets left by a failed writer
+    AVPacket* pkt = NULL;
+    while ((pkt = g_pktQueue.Pop()) != nullptr) {
+        av_packet_free(&pkt);
+    }
+}
+
+int PicToRtsp::ReopenEncoder(int64_t bitRate)
+{
+    // the packets of the old encoder are queued first, the new encoder starts with
+    // a key frame carrying the parameter sets in band, the size is not changed
+    int ret = EncodeFrame(NULL);
+    if (ret != ACLLITE_OK) {
+        return ACLLITE_ERROR;
+    }
+    int width = g_codecCtx->width;
+    int height = g_codecCtx->height;
+    avcodec_free_context(&g_codecCtx);
+    return OpenEncoder(width, height, bitRate);
+}
+
+int PicToRtsp::AdaptEncoder()
+{
+    // checked once per second
+    if (!g_config.adaptiveBitRate || (++g_adaptFrameCnt < g_config.frameRate)) {
+        return ACLLITE_OK;
+    }
+    g_adaptFrameCnt = 0;
+    uint32_t queuedNum = g_pktQueue.Size();
+    uint32_t level = g_adaptLevel;
+    if (queuedNum >= kCongestedPacketNum) {
+        level = std::min(level + 1, kAdaptLevelNum - 1);
+        g_idleCheckCnt = 0;
+    } else if ((queuedNum <= kIdlePacketNum) && (++g_idleCheckCnt >= kIdleCheckNum)) {
+        level = (level > 0) ? (level - 1) : 0;
+        g_idleCheckCnt = 0;
+    }
+    if (level == g_adaptLevel) {
+        return ACLLITE_OK;
+    }
+    g_adaptLevel = level;
+    int64_t bitRate = (int64_t)(g_config.bitRate * kAdaptBitRateRatios[level]);
+    ACLLITE_LOG_INFO("rtsp level %u: bitrate %ld -> %ld, %u packets wait for the network",
+                     level, (long)g_codecCtx->bit_rate, (long)bitRate, queuedNum);
+    // libx264 reconfigures itself when bit_rate of the context is changed, libx265 does not
+    if (g_codecCtx->codec_id == AV_CODEC_ID_H264) {
+        g_codecCtx->bit_rate = bitRate;
+        return ACLLITE_OK;
+    }
+    if (ReopenEncoder(bitRate) != ACLLITE_OK) {
+        ACLLITE_LOG_ERROR("Reopen rtsp encoder with bitrate %ld failed", (long)bitRate);
+        return ACLLITE_ERROR;
+    }
+    return ACLLITE_OK;
+}
+
+int PicToRtsp::EncodeFrame(AVFrame* frame)
+{
+    if (g_writeFailed.load()) {
+        return ACLLITE_ERROR;
+    }
+    timeval begin;
+    gettimeofday(&begin, NULL);
+    int ret = avcodec_send_frame(g_codecCtx, frame);
+    if (ret < 0) {
+        return ret;
+    }
+    while (avcodec_receive_packet(g_codecCtx, g_pkt) >= 0) {
+        g_pkt->stream_index = g_avStream->index;
+        av_packet_rescale_ts(g_pkt, g_codecCtx->time_base, g_avStream->time_base);
+        g_pkt->pos = -1;
+        AVPacket* pkt = av_packet_alloc();
+        av_packet_move_ref(pkt, g_pkt);
+        // the queue is bounded, the encoder waits when the network is slower than encoding
+        while (!g_pktQueue.WaitPush(pkt, kPacketWaitMs)) {
+            if (g_writeFailed.load() || !g_writeThread.joinable()) {
+                av_packet_free(&pkt);
+                return ACLLITE_ERROR;
+            }
+        }
+    }
+    if (frame == NULL) {
+        return ACLLITE_OK;
+    }
+    // the encode time includes the wait for a full packet queue
+    timeval end;
+    gettimeofday(&end, NULL);
+    g_encodeTimeMs += ((end.tv_sec - begin.tv_sec) * kUsPerMs * kUsPerMs + (end.tv_usec - begin.tv_usec)) / kUsPerMs;
+    if (++g_encodeFrameCnt % kEncodeStatFrameNum == 0) {
+        ACLLITE_LOG_INFO("rtsp %s preset %s %dx%d: encode %.2f ms/frame, bitrate %ld",
+                         g_config.codec.c_str(), g_config.preset.c_str(), g_codecCtx->width, g_codecCtx->height,
+                         g_encodeTimeMs / kEncodeStatFrameNum, (long)g_codecCtx->bit_rate);
+        g_encodeTimeMs = 0;
+    }
+    return ACLLITE_OK;
+}
+
 int PicToRtsp::FlushEncoder()
 {
     int ret;
+    if (!IsInited()) {
+        return ACLLITE_ERROR;
+    }
     int vStreamIndex = g_avStream->index;
-    AVPacket* pkt = av_packet_alloc();
-    pkt->data = NULL;
-    pkt->size = 0;
 
     if (!(g_codecCtx->codec->capabilities & AV_CODEC_CAP_DELAY)) {
-        av_packet_free(&pkt);
+        StopWritePacket();
         return ACLLITE_ERROR;
     }
 
     ACLLITE_LOG_INFO("Flushing stream %d encoder", vStreamIndex);
 
-    if ((ret = avcodec_send_frame(g_codecCtx, 0)) >= 0) {
-        while (avcodec_receive_packet(g_codecCtx, pkt) >= 0) {
-            pkt->stream_index = vStreamIndex;
-            av_packet_rescale_ts(pkt, g_codecCtx->time_base,
-                g_fmtCtx->streams[vStreamIndex]->time_base);
-            ret = av_interleaved_write_frame(g_fmtCtx, pkt);
-            if (ret < 0) {
-                ACLLITE_LOG_ERROR("error is: %d", ret);
-                break;
-            }
-        }
-    }
-    av_packet_free(&pkt);
+    ret = EncodeFrame(NULL);
+    StopWritePacket();
     av_write_trailer(g_fmtCtx);
 
     if (this->g_bgrToRtspFlag == true) {
@@ -142,6 +304,10 @@ int PicToRtsp::FlushEncoder()
         if (g_yuvFrame)
             av_frame_free(&g_yuvFrame);
     }
+    if (g_nv12ScaleCtx != NULL) {
+        sws_freeContext(g_nv12ScaleCtx);
+        g_nv12ScaleCtx = NULL;
+    }
     if (this->g_yuvToRtspFlag == true) {
         av_free(g_yuvBuf);
         if (g_yuvFrame)
@@ -150,72 +316,130 @@ int PicToRtsp::FlushEncoder()
     return ret;
 }
 
-void PicToRtsp::YuvDataInit()
+void PicToRtsp::AllocYuvFrame()
 {
-    if (this->g_yuvToRtspFlag == false) {
-        g_yuvFrame = av_frame_alloc();
-        g_yuvFrame->width = g_codecCtx->width;
-        g_yuvFrame->height = g_codecCtx->height;
-        g_yuvFrame->format = g_codecCtx->pix_fmt;
+    g_yuvFrame = av_frame_alloc();
+    g_yuvFrame->width = g_codecCtx->width;
+    g_yuvFrame->height = g_codecCtx->height;
+    g_yuvFrame->format = g_codecCtx->pix_fmt;
 
-        g_yuvSize = av_image_get_buffer_size(g_codecCtx->pix_fmt, g_codecCtx->width, g_codecCtx->height, 1);
-        
-        g_yuvBuf = (uint8_t*)av_malloc(g_yuvSize);
+    g_yuvSize = av_image_get_buffer_size(g_codecCtx->pix_fmt, g_codecCtx->width, g_codecCtx->height, 1);
 
-        int ret = av_image_fill_arrays(g_yuvFrame->data, g_yuvFrame->linesize,
+    g_yuvBuf = (uint8_t*)av_malloc(g_yuvSize);
+
+    av_image_fill_arrays(g_yuvFrame->data, g_yuvFrame->linesize,
         g_yuvBuf, g_codecCtx->pix_fmt,
         g_codecCtx->width, g_codecCtx->height, 1);
+}
+
+void PicToRtsp::YuvDataInit()
+{
+    if (this->g_yuvToRtspFlag == false) {
+        AllocYuvFrame();
         this->g_yuvToRtspFlag = true;
     }
 }
 
+int PicToRtsp::Nv12ToYuvFrame(const uint8_t* data, uint32_t width, uint32_t height,
+                              uint32_t stride, uint32_t rows)
+{
+    YuvDataInit();
+    // the same context is returned while the sizes and formats are not changed
+    g_nv12ScaleCtx = sws_getCachedContext(g_nv12ScaleCtx, width, height, AV_PIX_FMT_NV12,
+        g_codecCtx->width, g_codecCtx->height, g_codecCtx->pix_fmt,
+        SWS_BILINEAR, NULL, NULL, NULL);
+    if (g_nv12ScaleCtx == NULL) {
+        ACLLITE_LOG_ERROR("Create nv12 scale context of %ux%u failed", width, height);
+        return ACLLITE_ERROR;
+    }
+    const uint8_t* srcData[] = {data, data + stride * rows};
+    const int srcLinesize[] = {(int)stride, (int)stride};
+    sws_scale(g_nv12ScaleCtx, srcData, srcLinesize, 0, height, g_yuvFrame->data, g_yuvFrame->linesize);
+    return ACLLITE_OK;
+}
+
 int PicToRtsp::YuvDataToRtsp(void *dataBuf, uint32_t size, uint32_t seq)
 {
-    memcpy(g_yuvBuf, dataBuf, size);
+    // the NV12 image of the stream size, converted when the encoder takes another format
+    if (size != (uint32_t)YUV420SP_SIZE(g_codecCtx->width, g_codecCtx->height)) {
+        ACLLITE_LOG_ERROR("yuv data size %u is not of the stream size %dx%d",
+                          size, g_codecCtx->width, g_codecCtx->height);
+        return ACLLITE_ERROR;
+    }
+    if (AdaptEncoder() != ACLLITE_OK) {
+        return ACLLITE_ERROR;
+    }
+    YuvDataInit();
+    if (g_codecCtx->pix_fmt == AV_PIX_FMT_NV12) {
+        memcpy(g_yuvBuf, dataBuf, size);
+    } else if (Nv12ToYuvFrame((const uint8_t*)dataBuf, g_codecCtx->width, g_codecCtx->height,
+                              g_codecCtx->width, g_codecCtx->height) != ACLLITE_OK) {
+        return ACLLITE_ERROR;
+    }
     g_yuvFrame->pts = seq;
-    if (avcodec_send_frame(g_codecCtx, g_yuvFrame) >= 0) {
-        while (avcodec_receive_packet(g_codecCtx, g_pkt) >= 0) {
-            g_pkt->stream_index = g_avStream->index;
-            av_packet_rescale_ts(g_pkt, g_codecCtx->time_base, g_avStream->time_base);
-            g_pkt->pos = -1;
-            int ret = av_interleaved_write_frame(g_fmtCtx, g_pkt);
-            if (ret < 0) {
-                ACLLITE_LOG_ERROR("error is: %d", ret);
-            }
+    return (EncodeFrame(g_yuvFrame) == ACLLITE_OK) ? ACLLITE_OK : ACLLITE_ERROR;
+}
+
+int PicToRtsp::Nv12DataToRtsp(std::shared_ptr<uint8_t> data, uint32_t width, uint32_t height,
+                              uint32_t stride, uint32_t rows, uint32_t seq)
+{
+    if ((stride < width) || (rows < height)) {
+        ACLLITE_LOG_ERROR("nv12 image %ux%u is larger than stride %u rows %u", width, height, stride, rows);
+        return ACLLITE_ERROR;
+    }
+    if (AdaptEncoder() != ACLLITE_OK) {
+        return ACLLITE_ERROR;
+    }
+    // zero copy only when the encoder takes NV12 of the image size, h264 needs even width
+    // and height, the odd column or row is not encoded
+    if ((g_codecCtx->pix_fmt != AV_PIX_FMT_NV12) ||
+        ((width & ~1u) != (uint32_t)g_codecCtx->width) || ((height & ~1u) != (uint32_t)g_codecCtx->height)) {
+        if (Nv12ToYuvFrame(data.get(), width, height, stride, rows) != ACLLITE_OK) {
+            return ACLLITE_ERROR;
         }
+        g_yuvFrame->pts = seq;
+        return (EncodeFrame(g_yuvFrame) == ACLLITE_OK) ? ACLLITE_OK : ACLLITE_ERROR;
+    }
+    AVFrame* frame = av_frame_alloc();
+    if (frame == NULL) {
+        return ACLLITE_ERROR;
+    }
+    // the frame refers to the image of the caller, the reference is released by the encoder
+    frame->buf[0] = av_buffer_create(data.get(), stride * rows * 3 / 2, FreeFrameData,
+                                     new std::shared_ptr<uint8_t>(data), AV_BUFFER_FLAG_READONLY);
+    if (frame->buf[0] == NULL) {
+        av_frame_free(&frame);
+        return ACLLITE_ERROR;
     }
-	return ACLLITE_OK;
+    frame->data[0] = data.get();
+    frame->data[1] = data.get() + stride * rows;
+    frame->linesize[0] = stride;
+    frame->linesize[1] = stride;
+    frame->width = g_codecCtx->width;
+    frame->height = g_codecCtx->height;
+    frame->format = AV_PIX_FMT_NV12;
+    frame->pts = seq;
+    int ret = EncodeFrame(frame);
+    av_frame_free(&frame);
+    return (ret == ACLLITE_OK) ? ACLLITE_OK : ACLLITE_ERROR;
 }
 
 void PicToRtsp::BgrDataInint()
 {
     if (this->g_bgrToRtspFlag == false) {
         g_rgbFrame = av_frame_alloc();
-        g_yuvFrame = av_frame_alloc();
         g_rgbFrame->width = g_codecCtx->width;
-        g_yuvFrame->width = g_codecCtx->width;
         g_rgbFrame->height = g_codecCtx->height;
-        g_yuvFrame->height = g_codecCtx->height;
         g_rgbFrame->format = AV_PIX_FMT_BGR24;
-        g_yuvFrame->format = g_codecCtx->pix_fmt;
 
         g_rgbSize = av_image_get_buffer_size(AV_PIX_FMT_BGR24, g_codecCtx->width, g_codecCtx->height, 1);
-        g_yuvSize = av_image_get_buffer_size(g_codecCtx->pix_fmt, g_codecCtx->width, g_codecCtx->height, 1);
 
         g_brgBuf = (uint8_t*)av_malloc(g_rgbSize);
-        g_yuvBuf = (uint8_t*)av_malloc(g_yuvSize);
 
-        int ret = av_image_fill_arrays(g_rgbFrame->data, g_rgbFrame->linesize,
+        av_image_fill_arrays(g_rgbFrame->data, g_rgbFrame->linesize,
             g_brgBuf, AV_PIX_FMT_BGR24,
             g_codecCtx->width, g_codecCtx->height, 1);
-
-        ret = av_image_fill_arrays(g_yuvFrame->data, g_yuvFrame->linesize,
-            g_yuvBuf, g_codecCtx->pix_fmt,
-            g_codecCtx->width, g_codecCtx->height, 1);
-        g_imgCtx = sws_getContext(
-            g_codecCtx->width, g_codecCtx->height, AV_PIX_FMT_BGR24,
-            g_codecCtx->width, g_codecCtx->height, g_codecCtx->pix_fmt,
-            SWS_BILINEAR, NULL, NULL, NULL);
+        AllocYuvFrame();
         this->g_bgrToRtspFlag = true;
     }
 }
@@ -226,25 +450,22 @@ int PicToRtsp::BgrDataToRtsp(void *dataBuf, uint32_t size, uint32_t seq)
         ACLLITE_LOG_ERROR("bgr data size error, The data size should be %d, but the actual size is %d", g_rgbSize, size);
         return ACLLITE_ERROR;
     }
+    if (AdaptEncoder() != ACLLITE_OK) {
+        return ACLLITE_ERROR;
+    }
     memcpy(g_brgBuf, dataBuf, g_rgbSize);
+    // convert to the pixel format of the encoder
+    g_imgCtx = sws_getCachedContext(g_imgCtx,
+        g_rgbFrame->width, g_rgbFrame->height, AV_PIX_FMT_BGR24,
+        g_codecCtx->width, g_codecCtx->height, g_codecCtx->pix_fmt,
+        SWS_BILINEAR, NULL, NULL, NULL);
     sws_scale(g_imgCtx,
         g_rgbFrame->data,
         g_rgbFrame->linesize,
         0,
-        g_codecCtx->height,
+        g_rgbFrame->height,
         g_yuvFrame->data,
         g_yuvFrame->linesize);
     g_yuvFrame->pts = seq;
-    if (avcodec_send_frame(g_codecCtx, g_yuvFrame) >= 0) {
-        while (avcodec_receive_packet(g_codecCtx, g_pkt) >= 0) {
-            g_pkt->stream_index = g_avStream->index;
-            av_packet_rescale_ts(g_pkt, g_codecCtx->time_base, g_avStream->time_base);
-            g_pkt->pos = -1;
-            int ret = av_interleaved_write_frame(g_fmtCtx, g_pkt);
-            if (ret < 0) {
-                ACLLITE_LOG_ERROR("error is: %d", ret);
-            }
-        }
-    }
-	return ACLLITE_OK;
+    return (EncodeFrame(g_yuvFrame) == ACLLITE_OK) ? ACLLITE_OK : ACLLITE_ERROR;
 }
\ No newline at end of file
@@ -1,6 +1,22 @@
 #pragma once
+#include <atomic>
+#include <thread>
 #include "common.h"
 #include "AclLiteUtils.h"
+#include "ThreadSafeQueue.h"
+
+struct RtspEncodeConfig {
+    std::string codec = "h264";  // h264 or h265
+    std::string preset = "superfast";  // the preset of libx264/libx265
+    uint32_t bitRate = 2000000;
+    uint32_t gopSize = 12;
+    uint32_t frameRate = 15;
+    uint32_t width = 0;  // the stream size, 0: 600x400 for bgr input, the source size for nv12 input
+    uint32_t height = 0;
+    int encodeThreads = 0;  // the slice thread number of the encoder, 0: decided by the encoder
+    bool nv12Input = false;  // encode the NV12 image of the decoder instead of the BGR frame
+    bool adaptiveBitRate = false;  // lower the bitrate when the packets wait for the network
+};
 
 class PicToRtsp
 {
@@ -8,14 +24,45 @@ public:
 	PicToRtsp();
 	~PicToRtsp();
 
-	int AvInit(int picWidth, int picHeight, std::string g_outFile);
+	/**
+	 * @brief open the encoder and the rtsp stream, start the packet writer thread
+	 * @param [in] config: the encoder config, the stream size is picWidth x picHeight
+	 */
+	int AvInit(int picWidth, int picHeight, std::string g_outFile, const RtspEncodeConfig& config);
 	
 	void YuvDataInit();
 	void BgrDataInint();
 
+	/**
+	 * @brief encode a NV12 image of the stream size, the image is copied
+	 */
 	int YuvDataToRtsp(void *dataBuf, uint32_t size, uint32_t seq);
 	int BgrDataToRtsp(void *dataBuf, uint32_t size, uint32_t seq);
+	/**
+	 * @brief encode a NV12 image, the encoder keeps a reference of data without copy
+	 *        when the image size is the stream size, otherwise the image is scaled
+	 * @param [in] data: the NV12 image, the UV plane follows stride * rows bytes of Y plane
+	 * @param [in] width, height: the image size
+	 * @param [in] stride: the row stride of the image
+	 * @param [in] rows: the row number of Y plane in the buffer
+	 */
+	int Nv12DataToRtsp(std::shared_ptr<uint8_t> data, uint32_t width, uint32_t height,
+	                   uint32_t stride, uint32_t rows, uint32_t seq);
 	int FlushEncoder();
+	bool IsInited()
+	{
+		return g_pkt != NULL;
+	}
+
+private:
+	int OpenEncoder(int width, int height, int64_t bitRate);
+	int ReopenEncoder(int64_t bitRate);
+	void AllocYuvFrame();
+	int Nv12ToYuvFrame(const uint8_t* data, uint32_t width, uint32_t height, uint32_t stride, uint32_t rows);
+	int EncodeFrame(AVFrame* frame);
+	int AdaptEncoder();
+	void WritePacketThread();
+	void StopWritePacket();
 
 private:
     AVFormatContext* g_fmtCtx;
@@ -32,4 +79,17 @@ private:
 	struct SwsContext* g_imgCtx;
 	bool g_bgrToRtspFlag;
 	bool g_yuvToRtspFlag;
+	// the encoded packets are written to the network by g_writeThread
+	ThreadSafeQueue<AVPacket*> g_pktQueue;
+	std::thread g_writeThread;
+	std::atomic<bool> g_writeExit;
+	// set by g_writeThread when writing to the network fails, the thread exits
+	std::atomic<bool> g_writeFailed;
+	RtspEncodeConfig g_config;
+	struct SwsContext* g_nv12ScaleCtx;
+	uint32_t g_adaptFrameCnt;
+	uint32_t g_adaptLevel;  // the index of kAdaptBitRateRatios
+	uint32_t g_idleCheckCnt;
+	uint64_t g_encodeFrameCnt;
+	double g_encodeTimeMs;
 };
@@ -9,7 +9,8 @@ namespace {
     uint32_t kBgrMultiplier = 3;
 }
 
-PushRtspThread::PushRtspThread(std::string rtspUrl)
+PushRtspThread::PushRtspThread(std::string rtspUrl, const RtspEncodeConfig& config)
+    : g_config(config)
 {
     g_rtspUrl = rtspUrl;
     ACLLITE_LOG_INFO("PushRtspThread URL : %s", g_rtspUrl.c_str());
@@ -23,12 +24,22 @@ PushRtspThread::~PushRtspThread()
 AclLiteError PushRtspThread::Init() {
     g_frameSeq = 0;
     XInitThreads();
-    AclLiteError ret = g_picToRtsp.AvInit(kResizeWidth, kResizeHeight, g_rtspUrl);
+    if (g_config.width == 0 || g_config.height == 0) {
+        // the stream size of nv12 input is the size of the first frame
+        if (g_config.nv12Input) {
+            return ACLLITE_OK;
+        }
+        g_config.width = kResizeWidth;
+        g_config.height = kResizeHeight;
+    }
+    AclLiteError ret = g_picToRtsp.AvInit(g_config.width, g_config.height, g_rtspUrl, g_config);
     if (ret != ACLLITE_OK) {
         ACLLITE_LOG_ERROR("AvInit rtsp failed");
         return ACLLITE_ERROR;
     }
-	g_picToRtsp.BgrDataInint();
+    if (!g_config.nv12Input) {
+        g_picToRtsp.BgrDataInint();
+    }
     return ACLLITE_OK;
 }
 
@@ -47,28 +58,52 @@ AclLiteError PushRtspThread::Process(int msgId, std::shared_ptr<void> msgData) {
     return ACLLITE_OK;
 }
 
+AclLiteError PushRtspThread::EncodeYuvFrames(std::shared_ptr<DetectDataMsg> detectDataMsg) {
+    for (int i = 0; i < detectDataMsg->yuvFrame.size(); i++) {
+        ImageData& image = detectDataMsg->yuvFrame[i];
+        if (!g_picToRtsp.IsInited()) {
+            // h264 needs even width and height
+            AclLiteError ret = g_picToRtsp.AvInit(image.width & ~1u, image.height & ~1u, g_rtspUrl, g_config);
+            if (ret != ACLLITE_OK) {
+                ACLLITE_LOG_ERROR("AvInit rtsp failed");
+                return ACLLITE_ERROR;
+            }
+        }
+        if (g_picToRtsp.Nv12DataToRtsp(image.data, image.width, image.height,
+                                       image.alignWidth, image.alignHeight, g_frameSeq++) != ACLLITE_OK) {
+            return ACLLITE_ERROR;
+        }
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError PushRtspThread::EncodeMsgFrames(std::shared_ptr<DetectDataMsg> detectDataMsg) {
+    if (g_config.nv12Input) {
+        return EncodeYuvFrames(detectDataMsg);
+    }
+    for(int i = 0; i < detectDataMsg->frame.size(); i++) {
+        cv::Mat resized_image;
+        cv::resize(detectDataMsg->frame[i], resized_image, cv::Size(g_config.width, g_config.height));
+
+        if (g_picToRtsp.BgrDataToRtsp(resized_image.data, resized_image.cols * resized_image.rows * kBgrMultiplier,
+                                      g_frameSeq++) != ACLLITE_OK) {
+            return ACLLITE_ERROR;
+        }
+    }
+    return ACLLITE_OK;
+}
+
 AclLiteError PushRtspThread::DisplayMsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg) {
     if (detectDataMsg->isLastFrame) {
         if(av_log_get_level() != AV_LOG_ERROR) {
             av_log_set_level(AV_LOG_INFO);
         }
-        for(int i = 0; i < detectDataMsg->frame.size(); i++) {
-            cv::Mat resized_image;
-            cv::resize(detectDataMsg->frame[i], resized_image, cv::Size(kResizeWidth, kResizeHeight));
-
-            g_picToRtsp.BgrDataToRtsp(resized_image.data, resized_image.cols * resized_image.rows * kBgrMultiplier, g_frameSeq++);
-        }
+        EncodeMsgFrames(detectDataMsg);
         SendMessage(detectDataMsg->rtspDisplayThreadId, MSG_ENCODE_FINISH, nullptr);
         return ACLLITE_OK;
     }
     if(av_log_get_level() != AV_LOG_ERROR) {
         av_log_set_level(AV_LOG_INFO);
     }
-    for(int i = 0; i < detectDataMsg->frame.size(); i++) {
-        cv::Mat resized_image;
-        cv::resize(detectDataMsg->frame[i], resized_image, cv::Size(kResizeWidth, kResizeHeight));
-
-        g_picToRtsp.BgrDataToRtsp(resized_image.data, resized_image.cols * resized_image.rows * kBgrMultiplier, g_frameSeq++);
-    }
-    return ACLLITE_OK;
-}
\ No newline at end of file
+    return EncodeMsgFrames(detectDataMsg);
+}
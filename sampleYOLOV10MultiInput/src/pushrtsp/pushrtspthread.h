@@ -9,13 +9,21 @@
 class PushRtspThread: public AclLiteThread
 {
 public:
-    PushRtspThread(std::string rtspUrl);
+    /**
+     * @param [in] config: the encoder config of the channel, config.nv12Input true: encode
+     *                     DetectDataMsg::yuvFrame, false: encode DetectDataMsg::frame
+     */
+    PushRtspThread(std::string rtspUrl, const RtspEncodeConfig& config = RtspEncodeConfig());
     ~PushRtspThread();
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> msgData);
     AclLiteError DisplayMsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg);
+private:
+    AclLiteError EncodeMsgFrames(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError EncodeYuvFrames(std::shared_ptr<DetectDataMsg> detectDataMsg);
 private:
     PicToRtsp g_picToRtsp;
     uint64_t g_frameSeq;
     std::string g_rtspUrl;
+    RtspEncodeConfig g_config;
 };